@@ -97,8 +97,18 @@ pointsArray = pointsArray.sort(){|x,y| x.inst <=> y.inst}
 confFile = File.open(options[:conf],"a")
 
 confFile.puts("\n[SPointMode"+benchSpoint+"]")
-confFile.puts("type         = SPoint")
-confFile.puts("spointSize   = 1e8")
+confFile.puts("type              = \"SPoint\"")
+confFile.puts("spointSize        = 1e8")
+confFile.puts("nInstSkip         = 1")
+confFile.puts("nInstSkipThreads  = 1")
+confFile.puts("nInstMax          = 1e12")
+confFile.puts("maxnsTime         = 1e12")
+confFile.puts("nInstRabbit       = 0")
+confFile.puts("nInstWarmup       = 1e7")
+confFile.puts("nInstDetail       = 1e5")
+confFile.puts("nInstTiming       = 1e8")
+confFile.puts("PowPredictionHist = 5")
+confFile.puts("doPowPrediction   = 0")
 for i in 0 .. pointsArray.length - 1 do
   confFile.puts("spoint[" + i.to_s() +   "]    = " + pointsArray[i].inst.to_s() + "e8")
   confFile.puts("spweight[" + i.to_s() + "]  = " + pointsArray[i].weight.to_s())
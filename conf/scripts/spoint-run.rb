@@ -0,0 +1,214 @@
+#!/usr/bin/ruby
+#Runs each point of a SPoint sampler section as an independent esesc process
+#and adds up the weighted reports (each process scales its stats by the
+#point weight, so the merged report is the weighted estimate).
+#
+#  spoint-run.rb -e ./esesc -c esesc.conf -s SPointMode186crafty -n 6 -j 6
+#  spoint-run.rb -m merged.rep esesc_crafty_sp*
+#
+#With -k prefix, point i saves its warm state to prefix.i (first run) or
+#restores it (later runs of the same point with another configuration).
+#The section must not set spointRun or checkpoint* (they are added here).
+
+require "optparse"
+
+options = {}
+options[:jobs]   = 4
+options[:report] = "spoint"
+optparse = OptionParser.new do |opts|
+  opts.banner = "Useage: spoint-run.rb [options] | -m merged_report report..."
+
+  opts.on("-e esesc","--esesc esesc","esesc binary") do |e|
+    options[:esesc] = e
+  end
+  opts.on("-c conf","--conf conf","esesc configuration file") do |c|
+    options[:conf] = c
+  end
+  opts.on("-s section","--section section","SPoint sampler section") do |s|
+    options[:section] = s
+  end
+  opts.on("-n points","--points points","number of spoint[] in the section") do |n|
+    options[:points] = n.to_i
+  end
+  opts.on("-j jobs","--jobs jobs","processes in parallel, default = " + options[:jobs].to_s) do |j|
+    options[:jobs] = j.to_i
+  end
+  opts.on("-k prefix","--checkpoint prefix","checkpoint file prefix") do |k|
+    options[:ckp] = k
+  end
+  opts.on("-r name","--report name","report name, default = " + options[:report]) do |r|
+    options[:report] = r
+  end
+  opts.on("-m merged","--merge merged","only merge the reports given as arguments") do |m|
+    options[:merge] = m
+  end
+  opts.on('-h','--help','Display this screen') do
+    puts opts
+    exit
+  end
+
+  if ARGV.empty?
+    puts opts
+    exit
+  end
+end
+optparse.parse!
+
+# Adds up the GStats of weighted reports. Other lines come from the first report.
+def mergeReports(outName, files)
+  cntr  = {}  # name=v and name(key)=v (histogram buckets)
+  avg   = {}  # name:n=N::v=V (also histogram name:v= / name:n=)
+  max   = {}  # name:max=M:n=N and histogram name:max=K
+  order = []
+  seen  = {}
+  other = []
+
+  files.each_with_index do |f, i|
+    inStats = false
+    File.open(f,"r").each_line do |line|
+      line.chomp!
+      if line =~ /^#BEGIN GStats::report/
+        inStats = true
+        other.push(line) if i == 0
+        next
+      elsif line =~ /^#END GStats::report/
+        inStats = false
+        other.push(:stats) if i == 0
+        other.push(line) if i == 0
+        next
+      end
+      if !inStats
+        other.push(line) if i == 0
+        next
+      end
+
+      if line =~ /^(.*):n=(-?[0-9.e+]+)::v=(.*)$/
+        k = [:avg, $1]
+        avg[$1] ||= [0.0, 0.0]
+        avg[$1][0] += $2.to_f
+        avg[$1][1] += $2.to_f*$3.to_f
+      elsif line =~ /^(.*):max=(.*):n=(.*)$/
+        k = [:max, $1]
+        max[$1] ||= [0.0, 0.0]
+        max[$1][0] = [max[$1][0], $2.to_f].max
+        max[$1][1] += $3.to_f
+      elsif line =~ /^(.*):max=(.*)$/
+        k = [:hmax, $1]
+        max[$1] ||= [0.0, 0.0]
+        max[$1][0] = [max[$1][0], $2.to_f].max
+      elsif line =~ /^(.*):v=(.*)$/
+        # histogram average, weighted with the :n= line that follows
+        k = [:hv, $1]
+        avg[$1] ||= [0.0, 0.0]
+        avg[$1][2] = $2.to_f
+      elsif line =~ /^(.*):n=(.*)$/
+        k = [:hn, $1]
+        avg[$1] ||= [0.0, 0.0]
+        avg[$1][0] += $2.to_f
+        avg[$1][1] += $2.to_f*(avg[$1][2] || 0.0)
+      elsif line =~ /^(.*)=(-?[0-9.e+]+|nan|inf)$/
+        k = [:cntr, $1]
+        cntr[$1] = (cntr[$1] || 0.0) + $2.to_f
+      else
+        k = [:line, line]
+      end
+      if !seen[k] && (i == 0 || k[0] != :line)
+        order.push(k)
+        seen[k] = true
+      end
+    end
+  end
+
+  out = File.open(outName,"w")
+  other.each do |line|
+    if line != :stats
+      out.puts(line)
+      next
+    end
+    order.each do |k|
+      t, name = k
+      case t
+      when :avg
+        v = avg[name][0] > 0 ? avg[name][1]/avg[name][0] : 0
+        out.puts("%s:n=%d::v=%f" % [name, avg[name][0].round, v])
+      when :max
+        out.puts("%s:max=%f:n=%d" % [name, max[name][0], max[name][1].round])
+      when :hmax
+        out.puts("%s:max=%d" % [name, max[name][0]])
+      when :hv
+        v = avg[name][0] > 0 ? avg[name][1]/avg[name][0] : 0
+        out.puts("%s:v=%f" % [name, v])
+      when :hn
+        out.puts("%s:n=%f" % [name, avg[name][0]])
+      when :cntr
+        out.puts("%s=%f" % [name, cntr[name]])
+      else
+        out.puts(name)
+      end
+    end
+  end
+  out.close
+end
+
+if options[:merge]
+  mergeReports(options[:merge], ARGV)
+  exit
+end
+
+if !options[:esesc] || !options[:conf] || !options[:section] || !options[:points]
+  puts optparse
+  exit
+end
+
+confDir  = File.dirname(options[:conf])
+confBase = File.basename(options[:conf])
+
+# One configuration per point: the original one plus spointRun (and checkpoint)
+pids    = {}
+reports = []
+for i in 0 .. options[:points] - 1 do
+  spConf = File.join(confDir, "spoint_" + i.to_s + "_" + confBase)
+  File.open(spConf,"w") do |f|
+    f.puts("<" + confBase + ">")
+    f.puts("[" + options[:section] + "]")
+    f.puts("spointRun = " + i.to_s)
+    if options[:ckp]
+      ckp = options[:ckp] + "." + i.to_s
+      if File.exist?(ckp)
+        f.puts("checkpointLoad = \"" + ckp + "\"")
+      else
+        f.puts("checkpointSave = \"" + ckp + "\"")
+      end
+    end
+  end
+
+  while pids.size >= options[:jobs]
+    pid = Process.wait
+    pids.delete(pid)
+  end
+
+  report = options[:report] + "_sp" + i.to_s
+  reports.push(report)
+  puts "Running point " + i.to_s
+  pid = fork do
+    ENV["ESESC_reportFile"] = report
+    exec(options[:esesc], "-c", spConf)
+  end
+  pids[pid] = i
+end
+Process.waitall
+
+files = []
+reports.each do |r|
+  # esesc_<reportFile>.XXXXXX, the newest one
+  found = Dir.glob("esesc_" + r + ".*").sort_by { |f| File.mtime(f) }
+  if found.empty?
+    puts "ERROR: no report for " + r
+    exit 1
+  end
+  files.push(found.last)
+end
+
+merged = "esesc_" + options[:report] + ".spoint"
+mergeReports(merged, files)
+puts "Weighted report " + merged
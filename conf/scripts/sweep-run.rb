@@ -0,0 +1,223 @@
+#!/usr/bin/ruby
+#Runs a design space sweep over one recorded emulation stream.
+#
+#The base configuration runs once with traceRecord (it is also the "base"
+#point of the sweep). Every variant then replays the trace in its own esesc
+#process, in parallel, so QEMU boots and emulates the benchmark only once per
+#sweep. Each variant writes its own report (esesc_<prefix>_<variant>.*).
+#
+#An existing trace is reused: the base configuration then replays it like the
+#variants. <trace>.conf keeps the emulator and sampler keys used to record it,
+#and the sweep stops if the base configuration does not match them.
+#
+#  sweep-run.rb -e ./esesc -c esesc.conf -j 8 sweep.txt
+#
+#The sweep file has one variant per line, a name followed by the keys it
+#overrides ("key" for a global, "section.key" otherwise):
+#
+#  # name      overrides
+#  l2_512K     L2Cache.size=524288
+#  dram_2ch    MemCtrl.NumChannels=2 MemCtrl.interleave='xor'
+#  issue2      tradCORE.issueWidth=2 tradCORE.fetchWidth=2
+#
+#Keys already in the configuration are overridden with ESESC_ environment
+#variables, new keys are added to the variant configuration. The base
+#configuration must not set traceRecord/traceReplay (they are added here).
+#
+#The trace has the instructions that the sampler asked QEMU for, so the keys
+#of the emulator section, of its sampler section, the globals they use and
+#cpuemul can not be overridden (record another trace instead).
+
+require "optparse"
+
+options = {}
+options[:jobs]   = 4
+options[:emul]   = "QEMUSectionCPU"
+options[:trace]  = "sweep.trc"
+options[:report] = "sweep"
+optparse = OptionParser.new do |opts|
+  opts.banner = "Useage: sweep-run.rb [options] sweep_file"
+
+  opts.on("-e esesc","--esesc esesc","esesc binary") do |e|
+    options[:esesc] = e
+  end
+  opts.on("-c conf","--conf conf","base esesc configuration file") do |c|
+    options[:conf] = c
+  end
+  opts.on("-q section","--emul section","QEMU emul section, default = " + options[:emul]) do |q|
+    options[:emul] = q
+  end
+  opts.on("-t trace","--trace trace","trace file, recorded if it does not exist, default = " + options[:trace]) do |t|
+    options[:trace] = t
+  end
+  opts.on("-j jobs","--jobs jobs","processes in parallel, default = " + options[:jobs].to_s) do |j|
+    options[:jobs] = j.to_i
+  end
+  opts.on("-r prefix","--report prefix","report prefix, default = " + options[:report]) do |r|
+    options[:report] = r
+  end
+  opts.on('-h','--help','Display this screen') do
+    puts opts
+    exit
+  end
+
+  if ARGV.empty?
+    puts opts
+    exit
+  end
+end
+optparse.parse!
+
+if !options[:esesc] || !options[:conf] || ARGV.size != 1
+  puts optparse
+  exit
+end
+
+# Keys defined in a configuration file (following <includes>), as
+# "section.key" => value
+def confKeys(fname, keys = {})
+  section = ""
+  File.open(fname,"r").each_line do |line|
+    line = line.sub(/#.*/, "").strip
+    if line =~ /^<(.*)>$/
+      inc = $1
+      inc = File.join(File.dirname(fname), inc) if !File.exist?(inc)
+      confKeys(inc, keys)
+    elsif line =~ /^\[(.*)\]$/
+      section = $1
+    elsif line =~ /^([A-Za-z_][A-Za-z0-9_]*)\s*(\[[^\]]*\])?\s*=\s*(.*)$/
+      keys[(section.empty? ? "" : section + ".") + $1] = $3
+    end
+  end
+  keys
+end
+
+# Value of a key without quotes, $(global) expanded
+def confValue(keys, key)
+  v = keys[key]
+  return nil if !v
+  v = v.sub(/^["'](.*)["']$/, '\1')
+  v.gsub(/\$\(([^)]*)\)/) { confValue(keys, $1) || "" }
+end
+
+confDir  = File.dirname(options[:conf])
+confBase = File.basename(options[:conf])
+keys     = confKeys(options[:conf])
+
+# Keys fixed by the trace (see above)
+sampler = confValue(keys, options[:emul] + ".sampler")
+fixed   = { "cpuemul" => true }
+[options[:emul], sampler].compact.each do |sec|
+  keys.each do |k, v|
+    next if !k.start_with?(sec + ".")
+    fixed[k] = true
+    v.scan(/\$\(([^)]*)\)/) { |g| fixed[g[0]] = true }
+  end
+end
+stamp = fixed.keys.sort.map { |k| k + " = " + (confValue(keys, k) || "") }
+
+# Variants: name => [[section, key, value]]
+variants = []
+File.open(ARGV[0],"r").each_line do |line|
+  line = line.sub(/#.*/, "").strip
+  next if line.empty?
+  fields = line.split(/\s+/)
+  name   = fields.shift
+  if name == "base" || variants.assoc(name)
+    puts "ERROR: variant " + name + " is defined twice (base is the base configuration)"
+    exit 1
+  end
+  over = []
+  fields.each do |f|
+    if f !~ /^(([^.=]+)\.)?([^.=]+)=(.+)$/
+      puts "ERROR: variant " + name + " has a wrong override [" + f + "]"
+      exit 1
+    end
+    section, key, value = $2 || "", $3, $4
+    if fixed[(section.empty? ? "" : section + ".") + key] || section == options[:emul] || section == sampler
+      puts "ERROR: variant " + name + " overrides [" + f + "], fixed by the trace (emulator/sampler)"
+      exit 1
+    end
+    over.push([section, key, value])
+  end
+  variants.push([name, over])
+end
+
+# Starts esesc with a configuration of the base one plus extra lines
+def startPoint(options, confDir, confBase, name, globals, lines, env)
+  spConf = File.join(confDir, "sweep_" + name + "_" + confBase)
+  File.open(spConf,"w") do |f|
+    # new global keys must come before any section
+    globals.each { |l| f.puts(l) }
+    f.puts("<" + confBase + ">")
+    lines.each { |l| f.puts(l) }
+  end
+
+  fork do
+    env.each { |k, v| ENV[k] = v }
+    ENV["ESESC_reportFile"] = options[:report] + "_" + name
+    exec(options[:esesc], "-c", spConf)
+  end
+end
+
+failed    = []
+stampFile = options[:trace] + ".conf"
+if !File.exist?(options[:trace])
+  puts "Recording " + options[:trace] + " with the base configuration"
+  pid = startPoint(options, confDir, confBase, "base", [],
+                   ["[" + options[:emul] + "]", "traceRecord = \"" + options[:trace] + "\""], {})
+  Process.wait(pid)
+  if !$?.success? || !File.exist?(options[:trace])
+    puts "ERROR: the base configuration did not record " + options[:trace]
+    exit 1
+  end
+  File.open(stampFile,"w") { |f| stamp.each { |l| f.puts(l) } }
+else
+  if !File.exist?(stampFile) || File.readlines(stampFile).map { |l| l.chomp } != stamp
+    puts "ERROR: " + options[:trace] + " was not recorded with the emulator/sampler keys of " + options[:conf]
+    puts "       (see " + stampFile + "), remove the trace to record it again"
+    exit 1
+  end
+  # the base point replays the trace too
+  variants.unshift(["base", []])
+end
+
+pids = {}
+variants.each do |name, over|
+  globals = []
+  lines   = ["[" + options[:emul] + "]", "traceReplay = \"" + options[:trace] + "\""]
+  env     = {}
+  over.each do |section, key, value|
+    if keys[(section.empty? ? "" : section + ".") + key]
+      env["ESESC_" + (section.empty? ? "" : section + "_") + key] = value
+    elsif section.empty?
+      globals.push(key + " = " + value)
+    else
+      lines.push("[" + section + "]")
+      lines.push(key + " = " + value)
+    end
+  end
+
+  while pids.size >= options[:jobs]
+    pid = Process.wait
+    failed.push(pids[pid]) if !$?.success?
+    pids.delete(pid)
+  end
+
+  puts "Running variant " + name
+  pids[startPoint(options, confDir, confBase, name, globals, lines, env)] = name
+end
+while !pids.empty?
+  pid = Process.wait
+  failed.push(pids[pid]) if !$?.success?
+  pids.delete(pid)
+end
+
+(["base"] + variants.map { |v| v[0] }).uniq.each do |name|
+  found = Dir.glob("esesc_" + options[:report] + "_" + name + ".*").sort_by { |f| File.mtime(f) }
+  printf("%-20s %s\n", name, found.empty? ? "no report" : found.last)
+end
+if !failed.empty?
+  puts "ERROR: variants " + failed.join(" ") + " failed"
+  exit 1
+end
@@ -0,0 +1,117 @@
+// The ESESC/BSD License
+//
+// Copyright (c) 2005-2013, Regents of the University of California and 
+// the ESESC Project.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+//   - Neither the name of the University of California, Santa Cruz nor the
+//   names of its contributors may be used to endorse or promote products
+//   derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "CrackCache.h"
+
+CrackCache::CrackCache(uint32_t size, uint32_t fifoDist)
+  /* constructor {{{1 */
+  : nSets(size/Ways)
+  ,setMask(size/Ways-1)
+  ,fifoDistance(fifoDist)
+  ,nPushed(0)
+{
+  I(size >= Ways);
+  I((nSets & setMask) == 0); // power of two
+
+  Entry e;
+  e.pc    = 0;
+  e.insn  = 0;
+  e.mode  = 0;
+  e.block = 0;
+  entries.resize(nSets*Ways, e);
+  victim.resize(nSets, 0);
+}
+/* }}} */
+
+CrackCache::~CrackCache()
+  /* destructor {{{1 */
+{
+  for(size_t i=0;i<allBlocks.size();i++)
+    delete allBlocks[i];
+}
+/* }}} */
+
+CrackCache::Block *CrackCache::allocBlock()
+  /* a block not referenced by the tsfifo anymore {{{1 */
+{
+  if (!evicted.empty() && (evicted.front().when + fifoDistance) <= nPushed) {
+    Block *b = evicted.front().block;
+    evicted.pop_front();
+    return b;
+  }
+
+  Block *b = new Block;
+  allBlocks.push_back(b);
+  return b;
+}
+/* }}} */
+
+void CrackCache::insert(const RAWDInst *rinst, uint8_t mode)
+  /* copy the cracked uops in the set {{{1 */
+{
+  uint32_t ninst = rinst->getNumInst();
+  if (ninst == 0 || ninst > MaxUops)
+    return;
+
+  uint32_t set = getSet(rinst->getPC());
+  Entry   *e   = &entries[set*Ways];
+
+  int32_t pos = -1;
+  for(int i=0;i<Ways;i++) {
+    if (e[i].block == 0) {
+      pos = i;
+      break;
+    }
+  }
+  if (pos < 0) {
+    pos = victim[set];
+    victim[set] = (victim[set] + 1) % Ways;
+
+    Evicted ev;
+    ev.when  = nPushed;
+    ev.block = e[pos].block;
+    evicted.push_back(ev);
+    e[pos].block = 0;
+  }
+
+  Block *b = allocBlock();
+  for(uint32_t i=0;i<ninst;i++)
+    b->uop[i] = *rinst->getInstRef(i);
+  b->ninst = ninst;
+
+  e[pos].pc    = rinst->getPC();
+  e[pos].insn  = rinst->getInsn();
+  e[pos].mode  = mode;
+  e[pos].block = b;
+}
+/* }}} */
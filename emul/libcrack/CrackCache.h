@@ -0,0 +1,125 @@
+// The ESESC/BSD License
+//
+// Copyright (c) 2005-2013, Regents of the University of California and 
+// the ESESC Project.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+//   - Neither the name of the University of California, Santa Cruz nor the
+//   names of its contributors may be used to endorse or promote products
+//   derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef CRACKCACHE_H
+#define CRACKCACHE_H
+
+#include <stdint.h>
+
+#include <vector>
+#include <deque>
+
+#include "nanassert.h"
+#include "RAWDInst.h"
+
+/*
+ * Cache of cracked instructions for one flow, indexed by PC and checked
+ * against the encoding and the decode mode (ARM/Thumb). On a hit the
+ * RAWDInst references the cached uops (RAWDInst::setTemplate) and the
+ * cracker is not called.
+ *
+ * The uops of an entry are never modified once inserted: a replaced block
+ * may still be referenced by RAWDInsts in the tsfifo, so it is only reused
+ * after fifoDistance more instructions have been pushed (pushed()). The
+ * consumer has released them by then.
+ *
+ * Instructions with more than MaxUops uops are not cached.
+ */
+
+class CrackCache {
+public:
+  enum {
+    MaxUops = 8,
+    Ways    = 4
+  };
+
+private:
+  class Block {
+  public:
+    UOPPredecType uop[MaxUops];
+    uint32_t      ninst;
+  };
+
+  class Entry {
+  public:
+    AddrType    pc;
+    RAWInstType insn;
+    uint8_t     mode;
+    Block      *block; // 0 if invalid
+  };
+
+  class Evicted {
+  public:
+    uint64_t when;  // nPushed at eviction
+    Block   *block;
+  };
+
+  const uint32_t nSets;
+  const uint32_t setMask;
+  const uint64_t fifoDistance;
+
+  std::vector<Entry>   entries; // nSets*Ways
+  std::vector<uint8_t> victim;  // round robin per set
+  std::deque<Evicted>  evicted;
+  std::vector<Block *> allBlocks;
+  uint64_t             nPushed;
+
+  uint32_t getSet(AddrType pc) const {
+    return ((pc >> 1) ^ (pc >> 2) ^ (pc >> 13)) & setMask; // ARM and Thumb PCs use all the sets
+  }
+  Block *allocBlock();
+
+public:
+  CrackCache(uint32_t size, uint32_t fifoDistance);
+  ~CrackCache();
+
+  // true if found: rinst references the cached uops
+  bool lookup(RAWDInst *rinst, uint8_t mode) {
+    Entry *e = &entries[getSet(rinst->getPC())*Ways];
+    for(int i=0;i<Ways;i++) {
+      if (e[i].pc == rinst->getPC() && e[i].insn == rinst->getInsn() && e[i].mode == mode && e[i].block) {
+        rinst->setTemplate(e[i].block->uop, e[i].block->ninst);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Add the uops of a cracked (missed) instruction
+  void insert(const RAWDInst *rinst, uint8_t mode);
+
+  // One more instruction in the tsfifo
+  void pushed() { nPushed++; }
+};
+
+#endif // CRACKCACHE_H
@@ -86,6 +86,18 @@ private:
 protected:
   uint32_t ninst; // [sizhuo] number of uOPs cracked into?
   std::vector<UOPPredecType> predec; // [sizhuo] cracked into uOPs?
+  const UOPPredecType *tmpl; // uops owned by a CrackCache (instead of predec)
+
+  void copyFrom(const RAWDInst &p) {
+    ninst = p.ninst;
+    if (p.tmpl) {
+      // The cache may reuse the template, keep a private copy
+      predec.assign(p.tmpl, p.tmpl + p.ninst);
+    }else{
+      predec = p.predec;
+    }
+    tmpl = 0;
+  }
 public:
 #ifdef ENABLE_CUDA
   void setMemaccesstype(CUDAMemType type){
@@ -106,12 +118,28 @@ public:
 #else
     addr = p.addr;
 #endif
-    ninst = p.ninst;
-    predec = p.predec;
+    copyFrom(p);
     keepStats = false;
   }
 
-  RAWDInst() {
+  RAWDInst &operator=(const RAWDInst &p) {
+    insn = p.insn;
+    pc   = p.pc;
+#ifdef SCOORE
+    isClear = p.isClear;
+#else
+    addr = p.addr;
+#endif
+#ifdef ENABLE_CUDA
+    memaccess = p.memaccess;
+#endif
+    keepStats = p.keepStats;
+    inITBlock = p.inITBlock;
+    copyFrom(p);
+    return *this;
+  }
+
+  RAWDInst() : tmpl(0) {
     IS(clear());
   }
 
@@ -144,6 +172,7 @@ public:
 
   void clearInst() {
     ninst = 0;
+    tmpl  = 0;
     // predec.reserve(16);
 #ifdef ENABLE_CUDA
     memaccess   = GlobalMem;
@@ -153,6 +182,7 @@ public:
   }
 
   UOPPredecType *getNewInst() {
+    I(tmpl == 0);
     ninst++;
     if (ninst >= predec.size())
       predec.resize(2*ninst);
@@ -172,7 +202,14 @@ public:
 #endif
 
   size_t getNumInst() const { return ninst; }
-  const UOPPredecType *getInstRef(size_t id) const { return &predec[id]; }
+  const UOPPredecType *getInstRef(size_t id) const { return tmpl ? &tmpl[id] : &predec[id]; }
+
+  // Use n uops that live in a CrackCache (valid until the next set)
+  void setTemplate(const UOPPredecType *t, uint32_t n) {
+    tmpl      = t;
+    ninst     = n;
+    inITBlock = false;
+  }
 
   void clear() {
     insn = 0;
@@ -56,6 +56,9 @@ public:
   }
   void expand(RAWDInst *rinst);  
 
+  // Conditions pending from an IT instruction (the decode depends on them)
+  bool isInIT() const { return !itblockVector->empty(); }
+
   void thumb16expand(RAWDInst *rinst);  
   void thumb32expand(RAWDInst *rinst);  
 
@@ -110,6 +110,12 @@ EmuSampler::EmuSampler(const char *iname, EmulInterface *emu, FlowID fid)
   sprintf(str,"P(%d):nCommitted",fid);
   nCommitted = GStats::getRef(str);
   I(nCommitted);
+  sprintf(str,"P(%d):clockTicks",fid); //FIXME: needs mapping
+  clockTicks = GStats::getRef(str);
+  I(clockTicks);
+  sprintf(str,"P(%d):nFreeze",fid); //FIXME: needs mapping
+  nFreeze = GStats::getRef(str);
+  I(nFreeze);
   prevnCommitted = 0;
 
   sampler_count++;
@@ -418,13 +424,7 @@ void EmuSampler::calcCPI()
   uint64_t timingInst = iusage[EmuTiming]->getSamples();
   uint64_t instCount  = timingInst - instPrev[sFid];
 
-  char str[255];
-  sprintf(str, "P(%d):clockTicks", sFid); //FIXME: needs mapping
-  GStats *gref = 0;
-  gref = GStats::getRef(str);
-  I(gref);
-  //fprintf(stderr, "\n\nCalcCPI: %s->getSamples returns %lld (previously : %lld)\n\n",str,gref->getSamples(),clockPrev[sFid]);
-  uint64_t cticks        = gref->getSamples();
+  uint64_t cticks        = clockTicks->getSamples();
   uint64_t clockInterval = cticks - clockPrev[sFid] + 1;
 
   if(instCount<100 || clockInterval <100) // To avoid too frequent sampling errors
@@ -434,12 +434,7 @@ void EmuSampler::calcCPI()
   clockPrev[sFid]        = cticks;
   
   //Get freezed cycles due to thermal throttling 
-  sprintf(str, "P(%d):nFreeze", sFid); //FIXME: needs mapping
-  gref = 0;
-  gref = GStats::getRef(str);
-  I(gref);
-  uint64_t fticks = gref->getSamples();
-  //fprintf(stderr,"\n\nCalcCPI: %s->getSamples returns %lld\n\n",str,gref->getSamples());
+  uint64_t fticks = nFreeze->getSamples();
   uint64_t fticksInterval    =  fticks - fticksPrev[sFid] + 1;
   fticksPrev[sFid]        =  fticks;
 
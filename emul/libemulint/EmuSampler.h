@@ -92,6 +92,8 @@ protected:
   GStatsCntr *globalClock_Timing;
 
   GStats *nCommitted;
+  GStats *clockTicks; // resolved once, read every calcCPI
+  GStats *nFreeze;
   GStatsAvg *ipc;
   GStatsAvg *uipc;
   Time_t globalClock_Timing_prev;
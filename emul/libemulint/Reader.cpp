@@ -34,16 +34,22 @@
 
 #include "Reader.h"
 #include "Instruction.h"
-#include "ThreadSafeFIFO.h"
+#include "SPSCFIFO.h"
 #include "DInst.h"
 #include "SescConf.h"
 
 
-ThreadSafeFIFO<RAWDInst> *Reader::tsfifo = NULL;
+SPSCFIFO<RAWDInst>       *Reader::tsfifo = NULL;
 EmuDInstQueue            *Reader::ruffer = NULL;
 std::vector<GStatsCntr*>  Reader::rawInst;
 std::vector<GStatsCntr*>  Reader::LD_global;
 std::vector<GStatsCntr*>  Reader::LD_shared;
+std::vector<GStatsCntr*>  Reader::emulStall;
+std::vector<GStatsCntr*>  Reader::nEmulStall;
+std::vector<GStatsCntr*>  Reader::timingStall;
+std::vector<GStatsCntr*>  Reader::nTimingStall;
+std::vector<GStatsCntr*>  Reader::uopCacheHit;
+std::vector<GStatsCntr*>  Reader::uopCacheMiss;
 
 FlowID Reader::nemul = 0;
 
@@ -53,7 +59,7 @@ Reader::Reader(const char* section)
     // Shared through all the objects, but sized with the # cores
     
     nemul =  SescConf->getRecordSize("","cpuemul");
-    tsfifo = new ThreadSafeFIFO<RAWDInst>[nemul];
+    tsfifo = new SPSCFIFO<RAWDInst>[nemul];
     ruffer = new EmuDInstQueue[nemul];
     rawInst.resize(nemul);
 
@@ -67,6 +73,24 @@ Reader::Reader(const char* section)
       LD_shared[i] = new GStatsCntr("Reader(%d):LD_shared",i);
       LD_global[i] = new GStatsCntr("Reader(%d):LD_global",i);
     }
+
+    emulStall.resize(nemul);
+    nEmulStall.resize(nemul);
+    timingStall.resize(nemul);
+    nTimingStall.resize(nemul);
+    for (size_t i=0;i<nemul;i++){
+      emulStall[i]    = new GStatsCntr("Reader(%d):emulStallNs",i);
+      nEmulStall[i]   = new GStatsCntr("Reader(%d):nEmulStall",i);
+      timingStall[i]  = new GStatsCntr("Reader(%d):timingStallNs",i);
+      nTimingStall[i] = new GStatsCntr("Reader(%d):nTimingStall",i);
+    }
+
+    uopCacheHit.resize(nemul);
+    uopCacheMiss.resize(nemul);
+    for (size_t i=0;i<nemul;i++){
+      uopCacheHit[i]  = new GStatsCntr("Reader(%d):uopCacheHit",i);
+      uopCacheMiss[i] = new GStatsCntr("Reader(%d):uopCacheMiss",i);
+    }
   }
 
 }
@@ -36,7 +36,7 @@
 #define READER_H
 
 #include "Instruction.h"
-#include "ThreadSafeFIFO.h"
+#include "SPSCFIFO.h"
 #include "DInst.h"
 #include "SescConf.h"
 #include "EmuDInstQueue.h"
@@ -47,11 +47,17 @@ private:
 protected:
   static FlowID nemul; // [sizhuo] number of emulator interfaces
   // [sizhuo] below are all arrays of size nemul 
-  static ThreadSafeFIFO<RAWDInst> *tsfifo; // [sizhuo] FIFOs of raw inst (uncracked)
+  static SPSCFIFO<RAWDInst>       *tsfifo; // [sizhuo] FIFOs of raw inst (uncracked)
   static EmuDInstQueue            *ruffer; // [sizhuo] FIFOs of cracked uOPs 
   static std::vector <GStatsCntr*>       rawInst;
   static std::vector <GStatsCntr*>       LD_global;
   static std::vector <GStatsCntr*>       LD_shared;
+  static std::vector <GStatsCntr*>       emulStall;   // ns the emulator waited on a full tsfifo
+  static std::vector <GStatsCntr*>       nEmulStall;
+  static std::vector <GStatsCntr*>       timingStall; // ns the timing model waited on tsfifo
+  static std::vector <GStatsCntr*>       nTimingStall;
+  static std::vector <GStatsCntr*>       uopCacheHit;  // cracked instructions found in the CrackCache
+  static std::vector <GStatsCntr*>       uopCacheMiss;
 public:
   Reader(const char* section);
   virtual ~Reader() {
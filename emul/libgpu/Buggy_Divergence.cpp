@@ -27,7 +27,7 @@ extern   GStatsCntr*  totalPTXmemAccess_Rest;
 #endif
 
 
-extern uint64_t GPUReader_translate_d2h(AddrType addr_ptr);
+extern uint64_t GPUReader_translate_d2h(AddrType addr_ptr, uint32_t smid, uint32_t warpid);
 extern uint64_t GPUReader_translate_shared(AddrType addr_ptr, uint32_t blockid, uint32_t warpid);
 extern uint32_t roundUp(uint32_t numToRound, uint32_t multiple);
 extern uint32_t roundDown(uint32_t numToRound, uint32_t multiple);
@@ -107,11 +107,7 @@ bool GPUThreadManager::Timing_Original_buggy(EmuSampler* gsampler, uint32_t* h_t
               SM[smid].warp_status[localwid]         = relaunchReady;
               SM[smid].warp_last_active_pe[localwid] = 0;
               SM[smid].warp_blocked[localwid]        = 0;
-              for (uint32_t spid = 0; spid < numSP; spid++) {
-                if ((localwid < SM[smid].threads_per_pe[spid].size()) && (SM[smid].thread_status_per_pe[spid][localwid] != invalid)) {
-                  SM[smid].thread_status_per_pe[spid][localwid] = block_done;
-                  }
-                }
+              SM[smid].setWarpStatus(localwid, block_done);
               }
             SM[smid].warp_status[warpid]      = relaunchReady;
             SM[smid].warp_blocked[warpid]     = 0;
@@ -223,11 +219,7 @@ bool GPUThreadManager::Timing_Original_buggy(EmuSampler* gsampler, uint32_t* h_t
                         SM[smid].warp_status[localwid]         = relaunchReady;
                         SM[smid].warp_last_active_pe[localwid] = 0;
                         SM[smid].warp_blocked[localwid]        = 0;
-                        for (uint32_t spid = 0; spid < numSP; spid++) {
-                          if ((localwid < SM[smid].threads_per_pe[spid].size()) && (SM[smid].thread_status_per_pe[spid][localwid] != invalid)) {
-                            SM[smid].thread_status_per_pe[spid][localwid] = block_done;
-                            }
-                          }
+                        SM[smid].setWarpStatus(localwid, block_done);
                         }
                       // MSG(" ");
                       SM[smid].warp_blocked[warpid] = blockSize;
@@ -304,7 +296,7 @@ bool GPUThreadManager::Timing_Original_buggy(EmuSampler* gsampler, uint32_t* h_t
                                MSG("Store Basic Block %d Inst %d traceoffset = %d", trace_currentbbid, instoffset, traceoffset);
                                }
                                */
-                            addr = GPUReader_translate_d2h(addr);
+                            addr = GPUReader_translate_d2h(addr, smid, warpid);
                             //if ((active_thread == 0) || (active_thread == 1)) {
 #if TRACKGPU_MEMADDR
                             int acctype = 0;
@@ -0,0 +1,136 @@
+/*
+ESESC: Super ESCalar simulator
+Copyright (C) 2006 University California, Santa Cruz.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef GPU_ADDR_MAP_H
+#define GPU_ADDR_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+
+#include "nanassert.h"
+
+struct AddrRange {
+  uint64_t dev_start;
+  uint64_t dev_end;
+  size_t size;
+  uint64_t host_start;
+  uint64_t host_end;
+};
+
+// Device to host map of the cudaMalloc'ed buffers.
+//
+// The ranges do not overlap, so they are kept in a map keyed by dev_end and
+// a lookup is a lower_bound instead of a scan over all the allocations. Each
+// warp remembers the range of its last hit: the threads of a warp tend to
+// access the same buffer back to back. The per warp slots are direct mapped,
+// a collision only costs a lookup.
+class GPUAddrMap {
+private:
+  typedef std::map<uint64_t, AddrRange> RangeMap;
+
+  enum { Log2Slots = 10 };
+
+  RangeMap ranges; // by dev_end
+  AddrRange *lastHit[1 << Log2Slots];
+
+  static uint32_t slot(uint32_t smid, uint32_t warpid) {
+    return ((smid * 0x9E3779B1U) ^ warpid) & ((1 << Log2Slots) - 1);
+  }
+
+  static bool contains(const AddrRange *r, uint64_t dev_addr) {
+    return dev_addr >= r->dev_start && dev_addr <= r->dev_end;
+  }
+
+  void flushHits() {
+    memset(lastHit, 0, sizeof(lastHit));
+  }
+
+public:
+  GPUAddrMap() {
+    flushHits();
+  }
+
+  size_t size() const { return ranges.size(); }
+
+  // A new buffer replaces any stale range it overlaps (a free that was not
+  // reported).
+  AddrRange *insert(uint64_t dev_addr, size_t size) {
+    I(size > 0);
+    const uint64_t dev_end = dev_addr + size - 1;
+
+    RangeMap::iterator it = ranges.lower_bound(dev_addr);
+    while(it != ranges.end() && it->second.dev_start <= dev_end)
+      ranges.erase(it++);
+    flushHits();
+
+    AddrRange &r = ranges[dev_end];
+    r.dev_start  = dev_addr;
+    r.dev_end    = dev_end;
+    r.size       = size;
+    r.host_start = 0;
+    r.host_end   = 0;
+    return &r;
+  }
+
+  bool erase(uint64_t dev_addr) {
+    RangeMap::iterator it = ranges.lower_bound(dev_addr);
+    if (it == ranges.end() || it->second.dev_start != dev_addr)
+      return false;
+
+    ranges.erase(it);
+    flushHits();
+    return true;
+  }
+
+  AddrRange *find(uint64_t dev_addr) {
+    RangeMap::iterator it = ranges.lower_bound(dev_addr);
+    if (it == ranges.end() || !contains(&it->second, dev_addr))
+      return 0;
+    return &it->second;
+  }
+
+  AddrRange *find(uint64_t dev_addr, uint32_t smid, uint32_t warpid) {
+    AddrRange *&hit = lastHit[slot(smid, warpid)];
+    if (hit && contains(hit, dev_addr))
+      return hit;
+
+    AddrRange *r = find(dev_addr);
+    if (r)
+      hit = r;
+    return r;
+  }
+
+  /*******************************************************************
+   * Shared memory is not allocated by the host, each block has its own
+   * window. The 64 bits are decoded as follows
+   * Bits 31-0  -> raw_addr
+   * Bits 47-32 -> blockid
+   * Bits 48-55 -> warpid
+   *
+   * The upper bits are then set to 110 to denote GPU shared memory
+   * ******************************************************************/
+  static uint64_t shared(uint64_t addr, uint32_t blockid, uint32_t warpid) {
+    uint64_t upper = ((uint64_t)(warpid & 0xFF) << 16) | (blockid & 0xFFFF);
+    return 0xC000000000000000ULL | (upper << 32) | (addr & 0x00000000FFFFFFFFULL);
+  }
+};
+
+#endif
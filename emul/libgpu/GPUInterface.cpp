@@ -99,7 +99,7 @@ string current_CUDA_kernel = "";
 std::map < string, class CUDAKernel * >kernels;
 std::map < string, uint32_t > kernelsId;
 //std::vector <FlowID> SM_temp_pause;
-std::vector <AddrRange> Addrmap;
+GPUAddrMap Addrmap;
 
 uint32_t reexecute = 0;
 
@@ -169,16 +169,17 @@ extern "C" void GPUReader_mallocAddress(uint32_t dev_addr, uint32_t size, uint32
   cudamalloc.add(size);
   if (unifiedCPUGPUmem){
     MSG("Mapping %d bytes of memory on the GPU starting from address %x ", (int)size, dev_addr);
-    AddrRange a; 
-
-    a.dev_start = dev_addr;
-    a.size  = size;
-    a.dev_end   = dev_addr + size - 1;
+    Addrmap.insert(dev_addr, size);
+  }
+}
 
-    a.host_start  = 0;
-    a.host_end    = 0;
+extern "C" void GPUReader_freeAddress(uint32_t dev_addr){
 
-    Addrmap.push_back(a);
+  if (unifiedCPUGPUmem){
+    IS(MSG("Unmapping the GPU memory starting from address %x ", dev_addr));
+    if (!Addrmap.erase(dev_addr)){
+      IS(MSG("Address %x was not allocated!!!", dev_addr));
+    }
   }
 }
 
@@ -249,18 +250,12 @@ extern "C" void GPUReader_mapcudaMemcpy(uint32_t addr0, uint32_t addr1, uint32_t
 
     IS(MSG("Map %d bytes of memory between CPU address %x, and GPU address %x", (int)size, host_addr, dev_addr));
 
-    bool notfound = true;
-    for (uint32_t i = 0; i < Addrmap.size(); i++){
-      if ((dev_addr >= Addrmap[i].dev_start) && (dev_addr <= Addrmap[i].dev_end)){
-        notfound = false;
-        Addrmap[i].host_start = host_addr;
-        Addrmap[i].host_end   = host_addr+size;
-        I(size <= Addrmap[i].size);
-        i                     = Addrmap.size()+1;
-      }
-    }
-
-    if (notfound){
+    AddrRange *r = Addrmap.find(dev_addr);
+    if (r){
+      r->host_start = host_addr;
+      r->host_end   = host_addr+size;
+      I(size <= r->size);
+    } else {
       I(0);
       IS(MSG("ERROR!!!"));
     }
@@ -680,23 +675,17 @@ extern "C" uint32_t GPUReader_decode_trace(uint32_t * h_trace, uint32_t * qemuid
 
 }
 
-extern "C" uint64_t GPUReader_translate_d2h(AddrType addr_ptr){
+extern "C" uint64_t GPUReader_translate_d2h(AddrType addr_ptr, uint32_t smid, uint32_t warpid){
   if (unifiedCPUGPUmem){
     //Translate device address to the host address.
     uint64_t devaddr = addr_ptr;
     uint64_t hostaddr = 0;
 
-    bool notfound = true;
-    for (uint32_t i = 0; i < Addrmap.size(); i++){
-      if ((devaddr >= Addrmap[i].dev_start) && (devaddr <= Addrmap[i].dev_end)){
-        notfound = false;
-        uint32_t offset = devaddr - Addrmap[i].dev_start;
-        hostaddr = Addrmap[i].host_start + offset;
-        i = Addrmap.size()+1;
-      }
-    }
-
-    if (notfound){
+    const AddrRange *r = Addrmap.find(devaddr, smid, warpid);
+    if (r){
+      uint32_t offset = devaddr - r->dev_start;
+      hostaddr = r->host_start + offset;
+    } else {
       I(0);
       IS(MSG("Addr %llx not found!!!",addr_ptr));
     }
@@ -716,24 +705,7 @@ extern "C" uint64_t GPUReader_translate_d2h(AddrType addr_ptr){
 
 extern "C" uint64_t GPUReader_translate_shared(AddrType addr_ptr, uint32_t blockid, uint32_t warpid){
 
-  uint64_t raw_addr = addr_ptr;    //Upper 32 bits will be zero. 
-  uint16_t bid      = 0xFFFF & blockid;
-  uint8_t wid       = 0xFF & warpid;
-
-
-  /*******************************************************************
-   * The 64 bits are decoded as follows
-   * Bits 31-0  -> raw_addr
-   * Bits 47-32 -> blockid
-   * Bits 48-55 -> warpid
-   * 
-   * The upper three bits are then set to  101 to denote GPU memory
-   * ******************************************************************/
-
-  uint64_t upper = wid<<16;
-  upper          = upper | bid;
-  raw_addr       = (upper<<32) | (0x00000000FFFFFFFFULL & raw_addr);
-  raw_addr  = (0xC000000000000000ULL | raw_addr); 
+  uint64_t raw_addr = GPUAddrMap::shared(addr_ptr, blockid, warpid);
 
   //IS(MSG("Returning Addr %llx",raw_addr));
   return raw_addr;
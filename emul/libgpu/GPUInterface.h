@@ -29,6 +29,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include <string>
 #include "Instruction.h"
 #include "GPUThreadManager.h"
+#include "GPUAddrMap.h"
 
 class EmuSampler;
 
@@ -36,14 +37,6 @@ class GPUThreadManager;
 
 struct ThreadBlockStatus;
 
-struct AddrRange {
-  uint64_t dev_start;
-  uint64_t dev_end;
-  size_t size;
-  uint64_t host_start;
-  uint64_t host_end;
-};
-
 // These are all variables that will control how the traces
 // are fed to each tsfifo.
 
@@ -122,8 +115,9 @@ extern "C" {
 
 
   void GPUReader_mallocAddress(uint32_t dev_addr, uint32_t size, uint32_t* cpufid);
+  void GPUReader_freeAddress(uint32_t dev_addr);
   void GPUReader_mapcudaMemcpy(uint32_t addr0, uint32_t addr1, uint32_t size, uint32_t kind, void *env, uint32_t* cpufid);
-  uint64_t GPUReader_translate_d2h(uint64_t addr_ptr);
+  uint64_t GPUReader_translate_d2h(uint64_t addr_ptr, uint32_t smid, uint32_t warpid);
   uint64_t GPUReader_translate_shared(uint64_t addr_ptr, uint32_t blockid, uint32_t warpid);
 }
 
@@ -51,7 +51,7 @@ GStatsCntr*  GPUThreadManager::totalPTXmemAccess_Rest;
 #endif
 
 
-extern uint64_t GPUReader_translate_d2h(AddrType addr_ptr);
+extern uint64_t GPUReader_translate_d2h(AddrType addr_ptr, uint32_t smid, uint32_t warpid);
 extern uint64_t GPUReader_translate_shared(AddrType addr_ptr, uint32_t blockid, uint32_t warpid);
 extern uint32_t roundUp(uint32_t numToRound, uint32_t multiple);
 extern uint32_t roundDown(uint32_t numToRound, uint32_t multiple);
@@ -86,6 +86,10 @@ GPUThreadManager::GPUThreadManager(uint64_t numFlows, uint64_t numPEs) {
   maxSMID = 0;
   numSM = numFlows;
   numSP = numPEs;
+  if (numSP > WarpMask::MaxLanes) {
+    MSG("ERROR: GPU SMs have %llu SPs, the warp masks support up to %d", numSP, WarpMask::MaxLanes);
+    exit(-1);
+  }
   SM = new esescSM[numSM];
   GPUFlowStatus = new bool[numSM];
   SM_fid_revmap = NULL;
@@ -146,247 +150,57 @@ inline uint32_t GPUThreadManager::calcOccupancy() {
   return (i-1)*warps_per_block;
 }
 
-inline void GPUThreadManager::pauseAllThreads(uint32_t* h_trace, bool init, bool isRabbit) {
+// The instrumented kernel reads the pause word (and the skip count in rabbit
+// mode) of each thread from h_trace, so every thread gets its own words.
+inline void GPUThreadManager::setPauseRange(uint32_t* h_trace, uint64_t startRange, uint64_t endRange, uint32_t pause, bool init, bool isRabbit) {
   CUDAKernel* kernel = kernels[current_CUDA_kernel];
   traceSize = kernel->tracesize;
-  int64_t active_thread = 0;
 
-
-  if (init) {
-    if (isRabbit) {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1;     //First BB to 1
-        h_trace[active_thread*traceSize+2]=32760; //SkipInst to a big number
-        h_trace[active_thread*traceSize+4]=1;     //Pause = 1 (Pause)
-      }
-    }
-    else {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1;     //First BB to 1
-        h_trace[active_thread*traceSize+4]=1;     //Pause = 1 (Pause)
-      }
-    }
-  }
-  else {
-    if (isRabbit) {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+2]=32760; //SkipInst to a big number
-        h_trace[active_thread*traceSize+4]=1;     //Pause = 1 (Pause)
-      }
-    }
-    else {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+4]=1;     //Pause = 1 (Pause)
-      }
-    }
+  for (uint64_t active_thread = startRange; active_thread < endRange; active_thread++) {
+    uint32_t *trace = &h_trace[active_thread*traceSize];
+    if (init)
+      trace[0] = 1;     //First BB to 1
+    if (isRabbit)
+      trace[2] = 32760; //Skip Inst to a large number
+    trace[4] = pause;   //Pause = 1 (Pause), 0 (Resume)
   }
 }
 
-inline void GPUThreadManager::resumeAllThreads(uint32_t* h_trace, bool init, bool isRabbit) {
-
-  CUDAKernel* kernel = kernels[current_CUDA_kernel];
-  traceSize = kernel->tracesize;
-  int64_t active_thread = 0;
+inline void GPUThreadManager::setPauseLanes(uint32_t* h_trace, uint32_t smid, uint64_t warpid, const WarpMask &lanes, uint32_t pause, bool init, bool isRabbit) {
+  for (int32_t pe_id = lanes.next(); pe_id >= 0; pe_id = lanes.next(pe_id)) {
+    int64_t active_thread = SM[smid].threads_per_pe[pe_id][warpid];
+    I(active_thread >= 0);
+    uint32_t *trace = &h_trace[active_thread*traceSize];
+    if (init)
+      trace[0] = 1;
+    if (isRabbit)
+      trace[2] = 32760;
+    trace[4] = pause;
+  }
+}
 
+inline void GPUThreadManager::pauseAllThreads(uint32_t* h_trace, bool init, bool isRabbit) {
+  setPauseRange(h_trace, 0, numThreads, 1, init, isRabbit);
+}
 
-  if (init) {
-    if (isRabbit) {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1;     //First BB to 1
-        h_trace[active_thread*traceSize+2]=32760; //Skip Inst to a large number
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume);
-      }
-    }
-    else {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1;     //First BB to 1
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume);
-      }
-    }
-  }
-  else {
-    if (isRabbit) {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+2]=32760; //Skip Inst to a large number
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume)
-      }
-    }
-    else {
-      for (active_thread = 0; active_thread < (int64_t)numThreads; active_thread++) {
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume)
-      }
-    }
-  }
+inline void GPUThreadManager::resumeAllThreads(uint32_t* h_trace, bool init, bool isRabbit) {
+  setPauseRange(h_trace, 0, numThreads, 0, init, isRabbit);
 }
 
 inline void GPUThreadManager::pauseThreadsInRange(uint32_t* h_trace, uint64_t startRange, uint64_t endRange, bool init, bool isRabbit) {
-  CUDAKernel* kernel = kernels[current_CUDA_kernel];
-  traceSize = kernel->tracesize;
-  int64_t active_thread = 0;
-
-  if (init) {
-    if (isRabbit) {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1; //First BB to 1
-        h_trace[active_thread*traceSize+2]=32760; //Skip Inst to a large number
-        h_trace[active_thread*traceSize+4]=1; //Pause = 1 (Pause)
-      }
-    }
-    else {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1; //First BB to 1
-        h_trace[active_thread*traceSize+4]=1; //Pause = 1 (Pause)
-      }
-    }
-  }
-  else {
-    if (isRabbit) {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+2]=32760; //Skip Inst to a large number
-        h_trace[active_thread*traceSize+4]=1; //Pause = 1 (Pause)
-      }
-    }
-    else {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+4]=1; //Pause = 1 (Pause)
-      }
-    }
-  }
+  setPauseRange(h_trace, startRange, endRange, 1, init, isRabbit);
 }
 
 inline void GPUThreadManager::resumeThreadsInRange(uint32_t* h_trace, uint64_t startRange, uint64_t endRange, bool init, bool isRabbit) {
-  CUDAKernel* kernel = kernels[current_CUDA_kernel];
-  traceSize = kernel->tracesize;
-  int64_t active_thread = 0;
-  if (init) {
-    if (isRabbit) {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1;     //First BB to 1
-        h_trace[active_thread*traceSize+2]=32760; //Skip Inst to a large number
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume)
-      }
-    }
-    else  {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+0]=1;     //First BB to 1
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume)
-      }
-    }
-  }
-  else {
-    if (isRabbit) {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+2]=32760; //Skip Inst to a large number
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume)
-      }
-    }
-    else  {
-      for (active_thread = startRange; active_thread < (int64_t)endRange; active_thread++) {
-        h_trace[active_thread*traceSize+4]=0;     //Pause = 0 (Resume)
-      }
-    }
-  }
+  setPauseRange(h_trace, startRange, endRange, 0, init, isRabbit);
 }
 
 inline void GPUThreadManager::resumeSelectivethreads(uint32_t* h_trace, uint32_t smid, uint64_t warpid, bool init, bool isRabbit) {
-  int64_t active_thread = 0;
-  uint64_t maxcount = numSP;
-
-  if (maxcount > SM[smid].totalthreadsinSM) {
-    maxcount = SM[smid].totalthreadsinSM;
-  }
-
-
-  if (init) {
-    if (isRabbit) {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+0]=1;
-          h_trace[active_thread*traceSize+2]=32760;
-          h_trace[active_thread*traceSize+4]=0; //Resume
-        }
-      }
-    }
-    else {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+0]=1;
-          h_trace[active_thread*traceSize+4]=0; //Resume
-        }
-      }
-    }
-  }
-  else {
-    if (isRabbit) {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+2]=32760;
-          h_trace[active_thread*traceSize+4]=0; //Resume
-        }
-      }
-    }
-    else {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+4]=0; //Resume
-        }
-      }
-    }
-  }
-
+  setPauseLanes(h_trace, smid, warpid, SM[smid].warp_lanes[warpid], 0, init, isRabbit);
 }
 
 inline void GPUThreadManager::pauseSelectivethreads(uint32_t* h_trace, uint32_t smid, uint64_t warpid, bool init, bool isRabbit) {
-  int64_t active_thread = 0;
-  uint64_t maxcount = numSP;
-
-  if (maxcount > SM[smid].totalthreadsinSM) {
-    maxcount = SM[smid].totalthreadsinSM;
-  }
-
-  if (init) {
-    if (isRabbit) {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+0]=1;
-          h_trace[active_thread*traceSize+2]=32760;
-          h_trace[active_thread*traceSize+4]=1; //Pause
-        }
-      }
-    }
-    else {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+0]=1;
-          h_trace[active_thread*traceSize+4]=1; //Pause
-        }
-      }
-    }
-  }
-  else {
-    if (isRabbit) {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        if (likely(active_thread >= 0)) {
-          h_trace[active_thread*traceSize+2]=32760;
-          h_trace[active_thread*traceSize+4]=1; //Pause
-        }
-      }
-    }
-    else {
-      for (uint64_t pe_id = 0; pe_id < maxcount; pe_id++) {
-        active_thread = SM[smid].threads_per_pe[pe_id][warpid];
-        h_trace[active_thread*traceSize+4] = 1; //Pause
-      }
-    }
-  }
-
+  setPauseLanes(h_trace, smid, warpid, SM[smid].warp_lanes[warpid], 1, init, isRabbit);
 }
 
 
@@ -608,18 +422,19 @@ void GPUThreadManager::reOrganize() {
   }
 
 
-  int64_t active_sp_in_warp      = 0;
   for (uint32_t smid = 0; smid < numSM; smid++) {
     uint64_t warpid = 0;
+    SM[smid].warp_lanes.resize(SM[smid].warp_status.size());
     while (warpid < SM[smid].warp_status.size()) {
-      active_sp_in_warp      = 0;
+      WarpMask &lanes = SM[smid].warp_lanes[warpid];
+      lanes.clear();
       for (uint32_t peid = 0; peid < numSP; peid++) {
         if (warpid < SM[smid].threads_per_pe[peid].size() && (SM[smid].thread_status_per_pe[peid][warpid] != invalid)) {
-          active_sp_in_warp++;
+          lanes.set(peid);
         }
       }
-      //IS(MSG("There are %d active SPs in this warp", (int) active_sp_in_warp));
-      SM[smid].active_sps[warpid] = active_sp_in_warp;
+      //IS(MSG("There are %d active SPs in this warp", (int) lanes.count()));
+      SM[smid].active_sps[warpid] = lanes.count();
       warpid++;
     }
   }
@@ -774,7 +589,8 @@ bool GPUThreadManager::Rabbit(EmuSampler* gsampler, uint32_t* h_trace_qemu, void
 
         for (uint64_t warpid = SM[smid].timing_warps; warpid<SM[smid].warp_status.size() ; warpid++) {
 
-          for (uint64_t pe_id = 0; pe_id < numSP; pe_id++) {
+          const WarpMask &lanes = SM[smid].warp_lanes[warpid];
+          for (int32_t pe_id = lanes.next(); pe_id >= 0; pe_id = lanes.next(pe_id)) {
 
             // data            = pe_id;
             if (SM[smid].thread_status_per_pe[pe_id][warpid] == running) {
@@ -865,19 +681,11 @@ void GPUThreadManager::possiblyturnOFFSM(uint32_t smid) {
 }
 
 bool GPUThreadManager::switch2nextwarp(uint32_t smid, uint32_t* h_trace) {
-  int64_t active_thread;
   uint32_t warpid = SM[smid].getCurrentWarp();
 
   // MSG("Warp %u : Pausing threads in the old warp",warpid);
   // Pause all the threads in the current warp
-  for (uint32_t pe_id = 0; pe_id < numSP; pe_id++) {
-    if (warpid < SM[smid].threads_per_pe[pe_id].size()) {
-      active_thread                      = SM[smid].threads_per_pe[pe_id][warpid];
-      if (likely(active_thread >= 0)) {
-        h_trace[active_thread*traceSize+4] = 1;                                      // Pause
-      }
-    }
-  }
+  setPauseLanes(h_trace, smid, warpid, SM[smid].warp_lanes[warpid], 1, false, false);
 
   // Move to the next warp whose status is not warp_complete or warp_done.
   bool warpfound          = false;
@@ -1001,18 +809,14 @@ bool GPUThreadManager::switch2nextwarp(uint32_t smid, uint32_t* h_trace) {
   // Resume all the threads in the new warp
   newwarpid = SM[smid].getCurrentWarp();
   //MSG("Warp %d : SM[%d]: Unpausing threads in new Warp %d", (int) warpid, (int)smid, (int)newwarpid);
-  for (uint32_t pe_id = 0; pe_id < numSP; pe_id++) {
-    if (newwarpid < SM[smid].threads_per_pe[pe_id].size()) {
-      active_thread = SM[smid].threads_per_pe[pe_id][newwarpid];
-      if (likely(active_thread >= 0)) {
-        if (SM[smid].thread_status_per_pe[pe_id][newwarpid] != paused_on_a_barrier){
-          h_trace[active_thread*traceSize+4]=0; //Resume
-        } else {
-          MSG("New Warp %u : thread %lld is a barrier thread, not unpausing it",newwarpid, active_thread );
-        }
-      }
+  WarpMask resume = SM[smid].warp_lanes[newwarpid];
+  for (int32_t pe_id = resume.next(); pe_id >= 0; pe_id = resume.next(pe_id)) {
+    if (SM[smid].thread_status_per_pe[pe_id][newwarpid] == paused_on_a_barrier){
+      MSG("New Warp %u : thread %lld is a barrier thread, not unpausing it",newwarpid, SM[smid].threads_per_pe[pe_id][newwarpid]);
+      resume.reset(pe_id);
     }
   }
+  setPauseLanes(h_trace, smid, newwarpid, resume, 0, false, false);
 
   return true;
 }
@@ -1078,16 +882,7 @@ void GPUThreadManager::reset_nextTimingBB(uint32_t* h_trace) {
     else {
       if (SM[smid].totalthreadsinSM > 0) {
         uint32_t warpid = SM[smid].getCurrentWarp();
-        for (uint32_t pe_id = 0; pe_id < numSP; pe_id++) {
-          if (warpid < SM[smid].threads_per_pe[pe_id].size()) {
-            if ((SM[smid].thread_status_per_pe[pe_id][warpid] != execution_done) &&
-                (SM[smid].thread_status_per_pe[pe_id][warpid] != invalid)) {
-              SM[smid].thread_status_per_pe[pe_id][warpid]      = running;
-              SM[smid].thread_instoffset_per_pe[pe_id][warpid]  = 0;
-              SM[smid].thread_traceoffset_per_pe[pe_id][warpid] = 0;
-            }
-          }
-        }
+        SM[smid].restartWarp(warpid, true);
         SM[smid].warp_status[warpid] = traceReady;
         SM[smid].warp_last_active_pe[warpid] = 0;
 
@@ -1121,31 +916,21 @@ void GPUThreadManager::reset_nextRabbitBB(uint32_t* h_trace) {
         GPUFlowStatus[smid] = false;
       }
 
-      for (uint64_t pe_id = 0; pe_id < numSP; pe_id++) {
-        //Pause the timing
-        for (uint64_t warpid = 0; warpid < SM[smid].timing_warps; warpid++) {
-          if (warpid < SM[smid].threads_per_pe[pe_id].size()) {
-            if (likely(SM[smid].thread_status_per_pe[pe_id][warpid] != invalid)) {
-              SM[smid].thread_instoffset_per_pe[pe_id][warpid] = 0;
-              SM[smid].thread_traceoffset_per_pe[pe_id][warpid] = 0;
-              SM[smid].thread_status_per_pe[pe_id][warpid] = running;
-              h_trace[(SM[smid].threads_per_pe[pe_id][warpid])*traceSize+4] = 1; // pause
-            }
-          }
-        }
+      //Pause the timing
+      for (uint64_t warpid = 0; warpid < SM[smid].timing_warps && warpid < SM[smid].warp_lanes.size(); warpid++) {
+        SM[smid].restartWarp(warpid, false);
+        setPauseLanes(h_trace, smid, warpid, SM[smid].warp_lanes[warpid], 1, false, false);
+      }
 
-        //Unpause the rabbit
-        for (uint64_t warpid = SM[smid].timing_warps; warpid < SM[smid].warp_status.size(); warpid++) {
-          if (warpid < SM[smid].threads_per_pe[pe_id].size()) {
-            if (likely(SM[smid].thread_status_per_pe[pe_id][warpid] != invalid)) {
-              SM[smid].thread_instoffset_per_pe[pe_id][warpid] = 0; //Doesn't really matter
-              SM[smid].thread_traceoffset_per_pe[pe_id][warpid] = 0; //Doesn't really matter
-              SM[smid].thread_status_per_pe[pe_id][warpid] = running;
-              h_trace[(SM[smid].threads_per_pe[pe_id][warpid])*traceSize+4] = 0; // Unpause
-              h_trace[(SM[smid].threads_per_pe[pe_id][warpid])*traceSize+2] = 32767 ; // Runahead (this is a large number for a single thread)
-              h_trace[(SM[smid].threads_per_pe[pe_id][warpid])*traceSize+9] = 0 ; // Runahead (this is a large number for a single thread)
-            }
-          }
+      //Unpause the rabbit
+      for (uint64_t warpid = SM[smid].timing_warps; warpid < SM[smid].warp_status.size(); warpid++) {
+        const WarpMask &lanes = SM[smid].warp_lanes[warpid];
+        SM[smid].restartWarp(warpid, false); //Offsets do not really matter
+        for (int32_t pe_id = lanes.next(); pe_id >= 0; pe_id = lanes.next(pe_id)) {
+          int64_t active_thread = SM[smid].threads_per_pe[pe_id][warpid];
+          h_trace[active_thread*traceSize+4] = 0 ;     // Unpause
+          h_trace[active_thread*traceSize+2] = 32767 ; // Runahead (this is a large number for a single thread)
+          h_trace[active_thread*traceSize+9] = 0 ;
         }
       }
       //SM[smid].warpchange = false;
@@ -1166,22 +951,15 @@ void GPUThreadManager::reset_nextkernel() {
       SM[smid].rabbitthreadsComplete = 0;
       SM[smid].resetCurrentWarp();
 
-      uint64_t warpid = SM[smid].getCurrentWarp();
-      ///*
-      for (uint64_t pe_id = 0; pe_id < numSP; pe_id++) {
-        for (warpid = 0; warpid<SM[smid].warp_status.size(); warpid++) {
-          if (likely(SM[smid].thread_status_per_pe[pe_id][warpid] != invalid)) {
-            SM[smid].warp_status.at(warpid) = traceReady;
-            SM[smid].warp_last_active_pe.at(warpid) = 0;
-            SM[smid].warp_complete.at(warpid) = 0;
-            SM[smid].warp_blocked.at(warpid) = 0;
-            SM[smid].thread_instoffset_per_pe[pe_id][warpid] = 0;
-            SM[smid].thread_traceoffset_per_pe[pe_id][warpid] = 0;
-            SM[smid].thread_status_per_pe[pe_id][warpid] = running;
-          }
+      for (uint64_t warpid = 0; warpid<SM[smid].warp_status.size(); warpid++) {
+        if (likely(SM[smid].warp_lanes[warpid].any())) {
+          SM[smid].warp_status.at(warpid) = traceReady;
+          SM[smid].warp_last_active_pe.at(warpid) = 0;
+          SM[smid].warp_complete.at(warpid) = 0;
+          SM[smid].warp_blocked.at(warpid) = 0;
+          SM[smid].restartWarp(warpid, false);
         }
       }
-      //*/
       //SM[smid].warpchange = false;
       //SM[smid].warprollover = false;
       SM[smid].cycledthru_currentwarpset = false;
@@ -36,6 +36,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "CUDAInstruction.h"
 #include "EmuSampler.h"
 #include "GStats.h"
+#include "WarpMask.h"
 
 #include <iostream>
 using std::cerr;
@@ -140,7 +141,7 @@ class ThreadBlockStatus {
 
 struct divergence_data {
     std::set<uint32_t> divergent_bbs;
-    std::multimap<uint32_t,uint64_t> bb_mapped_threads;
+    std::map<uint32_t,WarpMask> bb_mapped_lanes;
 };
 
 class esescSM {
@@ -165,6 +166,7 @@ class esescSM {
     std::vector < uint32_t >        warp_blocked;
     std::vector < uint32_t >        warp_block_map;
     std::vector < uint32_t >        warp_threadcount;
+    std::vector < WarpMask >        warp_lanes;       // PEs with a thread in each warp
     // Divergence related
     std::vector < divergence_data > warp_divergence;
     std::vector < uint32_t >        unmasked_bb;
@@ -259,6 +261,24 @@ class esescSM {
       return numSP;
     }
 
+    void setWarpStatus(uint64_t warpid, ThreadStatus st) {
+      const WarpMask &lanes = warp_lanes[warpid];
+      for (int32_t pe_id = lanes.next(); pe_id >= 0; pe_id = lanes.next(pe_id))
+        thread_status_per_pe[pe_id][warpid] = st;
+    }
+
+    // Back to running from the start of the BB (except the finished threads)
+    void restartWarp(uint64_t warpid, bool keepDone) {
+      const WarpMask &lanes = warp_lanes[warpid];
+      for (int32_t pe_id = lanes.next(); pe_id >= 0; pe_id = lanes.next(pe_id)) {
+        if (keepDone && thread_status_per_pe[pe_id][warpid] == execution_done)
+          continue;
+        thread_status_per_pe[pe_id][warpid]      = running;
+        thread_instoffset_per_pe[pe_id][warpid]  = 0;
+        thread_traceoffset_per_pe[pe_id][warpid] = 0;
+      }
+    }
+
     void dump(){
       uint64_t warp_id = 0; 
       while (warp_id < warp_status.size()) {
@@ -425,6 +445,12 @@ class esescSM {
       active_sps.clear();
       warp_complete.clear();
       warp_blocked.clear();
+      warp_threadcount.clear();
+      warp_lanes.clear();
+
+      warp_divergence.clear();
+      unmasked_bb.clear();
+      divergence_data_valid.clear();
 
       totalthreadsinSM      = 0;
       rabbitthreadsComplete = 0;
@@ -501,6 +527,9 @@ class GPUThreadManager {
 
     uint64_t maxSMID;
     uint32_t number_ffinst_perThread;
+
+    void setPauseRange(uint32_t* h_trace, uint64_t startRange, uint64_t endRange, uint32_t pause, bool init, bool isRabbit);
+    void setPauseLanes(uint32_t* h_trace, uint32_t smid, uint64_t warpid, const WarpMask &lanes, uint32_t pause, bool init, bool isRabbit);
 #if TRACKGPU_MEMADDR
     ofstream memdata;
 #endif
@@ -606,7 +635,7 @@ class GPUThreadManager {
     //Divergence related functions
     void printDivergentList(uint64_t smid, uint64_t warpid, uint32_t bbid);
     bool switch2nextDivergentBB(uint64_t smid, uint64_t warpid);
-    void removeFromDivergentList(uint64_t smid, uint64_t warpid, uint32_t bbid, uint64_t active_thread);
+    void removeFromDivergentList(uint64_t smid, uint64_t warpid, uint32_t bbid, uint32_t pe_id);
 
    // Decode a h_trace before a kernel launch
     bool decode_trace(EmuSampler * gsampler, uint32_t * h_trace, void *env, uint32_t* qemuid);
@@ -26,7 +26,7 @@ extern   GStatsCntr*  totalPTXmemAccess_Rest;
 #endif
 
 
-extern uint64_t GPUReader_translate_d2h(AddrType addr_ptr);
+extern uint64_t GPUReader_translate_d2h(AddrType addr_ptr, uint32_t smid, uint32_t warpid);
 extern uint64_t GPUReader_translate_shared(AddrType addr_ptr, uint32_t blockid, uint32_t warpid);
 extern uint32_t roundUp(uint32_t numToRound, uint32_t multiple);
 extern uint32_t roundDown(uint32_t numToRound, uint32_t multiple);
@@ -110,11 +110,7 @@ bool GPUThreadManager::Timing_serial_branchdiv(EmuSampler* gsampler, uint32_t* h
               SM[smid].warp_status[localwid]         = relaunchReady;
               SM[smid].warp_last_active_pe[localwid] = 0;
               SM[smid].warp_blocked[localwid]        = 0;
-              for (uint32_t spid = 0; spid < numSP; spid++) {
-                if ((localwid < SM[smid].threads_per_pe[spid].size()) && (SM[smid].thread_status_per_pe[spid][localwid] != invalid)) {
-                  SM[smid].thread_status_per_pe[spid][localwid] = block_done;
-                }
-              }
+              SM[smid].setWarpStatus(localwid, block_done);
             }
             SM[smid].warp_status[warpid]      = relaunchReady;
             SM[smid].warp_blocked[warpid]     = 0;
@@ -179,14 +175,15 @@ bool GPUThreadManager::Timing_serial_branchdiv(EmuSampler* gsampler, uint32_t* h
                   }
 
                   SM[smid].warp_divergence[warpid].divergent_bbs.clear();
-                  SM[smid].warp_divergence[warpid].bb_mapped_threads.clear();
-                  for (int32_t l_pe_id = 0; (l_pe_id < (int32_t)numSP); l_pe_id++) {
+                  SM[smid].warp_divergence[warpid].bb_mapped_lanes.clear();
+                  const WarpMask &lanes = SM[smid].warp_lanes[warpid];
+                  for (int32_t l_pe_id = lanes.next(); l_pe_id >= 0; l_pe_id = lanes.next(l_pe_id)) {
                     uint64_t l_active_thread        = SM[smid].threads_per_pe[l_pe_id][warpid];
                     uint32_t l_currentbb = h_trace_qemu[(l_active_thread*traceSize)+1];
                     uint32_t l_pausedbb = h_trace_qemu[(l_active_thread*traceSize)+4];
                     if (l_pausedbb != 1) {
                       SM[smid].warp_divergence[warpid].divergent_bbs.insert(l_currentbb);
-                      SM[smid].warp_divergence[warpid].bb_mapped_threads.insert(std::pair<uint32_t,uint64_t>(l_currentbb,l_active_thread));
+                      SM[smid].warp_divergence[warpid].bb_mapped_lanes[l_currentbb].set(l_pe_id);
                     } else {
                       //MSG ("Warp %llu : Ignoring thread %llu which goes to paused basic block %d", warpid, l_active_thread, l_currentbb);
                     }
@@ -259,19 +256,15 @@ bool GPUThreadManager::Timing_serial_branchdiv(EmuSampler* gsampler, uint32_t* h
                             SM[smid].warp_status[localwid]         = relaunchReady;
                             SM[smid].warp_last_active_pe[localwid] = 0;
                             SM[smid].warp_blocked[localwid]        = 0;
-                            for (uint32_t spid = 0; spid < numSP; spid++) {
-                              if ((localwid < SM[smid].threads_per_pe[spid].size()) && (SM[smid].thread_status_per_pe[spid][localwid] != invalid)) {
-                                SM[smid].thread_status_per_pe[spid][localwid] = block_done;
-                              }
-                            }
+                            SM[smid].setWarpStatus(localwid, block_done);
                           }
                           // MSG(" ");
                           SM[smid].warp_blocked[warpid] = blockSize;
                         }
 
                         //Since this thread has reached the barrier, we remove this thread from the divergent list.
-                        removeFromDivergentList(smid,warpid,trace_currentbbid,active_thread);
-                        if (SM[smid].warp_divergence[warpid].bb_mapped_threads.count(trace_currentbbid) == 0) {
+                        removeFromDivergentList(smid,warpid,trace_currentbbid,pe_id);
+                        if (!SM[smid].warp_divergence[warpid].bb_mapped_lanes[trace_currentbbid].any()) {
                           if (switch2nextDivergentBB(smid, warpid) == true){
                             SM[smid].unmasked_bb[warpid] = *(SM[smid].warp_divergence[warpid].divergent_bbs.begin());
                             MSG("Warp %llu : Switched to another BB from this barrier BB", warpid);
@@ -349,7 +342,7 @@ bool GPUThreadManager::Timing_serial_branchdiv(EmuSampler* gsampler, uint32_t* h
                                 MSG("Store Basic Block %d Inst %d traceoffset = %d", trace_currentbbid, instoffset, traceoffset);
                                 }
                                 */
-                              addr = GPUReader_translate_d2h(addr);
+                              addr = GPUReader_translate_d2h(addr, smid, warpid);
                               //if ((active_thread == 0) || (active_thread == 1)) {
   #if TRACKGPU_MEMADDR
                               int acctype = 0;
@@ -440,8 +433,8 @@ bool GPUThreadManager::Timing_serial_branchdiv(EmuSampler* gsampler, uint32_t* h
                               if (SM[smid].thread_instoffset_per_pe[pe_id][warpid] >= (int32_t) numbbinst) {
                                 threads_in_current_warp_done++;
 
-                                removeFromDivergentList(smid,warpid,trace_currentbbid,active_thread);
-                                if (SM[smid].warp_divergence[warpid].bb_mapped_threads.count(trace_currentbbid) == 0) {
+                                removeFromDivergentList(smid,warpid,trace_currentbbid,pe_id);
+                                if (!SM[smid].warp_divergence[warpid].bb_mapped_lanes[trace_currentbbid].any()) {
                                   if (switch2nextDivergentBB(smid, warpid) == true){
                                     SM[smid].unmasked_bb[warpid] = *(SM[smid].warp_divergence[warpid].divergent_bbs.begin());
                                   } else {
@@ -669,26 +662,18 @@ bool GPUThreadManager::Timing_serial_branchdiv(EmuSampler* gsampler, uint32_t* h
   }
 }
 
-void GPUThreadManager::removeFromDivergentList(uint64_t smid, uint64_t warpid, uint32_t bbid, uint64_t active_thread){
-  typedef multimap<uint32_t, uint64_t>::iterator iter;
-
-  //Remove from the map
-  std::pair<iter, iter> iterpair = SM[smid].warp_divergence[warpid].bb_mapped_threads.equal_range(bbid);
-  for (iter local_it = iterpair.first; local_it != iterpair.second; ++local_it) {
-    if (local_it->second == active_thread) {
-      SM[smid].warp_divergence[warpid].bb_mapped_threads.erase(local_it);
-      break;
-    }
-  }
+void GPUThreadManager::removeFromDivergentList(uint64_t smid, uint64_t warpid, uint32_t bbid, uint32_t pe_id){
+  std::map<uint32_t, WarpMask>::iterator it = SM[smid].warp_divergence[warpid].bb_mapped_lanes.find(bbid);
+  if (it != SM[smid].warp_divergence[warpid].bb_mapped_lanes.end())
+    it->second.reset(pe_id);
 }
 
 void GPUThreadManager::printDivergentList(uint64_t smid, uint64_t warpid, uint32_t bbid){
-  fprintf(stderr,"Warp %llu : SM[%llu] contains BB %d (%d elems) : ",warpid,smid,bbid, SM[smid].warp_divergence[warpid].bb_mapped_threads.count(bbid));
+  const WarpMask &lanes = SM[smid].warp_divergence[warpid].bb_mapped_lanes[bbid];
+  fprintf(stderr,"Warp %llu : SM[%llu] contains BB %d (%d elems) : ",warpid,smid,bbid, lanes.count());
 
-  typedef multimap<uint32_t, uint64_t>::iterator iter;
-  std::pair<iter, iter> iterpair = SM[smid].warp_divergence[warpid].bb_mapped_threads.equal_range(bbid);
-  for (iter it=iterpair.first; it!=iterpair.second; ++it){
-    fprintf(stderr," %llu",it->second);
+  for (int32_t pe_id = lanes.next(); pe_id >= 0; pe_id = lanes.next(pe_id)){
+    fprintf(stderr," %lld",SM[smid].threads_per_pe[pe_id][warpid]);
   }
   fprintf(stderr,"\n");
 }
@@ -0,0 +1,103 @@
+/*
+ESESC: Super ESCalar simulator
+Copyright (C) 2006 University California, Santa Cruz.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef WARP_MASK_H
+#define WARP_MASK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nanassert.h"
+
+// One bit per lane (PE) of a warp. The size is fixed so that the masks can
+// live in plain vectors and the bulk operations are a few word ops (256 bits,
+// a single vector register with AVX2).
+class WarpMask {
+public:
+  enum { MaxLanes = 256, nWords = MaxLanes/64 };
+
+private:
+  uint64_t w[nWords];
+
+public:
+  WarpMask() { clear(); }
+
+  void clear() { memset(w, 0, sizeof(w)); }
+
+  void set(uint32_t lane) {
+    I(lane < MaxLanes);
+    w[lane >> 6] |= 1ULL << (lane & 63);
+  }
+  void reset(uint32_t lane) {
+    I(lane < MaxLanes);
+    w[lane >> 6] &= ~(1ULL << (lane & 63));
+  }
+  bool test(uint32_t lane) const {
+    I(lane < MaxLanes);
+    return (w[lane >> 6] >> (lane & 63)) & 1;
+  }
+
+  bool any() const {
+    uint64_t o = 0;
+    for (int i = 0; i < nWords; i++)
+      o |= w[i];
+    return o != 0;
+  }
+
+  uint32_t count() const {
+    uint32_t n = 0;
+    for (int i = 0; i < nWords; i++)
+      n += __builtin_popcountll(w[i]);
+    return n;
+  }
+
+  // First lane set after lane (-1 starts from lane 0). Returns -1 if none.
+  //   for (int32_t pe = m.next(); pe >= 0; pe = m.next(pe))
+  int32_t next(int32_t lane = -1) const {
+    int32_t i = (lane + 1) >> 6;
+    if (i >= nWords)
+      return -1;
+    uint64_t bits = w[i] & (~0ULL << ((lane + 1) & 63));
+    while (bits == 0) {
+      if (++i >= nWords)
+        return -1;
+      bits = w[i];
+    }
+    return (i << 6) + __builtin_ctzll(bits);
+  }
+
+  WarpMask &operator&=(const WarpMask &m) {
+    for (int i = 0; i < nWords; i++)
+      w[i] &= m.w[i];
+    return *this;
+  }
+  WarpMask &operator|=(const WarpMask &m) {
+    for (int i = 0; i < nWords; i++)
+      w[i] |= m.w[i];
+    return *this;
+  }
+  // this &= ~m
+  WarpMask &andNot(const WarpMask &m) {
+    for (int i = 0; i < nWords; i++)
+      w[i] &= ~m.w[i];
+    return *this;
+  }
+};
+
+#endif
@@ -29,6 +29,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "QEMUInterface.h"
 #include "QEMUReader.h"
 #include "EmuSampler.h"
+#include "QEMUTrace.h"
 
 EmuSampler *qsamplerlist[128];
 //EmuSampler *qsampler = 0;
@@ -78,11 +79,15 @@ extern "C" uint64_t QEMUReader_get_time()
 
 extern "C" void QEMUReader_queue_inst(uint32_t insn, uint32_t pc, uint32_t addr, uint32_t fid, char op, uint64_t icount, void *env) 
 {
+  if (QEMUTrace::isRecording())
+    QEMUTrace::recordInst(insn, pc, addr, fid, op, icount);
   qsamplerlist[fid]->queue(insn,pc,addr,fid,op,icount,env);
 }
 
 extern "C" void QEMUReader_finish(uint32_t fid)
 {
+  if (QEMUTrace::isRecording())
+    QEMUTrace::recordFinish(fid, false);
   qsamplerlist[fid]->stop();
   qsamplerlist[fid]->pauseThread(fid);
   qsamplerlist[fid]->terminate();
@@ -91,12 +96,16 @@ extern "C" void QEMUReader_finish(uint32_t fid)
 
 extern "C" void QEMUReader_finish_thread(uint32_t fid)
 {
+  if (QEMUTrace::isRecording())
+    QEMUTrace::recordFinish(fid, true);
   qsamplerlist[fid]->stop();
   qsamplerlist[fid]->pauseThread(fid);
 }
 
 extern "C" void QEMUReader_syscall(uint32_t num, uint64_t usecs, uint32_t fid)
 {
+  if (QEMUTrace::isRecording())
+    QEMUTrace::recordSyscall(num, usecs, fid);
   qsamplerlist[fid]->syscall(num, usecs, fid);
 }
 
@@ -109,9 +118,14 @@ extern "C" FlowID QEMUReader_resumeThread(FlowID uid, FlowID last_fid) {
 
   uint32_t fid = qsamplerlist[0]->getFid(last_fid); 
   MSG("resume %d -> %d",last_fid,fid);
-  return(qsamplerlist[fid]->resumeThread(uid, fid));
+  fid = qsamplerlist[fid]->resumeThread(uid, fid);
+  if (QEMUTrace::isRecording())
+    QEMUTrace::recordResume(uid, last_fid, fid);
+  return fid;
 }
 extern "C" void QEMUReader_pauseThread(FlowID fid) {
+  if (QEMUTrace::isRecording())
+    QEMUTrace::recordPause(fid);
   qsamplerlist[fid]->pauseThread(fid);
 }
 
@@ -43,6 +43,7 @@
 #include "callback.h"
 #include "DInst.h"
 #include "QEMUInterface.h"
+#include "QEMUTrace.h"
 
 /* }}} */
 
@@ -90,9 +91,35 @@ QEMUReader::QEMUReader(QEMUArgs *qargs, const char *section, EmulInterface *eint
   crackInstARM = new ARMCrack[numAllFlows];
   crackInstThumb = new ThumbCrack[numAllFlows];
   crackInst.resize(numAllFlows);
+
+  uint32_t uopCacheSize = 4096;
+  if (SescConf->checkInt(section,"uopCacheSize"))
+    uopCacheSize = SescConf->getInt(section,"uopCacheSize");
+  if (uopCacheSize) {
+    if (uopCacheSize < CrackCache::Ways || (uopCacheSize & (uopCacheSize-1))) {
+      MSG("ERROR: section [%s] uopCacheSize must be a power of two (at least %d) or 0", section, CrackCache::Ways);
+      SescConf->notCorrect();
+    }else{
+      // Cached uops are reused once the tsfifo has been drained past them
+      for(FlowID i=0;i<numAllFlows;i++)
+        uopCache.push_back(new CrackCache(uopCacheSize, SPSCFIFO<RAWDInst>::Capacity));
+    }
+  }
 #endif
   qemu_thread = -1;
   //started = false;
+
+  replayFile = 0;
+  if (SescConf->checkCharPtr(section,"traceReplay"))
+    replayFile = SescConf->getCharPtr(section,"traceReplay");
+  if (SescConf->checkCharPtr(section,"traceRecord")) {
+    if (replayFile) {
+      MSG("ERROR: section [%s] can not have both traceRecord and traceReplay", section);
+      SescConf->notCorrect();
+    }else{
+      QEMUTrace::openRecord(SescConf->getCharPtr(section,"traceRecord"));
+    }
+  }
 }
 /* }}} */
 
@@ -105,6 +132,12 @@ void QEMUReader::start()
 
   started = true;
 
+  if (replayFile) {
+    // The trace replaces QEMU, no emulation
+    QEMUTrace::startReplay(replayFile);
+    return;
+  }
+
 #if 1
   MSG ("STARTING QEMU ......");
   pthread_attr_t attr;
@@ -139,6 +172,10 @@ void QEMUReader::start()
 
 QEMUReader::~QEMUReader() {
   /* destructor {{{1 */
+#ifdef ESESC_QEMU_ISA_ARMEL
+  for(size_t i=0;i<uopCache.size();i++)
+    delete uopCache[i];
+#endif
 #if 0
   MSG("Killing group %d",getpgid(0));
   kill(-getpgid(0), SIGKILL);
@@ -149,27 +186,20 @@ QEMUReader::~QEMUReader() {
 void QEMUReader::queueInstruction(uint32_t insn, AddrType pc, AddrType addr, char thumb, FlowID fid, void * env, bool keepStats)
 /* queue instruction (called by QEMU) {{{1 */
 {
-  uint64_t conta=0;
-
-  if (tsfifo[fid].full()) {
+  if (!tsfifo[fid].canPush()) {
      
-    //release lock
-    QEMUReader_goto_sleep(env);
+    //release lock (no env when replaying a trace)
+    if (env)
+      QEMUReader_goto_sleep(env);
     // MSG("tsfifo full, goto sleep fid %d", fid);
-  
-    while(tsfifo[fid].full()) {
-      // Good for 65K buffer struct timespec ts = {0,10000};
-      //pthread_yield();
-      conta++;
-      if (conta> 100000) {
-        struct timespec ts = {0,100000};
-        nanosleep(&ts, 0);
-        conta = 0;
-      }
-    }
+
+    // Parks until the timing side drains some entries
+    emulStall[fid]->add(tsfifo[fid].waitNotFull());
+    nEmulStall[fid]->inc();
 
     // accuire lock again
-    QEMUReader_wakeup_from_sleep(env);
+    if (env)
+      QEMUReader_wakeup_from_sleep(env);
     // MSG("tsfifo not full anymore, wakeup from sleep fid %d", fid);
   }
 
@@ -186,6 +216,18 @@ void QEMUReader::queueInstruction(uint32_t insn, AddrType pc, AddrType addr, cha
     crackInst[fid] = &crackInstARM[fid];
   }
 
+  // Thumb instructions in (or starting) an IT block decode with the IT state
+  bool cacheable = !uopCache.empty() && !(thumb && crackInstThumb[fid].isInIT());
+  if (cacheable && uopCache[fid]->lookup(rinst, thumb ? 1 : 0)) {
+    uopCacheHit[fid]->inc(keepStats);
+  }else{
+    crackInst[fid]->expand(rinst); // [sizhuo] crack raw inst to uOPs
+    if (cacheable && !(thumb && crackInstThumb[fid].isInIT())) {
+      uopCacheMiss[fid]->inc(keepStats);
+      uopCache[fid]->insert(rinst, thumb ? 1 : 0);
+    }
+  }
+
 #if 0
   if (crackInst[fid]->isInIT()) {
     AddrType epc = crackInst[fid]->getCurrentDecodePC();
@@ -202,9 +244,6 @@ void QEMUReader::queueInstruction(uint32_t insn, AddrType pc, AddrType addr, cha
   }
 #endif
 
-  crackInst[fid]->expand(rinst); // [sizhuo] crack raw inst to uOPs
-  
- 
 #if 0
   static int sample=0;
   sample++;
@@ -264,7 +303,11 @@ if ((rinst->getPC() == 0xdeaddead) || (rinst->getPC() == 0xdeaddeb1)){
   //rawInst[fid]->add(1);
   rawInst[fid]->inc(keepStats);
 
-  tsfifo[fid].push();
+#ifdef ESESC_QEMU_ISA_ARMEL
+  if (!uopCache.empty())
+    uopCache[fid]->pushed();
+#endif
+  tsfifo[fid].pushBatch();
  }
 /* }}} */
 
@@ -298,17 +341,13 @@ void QEMUReader::syscall(uint32_t num, Time_t time, FlowID fid)
 uint32_t QEMUReader::wait_until_FIFO_full(FlowID fid)
 {
   while(!tsfifo[fid].full()) {
-    pthread_yield();
     if (qsamplerlist[fid]->isActive(fid) == false)
       return 0;
-    if (!tsfifo[fid].full()) {
-      pthread_yield();
-      //qsampler->pauseThread(fid); // Too slow, get it out for until the FIFO is full
-      // Very infrequent situation unless it is time to power down
-      if (tsfifo[fid].empty()){
-        return 0;
-      }
-    }
+    // Very infrequent situation unless it is time to power down
+    if (tsfifo[fid].empty())
+      return 0;
+    timingStall[fid]->add(tsfifo[fid].waitFull());
+    nTimingStall[fid]->inc();
   }
   return 1;
 }
@@ -325,17 +364,11 @@ DInst *QEMUReader::executeHead(FlowID fid)
 
   if (ruffer[fid].empty()) {
     while(!tsfifo[fid].full()) {
-      pthread_yield();
       if (qsamplerlist[fid]->isActive(fid) == false)
         return 0;
-      if (tsfifo[fid].empty()) {
-        pthread_yield();
-        //qsampler->pauseThread(fid); // Too slow, get it out for until the FIFO is full
-        // Very infrequent situation unless it is time to power down
-        if (tsfifo[fid].empty()){
-          //return 0;
-        }
-      }
+      // Parks until QEMU fills the FIFO (timeout to re-check isActive)
+      timingStall[fid]->add(tsfifo[fid].waitFull());
+      nTimingStall[fid]->inc();
     }
 
     I(tsfifo[fid].full());
@@ -36,10 +36,10 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "FastQueue.h"
 
 #include "QEMUInterface.h"
-#include "ThreadSafeFIFO.h"
 #include "CrackBase.h"
 #include "ARMCrack.h"
 #include "ThumbCrack.h"
+#include "CrackCache.h"
 
 
 
@@ -52,6 +52,7 @@ private:
   ARMCrack    *crackInstARM;
   ThumbCrack  *crackInstThumb;
   std::vector<CrackBase *>   crackInst;
+  std::vector<CrackCache *>  uopCache; // per flow, empty if uopCacheSize is 0
 #endif
 
   pthread_t         qemu_thread;
@@ -60,6 +61,7 @@ private:
   static bool       started;
   QEMUArgs         *qemuargs;
   EmulInterface    *eint;
+  const char       *replayFile; // traceReplay: feed the samplers from a trace instead of QEMU
 
 public:
 	static void setStarted() {
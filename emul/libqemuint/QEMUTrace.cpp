@@ -0,0 +1,618 @@
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "Snippets.h"
+#include "QEMUTrace.h"
+
+extern "C" void QEMUReader_queue_inst(uint32_t insn, uint32_t pc, uint32_t addr, uint32_t fid, char op, uint64_t icount, void *env);
+extern "C" void QEMUReader_syscall(uint32_t num, uint64_t usecs, uint32_t fid);
+extern "C" void QEMUReader_finish(uint32_t fid);
+extern "C" void QEMUReader_finish_thread(uint32_t fid);
+extern "C" FlowID QEMUReader_resumeThread(FlowID uid, FlowID last_fid);
+extern "C" void QEMUReader_pauseThread(FlowID fid);
+
+// File layout: FileHeader, then blocks (BlockHeader + payload), host endian
+static const char TraceMagic[8] = { 'E','S','E','S','C','T','R','C' };
+
+struct FileHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t blockSize;
+  uint32_t flags;     // FileFlags
+};
+
+struct BlockHeader {
+  uint32_t stream;
+  uint32_t nEvents;
+  uint32_t rawSize;
+  uint32_t storedSize; // == rawSize when stored uncompressed
+};
+
+// Event header flags (low 3 bits are the EventType)
+enum {
+  F_SameFid  = 0x08,
+  F_InsnHit  = 0x10,
+  F_NoAddr   = 0x20,
+  F_Icount1  = 0x40
+};
+
+FILE                                *QEMUTrace::recFile = 0;
+bool                                 QEMUTrace::recOpen = false;
+bool                                 QEMUTrace::recOn   = false;
+pthread_mutex_t                      QEMUTrace::recLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t                       QEMUTrace::recFlushed = PTHREAD_COND_INITIALIZER;
+std::vector<QEMUTrace::RecStream *>  QEMUTrace::recStreams;
+__thread QEMUTrace::RecStream       *QEMUTrace::myStream = 0;
+volatile uint32_t                    QEMUTrace::recSeq = 0;
+uint64_t                             QEMUTrace::recEvents = 0;
+uint64_t                             QEMUTrace::recBytes  = 0;
+
+const uint8_t                       *QEMUTrace::playMap = 0;
+size_t                               QEMUTrace::playSize = 0;
+std::vector<QEMUTrace::PlayStream *> QEMUTrace::playStreams;
+pthread_mutex_t                      QEMUTrace::playLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t                       QEMUTrace::playSeqDone = PTHREAD_COND_INITIALIZER;
+std::vector<FlowID>                  QEMUTrace::playFidMap;
+volatile uint32_t                    QEMUTrace::playMapGen = 0;
+volatile uint32_t                    QEMUTrace::playSeq = 0;
+volatile uint32_t                    QEMUTrace::playRunning = 0;
+volatile bool                        QEMUTrace::playFinished = false;
+
+static inline uint8_t *putVar(uint8_t *p, uint64_t v) {
+  while(v >= 0x80) {
+    *p++ = static_cast<uint8_t>(v) | 0x80;
+    v >>= 7;
+  }
+  *p++ = static_cast<uint8_t>(v);
+  return p;
+}
+
+static inline const uint8_t *getVar(const uint8_t *p, uint64_t *v) {
+  uint64_t r = 0;
+  int shift  = 0;
+  while(*p & 0x80) {
+    r |= static_cast<uint64_t>(*p++ & 0x7F) << shift;
+    shift += 7;
+  }
+  r |= static_cast<uint64_t>(*p++) << shift;
+  *v = r;
+  return p;
+}
+
+static inline uint32_t zigzag(uint32_t delta) {
+  int32_t d = static_cast<int32_t>(delta);
+  return (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t v) {
+  return (v >> 1) ^ (0 - (v & 1));
+}
+
+static inline uint32_t insnIndex(uint32_t pc) {
+  return (pc >> 1) & 4095;
+}
+
+void QEMUTrace::Coder::reset() {
+  lastPc   = 0;
+  lastAddr = 0;
+  lastFid  = 0;
+  memset(cachePc, 0xFF, sizeof(cachePc));
+  memset(cacheInsn, 0, sizeof(cacheInsn));
+}
+
+/* Record {{{1 */
+
+void QEMUTrace::openRecord(const char *fname) {
+  I(recFile == 0);
+
+  recFile = fopen(fname, "wb");
+  if (recFile == 0) {
+    MSG("ERROR: QEMUTrace could not create trace file [%s]", fname);
+    exit(-2);
+  }
+
+  FileHeader fh;
+  memcpy(fh.magic, TraceMagic, sizeof(TraceMagic));
+  fh.version   = Version;
+  fh.blockSize = BlockSize;
+  fh.flags     = 0;
+  fwrite(&fh, sizeof(fh), 1, recFile);
+  recBytes = sizeof(fh);
+  __atomic_store_n(&recOn, true, __ATOMIC_RELEASE);
+  __atomic_store_n(&recOpen, true, __ATOMIC_RELEASE);
+
+  atexit(closeRecord);
+  MSG("QEMUTrace: recording to %s", fname);
+}
+
+void QEMUTrace::closeRecord() {
+  pthread_mutex_lock(&recLock);
+  if (!recOn) {
+    pthread_mutex_unlock(&recLock);
+    return;
+  }
+  // No new streams, the owners flush theirs at their next event
+  __atomic_store_n(&recOn, false, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&recLock);
+
+  if (myStream)
+    stopStream(myStream);
+
+  // Threads blocked (or gone without finishing) never flush: wait up to 1s
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += 1;
+
+  size_t nPending = 0;
+  pthread_mutex_lock(&recLock);
+  while(true) {
+    nPending = 0;
+    for(size_t i=0;i<recStreams.size();i++) {
+      if (!__atomic_load_n(&recStreams[i]->flushed, __ATOMIC_ACQUIRE))
+        nPending++;
+    }
+    if (nPending == 0)
+      break;
+    if (pthread_cond_timedwait(&recFlushed, &recLock, &deadline) == ETIMEDOUT)
+      break;
+  }
+
+  if (nPending) {
+    // The events still buffered are lost, replaying would diverge
+    MSG("ERROR: QEMUTrace: %lu streams not flushed, the trace is marked truncated and can not be replayed", nPending);
+    uint32_t flags = TF_Truncated;
+    fseek(recFile, offsetof(FileHeader, flags), SEEK_SET);
+    fwrite(&flags, sizeof(flags), 1, recFile);
+  }
+
+  fclose(recFile);
+  recFile = 0;
+  __atomic_store_n(&recOpen, false, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&recLock);
+
+  MSG("QEMUTrace: recorded %llu events in %llu bytes (%lu streams)"
+      ,(unsigned long long)recEvents, (unsigned long long)recBytes, recStreams.size());
+}
+
+// Null once the recording stopped (the caller skips the event)
+QEMUTrace::RecStream *QEMUTrace::getStream() {
+  RecStream *s = myStream;
+
+  if (unlikely(!__atomic_load_n(&recOn, __ATOMIC_ACQUIRE))) {
+    if (s)
+      stopStream(s);
+    return 0;
+  }
+
+  if (likely(s)) {
+    if (unlikely(s->flushed)) // the thread finished and records again
+      __atomic_store_n(&s->flushed, false, __ATOMIC_RELEASE);
+    return s;
+  }
+
+  s = new RecStream;
+  s->nEvents = 0;
+  s->size    = 0;
+  s->flushed = false;
+  s->coder.reset();
+
+  pthread_mutex_lock(&recLock);
+  if (!recOn) {
+    pthread_mutex_unlock(&recLock);
+    delete s;
+    return 0;
+  }
+  s->id = recStreams.size();
+  recStreams.push_back(s);
+  pthread_mutex_unlock(&recLock);
+
+  myStream = s;
+  return s;
+}
+
+// Called by the owner thread only
+void QEMUTrace::stopStream(RecStream *s) {
+  if (s->flushed)
+    return;
+  flushStream(s);
+  pthread_mutex_lock(&recLock);
+  __atomic_store_n(&s->flushed, true, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&recFlushed);
+  pthread_mutex_unlock(&recLock);
+}
+
+void QEMUTrace::flushStream(RecStream *s) {
+  if (s->nEvents == 0)
+    return;
+
+  uLongf zsize = compressBound(s->size);
+  std::vector<uint8_t> zbuf(zsize);
+  const uint8_t *data = s->buf;
+  if (compress2(&zbuf[0], &zsize, s->buf, s->size, 1) == Z_OK && zsize < s->size)
+    data = &zbuf[0];
+  else
+    zsize = s->size;
+
+  BlockHeader bh;
+  bh.stream     = s->id;
+  bh.nEvents    = s->nEvents;
+  bh.rawSize    = s->size;
+  bh.storedSize = zsize;
+
+  pthread_mutex_lock(&recLock);
+  if (recFile) {
+    fwrite(&bh, sizeof(bh), 1, recFile);
+    fwrite(data, 1, zsize, recFile);
+    recEvents += s->nEvents;
+    recBytes  += sizeof(bh) + zsize;
+  }
+  pthread_mutex_unlock(&recLock);
+
+  s->nEvents = 0;
+  s->size    = 0;
+  s->coder.reset();
+}
+
+uint8_t *QEMUTrace::beginEvent(RecStream *s, EventType type, FlowID fid, uint8_t flags) {
+  uint8_t *p = &s->buf[s->size];
+  if (fid == s->coder.lastFid) {
+    *p++ = type | flags | F_SameFid;
+  }else{
+    *p++ = type | flags;
+    p = putVar(p, fid);
+    s->coder.lastFid = fid;
+  }
+  return p;
+}
+
+void QEMUTrace::endEvent(RecStream *s, uint8_t *p) {
+  s->size = p - s->buf;
+  I(s->size <= BlockSize + EventMaxSize);
+  s->nEvents++;
+  if (s->size >= BlockSize)
+    flushStream(s);
+}
+
+void QEMUTrace::recordInst(uint32_t insn, uint32_t pc, uint32_t addr, FlowID fid, char op, uint64_t icount) {
+  RecStream *s = getStream();
+  if (s == 0)
+    return;
+  Coder &c = s->coder;
+
+  uint32_t idx = insnIndex(pc);
+  uint8_t flags = 0;
+  if (c.cachePc[idx] == pc && c.cacheInsn[idx] == insn)
+    flags |= F_InsnHit;
+  if (addr == 0)
+    flags |= F_NoAddr;
+  if (icount == 1)
+    flags |= F_Icount1;
+
+  uint8_t *p = beginEvent(s, ev_inst, fid, flags);
+  *p++ = static_cast<uint8_t>(op);
+  p = putVar(p, zigzag(pc - (c.lastPc + 4)));
+  c.lastPc = pc;
+  if (!(flags & F_InsnHit)) {
+    memcpy(p, &insn, 4);
+    p += 4;
+    c.cachePc[idx]   = pc;
+    c.cacheInsn[idx] = insn;
+  }
+  if (addr) {
+    p = putVar(p, zigzag(addr - c.lastAddr));
+    c.lastAddr = addr;
+  }
+  if (icount != 1)
+    p = putVar(p, icount);
+
+  endEvent(s, p);
+}
+
+void QEMUTrace::recordSyscall(uint32_t num, uint64_t usecs, FlowID fid) {
+  RecStream *s = getStream();
+  if (s == 0)
+    return;
+  uint8_t *p = beginEvent(s, ev_syscall, fid, 0);
+  p = putVar(p, num);
+  p = putVar(p, usecs);
+  endEvent(s, p);
+}
+
+void QEMUTrace::recordFinish(FlowID fid, bool thread) {
+  RecStream *s = getStream();
+  if (s == 0)
+    return;
+  uint8_t *p = beginEvent(s, thread ? ev_finishThread : ev_finish, fid, 0);
+  endEvent(s, p);
+  if (thread)
+    stopStream(s);
+  else
+    closeRecord();
+}
+
+void QEMUTrace::recordResume(FlowID uid, FlowID lastFid, FlowID fid) {
+  RecStream *s = getStream();
+  if (s == 0)
+    return;
+  uint8_t *p = beginEvent(s, ev_resume, fid, 0);
+  p = putVar(p, uid);
+  p = putVar(p, lastFid);
+  p = putVar(p, AtomicAdd(&recSeq, 1));
+  endEvent(s, p);
+}
+
+void QEMUTrace::recordPause(FlowID fid) {
+  RecStream *s = getStream();
+  if (s == 0)
+    return;
+  uint8_t *p = beginEvent(s, ev_pause, fid, 0);
+  endEvent(s, p);
+}
+/* }}} */
+
+/* Replay {{{1 */
+
+void QEMUTrace::startReplay(const char *fname) {
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0) {
+    MSG("ERROR: QEMUTrace could not open trace file [%s]", fname);
+    exit(-2);
+  }
+  struct stat st;
+  fstat(fd, &st);
+  playSize = st.st_size;
+  void *map = mmap(0, playSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED || playSize < sizeof(FileHeader)) {
+    MSG("ERROR: QEMUTrace could not map trace file [%s]", fname);
+    exit(-2);
+  }
+  playMap = static_cast<const uint8_t *>(map);
+  madvise(map, playSize, MADV_SEQUENTIAL);
+
+  const FileHeader *fh = reinterpret_cast<const FileHeader *>(playMap);
+  if (memcmp(fh->magic, TraceMagic, sizeof(TraceMagic)) != 0 || fh->version != Version) {
+    MSG("ERROR: [%s] is not a version %d QEMU trace", fname, Version);
+    exit(-2);
+  }
+  if (fh->flags & TF_Truncated) {
+    MSG("ERROR: QEMUTrace [%s] is truncated (streams not flushed while recording)", fname);
+    exit(-2);
+  }
+
+  // Index the blocks of each stream
+  const uint8_t *p = playMap + sizeof(FileHeader);
+  while(p + sizeof(BlockHeader) <= playMap + playSize) {
+    const BlockHeader *bh = reinterpret_cast<const BlockHeader *>(p);
+    if (p + sizeof(BlockHeader) + bh->storedSize > playMap + playSize) {
+      MSG("ERROR: QEMUTrace [%s] is truncated", fname);
+      exit(-2);
+    }
+    while(playStreams.size() <= bh->stream) {
+      PlayStream *s = new PlayStream;
+      s->id        = playStreams.size();
+      s->nextBlock = 0;
+      s->nEvents   = 0;
+      s->pos       = 0;
+      s->end       = 0;
+      s->recFid    = 0;
+      s->playFid   = 0;
+      s->mapGen    = 0;
+      playStreams.push_back(s);
+    }
+    playStreams[bh->stream]->blocks.push_back(p);
+    p += sizeof(BlockHeader) + bh->storedSize;
+  }
+
+  if (playStreams.empty()) {
+    MSG("ERROR: QEMUTrace [%s] has no events", fname);
+    exit(-2);
+  }
+
+  MSG("QEMUTrace: replaying %s (%lu streams)", fname, playStreams.size());
+
+  playRunning = playStreams.size();
+  for(size_t i=0;i<playStreams.size();i++) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 1024*1024);
+    if (pthread_create(&playStreams[i]->thread, &attr, playMain, playStreams[i]) != 0) {
+      MSG("ERROR: pthread create failed");
+      exit(-2);
+    }
+  }
+}
+
+bool QEMUTrace::loadBlock(PlayStream *s) {
+  if (s->nextBlock >= s->blocks.size())
+    return false;
+
+  const BlockHeader *bh = reinterpret_cast<const BlockHeader *>(s->blocks[s->nextBlock++]);
+  const uint8_t *data   = reinterpret_cast<const uint8_t *>(bh + 1);
+
+  if (bh->storedSize == bh->rawSize) {
+    s->pos = data;
+  }else{
+    s->buf.resize(bh->rawSize + EventMaxSize);
+    uLongf rsize = bh->rawSize;
+    if (uncompress(&s->buf[0], &rsize, data, bh->storedSize) != Z_OK || rsize != bh->rawSize) {
+      MSG("ERROR: QEMUTrace corrupted block in stream %d", s->id);
+      return false;
+    }
+    s->pos = &s->buf[0];
+  }
+  s->end     = s->pos + bh->rawSize;
+  s->nEvents = bh->nEvents;
+  s->coder.reset();
+
+  return true;
+}
+
+bool QEMUTrace::nextEvent(PlayStream *s, Event *ev) {
+  if (s->nEvents == 0) {
+    if (!loadBlock(s))
+      return false;
+  }
+  s->nEvents--;
+
+  Coder &c = s->coder;
+  const uint8_t *p = s->pos;
+  uint64_t v;
+
+  uint8_t head = *p++;
+  ev->type = static_cast<EventType>(head & 0x7);
+  if (!(head & F_SameFid)) {
+    p = getVar(p, &v);
+    c.lastFid = v;
+  }
+  ev->fid = c.lastFid;
+
+  switch(ev->type) {
+    case ev_inst:
+      {
+        ev->op = static_cast<char>(*p++);
+        p = getVar(p, &v);
+        ev->pc   = c.lastPc + 4 + unzigzag(v);
+        c.lastPc = ev->pc;
+        uint32_t idx = insnIndex(ev->pc);
+        if (head & F_InsnHit) {
+          I(c.cachePc[idx] == ev->pc);
+          ev->insn = c.cacheInsn[idx];
+        }else{
+          memcpy(&ev->insn, p, 4);
+          p += 4;
+          c.cachePc[idx]   = ev->pc;
+          c.cacheInsn[idx] = ev->insn;
+        }
+        ev->addr = 0;
+        if (!(head & F_NoAddr)) {
+          p = getVar(p, &v);
+          ev->addr   = c.lastAddr + unzigzag(v);
+          c.lastAddr = ev->addr;
+        }
+        ev->icount = 1;
+        if (!(head & F_Icount1))
+          p = getVar(p, &ev->icount);
+      }
+      break;
+    case ev_syscall:
+      p = getVar(p, &v);
+      ev->num = v;
+      p = getVar(p, &ev->icount);
+      break;
+    case ev_resume:
+      p = getVar(p, &v);
+      ev->num = v;
+      p = getVar(p, &v);
+      ev->lastFid = v;
+      p = getVar(p, &v);
+      ev->seq = v;
+      break;
+    default:
+      break;
+  }
+
+  I(p <= s->end);
+  s->pos = p;
+  return true;
+}
+
+// Cached per stream, the shared map is only read when it changed
+FlowID QEMUTrace::mapFid(PlayStream *s, FlowID fid) {
+  if (likely(fid == s->recFid && s->mapGen == __atomic_load_n(&playMapGen, __ATOMIC_ACQUIRE)))
+    return s->playFid;
+
+  pthread_mutex_lock(&playLock);
+  s->recFid  = fid;
+  s->playFid = fid < playFidMap.size() ? playFidMap[fid] : fid;
+  s->mapGen  = playMapGen;
+  pthread_mutex_unlock(&playLock);
+
+  return s->playFid;
+}
+
+void QEMUTrace::resumeFlow(PlayStream *s, const Event &ev) {
+  // Flows resume in the recorded order
+  pthread_mutex_lock(&playLock);
+  while(playSeq != ev.seq && !playFinished)
+    pthread_cond_wait(&playSeqDone, &playLock);
+  pthread_mutex_unlock(&playLock);
+  if (playFinished)
+    return;
+
+  FlowID nfid = QEMUReader_resumeThread(ev.num, mapFid(s, ev.lastFid));
+  if (nfid != ev.fid)
+    MSG("QEMUTrace: stream %d resumed as flow %d (recorded %d)", s->id, nfid, ev.fid);
+
+  pthread_mutex_lock(&playLock);
+  if (playFidMap.size() <= ev.fid) {
+    size_t n = playFidMap.size();
+    playFidMap.resize(ev.fid+1);
+    for(size_t i=n;i<playFidMap.size();i++)
+      playFidMap[i] = i;
+  }
+  playFidMap[ev.fid] = nfid;
+  __atomic_store_n(&playMapGen, playMapGen + 1, __ATOMIC_RELEASE);
+  playSeq++;
+  pthread_cond_broadcast(&playSeqDone);
+  pthread_mutex_unlock(&playLock);
+}
+
+void QEMUTrace::finishReplay(FlowID fid) {
+  pthread_mutex_lock(&playLock);
+  playFinished = true;
+  pthread_cond_broadcast(&playSeqDone);
+  pthread_mutex_unlock(&playLock);
+
+  QEMUReader_finish(fid);
+}
+
+void *QEMUTrace::playMain(void *arg) {
+  PlayStream *s = static_cast<PlayStream *>(arg);
+
+  Event ev;
+  while(!playFinished && nextEvent(s, &ev)) {
+    if (ev.type == ev_resume) {
+      resumeFlow(s, ev);
+      continue;
+    }
+
+    FlowID fid = mapFid(s, ev.fid);
+    switch(ev.type) {
+      case ev_inst:
+        QEMUReader_queue_inst(ev.insn, ev.pc, ev.addr, fid, ev.op, ev.icount, 0);
+        break;
+      case ev_syscall:
+        QEMUReader_syscall(ev.num, ev.icount, fid);
+        break;
+      case ev_pause:
+        QEMUReader_pauseThread(fid);
+        break;
+      case ev_finishThread:
+        QEMUReader_finish_thread(fid);
+        break;
+      case ev_finish:
+        finishReplay(fid);
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (AtomicSub(&playRunning, 1) == 1 && !playFinished) {
+    MSG("QEMUTrace: end of trace without finish event");
+    finishReplay(0);
+  }
+
+  return 0;
+}
+/* }}} */
@@ -0,0 +1,168 @@
+#ifndef QEMUTRACE_H
+#define QEMUTRACE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <vector>
+
+#include "nanassert.h"
+#include "RAWDInst.h"
+
+/*
+ * Record/replay of the QEMU to sampler interface (QEMUReader_queue_inst,
+ * QEMUReader_syscall and the thread events in QEMUInterface.cpp).
+ *
+ * In record mode each QEMU host thread appends its events to a private
+ * stream. Events are delta encoded (pc/addr deltas, instruction words cached
+ * by pc, flags for the common cases) and written in zlib compressed blocks.
+ * Blocks from all the streams are interleaved in one file.
+ *
+ * Only the owner thread touches a stream buffer. A thread flushes its stream
+ * when it finishes, and when it sees that the recording stopped (recOn).
+ * closeRecord stops the recording, waits for the streams to be flushed and
+ * then closes the file. If a stream is not flushed within 1s (its thread is
+ * blocked) the header is marked truncated and the trace can not be replayed.
+ *
+ * In replay mode the file is memory mapped and one thread per stream calls
+ * the same entry points that QEMU calls, so the samplers, the tsfifo and
+ * the cracking work as in a live run but QEMU never runs. Thread resumes
+ * carry a global sequence number so that flows start in the recorded order.
+ * A resume may get a different flow than the recorded one; the recorded to
+ * replay flow map is shared by all the streams (a child stream uses the fid
+ * that its parent resumed).
+ *
+ * Replay with the same sampler configuration used to record: the trace has
+ * the instruction granularity that QEMU used in each sampling mode.
+ */
+
+class QEMUTrace {
+public:
+  enum {
+    Version   = 2,
+    BlockSize = 256*1024 // raw (uncompressed) bytes per block
+  };
+
+  enum FileFlags {
+    TF_Truncated = 0x1 // some streams were not flushed at closeRecord
+  };
+
+  enum EventType {
+    ev_inst = 0,
+    ev_syscall,
+    ev_finish,
+    ev_finishThread,
+    ev_resume,
+    ev_pause
+  };
+
+  // One decoded event
+  class Event {
+  public:
+    EventType type;
+    FlowID    fid;
+    uint32_t  insn;
+    uint32_t  pc;
+    uint32_t  addr;
+    char      op;
+    uint64_t  icount;   // also syscall usecs
+    uint32_t  num;      // syscall number or resume uid
+    FlowID    lastFid;  // resume
+    uint32_t  seq;      // resume
+  };
+
+private:
+  enum {
+    InsnCacheSize = 4096,
+    EventMaxSize  = 48
+  };
+
+  // Delta encoding state (reset at every block)
+  class Coder {
+  public:
+    uint32_t lastPc;
+    uint32_t lastAddr;
+    FlowID   lastFid;
+    uint32_t cachePc[InsnCacheSize];
+    uint32_t cacheInsn[InsnCacheSize];
+
+    void reset();
+  };
+
+  class RecStream {
+  public:
+    uint32_t id;
+    uint32_t nEvents;
+    size_t   size;
+    bool     flushed; // nothing buffered, written by the owner
+    Coder    coder;
+    uint8_t  buf[BlockSize + EventMaxSize];
+  };
+
+  class PlayStream {
+  public:
+    uint32_t id;
+    std::vector<const uint8_t *> blocks;
+    size_t   nextBlock;
+    uint32_t nEvents;
+    const uint8_t *pos;
+    const uint8_t *end;
+    Coder    coder;
+    std::vector<uint8_t> buf;
+    FlowID   recFid;  // last playFidMap lookup
+    FlowID   playFid;
+    uint32_t mapGen;
+    pthread_t thread;
+  };
+
+  static FILE            *recFile;
+  static bool             recOpen; // file open (the streams may still flush)
+  static bool             recOn;   // events recorded
+  static pthread_mutex_t  recLock;
+  static pthread_cond_t   recFlushed;
+  static std::vector<RecStream *> recStreams;
+  static __thread RecStream *myStream;
+  static volatile uint32_t recSeq;
+  static uint64_t recEvents;
+  static uint64_t recBytes;
+
+  static const uint8_t   *playMap;
+  static size_t           playSize;
+  static std::vector<PlayStream *> playStreams;
+  static pthread_mutex_t  playLock;
+  static pthread_cond_t   playSeqDone;
+  static std::vector<FlowID> playFidMap; // recorded fid -> replay fid
+  static volatile uint32_t playMapGen;   // bumped at each playFidMap update
+  static volatile uint32_t playSeq;
+  static volatile uint32_t playRunning;
+  static volatile bool     playFinished;
+
+  static RecStream *getStream();
+  static uint8_t *beginEvent(RecStream *s, EventType type, FlowID fid, uint8_t flags);
+  static void endEvent(RecStream *s, uint8_t *p);
+  static void flushStream(RecStream *s);
+  static void stopStream(RecStream *s);
+
+  static bool nextEvent(PlayStream *s, Event *ev);
+  static bool loadBlock(PlayStream *s);
+  static FlowID mapFid(PlayStream *s, FlowID fid);
+  static void resumeFlow(PlayStream *s, const Event &ev);
+  static void finishReplay(FlowID fid);
+  static void *playMain(void *arg);
+
+public:
+  static void openRecord(const char *fname);
+  static void closeRecord();
+  static bool isRecording() { return __atomic_load_n(&recOpen, __ATOMIC_ACQUIRE); }
+
+  static void recordInst(uint32_t insn, uint32_t pc, uint32_t addr, FlowID fid, char op, uint64_t icount);
+  static void recordSyscall(uint32_t num, uint64_t usecs, FlowID fid);
+  static void recordFinish(FlowID fid, bool thread);
+  static void recordResume(FlowID uid, FlowID lastFid, FlowID fid);
+  static void recordPause(FlowID fid);
+
+  // Map the trace and start one replay thread per recorded stream
+  static void startReplay(const char *fname);
+};
+
+#endif
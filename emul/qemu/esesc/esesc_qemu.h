@@ -73,6 +73,7 @@ uint32_t  GPUReader_setNumThreads(uint64_t binnumthreads, uint64_t binblockthrea
 uint32_t  GPUReader_getTracesize(void);
 
 void GPUReader_mallocAddress(uint32_t dev_addr, uint32_t size, uint32_t* qemuid );
+void GPUReader_freeAddress(uint32_t dev_addr);
 void GPUReader_mapcudaMemcpy(uint32_t dev_addr, uint32_t host_addr, uint32_t size, uint32_t kind, void *env, uint32_t* cpufid);
 
 void GPUReader_setCurrentKernel(const char* local_kernel_name);
@@ -697,6 +697,8 @@ uint32_t callRealCudaFunctions(struct Arguments* p1, uint32_t func_num, void* en
         printf("\nCalling cudaFree on pointer %p\n",(void*)(PTRSZ)(*(uint32_t*)((PTRSZ)(p1->args[0]))));
 
       cudaFree((void*)(PTRSZ)(*(uint32_t*)((PTRSZ)(p1->args[0]))));
+
+      GPUReader_freeAddress(*(uint32_t*)((PTRSZ)(p1->args[0])));
       break;
 
 
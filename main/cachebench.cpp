@@ -35,7 +35,7 @@ void startBench()
 }
 
 
-void endBench(const char *str)
+double endBench(const char *str)
 {
   gettimeofday(&endTime, 0);
 
@@ -44,6 +44,8 @@ void endBench(const char *str)
   
   fprintf(stderr,"%s: %8.2f Maccesses/s %7.3f%%\n"
 	  ,str,nAccess/usecs, 100*nMisses/nAccess);
+
+  return usecs;
 }
 
 #define MSIZE 256
@@ -52,7 +54,7 @@ double A[MSIZE][MSIZE];
 double B[MSIZE][MSIZE];
 double C[MSIZE][MSIZE];
 
-void benchMatrix(const char *str)
+double benchMatrix(const char *str)
 {
   MSG("Benchmark a code like a matrix multiply: %s", str);
 
@@ -115,7 +117,56 @@ void benchMatrix(const char *str)
     }
   }
 
-  endBench(str);
+  return endBench(str);
+}
+
+double benchRandom(const char *str, int32_t cacheSize, int32_t lineSize)
+{
+  // Random lines over 3/4 of the cache (mostly hits, spread over all the ways)
+  uint32_t nLines = (cacheSize/lineSize)*3/4;
+  uint32_t x      = 1;
+
+  startBench();
+
+  for(int32_t i=0;i<20000000;i++) {
+    x = x*1103515245 + 12345;
+    long addr = (long)((x>>4) % nLines) * lineSize + 0x10000;
+
+    MyCacheType::CacheLine *line = cache->readLine(addr);
+    nAccess++;
+    if (line==0) {
+      cache->fillLine(addr);
+      nAccess++;
+      nMisses++;
+    }
+  }
+
+  return endBench(str);
+}
+
+// Same cache with the pointer based (CacheAssoc) and the SIMD (CacheAssocSoA) tag store
+void benchLayouts(const char *section)
+{
+  int32_t     s    = SescConf->getInt(section, "Size");
+  int32_t     a    = SescConf->getInt(section, "Assoc");
+  int32_t     b    = SescConf->getInt(section, "Bsize");
+  const char *pStr = SescConf->getCharPtr(section, "ReplPolicy");
+
+  char str[256];
+  double t[2][2];
+
+  for(int32_t soa=0;soa<2;soa++) {
+    cache = MyCacheType::create(s, a, b, 1, pStr, false, false, 0, soa);
+    sprintf(str, "%s %s matrix", section, soa ? "SoA" : "AoS");
+    t[soa][0] = benchMatrix(str);
+
+    cache = MyCacheType::create(s, a, b, 1, pStr, false, false, 0, soa);
+    sprintf(str, "%s %s random", section, soa ? "SoA" : "AoS");
+    t[soa][1] = benchRandom(str, s, b);
+  }
+
+  fprintf(stderr,"%s: SoA tag store speedup matrix %5.2fx random %5.2fx\n"
+          ,section, t[0][0]/t[1][0], t[0][1]/t[1][1]);
 }
 
 int main(int32_t argc, const char **argv)
@@ -174,6 +225,10 @@ int main(int32_t argc, const char **argv)
   cache = MyCacheType::create("DL1_core","","L1");
   benchMatrix("DL1_core");
 
+  benchLayouts("DL1_core");
+  benchLayouts("PrivL2");
+  benchLayouts("L3Cache");
+
 #if 0
   cache = MyCacheType::create("BTB","","BTB");
   benchMatrix("BTB");
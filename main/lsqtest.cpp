@@ -1,4 +1,4 @@
-/* 
+/*
    ESESC: Super ESCalar simulator
    Copyright (C) 2009 University of California, Santa Cruz.
 
@@ -23,67 +23,215 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 */
 
 /*
- * This launches the ESESC simulator environment with an ideal memory
+ * Throughput of the speculative LSQ queue used by MTLSQ.
+ *
+ * A synthetic stream of loads/stores goes through the same steps as in
+ * WMMLSQ: a placeholder is added in program order, the entry is filled when
+ * it issues (out of order, up to window/2 instructions later), a store
+ * searches younger loads to the same word, a load searches older entries for
+ * a forwarding source, and entries retire in order from the head.
+ *
+ * The same stream runs over std::map (the old specLSQ) and over LSQRing with
+ * the address filter, and both must find the same matches.
+ *
+ *   lsqtest [nInsts] [window] [nWords]
  */
 
 #include <sys/time.h>
-#include <sys/types.h>
-#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <map>
+#include <vector>
 
 #include "nanassert.h"
+#include "LSQRing.h"
 
-#include "Instruction.h"
-#include "DInst.h"
+class LSQBenchEntry {
+public:
+  uint64_t addr;
+  bool     isStore;
+};
 
-//*********** BEGIN CREATE FAKE PROCESSOR CLASS
-uint64_t nReplays = 0;
-#define GPROCESSOR_H 1
-class GProcessor {
-  public:
-  void replay(DInst *dinst) {
-    nReplays++;
+// Same stream for both queues
+class LSQBenchTrace {
+public:
+  std::vector<LSQBenchEntry> insts;
+  std::vector<uint32_t>      issueAt; // issue cycle of each inst
+
+  LSQBenchTrace(uint32_t n, uint32_t window, uint32_t nWords) {
+    srand(1);
+    insts.resize(n);
+    issueAt.resize(n);
+    for(uint32_t i = 0; i < n; i++) {
+      insts[i].addr    = rand() % nWords;
+      insts[i].isStore = (rand() % 3) == 0;
+      issueAt[i]       = i + rand() % (window / 2);
+    }
   }
 };
-//*********** END CREATE FAKE PROCESSOR CLASS
-#include "SescConf.h"
-#include "LSQ.h"
 
-long long instTotal = 0;
+class MapQ {
+private:
+  typedef std::map<Time_t, LSQBenchEntry*> Q;
+  Q q;
 
-LSQ *lsq;
+public:
+  void add(Time_t id) {
+    q.insert(std::make_pair<Time_t, LSQBenchEntry*>(id, 0));
+  }
 
-void doTest() {
-#if 0
-  Instruction *ld    = Instruction::create(iLALU_LD, 0, 0, 0, 0, false );
-  Instruction *st    = Instruction::create(iSALU_ST, 0, 0, 0, 0, false );
-  Instruction *stadd = Instruction::create(iSALU_ADDR, 0, 0, 0, 0, false );
+  uint64_t issue(Time_t id, LSQBenchEntry *en) {
+    Q::iterator it = q.find(id);
+    I(it != q.end());
+    it->second = en;
+
+    uint64_t nMatch = 0;
+    if (en->isStore) {
+      for(Q::iterator i = it; ++i != q.end();) {
+        if (i->second && !i->second->isStore && i->second->addr == en->addr)
+          nMatch++;
+      }
+    }else{
+      Q::iterator i = it;
+      while(i != q.begin()) {
+        --i;
+        if (i->second && i->second->addr == en->addr) {
+          nMatch++;
+          break;
+        }
+      }
+    }
+    return nMatch;
+  }
 
-  DInst *dld1 = DInst::create(ld, rinst1, 0);
-#endif
-}
+  bool retire() {
+    if (q.empty() || q.begin()->second == 0)
+      return false;
+    q.erase(q.begin());
+    return true;
+  }
+  size_t size() const { return q.size(); }
+};
 
-int main(int argc, const char **argv) { 
-  SescConf = new SConfig(argc, argv);
+class RingQ {
+private:
+  typedef LSQRing<LSQBenchEntry*> Q;
+  Q q;
+  LSQAddrFilter filter;
 
-  GProcessor gproc;
-  //lsq = new LSQFull(&gproc,0);
-  lsq = new LSQFull(0);I(0);
+public:
+  RingQ(uint32_t window) : q(window) {}
 
-  timeval startTime;
-  gettimeofday(&startTime,0);
+  void add(Time_t id) {
+    q.insert(id, 0);
+  }
+
+  uint64_t issue(Time_t id, LSQBenchEntry *en) {
+    Q::iterator it = q.find(id);
+    I(it != q.end());
+    it->second = en;
+    filter.add(en->addr);
+
+    if (filter.count(en->addr) == 1)
+      return 0;
+
+    uint64_t nMatch = 0;
+    if (en->isStore) {
+      for(Q::iterator i = it; ++i != q.end();) {
+        if (i->second && !i->second->isStore && i->second->addr == en->addr)
+          nMatch++;
+      }
+    }else{
+      Q::iterator i = it;
+      while(i != q.begin()) {
+        --i;
+        if (i->second && i->second->addr == en->addr) {
+          nMatch++;
+          break;
+        }
+      }
+    }
+    return nMatch;
+  }
+
+  bool retire() {
+    if (q.empty() || q.begin()->second == 0)
+      return false;
+    filter.remove(q.begin()->second->addr);
+    q.erase(q.begin());
+    return true;
+  }
+  size_t size() const { return q.size(); }
+};
+
+template<class Queue>
+uint64_t runTrace(Queue &q, LSQBenchTrace &trace, uint32_t window, double &secs) {
+  const uint32_t n = trace.insts.size();
 
-  doTest();
+  // issue events, bucketed by cycle
+  std::vector< std::vector<uint32_t> > pend(window);
+
+  timeval startTime;
+  gettimeofday(&startTime, 0);
+
+  uint64_t nMatch = 0;
+  for(uint32_t t = 0; t < n + window; t++) {
+    std::vector<uint32_t> &now = pend[t % window];
+
+    if (t < n) {
+      q.add(t);
+      if (trace.issueAt[t] == t)
+        now.push_back(t);
+      else
+        pend[trace.issueAt[t] % window].push_back(t);
+    }
+    for(size_t i = 0; i < now.size(); i++)
+      nMatch += q.issue(now[i], &trace.insts[now[i]]);
+    now.clear();
+
+    // retire width 4
+    for(int i = 0; i < 4 && q.retire(); i++)
+      ;
+  }
+  I(q.size() == 0);
 
   timeval endTime;
-  gettimeofday(&endTime,0);
-  double msecs = ( endTime.tv_sec - startTime.tv_sec ) * 1000
-    + ( endTime.tv_usec - startTime.tv_usec ) / 1000;
+  gettimeofday(&endTime, 0);
+  secs = (endTime.tv_sec - startTime.tv_sec) + (endTime.tv_usec - startTime.tv_usec) / 1e6;
+
+  return nMatch;
+}
+
+int main(int argc, const char **argv) {
+  uint32_t nInsts = argc > 1 ? strtoul(argv[1], 0, 0) : 20000000;
+  uint32_t window = argc > 2 ? strtoul(argv[2], 0, 0) : 128;
+  uint32_t nWords = argc > 3 ? strtoul(argv[3], 0, 0) : 4096;
+  if (window < 4 || nWords == 0) {
+    MSG("usage: lsqtest [nInsts] [window>=4] [nWords]");
+    return -1;
+  }
+
+  LSQBenchTrace trace(nInsts, window, nWords);
+
+  double mapSecs;
+  MapQ mapQ;
+  uint64_t mapMatch = runTrace(mapQ, trace, window, mapSecs);
+
+  double ringSecs;
+  RingQ ringQ(window);
+  uint64_t ringMatch = runTrace(ringQ, trace, window, ringSecs);
 
-  long double res = instTotal/1000;
-  res /= msecs;
   MSG("------------------");
-  MSG ( "LSQ MIPS = %g secs = %g insts = %lld", (double) res, msecs/1000,(long long) instTotal );
+  MSG("LSQ window %u words %u insts %u", window, nWords, nInsts);
+  MSG("std::map  %8.2f Minst/s matches %llu", nInsts / mapSecs / 1e6, (unsigned long long)mapMatch);
+  MSG("LSQRing   %8.2f Minst/s matches %llu", nInsts / ringSecs / 1e6, (unsigned long long)ringMatch);
   MSG("------------------");
 
+  if (mapMatch != ringMatch) {
+    MSG("ERROR: LSQRing and std::map found different matches");
+    return -1;
+  }
+
   return 0;
 }
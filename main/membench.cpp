@@ -26,6 +26,10 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  * This launches the ESESC simulator environment with an ideal memory
  */
 
+#include <sys/time.h>
+#include <string.h>
+#include <vector>
+
 #include "nanassert.h"
 
 #include "GProcessor.h"
@@ -35,6 +39,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "callback.h"
 #include "MemorySystem.h"
 #include "SescConf.h"
+#include "SynthBench.h"
 #include "DInst.h"
 #include "nanassert.h"
 #include "RAWDInst.h"
@@ -658,6 +663,180 @@ void test7()
 
 #endif
 
+/*
+ * Synthetic traffic over the real memory hierarchy (DL1s, shared caches,
+ * memory controller). It runs if the configuration has a [membench]
+ * section (see conf/membench.conf), one run per pattern[i]:
+ *
+ *  stream : consecutive lines, per core region
+ *  stride : every stride bytes, per core region
+ *  random : random lines, per core region
+ *  chase  : pointer chase over a random cycle of lines (one read in flight)
+ *  share  : core 0 writes a block of lines, the other cores read it
+ *
+ * Each run reports the simulated latency and bandwidth next to the host
+ * throughput (simulated requests and events per host second), so it can be
+ * used to check the simulator speed when the hot paths change. The
+ * requests per host second are checked against the baseline file (see
+ * SynthBench.h).
+ */
+
+static const char *synthSection = "membench";
+static SynthBench  synthBench("membench");
+
+static int      synth_pending = 0;
+static uint64_t synth_done    = 0;
+static uint64_t synth_latency = 0;
+
+void synthDone(Time_t issued) {
+  synth_pending--;
+  synth_done++;
+  synth_latency += globalClock - issued;
+}
+
+typedef CallbackFunction1<Time_t, &synthDone> synthDoneCB;
+
+static void synthIssue(MemObj *cache, AddrType addr, bool wr, int maxOutstanding) {
+  while(synth_pending >= maxOutstanding || cache->isBusy(addr))
+    EventScheduler::advanceClock();
+
+  synthDoneCB *cb = synthDoneCB::create(globalClock);
+  if (wr)
+    MemRequest::sendReqWrite(cache, true, addr, cb);
+  else
+    MemRequest::sendReqRead(cache, true, addr, cb);
+
+  synth_pending++;
+  num_operations++;
+}
+
+static void synthWait() {
+  while(synth_pending)
+    EventScheduler::advanceClock();
+}
+
+static void synth(const char *pattern) {
+
+  int32_t nOps        = SescConf->getInt(synthSection, "nOps");
+  int32_t nCores      = SescConf->getInt(synthSection, "nCores");
+  int32_t lineBytes   = SescConf->getInt(synthSection, "lineBytes");
+  int32_t footprint   = SescConf->getInt(synthSection, "footprint");
+  int32_t stride      = SescConf->getInt(synthSection, "stride");
+  int32_t maxOut      = SescConf->getInt(synthSection, "maxOutstanding");
+  int32_t writePct    = SescConf->getInt(synthSection, "writePct");
+  int32_t shareLines  = SescConf->getInt(synthSection, "shareLines");
+
+  SescConf->isBetween(synthSection, "nCores", 1, TaskHandler::getNumCPUS());
+  SescConf->isPower2(synthSection, "lineBytes");
+  SescConf->isGT(synthSection, "footprint", lineBytes-1);
+  SescConf->isGT(synthSection, "stride", 0);
+  SescConf->isGT(synthSection, "maxOutstanding", 0);
+  SescConf->isBetween(synthSection, "writePct", 0, 100);
+  SescConf->isGT(synthSection, "shareLines", 0);
+  if (strcasecmp(pattern, "share") == 0 && nCores < 2) {
+    MSG("ERROR: membench share pattern needs nCores >= 2");
+    SescConf->notCorrect();
+  }
+  if (!SescConf->check()) {
+    MSG("ERROR: membench configuration incorrect");
+    exit(-2);
+  }
+
+  std::vector<MemObj *> dl1(nCores);
+  for(int32_t c=0;c<nCores;c++) {
+    GProcessor *gproc = TaskHandler::getSimu(c);
+    I(gproc);
+    dl1[c] = gproc->getMemorySystem()->getDL1();
+    I(dl1[c]);
+  }
+
+  const AddrType base   = 0x10000000;
+  const int32_t  nLines = footprint / lineBytes;
+
+  synthBench.seed(SescConf->getInt(synthSection, "seed"));
+  synth_done    = 0;
+  synth_latency = 0;
+
+  // Chase order: a random cycle over the lines (Sattolo)
+  std::vector<int32_t> chase;
+  if (strcasecmp(pattern, "chase") == 0) {
+    chase.resize(nLines);
+    for(int32_t i=0;i<nLines;i++)
+      chase[i] = i;
+    for(int32_t i=nLines-1;i>0;i--) {
+      int32_t j   = synthBench.rand() % i;
+      int32_t tmp = chase[i];
+      chase[i]    = chase[j];
+      chase[j]    = tmp;
+    }
+  }
+
+  synthBench.start();
+
+  if (strcasecmp(pattern, "stream") == 0 || strcasecmp(pattern, "stride") == 0 || strcasecmp(pattern, "random") == 0) {
+    bool     isStream = strcasecmp(pattern, "stream") == 0;
+    bool     isStride = strcasecmp(pattern, "stride") == 0;
+    for(int32_t i=0;i<nOps;i++) {
+      int32_t  c = i % nCores;
+      uint64_t a;
+      if (isStream)
+        a = ((i / nCores) * (uint64_t)lineBytes) % footprint;
+      else if (isStride)
+        a = ((i / nCores) * (uint64_t)stride) % footprint;
+      else
+        a = (synthBench.rand() % nLines) * lineBytes;
+      synthIssue(dl1[c], base + (AddrType)c * footprint + a, (int32_t)(synthBench.rand() % 100) < writePct, maxOut);
+    }
+  }else if (strcasecmp(pattern, "chase") == 0) {
+    int32_t line = 0;
+    for(int32_t i=0;i<nOps;i++) {
+      // The next address comes from the loaded data: wait for the load
+      synthIssue(dl1[0], base + (AddrType)line * lineBytes, false, 1);
+      synthWait();
+      line = chase[line];
+    }
+  }else if (strcasecmp(pattern, "share") == 0) {
+    int32_t i = 0;
+    int32_t blk = 0;
+    while(i < nOps) {
+      AddrType blkBase = base + (AddrType)((blk * shareLines) % nLines) * lineBytes;
+      for(int32_t l=0;l<shareLines && i<nOps;l++,i++)
+        synthIssue(dl1[0], blkBase + l * lineBytes, true, maxOut);
+      synthWait();
+      for(int32_t c=1;c<nCores;c++) {
+        for(int32_t l=0;l<shareLines && i<nOps;l++,i++)
+          synthIssue(dl1[c], blkBase + l * lineBytes, false, maxOut);
+      }
+      synthWait();
+      blk++;
+    }
+  }else{
+    MSG("ERROR: membench unknown pattern [%s] (stream, stride, random, chase, share)", pattern);
+    exit(-2);
+  }
+  synthWait();
+
+  synthBench.stop();
+
+  double secs   = synthBench.getSecs();
+  Time_t cycles = synthBench.getCycles();
+  if (cycles == 0)
+    cycles = 1;
+
+  fprintf(stderr, "membench %-6s: %lld reqs %lld cycles, avg lat %.2f cycles, %.3f B/cycle"
+          " | %.3f host secs, %.0f reqs/host-sec, %.0f events/host-sec\n"
+          ,pattern
+          ,(long long)synth_done
+          ,(long long)cycles
+          ,synth_done ? (double)synth_latency/synth_done : 0.0
+          ,(double)synth_done*lineBytes/cycles
+          ,secs
+          ,(double)synth_done/secs
+          ,synthBench.getEventRate());
+
+  synthBench.check(pattern, (double)synth_done/secs);
+}
+
 int main(int argc, const char **argv) { 
 
   BootLoader::plug(argc, argv);
@@ -672,7 +851,13 @@ int main(int argc, const char **argv) {
   crackInstARM.expand(&rinst);
   st = DInst::create(rinst.getInstRef(0), &rinst, rinst.getPC(), 0);
 
-  isca_demo();
+  if (SescConf->checkCharPtr(synthSection, "pattern")) {
+    int32_t nPatterns = SescConf->getRecordSize(synthSection, "pattern");
+    for(int32_t i=0;i<nPatterns;i++)
+      synth(SescConf->getCharPtr(synthSection, "pattern", i));
+  }else{
+    isca_demo();
+  }
 
   //printf("SINGLE CORE TEST\n");
   //single();
@@ -688,5 +873,5 @@ int main(int argc, const char **argv) {
 
 	printf("It performed a total of %lld operations\n", num_operations);
 
-  return 0;
+  return synthBench.hasFailed() ? 1 : 0;
 }
@@ -2,10 +2,13 @@
 #include <sys/time.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 #include "Report.h"
 //#include "ReportGen.h" This file doesn't exist. Replaced it with Report.h
 #include "SescConf.h"
+#include "SynthBench.h"
 #include "ProtocolBase.h"
 #include "InterConn.h"
 
@@ -24,9 +27,12 @@ public:
     PBTestMsg *msg = msgPool.out();
     msg->setupMessage((ProtocolBase *)srcPB, (ProtocolBase *)dstPB, TestMsg);
   //  msg->setupMessage((ProtocolBase *)1, (ProtocolBase *)2, TestMsg);
+    msg->sent = globalClock;
 
     return msg;
   };
+
+  Time_t sent; // for the synthetic traffic latency
   
   void garbageCollect() {
     msgPool.in(this);
@@ -59,6 +65,11 @@ public:
 // for the number of messages
 int32_t nMessages;
 
+// Synthetic traffic (synth): the test messages are not acked, and their
+// latency is accumulated
+bool     synthMode = false;
+uint64_t synthLatency;
+
 
 //Ok, a new class. What is ProtocolA?
 //And is the stuff under it part of the class? Just
@@ -94,6 +105,11 @@ public:
     conta++;
 
     I(this == msg->getDstPB());
+    if (synthMode) {
+      synthLatency += globalClock - msg->sent;
+      msg->garbageCollect();
+      return;
+    }
     if( conta & 1 ) {
       sendMsg(2,PBTestAckMsg::create(this,msg->getSrcPB()));
     }else if( conta & 2 ) {
@@ -125,26 +141,22 @@ std::vector<ProtocolA *> pa;
 InterConnection *net;
 size_t nRouters;
 
-Time_t  stClock;
-timeval stTime;
-timeval endTime;
+SynthBench synthBench("netBench");
 
 void startBench()
 {
-  gettimeofday(&stTime, 0);
-  stClock   = globalClock;
+  synthBench.start();
   nMessages = 0;
 };
 
 void endBench(const char *str)
 {
-  gettimeofday(&endTime, 0);
+  synthBench.stop();
+  double secs = synthBench.getSecs();
 
-  double msecs = (endTime.tv_sec - stTime.tv_sec) * 1000 
-    + (endTime.tv_usec - stTime.tv_usec) / 1000;
-  
-  fprintf(stderr,"%s: %8.2f KPackets/s or %8.2f Kclks/s\n"
-	  ,str,(double)nMessages/msecs,(double)(globalClock-stClock)/msecs);
+  // nMessages are the simulated messages delivered (handlers called)
+  fprintf(stderr,"%s: %d msgs in %8.3f host secs, %10.0f simulated msgs/host-sec or %8.2f Kclks/s\n"
+	  ,str,nMessages,secs,(double)nMessages/secs,(double)synthBench.getCycles()/(1000*secs));
 };
 
 
@@ -176,7 +188,7 @@ void bench2()
   for(size_t i=0; i< NMSG/nRouters ; i++ ) {
     for(size_t k=0; k< nRouters ; k++ ) {
     //  Message *msg = PBTestMsg::create(pa[(k*7) % nRouters]
-				       ,pa[(k*3)% nRouters]);
+    //				       ,pa[(k*3)% nRouters]);
       Message *msg = PBTestMsg::create(pa[(k*5) % nRouters]
 				       ,pa[(k*3)% nRouters]);
 
@@ -195,6 +207,103 @@ void bench2()
   }
 };
 
+/*
+ * Synthetic traffic. It runs if the configuration has a [netBench]
+ * section, one run per pattern[i]. Each router injects a message per cycle
+ * with probability injectRate/1000 during nCycles:
+ *
+ *  uniform   : random destination
+ *  neighbor  : next router
+ *  transpose : router (x,y) sends to (y,x) (square number of routers)
+ *  hotspot   : hotPct% of the messages go to router 0, the rest uniform
+ *
+ * The run reports the simulated latency and accepted throughput next to
+ * the host throughput (simulated messages and events per host second). The
+ * messages per host second are checked against the baseline file (see
+ * SynthBench.h).
+ */
+
+const char *synthSection = "netBench";
+
+void synth(const char *pattern)
+{
+  int32_t nCycles    = SescConf->getInt(synthSection, "nCycles");
+  int32_t injectRate = SescConf->getInt(synthSection, "injectRate");
+  int32_t hotPct     = SescConf->getInt(synthSection, "hotPct");
+
+  SescConf->isGT(synthSection, "nCycles", 0);
+  SescConf->isBetween(synthSection, "injectRate", 0, 1000);
+  SescConf->isBetween(synthSection, "hotPct", 0, 100);
+
+  size_t side = (size_t)sqrt((double)nRouters);
+  bool isUniform   = strcasecmp(pattern, "uniform") == 0;
+  bool isNeighbor  = strcasecmp(pattern, "neighbor") == 0;
+  bool isTranspose = strcasecmp(pattern, "transpose") == 0;
+  bool isHotspot   = strcasecmp(pattern, "hotspot") == 0;
+  if (!isUniform && !isNeighbor && !isTranspose && !isHotspot) {
+    MSG("ERROR: netBench unknown pattern [%s] (uniform, neighbor, transpose, hotspot)", pattern);
+    SescConf->notCorrect();
+  }
+  if (isTranspose && side*side != nRouters) {
+    MSG("ERROR: netBench transpose needs a square number of routers (%d)", (int)nRouters);
+    SescConf->notCorrect();
+  }
+  if (!SescConf->check()) {
+    MSG("ERROR: netBench configuration incorrect");
+    exit(-2);
+  }
+
+  synthBench.seed(SescConf->getInt(synthSection, "seed"));
+  synthMode    = true;
+  synthLatency = 0;
+
+  int32_t nSent = 0;
+  Time_t stClock = globalClock;
+  startBench();
+
+  for(int32_t t=0;t<nCycles;t++) {
+    for(size_t src=0;src<nRouters;src++) {
+      if ((int32_t)(synthBench.rand() % 1000) >= injectRate)
+        continue;
+
+      size_t dst;
+      if (isNeighbor)
+        dst = (src + 1) % nRouters;
+      else if (isTranspose)
+        dst = (src % side) * side + src / side;
+      else if (isHotspot && (int32_t)(synthBench.rand() % 100) < hotPct)
+        dst = 0;
+      else
+        dst = synthBench.rand() % nRouters;
+
+      net->sendMsg(PBTestMsg::create(pa[src], pa[dst]));
+      nSent++;
+    }
+    EventScheduler::advanceClock();
+  }
+  Time_t injEnd = globalClock;
+  while(nMessages < nSent)
+    EventScheduler::advanceClock();
+
+  synthBench.stop();
+  synthMode = false;
+
+  double secs = synthBench.getSecs();
+
+  fprintf(stderr,"netBench %-9s: %d msgs %lld cycles, avg lat %.2f cycles, %.3f msgs/router/kcycle"
+          " | %.3f host secs, %.0f msgs/host-sec, %.0f events/host-sec\n"
+          ,pattern
+          ,nMessages
+          ,(long long)synthBench.getCycles()
+          ,nMessages ? (double)synthLatency/nMessages : 0.0
+          ,(double)nMessages*1000/nRouters/(injEnd-stClock)
+          ,secs
+          ,(double)nMessages/secs
+          ,synthBench.getEventRate());
+
+  synthBench.check(pattern, (double)nMessages/secs);
+}
+
 /* Version 1 from Ehsan--fails at different point in gdb
 int32_t main(int32_t argc, char **argv, char **envp)
 {
@@ -257,12 +366,20 @@ int32_t main(int32_t argc, char **argv, char **envp)
   fprintf(stderr,"done\n");
   endBench("bench3");
 
+  if (SescConf->checkCharPtr(synthSection, "pattern")) {
+    int32_t nPatterns = SescConf->getRecordSize(synthSection, "pattern");
+    for(int32_t i=0;i<nPatterns;i++)
+      synth(SescConf->getCharPtr(synthSection, "pattern", i));
+  }
+
   for(int32_t k = 0; k < TIME_BUBBLE*100 ; k++) {
     EventScheduler::advanceClock();
   }
 
   GStats::report("netBench stats");
   Report::close();
+
+  return synthBench.hasFailed() ? 1 : 0;
 }
 
 
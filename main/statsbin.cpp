@@ -0,0 +1,48 @@
+/*
+   ESESC: Enhanced Super ESCalar simulator
+   Copyright (C) 2010 University California, Santa Cruz.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "GStatsBin.h"
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 || argc > 3) {
+    printf("Usage:\n\t%s esesc_xxx.stb [esesc_xxx]\n",argv[0]);
+    printf("\tPrints the report with the #BINARY rows expanded (or all the rows)\n");
+    exit(0);
+  }
+
+  FILE *text = 0;
+  if (argc == 3) {
+    text = fopen(argv[2], "r");
+    if (text == 0) {
+      fprintf(stderr, "ERROR: could not open report [%s]\n", argv[2]);
+      exit(-1);
+    }
+  }
+
+  bool ok = GStatsBin::toText(argv[1], text, stdout);
+
+  if (text)
+    fclose(text);
+
+  return ok ? 0 : -1;
+}
@@ -43,7 +43,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 // Class CacheGeneric, the combinational logic of Cache
 //
 template<class State, class Addr_t>
-CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(int32_t size, int32_t assoc, int32_t bsize, int32_t addrUnit, const char *pStr, bool skew, bool xr, uint32_t shct_size)
+CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(int32_t size, int32_t assoc, int32_t bsize, int32_t addrUnit, const char *pStr, bool skew, bool xr, uint32_t shct_size, bool soa)
 {
   CacheGeneric *cache;
 
@@ -68,7 +68,10 @@ CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(int32_t size, i
   }else if(size == (assoc * bsize)) {
     if (strcasecmp(pStr, k_SHIP) != 0){ 
       // TODO: Fully assoc can use STL container for speed
-      cache = new CacheAssoc<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, xr);
+      if (soa && assoc <= (int32_t)CacheAssocSoA<State, Addr_t>::MaxAssoc)
+        cache = new CacheAssocSoA<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, xr);
+      else
+        cache = new CacheAssoc<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, xr);
     } else {
       //SHIP Cache
       cache = new CacheSHIP<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, shct_size);
@@ -76,7 +79,10 @@ CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(int32_t size, i
   }else{
     if (strcasecmp(pStr, k_SHIP) != 0) {
       // Associative Cache
-      cache = new CacheAssoc<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, xr);
+      if (soa && assoc <= (int32_t)CacheAssocSoA<State, Addr_t>::MaxAssoc)
+        cache = new CacheAssocSoA<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, xr);
+      else
+        cache = new CacheAssoc<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, xr);
     } else {
       //SHIP Cache
       cache = new CacheSHIP<State, Addr_t>(size, assoc, bsize, addrUnit, pStr, shct_size);
@@ -125,6 +131,12 @@ CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(const char *sec
   if (SescConf->checkBool(section,"xorIndex")) {
     xr = SescConf->getBool(section, "xorIndex");
   }
+  // SIMD tag store (same replacement as CacheAssoc). Small structures with
+  // MRU locality are as fast with the pointer based one.
+  bool soa = b > 0 && (s/b) >= 2048;
+  if (SescConf->checkBool(section,"soaTags")) {
+    soa = SescConf->getBool(section, "soaTags");
+  }
   //printf("Created %s cache, with size:%d, assoc %d, bsize %d\n",section,s,a,b);
   bool sk = false;
   if (SescConf->checkBool(section, skew))
@@ -156,7 +168,7 @@ CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(const char *sec
      SescConf->isPower2(section, bsize) &&
      SescConf->isPower2(section, assoc) &&
      SescConf->isInList(section, repl, k_RANDOM, k_LRU, k_SHIP, k_LRUp)) {
-    cache = create(s, a, b, u, pStr, sk, xr, shct_size);
+    cache = create(s, a, b, u, pStr, sk, xr, shct_size, soa);
   } else {
     // this is just to keep the configuration going, 
     // sesc will abort before it begins
@@ -178,6 +190,31 @@ CacheGeneric<State, Addr_t> *CacheGeneric<State, Addr_t>::create(const char *sec
   return cache;
 }
 
+template<class State, class Addr_t>
+bool CacheGeneric<State, Addr_t>::beginCheckpoint(Checkpoint *ck, const char *name, Checkpoint::Group g, uint32_t layout, uint64_t extra)
+{
+  uint64_t sig = Checkpoint::signature(layout, size, lineSize, (assoc<<1) | xorIndex, addrUnit, (sizeof(CacheLine)<<32) ^ extra);
+
+  return ck->beginSection(g, sig, "%s", name);
+}
+
+template<class State, class Addr_t>
+void CacheGeneric<State, Addr_t>::checkpoint(Checkpoint *ck, const char *name, Checkpoint::Group g)
+{
+  if (!beginCheckpoint(ck, name, g, 0))
+    return;
+
+  // getPLine follows the replacement order (content pointers), so writing
+  // the lines back in the same position restores it
+  for(uint32_t i = 0; i < numLines; i++) {
+    CacheLine *l = getPLine(i);
+    l->checkpoint(ck);
+    ck->io(l->recent);
+  }
+
+  ck->endSection();
+}
+
 /*********************************************************
  *  CacheAssoc
  *********************************************************/
@@ -347,6 +384,204 @@ typename CacheAssoc<State, Addr_t>::Line
   return tmp;
 }
 
+/*********************************************************
+ *  CacheAssocSoA
+ *********************************************************/
+
+template<class State, class Addr_t>
+CacheAssocSoA<State, Addr_t>::CacheAssocSoA(int32_t size, int32_t assoc, int32_t blksize, int32_t addrUnit, const char *pStr, bool xr) 
+  : CacheGeneric<State, Addr_t>(size, assoc, blksize, addrUnit, xr) 
+{
+  I(numLines>0);
+  I(assoc<=(int32_t)MaxAssoc);
+  
+  if (strcasecmp(pStr, k_RANDOM) == 0) 
+    policy = RANDOM;
+  else if (strcasecmp(pStr, k_LRU)    == 0) 
+    policy = LRU;
+  else if (strcasecmp(pStr, k_LRUp)    == 0) 
+    policy = LRUp;
+  else {
+    MSG("Invalid cache policy [%s]",pStr);
+    exit(0);
+  }
+
+  mem     = (Line *)malloc(sizeof(Line)*(numLines + 1));
+  for(uint32_t i=0;i<numLines;i++) {
+    new(&mem[i]) Line(blksize);
+  }
+
+  void *ptr;
+  if (posix_memalign(&ptr, 64, sizeof(Addr_t)*numLines)) {
+    MSG("ERROR: could not allocate the cache tags");
+    exit(-1);
+  }
+  tags = (Addr_t *)ptr;
+
+  uint32_t nSets = this->getNumSets();
+  log2Assoc = log2i(assoc);
+  rankWords = (assoc + 7) / 8;
+  rank      = new uint64_t[nSets * rankWords];
+  mruWay    = new uint8_t[nSets];
+  bzero(mruWay, nSets);
+
+  // Initial order as CacheAssoc (way i in position i)
+  for(uint32_t s = 0; s < nSets; s++) {
+    for(uint32_t i = 0; i < rankWords; i++) {
+      uint64_t word = 0;
+      for(uint32_t b = 0; b < 8; b++) {
+        uint64_t w = i*8 + b;
+        word |= (w < (uint32_t)assoc ? w : 0x7F) << (b*8);
+      }
+      rank[s*rankWords + i] = word;
+    }
+  }
+
+  for(uint32_t i = 0; i < numLines; i++) {
+    mem[i].initialize(this);
+    mem[i].invalidate();
+    tags[i] = 0;
+  }
+  
+  irand = 0;
+}
+
+template<class State, class Addr_t>
+int32_t CacheAssocSoA<State, Addr_t>::findWay(uint32_t index, Addr_t tag) const
+{
+  const Addr_t  *t = &tags[index];
+  const uint32_t n = assoc;
+
+  // Compare 4 tags at a time and stop at the first group with a match. There
+  // can be more than one match (stale tag after invalidate), so each one is
+  // checked against its Line.
+  for(uint32_t base=0;base<n;base+=4) {
+    uint32_t m = 0;
+
+#if defined(__SSE2__)
+    if (sizeof(Addr_t) == 8 && base+4 <= n) {
+#if defined(__AVX2__)
+      __m256i c = _mm256_cmpeq_epi64(_mm256_load_si256((const __m256i *)&t[base]), _mm256_set1_epi64x((long long)tag));
+      m = _mm256_movemask_pd(_mm256_castsi256_pd(c));
+#else
+      // No 64bit compare in SSE2: both halves must match
+      const __m128i key = _mm_set1_epi64x((long long)tag);
+      __m128i c0 = _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)&t[base]),   key);
+      __m128i c1 = _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)&t[base+2]), key);
+      c0 = _mm_and_si128(c0, _mm_shuffle_epi32(c0, _MM_SHUFFLE(2,3,0,1)));
+      c1 = _mm_and_si128(c1, _mm_shuffle_epi32(c1, _MM_SHUFFLE(2,3,0,1)));
+      m  = _mm_movemask_pd(_mm_castsi128_pd(c0)) | (_mm_movemask_pd(_mm_castsi128_pd(c1)) << 2);
+#endif
+    }else if (sizeof(Addr_t) == 4 && base+4 <= n) {
+      __m128i c = _mm_cmpeq_epi32(_mm_load_si128((const __m128i *)&t[base]), _mm_set1_epi32((int)tag));
+      m = _mm_movemask_ps(_mm_castsi128_ps(c));
+    }else
+#endif
+    {
+      for(uint32_t i=base;i<n && i<base+4;i++)
+        m |= (t[i] == tag) << (i-base);
+    }
+
+    while(m) {
+      uint32_t w = base + __builtin_ctz(m);
+      if (likely(mem[index+w].getTag() == tag))
+        return w;
+      m &= m - 1;
+    }
+  }
+
+  return -1;
+}
+
+template<class State, class Addr_t>
+int32_t CacheAssocSoA<State, Addr_t>::findRank(uint32_t index, uint8_t r) const
+{
+  const uint64_t  Ones  = 0x0101010101010101ULL;
+  const uint64_t  Highs = 0x8080808080808080ULL;
+  const uint64_t *rk    = getRank(index);
+
+  for(uint32_t i=0;i<rankWords;i++) {
+    uint64_t x    = rk[i] ^ (r * Ones);
+    uint64_t zero = (x - Ones) & ~x & Highs; // lowest set byte is exact
+    if (zero)
+      return i*8 + (__builtin_ctzll(zero) >> 3);
+  }
+  I(0);
+  return 0;
+}
+
+template<class State, class Addr_t>
+typename CacheAssocSoA<State, Addr_t>::Line *CacheAssocSoA<State, Addr_t>::findLinePrivate(Addr_t addr, bool updateSHIP, Addr_t SHIP_signature)
+{
+  Addr_t   tag   = this->calcTag(addr);
+  uint32_t index = this->calcIndex4Tag(tag);
+
+  // Check most typical case
+  uint32_t mru = mruWay[index >> log2Assoc];
+  if (tags[index+mru] == tag && mem[index+mru].getTag() == tag) {
+    I(mem[index+mru].isValid());
+    return &mem[index+mru];
+  }
+
+  int32_t way = findWay(index, tag);
+  if (way < 0)
+    return 0;
+
+  I(mem[index+way].isValid());
+
+  // No matter what is the policy, move the hit to the MRU (like CacheAssoc)
+  moveToFront(index, way);
+
+  return &mem[index+way];
+}
+
+template<class State, class Addr_t>
+typename CacheAssocSoA<State, Addr_t>::Line 
+*CacheAssocSoA<State, Addr_t>::findLine2Replace(Addr_t addr, bool updateSHIP, Addr_t SHIP_signature)
+{ 
+  Addr_t   tag   = this->calcTag(addr);
+  I(tag);
+  uint32_t index = this->calcIndex4Tag(tag);
+
+  int32_t way = findWay(index, tag);
+  if (way < 0) {
+    if (policy == RANDOM) {
+      way   = findRank(index, irand);
+      irand = (irand + 1) & maskAssoc;
+    }else{
+      I(policy == LRU || policy == LRUp);
+      // Get the oldest line possible
+      way = findRank(index, assoc-1);
+    }
+    tags[index+way] = tag; // fillLine sets the Line tag
+  }
+
+  if (policy != LRUp)
+    moveToFront(index, way);
+
+  return &mem[index+way];
+}
+
+template<class State, class Addr_t>
+void CacheAssocSoA<State, Addr_t>::checkpoint(Checkpoint *ck, const char *name, Checkpoint::Group g)
+{
+  if (!this->beginCheckpoint(ck, name, g, 1))
+    return;
+
+  uint32_t nSets = this->getNumSets();
+
+  // Lines in place, with the tag store and the ranks
+  for(uint32_t i = 0; i < numLines; i++) {
+    mem[i].checkpoint(ck);
+    ck->io(mem[i].recent);
+  }
+  ck->io(tags, sizeof(Addr_t)*numLines);
+  ck->io(rank, sizeof(uint64_t)*nSets*rankWords);
+  ck->io(mruWay, nSets);
+
+  ck->endSection();
+}
+
 /*********************************************************
  *  CacheDM
  *********************************************************/
@@ -752,3 +987,19 @@ typename CacheSHIP<State, Addr_t>::Line
 */
   return tmp;
 }
+
+template<class State, class Addr_t>
+void CacheSHIP<State, Addr_t>::checkpoint(Checkpoint *ck, const char *name, Checkpoint::Group g)
+{
+  if (!this->beginCheckpoint(ck, name, g, 2, log2shct))
+    return;
+
+  for(uint32_t i = 0; i < numLines; i++) {
+    Line *l = content[i];
+    l->checkpoint(ck);
+    ck->io(l->recent);
+  }
+  ck->io(SHCT, 2<<log2shct);
+
+  ck->endSection();
+}
@@ -43,6 +43,14 @@
 
 #include "nanassert.h"
 #include "Snippets.h"
+#include "Checkpoint.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 //-------------------------------------------------------------
 #define RRIP_M 4         // max value = 2^M   | 4 | 8   | 16   |
@@ -121,9 +129,11 @@ template<class State, class Addr_t>
 
   void createStats(const char *section, const char *name);
 
+  bool beginCheckpoint(Checkpoint *ck, const char *name, Checkpoint::Group g, uint32_t layout, uint64_t extra = 0);
+
   public:
   // Do not use this interface, use other create
-  static CacheGeneric<State, Addr_t> *create(int32_t size, int32_t assoc, int32_t blksize, int32_t addrUnit, const char *pStr, bool skew, bool xr, uint32_t shct_size = 13); //13 is the optimal size specified in the paper
+  static CacheGeneric<State, Addr_t> *create(int32_t size, int32_t assoc, int32_t blksize, int32_t addrUnit, const char *pStr, bool skew, bool xr, uint32_t shct_size = 13, bool soa = false); //13 is the optimal size specified in the paper
   static CacheGeneric<State, Addr_t> *create(const char *section, const char *append, const char *format, ...);
   void destroy() {
     delete this;
@@ -131,6 +141,10 @@ template<class State, class Addr_t>
 
   virtual CacheLine *findLine2Replace(Addr_t addr,  bool updateSHIP, Addr_t SHIP_signature)=0;
 
+  // Save/restore the tags, the replacement order and the State of each line
+  // (State::checkpoint). See Checkpoint.h
+  virtual void checkpoint(Checkpoint *ck, const char *name, Checkpoint::Group g = Checkpoint::Independent);
+
   // TO DELETE if flush from Cache.cpp is cleared.  At least it should have a
   // cleaner interface so that Cache.cpp does not touch the internals.
   //
@@ -267,7 +281,7 @@ protected:
 public:
   virtual ~CacheAssoc() {
     delete [] content;
-    delete [] mem;
+    free(mem);
   }
 
   // TODO: do an iterator. not this junk!!
@@ -280,6 +294,84 @@ public:
   Line *findLine2Replace(Addr_t addr, bool updateSHIP = false, Addr_t SHIP_signature = 0);
 };
 
+// Same behavior as CacheAssoc (LRU, LRUp, RANDOM), but the tags of a set are
+// contiguous and compared with SIMD, so a lookup only touches the Line that
+// hits. The tags never move; the MRU order is a per-way rank byte (8 packed
+// per word, updated with word operations) instead of reordering pointers.
+// Tags are only written here (fillLine), so a stale tag left by
+// Line::invalidate is filtered by checking the Line tag.
+template<class State, class Addr_t>
+class CacheAssocSoA : public CacheGeneric<State, Addr_t> {
+  using CacheGeneric<State, Addr_t>::numLines;
+  using CacheGeneric<State, Addr_t>::assoc;
+  using CacheGeneric<State, Addr_t>::maskAssoc;
+  using CacheGeneric<State, Addr_t>::goodInterface;
+
+private:
+public:
+  typedef typename CacheGeneric<State, Addr_t>::CacheLine Line;
+
+  static const uint32_t MaxAssoc = 128; // ranks use 7 bits
+
+protected:
+
+  Line     *mem;
+  Addr_t   *tags;      // numLines, set major
+  uint64_t *rank;      // rankWords per set, 0 is MRU, assoc-1 is LRU (unused bytes 0x7F)
+  uint8_t  *mruWay;    // per set, way with rank 0
+  uint32_t  rankWords;
+  uint32_t  log2Assoc;
+  uint16_t  irand;
+  ReplacementPolicy policy;
+
+  friend class CacheGeneric<State, Addr_t>;
+  CacheAssocSoA(int32_t size, int32_t assoc, int32_t blksize, int32_t addrUnit, const char *pStr, bool xr);
+
+  int32_t findWay(uint32_t index, Addr_t tag) const;
+  int32_t findRank(uint32_t index, uint8_t r) const;
+
+  uint64_t *getRank(uint32_t index) const {
+    return &rank[(index >> log2Assoc) * rankWords];
+  }
+
+  void moveToFront(uint32_t index, uint32_t way) {
+    uint64_t *r   = getRank(index);
+    uint64_t  pos = (r[way>>3] >> ((way & 7)*8)) & 0xFF;
+    if (pos == 0)
+      return;
+
+    // +1 to every rank below pos (bytes are < 0x80, so no borrow across bytes)
+    const uint64_t Ones  = 0x0101010101010101ULL;
+    const uint64_t Highs = 0x8080808080808080ULL;
+    const uint64_t bound = Highs + (pos - 1)*Ones;
+    for(uint32_t i=0;i<rankWords;i++)
+      r[i] += ((bound - r[i]) & Highs) >> 7;
+
+    r[way>>3] &= ~(0xFFULL << ((way & 7)*8));
+    mruWay[index >> log2Assoc] = way;
+  }
+
+  Line *findLinePrivate(Addr_t addr, bool updateSHIP = false, Addr_t SHIP_signature = 0 );
+public:
+  virtual ~CacheAssocSoA() {
+    free(tags);
+    delete [] rank;
+    delete [] mruWay;
+    free(mem);
+  }
+
+  Line *getPLine(uint32_t l) {
+    // Lines [l..l+assoc] belong to the same set (MRU order, like CacheAssoc)
+    I(l<numLines);
+    uint32_t index = l & ~maskAssoc;
+    return &mem[index + findRank(index, l & maskAssoc)];
+  }
+
+  Line *findLine2Replace(Addr_t addr, bool updateSHIP = false, Addr_t SHIP_signature = 0);
+
+  void checkpoint(Checkpoint *ck, const char *name, Checkpoint::Group g = Checkpoint::Independent);
+};
+
 template<class State, class Addr_t>
 class CacheDM : public CacheGeneric<State, Addr_t> {
   using CacheGeneric<State, Addr_t>::numLines;
@@ -390,6 +482,8 @@ public:
   }
 
   Line *findLine2Replace(Addr_t addr, bool updateSHIP = false, Addr_t SHIP_signature = 0);
+
+  void checkpoint(Checkpoint *ck, const char *name, Checkpoint::Group g = Checkpoint::Independent);
 };
 
 
@@ -451,6 +545,13 @@ public:
 
  virtual void dump(const char *str) {
  }
+
+ void checkpoint(Checkpoint *ck) {
+   ck->io(tag);
+   ck->io(rrpv);
+   ck->io(signature);
+   ck->io(outcome);
+ }
 };
 
 // [sizhuo] generic cache line: only a tag
@@ -482,6 +583,11 @@ public:
  virtual void dump(const char *str) {
  }
 
+ // Derived states with more fields hide it (call it first, then io() the rest)
+ void checkpoint(Checkpoint *ck) {
+   ck->io(tag);
+ }
+
  Addr_t getSignature() const { return 0; }
  void setSignature(Addr_t a) {
    I(0); // Incorrect state used for SHIP
@@ -0,0 +1,286 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "nanassert.h"
+#include "Checkpoint.h"
+
+static const char CheckpointMagic[8] = { 'E', 'S', 'E', 'S', 'C', 'C', 'K', 'P' };
+
+/* File layout:
+ *
+ *  header : magic[8] version(u32) nSections(u32) key(u64)
+ *  section: nameLen(u32) name group(u32) signature(u64) size(u64) data[size]
+ */
+
+Checkpoint::Checkpoint(FILE *fp_, const char *fname_, bool saving_, uint64_t key_)
+  : fp(fp_)
+  ,fname(strdup(fname_))
+  ,saving(saving_)
+  ,probing(false)
+  ,key(key_)
+  ,nSections(0)
+  ,sizePos(0)
+  ,secLeft(0)
+  ,inSection(false)
+  ,nRestored(0)
+  ,nCold(0)
+{
+  for(int i=0;i<MaxGroup;i++) {
+    nFile[i]     = 0;
+    nMatch[i]    = 0;
+    nMismatch[i] = 0;
+    groupOk[i]   = true;
+  }
+}
+
+Checkpoint::~Checkpoint()
+{
+  I(!inSection);
+
+  if (saving) {
+    // patch the number of sections
+    fseek(fp, sizeof(CheckpointMagic) + sizeof(uint32_t), SEEK_SET);
+    write(&nSections, sizeof(nSections));
+  }
+  if (fclose(fp) != 0 && saving) {
+    MSG("ERROR: could not write checkpoint [%s]", fname);
+    exit(-2);
+  }
+  free((void *)fname);
+}
+
+Checkpoint *Checkpoint::create(const char *fname, uint64_t key)
+{
+  FILE *fp = fopen(fname, "w");
+  if (fp == 0)
+    return 0;
+
+  Checkpoint *ck = new Checkpoint(fp, fname, true, key);
+
+  uint32_t version = Version;
+  ck->write(CheckpointMagic, sizeof(CheckpointMagic));
+  ck->write(&version, sizeof(version));
+  ck->write(&ck->nSections, sizeof(ck->nSections));
+  ck->write(&key, sizeof(key));
+
+  return ck;
+}
+
+Checkpoint *Checkpoint::open(const char *fname)
+{
+  FILE *fp = fopen(fname, "r");
+  if (fp == 0)
+    return 0;
+
+  Checkpoint *ck = new Checkpoint(fp, fname, false, 0);
+  if (!ck->readIndex()) {
+    delete ck;
+    return 0;
+  }
+
+  return ck;
+}
+
+bool Checkpoint::readIndex()
+  /* read the header and the position of all the sections {{{1 */
+{
+  char     magic[sizeof(CheckpointMagic)];
+  uint32_t version;
+
+  if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, CheckpointMagic, sizeof(magic)) != 0) {
+    MSG("ERROR: [%s] is not a checkpoint file", fname);
+    return false;
+  }
+  if (fread(&version, sizeof(version), 1, fp) != 1 || version != Version) {
+    MSG("ERROR: checkpoint [%s] has version %u (expected %u)", fname, version, Version);
+    return false;
+  }
+  if (fread(&nSections, sizeof(nSections), 1, fp) != 1 || fread(&key, sizeof(key), 1, fp) != 1) {
+    MSG("ERROR: checkpoint [%s] is truncated", fname);
+    return false;
+  }
+
+  for(uint32_t i=0;i<nSections;i++) {
+    uint32_t len;
+    Section  s;
+
+    if (fread(&len, sizeof(len), 1, fp) != 1 || len > 4096) {
+      MSG("ERROR: checkpoint [%s] is truncated", fname);
+      return false;
+    }
+    std::string name(len, ' ');
+    if (fread(&name[0], len, 1, fp) != 1
+        || fread(&s.group, sizeof(s.group), 1, fp) != 1
+        || fread(&s.signature, sizeof(s.signature), 1, fp) != 1
+        || fread(&s.size, sizeof(s.size), 1, fp) != 1
+        || s.group >= MaxGroup) {
+      MSG("ERROR: checkpoint [%s] is truncated", fname);
+      return false;
+    }
+    s.offset = ftell(fp);
+    sections[name] = s;
+    nFile[s.group]++;
+
+    if (fseek(fp, s.size, SEEK_CUR) != 0) {
+      MSG("ERROR: checkpoint [%s] is truncated", fname);
+      return false;
+    }
+  }
+
+  return true;
+}
+/* }}} */
+
+uint64_t Checkpoint::signature(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f)
+  /* FNV-1a of the geometry parameters {{{1 */
+{
+  const uint64_t v[6] = { a, b, c, d, e, f };
+
+  uint64_t h = 14695981039346656037ULL;
+  for(int i=0;i<6;i++) {
+    for(int j=0;j<8;j++) {
+      h ^= (v[i] >> (j*8)) & 0xFF;
+      h *= 1099511628211ULL;
+    }
+  }
+  return h;
+}
+/* }}} */
+
+void Checkpoint::setProbe(bool p)
+{
+  I(!saving);
+
+  if (probing && !p) {
+    // A group is restored if all its sections match in both directions
+    for(int i=0;i<MaxGroup;i++)
+      groupOk[i] = nMismatch[i] == 0 && nMatch[i] == nFile[i];
+  }
+  probing = p;
+}
+
+bool Checkpoint::beginSection(Group g, uint64_t sig, const char *format, ...)
+{
+  I(!inSection);
+  I(g < MaxGroup);
+
+  char name[1024];
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(name, sizeof(name), format, ap);
+  va_end(ap);
+
+  if (saving) {
+    uint32_t len   = strlen(name);
+    uint32_t group = g;
+    uint64_t size  = 0;
+    write(&len, sizeof(len));
+    write(name, len);
+    write(&group, sizeof(group));
+    write(&sig, sizeof(sig));
+    sizePos = ftell(fp);
+    write(&size, sizeof(size));
+
+    nSections++;
+    inSection = true;
+    return true;
+  }
+
+  SectionMap::const_iterator it = sections.find(name);
+  bool match = it != sections.end() && it->second.signature == sig && it->second.group == (uint32_t)g;
+
+  if (probing) {
+    if (match)
+      nMatch[g]++;
+    else
+      nMismatch[g]++;
+    return false;
+  }
+
+  if (!match || !groupOk[g]) {
+    nCold++;
+    return false;
+  }
+
+  if (fseek(fp, it->second.offset, SEEK_SET) != 0) {
+    MSG("ERROR: checkpoint [%s] is truncated", fname);
+    exit(-2);
+  }
+  secLeft   = it->second.size;
+  inSection = true;
+  nRestored++;
+  return true;
+}
+
+void Checkpoint::endSection()
+{
+  I(inSection);
+  inSection = false;
+
+  if (saving) {
+    long end = ftell(fp);
+    uint64_t size = end - sizePos - sizeof(uint64_t);
+    fseek(fp, sizePos, SEEK_SET);
+    write(&size, sizeof(size));
+    fseek(fp, end, SEEK_SET);
+    return;
+  }
+
+  if (secLeft) {
+    // Same signature but different contents: the writer changed
+    MSG("ERROR: checkpoint [%s] section has %llu extra bytes (rebuild the checkpoint)", fname, (unsigned long long)secLeft);
+    exit(-2);
+  }
+}
+
+void Checkpoint::write(const void *data, size_t size)
+{
+  I(saving);
+  if (fwrite(data, 1, size, fp) != size) {
+    MSG("ERROR: could not write checkpoint [%s]", fname);
+    exit(-2);
+  }
+}
+
+void Checkpoint::read(void *data, size_t size)
+{
+  I(!saving);
+  I(inSection);
+
+  if (size > secLeft || fread(data, 1, size, fp) != size) {
+    MSG("ERROR: checkpoint [%s] section is shorter than expected (rebuild the checkpoint)", fname);
+    exit(-2);
+  }
+  secLeft -= size;
+}
+
+void Checkpoint::report() const
+{
+  if (saving) {
+    MSG("checkpoint [%s] saved at instruction %llu, %u sections", fname, (unsigned long long)key, nSections);
+    return;
+  }
+
+  MSG("checkpoint [%s] restored at instruction %llu, %u sections restored, %u left cold", fname, (unsigned long long)key, nRestored, nCold);
+  if (!groupOk[Coherent])
+    MSG("checkpoint [%s] cache hierarchy does not match the configuration, caches start cold", fname);
+}
@@ -0,0 +1,133 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+
+/*
+ * Snapshot of the warm microarchitectural state (cache arrays, TLBs, branch
+ * predictors, prefetcher tables, memory controller banks) keyed by the
+ * instruction count where it was taken.
+ *
+ * The file has a header (magic, Version, key) and one named section per
+ * structure. A section carries a signature of the structure geometry, so the
+ * same checkpoint(Checkpoint *) method saves and restores through io(), and a
+ * restore only loads the sections whose name and signature match the current
+ * configuration. The rest of the structures stay cold.
+ *
+ * Sections in the Coherent group (cache levels that keep a directory of the
+ * upper levels) are restored all or nothing: a restore first runs a probe
+ * pass (setProbe) over all the objects to check the whole group.
+ *
+ * Data is stored in host byte order.
+ */
+
+class Checkpoint {
+public:
+  enum {
+    Version = 1
+  };
+
+  enum Group {
+    Independent = 0,
+    Coherent,
+    MaxGroup
+  };
+
+private:
+  class Section {
+  public:
+    uint64_t signature;
+    uint32_t group;
+    long     offset; // data start
+    uint64_t size;
+  };
+  typedef std::map<std::string, Section> SectionMap;
+
+  FILE       *fp;
+  const char *fname;
+  const bool  saving;
+  bool        probing;
+  uint64_t    key;
+  uint32_t    nSections;
+
+  // Save: position of the size field of the open section
+  // Load: bytes left in the open section
+  long        sizePos;
+  uint64_t    secLeft;
+  bool        inSection;
+
+  SectionMap  sections; // load only
+  uint32_t    nFile[MaxGroup];
+  uint32_t    nMatch[MaxGroup];
+  uint32_t    nMismatch[MaxGroup];
+  bool        groupOk[MaxGroup];
+
+  uint32_t    nRestored;
+  uint32_t    nCold;
+
+  Checkpoint(FILE *fp, const char *fname, bool saving, uint64_t key);
+
+  void write(const void *data, size_t size);
+  void read(void *data, size_t size);
+  bool readIndex();
+
+public:
+  ~Checkpoint();
+
+  // Create a snapshot file (returns 0 if it can not be created)
+  static Checkpoint *create(const char *fname, uint64_t key);
+  // Open a snapshot (returns 0 if missing, or with another format/version)
+  static Checkpoint *open(const char *fname);
+
+  static uint64_t signature(uint64_t a, uint64_t b = 0, uint64_t c = 0, uint64_t d = 0, uint64_t e = 0, uint64_t f = 0);
+
+  bool     isSaving() const { return saving; }
+  uint64_t getKey() const   { return key;    }
+
+  // Restore only: while probing, beginSection only records matches
+  void setProbe(bool p);
+
+  // Returns true if the caller must io() the section data (and endSection)
+  bool beginSection(Group g, uint64_t sig, const char *format, ...)
+    __attribute__ ((format (printf, 4, 5)));
+  void endSection();
+
+  void io(void *data, size_t size) {
+    if (saving)
+      write(data, size);
+    else
+      read(data, size);
+  }
+  template<class T>
+  void io(T &v) {
+    io(&v, sizeof(T));
+  }
+
+  void report() const;
+};
+
+#endif // CHECKPOINT_H
@@ -30,6 +30,7 @@
 #include <math.h>
 
 #include "GStats.h"
+#include "GStatsBin.h"
 #include "Report.h"
 
 /*********************** GStats */
@@ -37,6 +38,7 @@
 GStats::Container GStats::store;
 
 GStats::GStats() 
+  : binIndex(-1)
 {
 
 }
@@ -77,10 +79,19 @@ void GStats::unsubscribe()
   if( it != store.end()) {
     store.erase(it);
   }
+  if (binIndex >= 0)
+    GStatsBin::remove(this);
 }
 
 void GStats::report(const char *str)
 {
+  if (GStatsBin::isOpen()) {
+    // The text report only keeps a reference (statsbin expands it)
+    uint32_t row = GStatsBin::append(str);
+    Report::field("#BINARY GStats::report row=%u %s", row, str);
+    return;
+  }
+
   Report::field("#BEGIN GStats::report %s", str);
 
   for(ContainerIter it = store.begin(); it != store.end(); it++) {
@@ -90,6 +101,13 @@ void GStats::report(const char *str)
   Report::field("#END GStats::report %s", str);
 }
 
+void GStats::weight(double w)
+{
+  for(ContainerIter it = store.begin(); it != store.end(); it++) {
+    it->second->weightInterval(w);
+  }
+}
+
 GStats *GStats::getRef(const char *str) {
 
   ContainerIter it = store.find(str);
@@ -114,6 +132,7 @@ GStatsCntr::GStatsCntr(const char *format,...)
   va_end(ap);
 
   data    = 0;
+  base    = 0;
 
   name = str;
   I(*name!=0);
@@ -135,6 +154,12 @@ int64_t GStatsCntr::getSamples() const
   return (int64_t)data;
 }
 
+void GStatsCntr::weightInterval(double w)
+{
+  data = base + w*(data - base);
+  base = data;
+}
+
 /*********************** GStatsAvg */
 
 GStatsAvg::GStatsAvg(const char *format,...)
@@ -148,6 +173,8 @@ GStatsAvg::GStatsAvg(const char *format,...)
 
   data  = 0;
   nData = 0;
+  dataBase  = 0;
+  nDataBase = 0;
 
   name = str;
   subscribe();
@@ -168,6 +195,15 @@ int64_t GStatsAvg::getSamples() const
   return nData;
 }
 
+void GStatsAvg::weightInterval(double w)
+{
+  // nData is rounded, the average keeps the weighted data/nData ratio
+  data  = dataBase  + w*(data - dataBase);
+  nData = nDataBase + llround(w*(nData - nDataBase));
+  dataBase  = data;
+  nDataBase = nData;
+}
+
 /*********************** GStatsMax */
 
 GStatsMax::GStatsMax(const char *format,...)
@@ -216,6 +252,8 @@ GStatsHist::GStatsHist(const char *format,...) : numSample(0), cumulative(0)
 
   numSample  = 0;
   cumulative = 0;
+  numSampleBase  = 0;
+  cumulativeBase = 0;
 
   name = str;
   subscribe();
@@ -240,6 +278,21 @@ void GStatsHist::reportValue() const
   Report::field("%s:n=%f"   ,name,numSample);
 }
 
+void GStatsHist::getBinValues(double *v) const
+{
+  uint32_t maxKey = 0;
+  for(Histogram::const_iterator it=H.begin();it!=H.end();it++) {
+    if(it->first > maxKey)
+      maxKey = it->first;
+  }
+  long double div = cumulative;
+  div /= numSample;
+
+  v[0] = maxKey;
+  v[1] = (double)div;
+  v[2] = numSample;
+}
+
 void GStatsHist::sample(bool enable, uint32_t key, double weight)
 {
   if(enable) {
@@ -258,3 +311,61 @@ int64_t GStatsHist::getSamples() const
   return static_cast<int64_t>(numSample);
 }
 
+void GStatsHist::weightInterval(double w)
+{
+  for(Histogram::iterator it=H.begin();it!=H.end();it++) {
+    double b = 0;
+    Histogram::const_iterator bit = HBase.find(it->first);
+    if (bit != HBase.end())
+      b = bit->second;
+    it->second = b + w*(it->second - b);
+  }
+  HBase = H;
+
+  numSample  = numSampleBase  + w*(numSample - numSampleBase);
+  cumulative = cumulativeBase + w*(cumulative - cumulativeBase);
+  numSampleBase  = numSample;
+  cumulativeBase = cumulative;
+}
+
+/*********************** GStatsSnapshot */
+
+GStatsSnapshot::~GStatsSnapshot()
+{
+  for(size_t i=0;i<slowValue.size();i++)
+    delete slowValue[i];
+}
+
+int32_t GStatsSnapshot::add(const char *str)
+{
+  GStats *ref = GStats::getRef(str);
+  if (ref == 0)
+    return -1;
+
+  const double *v = ref->getSamplesRef();
+  if (v == 0) {
+    double *copy = new double(0);
+    slowStat.push_back(ref);
+    slowValue.push_back(copy);
+    v = copy;
+  }
+
+  // The first delta counts from the beginning
+  value.push_back(v);
+  last.push_back(0);
+  delta.push_back(0);
+
+  return value.size() - 1;
+}
+
+void GStatsSnapshot::update()
+{
+  for(size_t i=0;i<slowStat.size();i++)
+    *slowValue[i] = static_cast<double>(slowStat[i]->getSamples());
+
+  for(size_t i=0;i<value.size();i++) {
+    double v = *value[i];
+    delta[i] = v - last[i];
+    last[i]  = v;
+  }
+}
@@ -45,6 +45,7 @@ public:
 
 class GStats {
 private:
+  friend class GStatsBin;
   typedef HASH_MAP<const char *, GStats *, HASH<const char*>, GStats_strcasecmp > Container;
   typedef HASH_MAP<const char *, GStats *, HASH<const char*>, GStats_strcasecmp >::iterator ContainerIter;
   static Container store;
@@ -58,9 +59,12 @@ protected:
 
 public:
   int32_t gd;
+  int32_t binIndex; // field in GStatsBin (-1 not in the schema yet)
 
   static void report(const char *str);
   static GStats *getRef(const char *str);
+  // Scale what every stat collected since the previous call by w (SimPoint weights)
+  static void weight(double w);
 
   GStats();
   virtual ~GStats();
@@ -76,11 +80,22 @@ public:
 
   const char *getName() const { return name; }
   virtual int64_t getSamples() const = 0;
+  // Address of a double that getSamples truncates (0 if there is none)
+  virtual const double *getSamplesRef() const { return 0; }
+
+  virtual void weightInterval(double w) { }
+
+  // Binary report (GStatsBin): kind and fixed columns. A stat whose
+  // reportValue is not "name=samples" needs its own kind (GStatsBin.cpp)
+  virtual char    getBinKind() const { return 'o'; }
+  virtual int32_t getBinCols() const { return 1;   }
+  virtual void    getBinValues(double *v) const { v[0] = static_cast<double>(getSamples()); }
 };
 
 class GStatsCntr : public GStats {
 private:
   double data;
+  double base; // value at the last weight
 protected:
 public:
   GStatsCntr(const char *format,...);
@@ -103,8 +118,13 @@ public:
 
   double  getDouble() const;
   int64_t getSamples() const;
+  const double *getSamplesRef() const { return &data; }
 
   void reportValue() const;
+  void weightInterval(double w);
+
+  char    getBinKind() const { return 'c'; }
+  void    getBinValues(double *v) const { v[0] = data; }
 };
 
 class GStatsAvg : public GStats {
@@ -112,20 +132,32 @@ private:
 protected:
   double data;
   int64_t nData;
+  double  dataBase;
+  int64_t nDataBase;
 public:
   GStatsAvg(const char *format,...);
-  GStatsAvg() { }
+  GStatsAvg() : dataBase(0), nDataBase(0) { }
 
-  void    reset() { data = 0; nData = 0; };
+  void    reset() { data = 0; nData = 0; dataBase = 0; nDataBase = 0; };
   double  getDouble() const;
 
   virtual void sample(const double v, bool en = true) {
     data  += en ? v : 0;
     nData += en ? 1 : 0;
   }
+  // Same as n calls to sample(v, en)
+  void sampleRepeat(const double v, int64_t n, bool en) {
+    data  += en ? v*n : 0;
+    nData += en ? n : 0;
+  }
   int64_t getSamples() const;
 
   virtual void reportValue() const;
+  void weightInterval(double w);
+
+  char    getBinKind() const { return 'a'; }
+  int32_t getBinCols() const { return 2;   }
+  void    getBinValues(double *v) const { v[0] = nData; v[1] = getDouble(); }
 };
 
 class GStatsMax : public GStats {
@@ -141,10 +173,15 @@ public:
   int64_t getSamples() const;
 
   void reportValue() const;
+
+  char    getBinKind() const { return 'm'; }
+  int32_t getBinCols() const { return 2;   }
+  void    getBinValues(double *v) const { v[0] = maxValue; v[1] = nData; }
 };
 
 class GStatsHist : public GStats {
 private:
+  friend class GStatsBin; // buckets
 protected:
   
   typedef HASH_MAP<uint32_t, double> Histogram;
@@ -153,15 +190,52 @@ protected:
   double cumulative;
 
   Histogram H;
+  Histogram HBase;
+  double numSampleBase;
+  double cumulativeBase;
 
 public:
   GStatsHist(const char *format,...);
-  GStatsHist() { }
+  GStatsHist() : numSampleBase(0), cumulativeBase(0) { }
 
   void sample(bool enable, uint32_t key, double weight=1);
   int64_t getSamples() const;
+  const double *getSamplesRef() const { return &numSample; }
 
   void reportValue() const;
+  void weightInterval(double w);
+
+  char    getBinKind() const { return 'h'; }
+  int32_t getBinCols() const { return 3;   }
+  void    getBinValues(double *v) const;
+};
+
+/*
+ * Fixed set of statistics read every interval (power model activity).
+ * Stats are looked up by name once, add() returns a stable index, and
+ * update() reads all of them in one pass through getSamplesRef and keeps
+ * the delta since the previous update. The few stats without a
+ * getSamplesRef are copied with getSamples first.
+ */
+class GStatsSnapshot {
+private:
+  std::vector<const double *> value;
+  std::vector<double>         last;
+  std::vector<double>         delta;
+
+  std::vector<const GStats *> slowStat;
+  std::vector<double *>       slowValue;
+
+public:
+  GStatsSnapshot() { }
+  ~GStatsSnapshot();
+
+  int32_t add(const char *str); // -1 if the stat does not exist
+  void    update();
+
+  size_t  size() const              { return value.size(); }
+  double  getDelta(int32_t i) const { return delta[i];     }
+  double  getValue(int32_t i) const { return last[i];      }
 };
 
 #endif   // GSTATSD_H
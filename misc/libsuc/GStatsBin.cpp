@@ -0,0 +1,448 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <string>
+
+#include "nanassert.h"
+#include "GStats.h"
+#include "GStatsBin.h"
+
+static const char GStatsBinMagic[8] = { 'E', 'S', 'E', 'S', 'C', 'S', 'T', 'B' };
+
+class GStatsBinBucket {
+public:
+  uint32_t field;
+  uint32_t key;
+  double   value;
+};
+
+FILE    *GStatsBin::fd    = 0;
+char    *GStatsBin::fname = 0;
+uint64_t GStatsBin::pos   = 0;
+uint32_t GStatsBin::nRows = 0;
+uint32_t GStatsBin::nLive = 0;
+int32_t  GStatsBin::nCols = 0;
+std::vector<GStats *> GStatsBin::fields;
+std::vector<int32_t>  GStatsBin::colPos;
+std::vector<double>   GStatsBin::row;
+pthread_mutex_t       GStatsBin::lock = PTHREAD_MUTEX_INITIALIZER;
+
+void GStatsBin::write(const void *data, size_t size)
+{
+  if (fwrite(data, 1, size, fd) != size) {
+    MSG("ERROR: could not write binary report [%s]", fname);
+    exit(-3);
+  }
+  pos += size;
+}
+
+void GStatsBin::pad()
+{
+  static const char zero[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  if (pos & 7)
+    write(zero, 8 - (pos & 7));
+}
+
+void GStatsBin::open(const char *name)
+{
+  I(fd == 0);
+
+  fd = fopen(name, "w");
+  if (fd == 0) {
+    MSG("ERROR: could not create binary report [%s]", name);
+    exit(-3);
+  }
+  fname = strdup(name);
+  pos   = 0;
+
+  uint32_t version = Version;
+  write(GStatsBinMagic, sizeof(GStatsBinMagic));
+  write(&version, sizeof(version));
+  pad();
+}
+
+void GStatsBin::close()
+{
+  if (fd == 0)
+    return;
+
+  fclose(fd);
+  fd = 0;
+  free(fname);
+  fname = 0;
+
+  for(size_t i=0;i<fields.size();i++) {
+    if (fields[i])
+      fields[i]->binIndex = -1;
+  }
+  fields.clear();
+  colPos.clear();
+  row.clear();
+  nCols = 0;
+  nRows = 0;
+  nLive = 0;
+}
+
+void GStatsBin::addSchema()
+  /* append a schema record with the stats created since the last one {{{1 */
+{
+  uint32_t first = fields.size();
+
+  for(GStats::ContainerIter it = GStats::store.begin(); it != GStats::store.end(); it++) {
+    GStats *g = it->second;
+    if (g->binIndex >= 0)
+      continue;
+
+    g->binIndex = fields.size();
+    fields.push_back(g);
+    colPos.push_back(nCols);
+    nCols += g->getBinCols();
+    nLive++;
+  }
+
+  uint32_t n = fields.size() - first;
+  if (n == 0)
+    return;
+
+  uint32_t type = RecordSchema;
+  write(&type, sizeof(type));
+  write(&n, sizeof(n));
+  for(size_t i=first;i<fields.size();i++) {
+    const char *name = fields[i]->getName();
+    uint8_t  kind = fields[i]->getBinKind();
+    uint8_t  cols = fields[i]->getBinCols();
+    uint16_t len  = strlen(name);
+    write(&kind, sizeof(kind));
+    write(&cols, sizeof(cols));
+    write(&len , sizeof(len));
+    write(name , len);
+  }
+  pad();
+
+  row.resize(nCols);
+}
+/* }}} */
+
+uint32_t GStatsBin::append(const char *tag)
+  /* snapshot of all the stats {{{1 */
+{
+  I(fd);
+  pthread_mutex_lock(&lock);
+
+  if (GStats::store.size() != nLive)
+    addSchema();
+
+  std::vector<GStatsBinBucket> buckets;
+  for(size_t i=0;i<fields.size();i++) {
+    GStats *g = fields[i];
+    if (g == 0) {
+      int32_t end = (i+1) < colPos.size() ? colPos[i+1] : nCols;
+      for(int32_t j=colPos[i];j<end;j++)
+        row[j] = NAN;
+      continue;
+    }
+
+    g->getBinValues(&row[colPos[i]]);
+
+    if (g->getBinKind() != 'h')
+      continue;
+    const GStatsHist *h = static_cast<const GStatsHist *>(g);
+    for(GStatsHist::Histogram::const_iterator it=h->H.begin();it!=h->H.end();it++) {
+      GStatsBinBucket b;
+      b.field = i;
+      b.key   = it->first;
+      b.value = it->second;
+      buckets.push_back(b);
+    }
+  }
+
+  uint32_t type   = RecordRow;
+  uint32_t tagLen = strlen(tag);
+  uint32_t n      = nCols;
+  write(&type, sizeof(type));
+  write(&tagLen, sizeof(tagLen));
+  write(tag, tagLen);
+  pad();
+  write(&n, sizeof(n));
+  pad();
+  if (nCols)
+    write(&row[0], sizeof(double)*nCols);
+
+  n = buckets.size();
+  write(&n, sizeof(n));
+  pad();
+  if (!buckets.empty())
+    write(&buckets[0], sizeof(GStatsBinBucket)*buckets.size());
+
+  fflush(fd);
+
+  uint32_t r = nRows++;
+  pthread_mutex_unlock(&lock);
+
+  return r;
+}
+/* }}} */
+
+void GStatsBin::remove(GStats *g)
+{
+  I(g->binIndex >= 0 && g->binIndex < (int32_t)fields.size());
+
+  pthread_mutex_lock(&lock);
+  fields[g->binIndex] = 0;
+  g->binIndex = -1;
+  nLive--;
+  pthread_mutex_unlock(&lock);
+}
+
+/*********************** Reader */
+
+class GStatsBin::Reader {
+private:
+  const uint8_t *base;
+  size_t         size;
+
+  class Row {
+  public:
+    std::string tag;
+    uint32_t    nFields;
+    const double *v;
+    uint32_t    nBuckets;
+    const GStatsBinBucket *b;
+  };
+
+  std::vector<char>        kind;
+  std::vector<int32_t>     cols;
+  std::vector<int32_t>     colPos;
+  std::vector<std::string> names;
+
+  const uint8_t *get(size_t &p, size_t n) {
+    if (p + n > size)
+      return 0;
+    const uint8_t *r = base + p;
+    p += n;
+    return r;
+  }
+  static size_t align(size_t p) { return (p + 7) & ~((size_t)7); }
+
+public:
+  std::vector<Row> rows;
+
+  Reader() : base(0), size(0) { }
+  ~Reader() {
+    if (base)
+      munmap((void *)base, size);
+  }
+
+  bool load(const char *name);
+  void print(FILE *out, const Row &r, const char *tag) const;
+};
+
+bool GStatsBin::Reader::load(const char *name)
+  /* map the file and index the schema and rows {{{1 */
+{
+  int fdr = ::open(name, O_RDONLY);
+  if (fdr < 0) {
+    MSG("ERROR: could not open binary report [%s]", name);
+    return false;
+  }
+  struct stat st;
+  fstat(fdr, &st);
+  size = st.st_size;
+  if (size < 16) {
+    ::close(fdr);
+    MSG("ERROR: [%s] is not a binary report", name);
+    return false;
+  }
+  base = static_cast<const uint8_t *>(mmap(0, size, PROT_READ, MAP_PRIVATE, fdr, 0));
+  ::close(fdr);
+  if (base == MAP_FAILED) {
+    base = 0;
+    MSG("ERROR: could not map binary report [%s]", name);
+    return false;
+  }
+
+  uint32_t version;
+  memcpy(&version, base + sizeof(GStatsBinMagic), sizeof(version));
+  if (memcmp(base, GStatsBinMagic, sizeof(GStatsBinMagic)) != 0 || version != Version) {
+    MSG("ERROR: [%s] is not a binary report (version %d)", name, Version);
+    return false;
+  }
+
+  int32_t nc = 0;
+  size_t  p  = 16;
+  while(p < size) {
+    const uint8_t *h = get(p, 8);
+    if (h == 0)
+      break;
+    uint32_t type, n;
+    memcpy(&type, h, 4);
+    memcpy(&n, h+4, 4);
+
+    if (type == RecordSchema) {
+      bool ok = true;
+      for(uint32_t i=0;i<n && ok;i++) {
+        const uint8_t *f = get(p, 4);
+        uint16_t len;
+        if (f)
+          memcpy(&len, f+2, 2);
+        const uint8_t *str = f ? get(p, len) : 0;
+        if (str == 0) {
+          ok = false;
+          break;
+        }
+        kind.push_back(f[0]);
+        cols.push_back(f[1]);
+        colPos.push_back(nc);
+        names.push_back(std::string((const char *)str, len));
+        nc += f[1];
+      }
+      if (!ok)
+        break;
+      p = align(p);
+    }else if (type == RecordRow) {
+      Row r;
+      const uint8_t *tag = get(p, n);
+      if (tag == 0)
+        break;
+      r.tag.assign((const char *)tag, n);
+      p = align(p);
+
+      const uint8_t *c = get(p, 8);
+      uint32_t ncols;
+      if (c == 0)
+        break;
+      memcpy(&ncols, c, 4);
+      if (ncols != (uint32_t)nc) {
+        MSG("ERROR: binary report [%s] row %d has %d columns (schema has %d)", name, (int)rows.size(), ncols, nc);
+        return false;
+      }
+      r.v = (const double *)get(p, sizeof(double)*ncols);
+      const uint8_t *nb = get(p, 8);
+      if (r.v == 0 || nb == 0)
+        break;
+      memcpy(&r.nBuckets, nb, 4);
+      r.b = (const GStatsBinBucket *)get(p, sizeof(GStatsBinBucket)*r.nBuckets);
+      if (r.b == 0 && r.nBuckets)
+        break;
+      r.nFields = kind.size();
+      rows.push_back(r);
+    }else{
+      MSG("ERROR: binary report [%s] has an unknown record at %lu", name, (unsigned long)(p-8));
+      return false;
+    }
+  }
+  if (p < size)
+    MSG("WARNING: binary report [%s] is truncated after %d rows", name, (int)rows.size());
+
+  return true;
+}
+/* }}} */
+
+void GStatsBin::Reader::print(FILE *out, const Row &r, const char *tag) const
+  /* same format as the GStats reportValue methods {{{1 */
+{
+  fprintf(out, "#BEGIN GStats::report %s\n", tag);
+
+  uint32_t b = 0;
+  for(uint32_t i=0;i<r.nFields;i++) {
+    const char   *name = names[i].c_str();
+    const double *v    = r.v + colPos[i];
+    if (isnan(v[0]))
+      continue; // deleted
+
+    switch(kind[i]) {
+    case 'c':
+      fprintf(out, "%s=%f\n", name, v[0]);
+      break;
+    case 'a':
+      fprintf(out, "%s:n=%lld::v=%f\n", name, (long long)v[0], v[1]);
+      break;
+    case 'm':
+      fprintf(out, "%s:max=%f:n=%lld\n", name, v[0], (long long)v[1]);
+      break;
+    case 'l':
+      fprintf(out, "%s=%Lg\n", name, static_cast<long double>(v[0]) + static_cast<long double>(v[1]));
+      break;
+    case 'x':
+      fprintf(out, "%s:max=%g\n", name, v[0]);
+      break;
+    case 'h':
+      for(;b<r.nBuckets && r.b[b].field == i;b++)
+        fprintf(out, "%s(%lu)=%f\n", name, (unsigned long)r.b[b].key, r.b[b].value);
+      fprintf(out, "%s:max=%lu\n", name, (unsigned long)v[0]);
+      fprintf(out, "%s:v=%f\n"   , name, v[1]);
+      fprintf(out, "%s:n=%f\n"   , name, v[2]);
+      break;
+    default:
+      fprintf(out, "%s=%f\n", name, v[0]);
+    }
+  }
+
+  fprintf(out, "#END GStats::report %s\n", tag);
+}
+/* }}} */
+
+bool GStatsBin::toText(const char *binName, FILE *text, FILE *out)
+{
+  Reader r;
+  if (!r.load(binName))
+    return false;
+
+  if (text == 0) {
+    for(size_t i=0;i<r.rows.size();i++)
+      r.print(out, r.rows[i], r.rows[i].tag.c_str());
+    return true;
+  }
+
+  static const char ref[] = "#BINARY GStats::report row=";
+  char  *line = 0;
+  size_t len  = 0;
+  while(getline(&line, &len, text) > 0) {
+    if (strncmp(line, ref, sizeof(ref)-1) != 0) {
+      fputs(line, out);
+      continue;
+    }
+
+    char *tag;
+    unsigned long n = strtoul(line + sizeof(ref) - 1, &tag, 10);
+    if (*tag == ' ')
+      tag++;
+    tag[strcspn(tag, "\n")] = 0;
+
+    if (n >= r.rows.size()) {
+      MSG("WARNING: row %lu is not in binary report [%s]", n, binName);
+      fputs(line, out);
+      fputs("\n", out);
+      continue;
+    }
+    r.print(out, r.rows[n], tag);
+  }
+  free(line);
+
+  return true;
+}
@@ -0,0 +1,99 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+
+#ifndef GSTATSBIN_H
+#define GSTATSBIN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <vector>
+
+class GStats;
+
+/*
+ * Binary statistics sink. When it is open, GStats::report appends a row
+ * here and only leaves a "#BINARY GStats::report row=N" reference in the
+ * text report, and append() can add interval snapshots while running.
+ *
+ * File layout (host byte order), a header and a sequence of records:
+ *
+ *  header : magic[8] version(u32) pad(u32)
+ *  schema : 'S'(u32) nFields(u32) { kind(u8) nCols(u8) nameLen(u16) name }
+ *  row    : 'R'(u32) tagLen(u32) tag nCols(u32) pad(u32) double[nCols]
+ *           nBuckets(u32) pad(u32) { field(u32) key(u32) value(double) }
+ *
+ * Records and the tag are zero padded to 8 bytes, so the columns of a
+ * mapped row can be read in place as doubles.
+ *
+ * A schema record adds fields to the previous ones, rows have one
+ * fixed-width column group per field in schema order (see
+ * GStats::getBinCols) followed by the histogram buckets. Fields for the
+ * stats created after the first row come in another schema record, so
+ * rows only grow. Deleted stats keep their columns, filled with NaN.
+ *
+ * Kinds: 'c' GStatsCntr, 'a' GStatsAvg, 'm' GStatsMax, 'h' GStatsHist,
+ * 'l' GStatsThermCntr (long double as two doubles), 'x' GStatsThermMax,
+ * 'o' others (getSamples). main/statsbin.cpp converts back to the text
+ * format.
+ */
+
+class GStatsBin {
+private:
+  enum {
+    Version      = 1,
+    RecordSchema = 'S',
+    RecordRow    = 'R'
+  };
+
+  static FILE    *fd;
+  static char    *fname;
+  static uint64_t pos;
+  static uint32_t nRows;
+  static uint32_t nLive;
+  static std::vector<GStats *> fields; // schema order, 0 if deleted
+  static std::vector<int32_t>  colPos;
+  static int32_t  nCols;
+  static std::vector<double>   row;
+  static pthread_mutex_t       lock;
+
+  static void write(const void *data, size_t size);
+  static void pad();
+  static void addSchema();
+
+  class Reader;
+
+public:
+  static void open(const char *name);
+  static void close();
+  static bool isOpen() { return fd != 0; }
+
+  // Append a snapshot of all the stats, returns the row number
+  static uint32_t append(const char *tag);
+  static void remove(GStats *g);
+
+  // Print in the GStats::report text format. With a text report, its
+  // #BINARY references are expanded; otherwise all the rows are printed.
+  // Returns false if binName is not a stats file.
+  static bool toText(const char *binName, FILE *text, FILE *out);
+};
+
+#endif // GSTATSBIN_H
@@ -70,6 +70,15 @@ PortGeneric *PortGeneric::create(const char *unitName,
   return gen;
 }
 
+Time_t PortGeneric::occupySlots(int32_t nSlots, bool en)
+{
+  I(nSlots>0);
+  Time_t t = nextSlot(en);
+  for(int32_t i=1;i<nSlots;i++)
+    nextSlot(en);
+  return t;
+}
+
 void PortGeneric::destroy()
 {
   delete this;
@@ -86,6 +95,11 @@ Time_t PortUnlimited::nextSlot(bool en) {
   return globalClock;
 }
 
+Time_t PortUnlimited::occupySlots(int32_t nSlots, bool en) {
+  avgTime.sample(0, en);
+  return globalClock;
+}
+
 Time_t PortUnlimited::calcNextSlot() const
 {
   return globalClock;
@@ -109,6 +123,19 @@ Time_t PortFullyPipe::nextSlot(bool en)
   return lTime++;
 }
 
+Time_t PortFullyPipe::occupySlots(int32_t nSlots, bool en)
+{
+  I(nSlots>0);
+  if(lTime < globalClock)
+    lTime = globalClock;
+
+  Time_t st = lTime;
+  lTime += nSlots;
+
+  avgTime.sample(st-globalClock, en);
+  return st;
+}
+
 Time_t PortFullyPipe::calcNextSlot() const
 {
   return ((lTime < globalClock) ? globalClock : lTime);
@@ -169,6 +196,19 @@ Time_t PortPipe::nextSlot(bool en)
   return st;
 }
 
+Time_t PortPipe::occupySlots(int32_t nSlots, bool en)
+{
+  I(nSlots>0);
+  if(lTime < globalClock)
+    lTime = globalClock;
+
+  Time_t st = lTime;
+  lTime += ocp*nSlots;
+
+  avgTime.sample(st-globalClock, en);
+  return st;
+}
+
 Time_t PortPipe::calcNextSlot() const
 {
   return ((lTime < globalClock) ? globalClock : lTime);
@@ -84,6 +84,7 @@ public:
   //!  nextSlot();
   //! }
   //! return t;
+  virtual Time_t occupySlots(int32_t nSlots, bool en);
 
   //! returns when the next slot can be free without occupying any slot
   virtual Time_t calcNextSlot() const =0;
@@ -107,6 +108,7 @@ public:
   PortUnlimited(const char *name);
   
   Time_t nextSlot(bool en);
+  Time_t occupySlots(int32_t nSlots, bool en);
   Time_t calcNextSlot() const;
 };
 
@@ -120,6 +122,7 @@ public:
   PortFullyPipe(const char *name);
 
   Time_t nextSlot(bool en);
+  Time_t occupySlots(int32_t nSlots, bool en);
   Time_t calcNextSlot() const;
 };
 
@@ -147,6 +150,7 @@ public:
   PortPipe(const char *name, TimeDelta_t occ);
 
   Time_t nextSlot(bool en);
+  Time_t occupySlots(int32_t nSlots, bool en);
   Time_t calcNextSlot() const;
 };
 
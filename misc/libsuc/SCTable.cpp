@@ -22,6 +22,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 */
 
 #include "SCTable.h"
+#include "Checkpoint.h"
 
 SCTable::SCTable(const char *str, size_t size, uint8_t bits)
   : sizeMask(size - 1)
@@ -52,6 +53,11 @@ SCTable::~SCTable(void){
   delete [] table;
 }
 
+void SCTable::checkpoint(Checkpoint *ck)
+{
+  ck->io(table, getSize());
+}
+
 void SCTable::reset(uint32_t cid, bool taken)
 {
   table[cid & sizeMask] = taken ? Saturate : Saturate-1;
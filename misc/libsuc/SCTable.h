@@ -27,6 +27,8 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "Snippets.h"
 #include "nanassert.h"
 
+class Checkpoint;
+
 class SCTable {
 private:
   const uint64_t  sizeMask;
@@ -47,6 +49,9 @@ private:
   bool isLowest(uint32_t cid) const    { return table[cid & sizeMask] == MaxValue; }
   bool isHighest(uint32_t cid) const   { return table[cid & sizeMask] == 0; }
   uint8_t getValue(uint32_t cid) const { return table[cid & sizeMask]; }
+
+  size_t getSize() const { return sizeMask + 1; }
+  void checkpoint(Checkpoint *ck); // counters only, the owner opens the section
 };
 
 #endif
@@ -0,0 +1,242 @@
+#ifndef SPSCFIFO_H
+#define SPSCFIFO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "nanassert.h"
+#include "Snippets.h"
+
+/*
+ * Single producer, single consumer FIFO used to hand off instructions from the
+ * emulator thread to the timing thread.
+ *
+ * The producer fills entries in place (getTailRef) and advances a private
+ * tail. The shared tail is published once per CommitBatch entries (or when
+ * the FIFO becomes full, or with commit), so the consumer cache line is only
+ * pulled every few instructions. Head and tail live in separate cache lines.
+ *
+ * A side that must wait (producer on full, consumer until full) spins for a
+ * short time and then parks in a futex on the other side index. The other
+ * side wakes it only when a waiter is flagged, so the common case has no
+ * syscalls (and pop no fence). Waits return the stall time in ns for the caller statistics.
+ */
+
+template<class Type>
+class SPSCFIFO {
+  public:
+    enum {
+      Capacity    = 256,
+      CommitBatch = 16,
+      SpinIters   = 512,
+      LineSize    = 64
+    };
+
+  private:
+    // Consumer written
+    volatile uint32_t head;
+    volatile uint32_t consParked;
+    volatile uint32_t consWant;
+    char pad0[LineSize - 3*sizeof(uint32_t)];
+
+    // Producer written
+    volatile uint32_t tail;
+    volatile uint32_t prodParked;
+    char pad1[LineSize - 2*sizeof(uint32_t)];
+
+    // Producer private
+    uint32_t localTail;
+    char pad2[LineSize - sizeof(uint32_t)];
+
+    Type array[Capacity];
+
+    static uint32_t loadAcquire(const volatile uint32_t *p) {
+      return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+    static void storeRelease(volatile uint32_t *p, uint32_t v) {
+      __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+    static uint64_t now() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ((uint64_t)ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+    }
+
+    static void cpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+      __builtin_ia32_pause();
+#endif
+    }
+
+    static void park(volatile uint32_t *addr, uint32_t val, uint32_t timeoutNs) {
+#ifdef __linux__
+      struct timespec ts = { 0, (long)timeoutNs };
+      syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_PRIVATE, val, &ts, 0, 0);
+#else
+      struct timespec ts = { 0, (long)(timeoutNs < 100000 ? timeoutNs : 100000) };
+      nanosleep(&ts, 0);
+#endif
+    }
+
+    static void unpark(volatile uint32_t *addr) {
+#ifdef __linux__
+      syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE_PRIVATE, INT_MAX, 0, 0, 0);
+#endif
+    }
+
+    void wakeConsumer() {
+      // Pairs with the fence in waitFull (a waiter either sees the new tail or gets woken)
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (likely(consParked == 0))
+        return;
+      if ((tail - head) < consWant)
+        return;
+      if (AtomicCompareSwap(&consParked, 1, 0) == 1)
+        unpark(&tail);
+    }
+
+    // Called on every pop, so no fence unless the producer published that it
+    // parks. If the flag is missed (the head store still not visible), the
+    // producer sleeps at most its timeout and the next pop of the (full)
+    // FIFO sees the flag.
+    void wakeProducer() {
+      if (likely(loadAcquire(&prodParked) == 0))
+        return;
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (AtomicCompareSwap(&prodParked, 1, 0) == 1)
+        unpark(&head);
+    }
+
+  public:
+    SPSCFIFO()
+      : head(0), consParked(0), consWant(0), tail(0), prodParked(0), localTail(0) {
+    }
+    virtual ~SPSCFIFO() {}
+
+    // Number of entries a consumer drains per burst (same as ThreadSafeFIFO)
+    uint16_t size() const { return 237; }
+
+    // Published entries
+    uint16_t realsize() const {
+      return loadAcquire(&tail) - head;
+    }
+
+    // Consumer view: all the published entries
+    bool full() const {
+      return (loadAcquire(&tail) - head) >= (Capacity - 2);
+    }
+    bool empty() const {
+      return loadAcquire(&tail) == head;
+    }
+
+    // Producer view: includes the entries not committed yet
+    bool canPush() const {
+      return (localTail - loadAcquire(&head)) < (Capacity - 2);
+    }
+
+    /* Producer side */
+
+    Type *getTailRef() {
+      return &array[localTail & (Capacity - 1)];
+    }
+
+    void commit() {
+      if (localTail == tail)
+        return;
+      storeRelease(&tail, localTail);
+      wakeConsumer();
+    }
+
+    // Fill getTailRef() in place; published every CommitBatch entries
+    void pushBatch() {
+      I(canPush());
+      localTail++;
+      if ((localTail - tail) >= CommitBatch || !canPush())
+        commit();
+    }
+
+    void push() {
+      I(canPush());
+      localTail++;
+      commit();
+    }
+    void push(const Type *item_) {
+      *getTailRef() = *item_;
+      push();
+    }
+
+    // Wait until there is space for a push. Returns the stall time (ns)
+    uint64_t waitNotFull(uint32_t timeoutNs = 1000000) {
+      if (canPush())
+        return 0;
+
+      commit(); // consumer may be waiting for these
+
+      uint64_t start = now();
+      for(int i=0;i<SpinIters && !canPush();i++)
+        cpuRelax();
+
+      while(!canPush()) {
+        uint32_t h = head;
+        prodParked = 1;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!canPush())
+          park(&head, h, timeoutNs);
+        prodParked = 0;
+      }
+
+      return now() - start;
+    }
+
+    /* Consumer side */
+
+    Type *getHeadRef() {
+      return &array[head & (Capacity - 1)];
+    }
+    Type *getNextHeadRef() {
+      return &array[(head + 1) & (Capacity - 1)];
+    }
+
+    void pop() {
+      I(!empty());
+      storeRelease(&head, head + 1);
+      wakeProducer();
+    }
+    void pop(Type *obj) {
+      *obj = *getHeadRef();
+      pop();
+    }
+
+    // Wait until the FIFO is full or timeoutNs passed. Returns the stall time (ns)
+    uint64_t waitFull(uint32_t timeoutNs = 1000000) {
+      if (full())
+        return 0;
+
+      uint64_t start = now();
+      for(int i=0;i<SpinIters && !full();i++)
+        cpuRelax();
+
+      if (!full()) {
+        uint32_t t = tail;
+        consWant   = Capacity - 2;
+        consParked = 1;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!full())
+          park(&tail, t, timeoutNs);
+        consParked = 0;
+      }
+
+      return now() - start;
+    }
+};
+
+#endif
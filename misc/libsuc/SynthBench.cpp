@@ -0,0 +1,106 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "SynthBench.h"
+#include "SescConf.h"
+#include "callback.h"
+
+SynthBench::SynthBench(const char *s)
+  : section(s)
+  ,rnd(1)
+  ,stClock(0)
+  ,stCalls(0)
+  ,secs(1e-6)
+  ,cycles(0)
+  ,calls(0)
+  ,failed(false)
+{
+}
+
+void SynthBench::start()
+{
+  stClock = globalClock;
+  stCalls = EventScheduler::getCalls();
+  gettimeofday(&stTime, 0);
+}
+
+void SynthBench::stop()
+{
+  timeval endTime;
+  gettimeofday(&endTime, 0);
+
+  secs = (endTime.tv_sec - stTime.tv_sec) + (endTime.tv_usec - stTime.tv_usec) / 1e6;
+  if (secs <= 0)
+    secs = 1e-6;
+  cycles = globalClock - stClock;
+  calls  = EventScheduler::getCalls() - stCalls;
+}
+
+bool SynthBench::check(const char *run, double rate)
+{
+  if (!SescConf->checkCharPtr(section, "baseline"))
+    return true;
+
+  const char *fname = SescConf->getCharPtr(section, "baseline");
+  double tol = 0.25;
+  if (SescConf->checkDouble(section, "baselineTol")) {
+    tol = SescConf->getDouble(section, "baselineTol");
+    SescConf->isBetween(section, "baselineTol", 0, 1);
+  }
+
+  // One "section:run rate" line per run
+  char key[256];
+  snprintf(key, sizeof(key), "%s:%s", section, run);
+
+  double base = -1;
+  FILE *fp = fopen(fname, "r");
+  if (fp) {
+    char   name[256];
+    double r;
+    while(fscanf(fp, "%255s %lf", name, &r) == 2) {
+      if (strcmp(name, key) == 0)
+        base = r;
+    }
+    fclose(fp);
+  }
+
+  if (base < 0) {
+    fp = fopen(fname, "a");
+    if (fp == 0) {
+      MSG("ERROR: %s could not write the baseline file [%s]", key, fname);
+      failed = true;
+      return false;
+    }
+    fprintf(fp, "%s %.0f\n", key, rate);
+    fclose(fp);
+    MSG("%s: %.0f/host-sec saved as baseline in %s", key, rate, fname);
+    return true;
+  }
+
+  if (rate < base*(1 - tol)) {
+    MSG("ERROR: %s: %.0f/host-sec is %.1f%% below the baseline %.0f (%s)", key, rate, 100*(1 - rate/base), base, fname);
+    failed = true;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,78 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#ifndef SYNTHBENCH_H
+#define SYNTHBENCH_H
+
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "Snippets.h"
+
+/*
+ * Common part of the synthetic traffic drivers (main/membench and
+ * main/netBench), configured by their bench section.
+ *
+ * rand() is a LCG, so the runs do not depend on the host libc. start() and
+ * stop() measure a run: host seconds, simulated cycles and events called
+ * (EventScheduler::getCalls).
+ *
+ * check() compares the host rate of a run (work per host second) with the
+ * file in the baseline key of the section. A run slower than its baseline by
+ * more than baselineTol (fraction, default 0.25) fails, so "make bench" can
+ * fail. A run missing in the file is appended as its baseline. Without a
+ * baseline key nothing is checked.
+ */
+class SynthBench {
+private:
+  const char *section;
+
+  uint64_t rnd;
+
+  timeval  stTime;
+  Time_t   stClock;
+  uint64_t stCalls;
+
+  double   secs;
+  Time_t   cycles;
+  uint64_t calls;
+
+  bool     failed;
+
+public:
+  SynthBench(const char *section);
+
+  void seed(uint64_t s) { rnd = s; }
+  uint64_t rand() {
+    rnd = rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+    return rnd >> 33;
+  }
+
+  void start();
+  void stop();
+
+  double   getSecs() const      { return secs;        } // never 0
+  Time_t   getCycles() const    { return cycles;      }
+  double   getEventRate() const { return calls/secs;  }
+
+  bool check(const char *run, double rate);
+  bool hasFailed() const { return failed; }
+};
+
+#endif
@@ -34,6 +34,10 @@ exportTemplate template < class Data, class Time> TQueue < Data, Time >
   I(AccessSize > 7);
   I((AccessSize & (AccessSize -1)) == 0 );
 
+  AccessBits = 0;
+  while((1U<<AccessBits) < AccessSize)
+    AccessBits++;
+
   accessTail = (Data *) malloc(AccessSize * sizeof(Data));
 
   access = (Data *) malloc(AccessSize * sizeof(Data));
@@ -50,13 +54,15 @@ exportTemplate template < class Data, class Time> void TQueue < Data, Time >
   minTime = 0;
   minPos = 0;
 
-  minTooFar   = MaxTime;              // MaxTime means empty
+  bzero(far, sizeof(far));
+  bzero(farUsed, sizeof(farUsed));
+  nFar = 0;
 }
 
 exportTemplate template < class Data, class Time > TQueue < Data, Time >
 ::~TQueue()
 {
-  GMSG(nNodes, "Destroying TQueue %d with pending nodes", nNodes);
+  GMSG(nNodes+nFar, "Destroying TQueue %d with pending nodes", nNodes+nFar);
 
   free(accessTail);
 
@@ -84,5 +90,7 @@ exportTemplate template < class Data, class Time > void TQueue < Data, Time >
     }
   }
   printf("\n");
+  if (nFar)
+    printf(" %d nodes in the timing wheel\n", nFar);
 }
 
@@ -22,9 +22,6 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #ifndef TQUEUEMODULE_H
 #define TQUEUEMODULE_H
 
-#include <algorithm>
-#include <vector>
-
 #include <string.h>
 #include <strings.h>
 
@@ -32,9 +29,12 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "pool.h"
 
 /*
- * The maximum time difference between tasks in the queue should be less than
- * MaxTimeDiff. Otherways, an additional slowdown would be suffered because
- * heaps would be used.
+ * Tasks less than MaxTimeDiff cycles away go to a circular array of
+ * lists (the fast queue). Further tasks go to a hierarchical timing
+ * wheel: FarLevels levels of FarSlots lists, each level FarSlots times
+ * coarser than the previous one. Insert and remove are O(1). When the
+ * queue time crosses a level boundary, the corresponding list is
+ * cascaded one level down (or to the fast queue).
  *
  */
 
@@ -46,6 +46,8 @@ public:
   private:
     Time time;              // when the instruction finishes
     Data next;
+    Data prev;              // only used in the timing wheel
+    int32_t farPos;         // timing wheel list
     enum QueueType {
       InNoQueue,
       InFastQueue,
@@ -71,12 +73,16 @@ public:
       return qType == InFastQueue;
     };
 
-    void setInTooFarQueue() {
-      qType = InTooFarQueue;
+    void setInTooFarQueue(int32_t pos) {
+      qType  = InTooFarQueue;
+      farPos = pos;
     };
     bool isInTooFarQueue() const {
       return qType == InTooFarQueue;
     };
+    int32_t getFarPos() const {
+      return farPos;
+    };
   
     void setTQTime(Time t) {
       time = t;
@@ -92,9 +98,24 @@ public:
     Data getTQNext() const {
       return next;
     };
+
+    void setTQPrev(Data p) {
+      prev = p;
+    };
+    Data getTQPrev() const {
+      return prev;
+    };
   };
 
 private:
+  enum {
+    FarBits   = 6,
+    FarSlots  = 1<<FarBits,
+    FarMask   = FarSlots-1,
+    FarLevels = 4,
+    OverflowPos = FarLevels*FarSlots // Beyond the last level
+  };
+
   Time minTime;
   int32_t minPos;
 
@@ -102,44 +123,22 @@ private:
 
   const uint32_t AccessSize;
   const uint32_t AccessMask;
+  uint32_t AccessBits;
 
   Data *access;
   Data *accessTail;
 
-  class DLess {
-  public:
-    bool operator() (const Data x, const Data y) const {
-      return x->getTQTime() > y->getTQTime();
-    };
-  } dLess;
-
-  std::vector< Data > tooFar;
-    
-  Time minTooFar;
-
-  void adjustTooFar() {
-
-    I(!tooFar.empty());
-
-    while (((uint32_t)(tooFar.front()->getTQTime() - minTime)) < AccessSize) {
-
-      addNode(tooFar.front(), tooFar.front()->getTQTime());
+  Data far[OverflowPos+1];
+  uint64_t farUsed[FarLevels]; // One bit per non-empty list (FarSlots == 64)
+  int32_t nFar;
 
-      std::pop_heap(tooFar.begin(), tooFar.end(), dLess);
-      tooFar.pop_back();
-
-      if(tooFar.empty()) {
-        minTooFar = MaxTime;
-        return;
-      }
-    }
-  
-    minTooFar = tooFar.front()->getTQTime();
+  uint32_t farShift(int32_t level) const {
+    return AccessBits + FarBits*level;
   };
 
   void addNode(Data node, Time time) {
     I(time >= minTime);
-    I((unsigned)abs((int)(time - minTime)) < AccessSize);
+    I((Time)(time - minTime) < AccessSize);
 
     uint32_t pos = ((uint32_t)(minPos + time - minTime)) & AccessMask;
 
@@ -154,6 +153,95 @@ private:
     nNodes++;
   };
 
+  void addFar(Data node, Time time) {
+    int32_t pos = OverflowPos;
+    for(int32_t level=0;level<FarLevels;level++) {
+      uint32_t shift = farShift(level);
+      if (((time >> shift) - (minTime >> shift)) < FarSlots) {
+        pos = level*FarSlots + ((time >> shift) & FarMask);
+        break;
+      }
+    }
+
+    Data head = far[pos];
+    node->setTQPrev(0);
+    node->setTQNext(head);
+    if (head)
+      head->setTQPrev(node);
+    far[pos] = node;
+    if (pos != OverflowPos)
+      farUsed[pos/FarSlots] |= ((uint64_t)1) << (pos & FarMask);
+    node->setInTooFarQueue(pos);
+    nFar++;
+  };
+
+  void insertNode(Data node, Time time) {
+    if((Time)(time - minTime) < AccessSize)
+      addNode(node, time);
+    else
+      addFar(node, time);
+  };
+
+  void cascadeList(int32_t pos) {
+    Data node = far[pos];
+    far[pos] = 0;
+    if (pos != OverflowPos)
+      farUsed[pos/FarSlots] &= ~(((uint64_t)1) << (pos & FarMask));
+
+    while(node) {
+      Data next = node->getTQNext();
+      nFar--;
+      insertNode(node, node->getTQTime());
+      node = next;
+    }
+  };
+
+  // First time that cascades a non-empty list
+  Time nextFarTime() const {
+    Time next = MaxTime;
+
+    for(int32_t level=0;level<FarLevels;level++) {
+      if (farUsed[level] == 0)
+        continue;
+      uint32_t shift = farShift(level);
+      Time     cur   = minTime >> shift;
+      uint32_t rot   = (cur + 1) & FarMask;
+      uint64_t used  = farUsed[level];
+      if (rot)
+        used = (used >> rot) | (used << (FarSlots - rot));
+      Time t = (cur + 1 + __builtin_ctzll(used)) << shift;
+      if (t < next)
+        next = t;
+    }
+
+    if (far[OverflowPos]) {
+      uint32_t shift = farShift(FarLevels-1);
+      Time t = ((minTime >> shift) + 1) << shift;
+      if (t < next)
+        next = t;
+    }
+
+    return next;
+  };
+
+  // minTime just crossed a fast queue boundary: refill from the wheel
+  void cascade() {
+    I((minTime & AccessMask) == 0);
+
+    int32_t top = 0;
+    while(top<FarLevels-1 && (minTime & ((((Time)1) << farShift(top))-1)) == 0)
+      top++;
+
+    if (top == FarLevels-1 && (minTime & ((((Time)1) << farShift(top))-1)) == 0)
+      cascadeList(OverflowPos);
+
+    for(int32_t level=top;level>=0;level--) {
+      if ((minTime & ((((Time)1) << farShift(level))-1)) != 0)
+        continue;
+      cascadeList(level*FarSlots + ((minTime >> farShift(level)) & FarMask));
+    }
+  };
+
 protected:
 public:
   TQueue(uint32_t MaxTimeDiff);
@@ -167,19 +255,7 @@ public:
 
     data->setTQTime(time);
 
-    if((uint32_t)(time - minTime) < AccessSize) {
-      addNode(data, time);
-    } else {
-      // Some nodes already exists, and this is too distant in
-      // time.  
-      data->setInTooFarQueue();
-
-      tooFar.push_back(data);
-      std::push_heap(tooFar.begin(),tooFar.end(),dLess);
-
-      if(minTooFar > time)
-        minTooFar = time;
-    }
+    insertNode(data, time);
   };
 
   Data nextJob(Time cTime) {
@@ -192,20 +268,26 @@ public:
       return node;
     }
 
-    if(minTooFar <= cTime)
-      adjustTooFar();
-
-    if(nNodes == 0) {
-      minTime = cTime;
-      minPos = 0;
-      return 0;
-    }
-
     Data node = access[minPos];
 
     while (node == 0 && minTime < cTime) {
-      minPos = (minPos + 1) & AccessMask;
-      minTime++;
+      if (nNodes == 0) {
+        // Nothing in the fast queue, jump to the next cascade (or cTime)
+        Time next = nFar ? nextFarTime() : MaxTime;
+        if (next > cTime) {
+          minTime = cTime;
+          minPos  = cTime & AccessMask;
+          return 0;
+        }
+        minTime = next;
+        minPos  = next & AccessMask;
+        cascade();
+      }else{
+        minPos = (minPos + 1) & AccessMask;
+        minTime++;
+        if (unlikely(minPos == 0) && nFar)
+          cascade();
+      }
       node = access[minPos];
     }
 
@@ -222,62 +304,67 @@ public:
     return node;
   };
 
+  // Earliest time with a task pending, or MaxTime if the queue is empty.
+  // Tasks in the timing wheel are reported at the start of their list.
+  Time nextTime() const {
+    Time limit = MaxTime;
+    if (nFar)
+      limit = nextFarTime();
+
+    if (nNodes) {
+      Time t = minTime;
+      uint32_t pos = minPos;
+      while(access[pos] == 0 && t < limit) {
+        pos = (pos + 1) & AccessMask;
+        t++;
+      }
+      return t;
+    }
+
+    return limit;
+  };
+
   void remove(Data node) {
     if( node->isInTooFarQueue() ) {
-      if( tooFar.front() == node ) {
-        std::pop_heap(tooFar.begin(),tooFar.end(),dLess);
-        tooFar.pop_back();
-
-        if( tooFar.empty() )
-          minTooFar = MaxTime;
-        else
-          minTooFar = tooFar.front()->getTQTime();
-    
-      }else{
-        typedef typename std::vector<Data>::iterator DataIter;
-        DataIter it = std::find(tooFar.begin(),tooFar.end(),node);
-
-        I(it != tooFar.end());
-        tooFar.erase(it);
-        I(std::find(tooFar.begin(),tooFar.end(),node) == tooFar.end());
-        std::make_heap(tooFar.begin(),tooFar.end(),dLess);
-      }
+      int32_t pos = node->getFarPos();
+      Data prev = node->getTQPrev();
+      Data next = node->getTQNext();
+
+      if (prev)
+        prev->setTQNext(next);
+      else
+        far[pos] = next;
+      if (next)
+        next->setTQPrev(prev);
+      if (far[pos] == 0 && pos != OverflowPos)
+        farUsed[pos/FarSlots] &= ~(((uint64_t)1) << (pos & FarMask));
+
+      nFar--;
+      node->removeFromQueue();
     }else if( node->isInFastQueue() ) {
       Time time = node->getTQTime();
-      
-      if( access[minPos] == node ) {
-        // First in FastQueue
-        nNodes--;
-        access[minPos] = access[minPos]->getTQNext();
-        node->removeFromQueue();
-      }else{
-        uint32_t pos = ((uint32_t)(minPos + time - minTime)) & AccessMask;
+      uint32_t pos = ((uint32_t)(minPos + time - minTime)) & AccessMask;
 
-        Data prev = 0;
-        Data curr = access[pos];
+      Data prev = 0;
+      Data curr = access[pos];
 
-        while( curr != node ) {
-          prev = curr;
-          curr = curr->getTQNext();
-        }
-        I( curr == node );
+      while( curr != node ) {
+        prev = curr;
+        curr = curr->getTQNext();
+      }
+      I( curr == node );
 
-        if( prev == 0 ) {
-          access[pos] = access[pos]->getTQNext();
-        }else{
-          prev->setTQNext(curr->getTQNext());
-        }
+      if( prev == 0 ) {
+        access[pos] = curr->getTQNext();
+      }else{
+        prev->setTQNext(curr->getTQNext());
+      }
 
-        if( accessTail[pos] == node ) {
-          prev = access[pos];
-          while( prev ) {
-            prev = prev->getTQNext();
-          }
-          accessTail[pos] = prev;
-        }
+      if( accessTail[pos] == node )
+        accessTail[pos] = prev;
 
-        nNodes--;
-      }
+      nNodes--;
+      node->removeFromQueue();
     }else {
       I(!node->isInQueue());
     }
@@ -292,10 +379,10 @@ public:
   };
 
   size_t size() const {
-    return nNodes + tooFar.size();
+    return nNodes + nFar;
   };
   bool empty() const {
-    return nNodes == 0 && tooFar.empty();
+    return nNodes == 0 && nFar == 0;
   };
 
   void dump();
@@ -22,6 +22,7 @@ Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 #include "callback.h"
 
 EventScheduler::TimedCallbacksQueue EventScheduler::cbQ(256);
+uint64_t                            EventScheduler::nCalls = 0;
 
 volatile Time_t globalClock=0;
 
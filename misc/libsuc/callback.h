@@ -62,6 +62,7 @@ private:
   typedef TQueue<EventScheduler *,Time_t> TimedCallbacksQueue;
 
   static TimedCallbacksQueue cbQ; // a queue of callback functions/members
+  static uint64_t nCalls;         // callbacks executed so far
   
 #ifdef DEBUG
   const char *fileName;
@@ -121,6 +122,7 @@ public:
     globalClock++;
     while ((cb = cbQ.nextJob(globalClock)) ) {
       cb->call();
+      nCalls++;
     }
   }
 
@@ -138,6 +140,16 @@ public:
     globalClock = 0;
   }
 
+  // Earliest cycle with a callback pending (MaxTime if none)
+  static Time_t nextEvent() {
+    return cbQ.nextTime();
+  }
+
+  // Callbacks executed so far (host throughput stats)
+  static uint64_t getCalls() {
+    return nCalls;
+  }
+
 };
 
 // [sizhuo] base class for all callback functions/members
@@ -0,0 +1,39 @@
+/*
+   ESESC: Super ESCalar simulator
+   Copyright (C) 2003 University of Illinois.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is    distributed in the  hope that  it will  be  useful, but  WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+*/
+
+#include <stdlib.h>
+
+#include "pool.h"
+
+__thread int32_t poolThreadId = -1;
+
+static volatile int32_t poolNThreads = 0;
+
+int32_t poolRegisterThread()
+{
+  // Ids are not reused, each host thread that touches a ptpool keeps its own
+  // free lists
+  int32_t id = AtomicAdd(&poolNThreads, 1);
+  if (id >= POOL_MAX_THREADS) {
+    MSG("ERROR: more than %d host threads use ptpool", POOL_MAX_THREADS);
+    exit(-2);
+  }
+  poolThreadId = id;
+  return id;
+}
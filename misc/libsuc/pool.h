@@ -302,6 +302,203 @@ public:
   }
 };
 
+//*********************************************
+
+// ptpool<> keeps a free list per host thread, so out/in do not lock. An
+// object can be released by any thread: it goes back to the thread that
+// allocated it (its owner), in batches pushed to the owner remote list with
+// one CAS. The owner takes the whole remote list when its own list is empty.
+//
+// A partial batch is pushed as soon as its owner runs dry (wantRemote), and
+// flushRemote pushes all the partial batches of the calling thread. A thread
+// that releases objects of other threads must call it before it exits.
+//
+// The simulator is single threaded, so pool<> is still the default. Objects
+// are allocated by the thread that first needs them, so with the default
+// first touch policy they live in the memory of its NUMA node.
+
+#define POOL_MAX_THREADS 64
+#define POOL_REMOTE_BATCH 32
+
+extern __thread int32_t poolThreadId;
+int32_t poolRegisterThread();
+
+static inline int32_t poolGetThreadId() {
+  if (unlikely(poolThreadId < 0))
+    return poolRegisterThread();
+  return poolThreadId;
+}
+
+template<class Ttype>
+class ptpool {
+protected:
+  class Holder : public Ttype {
+  public:
+    Holder *holderNext;
+    int32_t owner;
+    ID(bool inPool;)
+  };
+
+  class ThreadCache {
+  public:
+    Holder *first;               // List of free nodes
+    Holder * volatile remote;    // Released by other threads
+    volatile bool     wantRemote; // first is empty, push the partial batches
+
+    // Released objects of other owners, not pushed yet
+    Holder **batchFirst;
+    Holder **batchLast;
+    int32_t *batchSize;
+  };
+
+  ID(bool deleted;)
+
+  const int32_t Size; // Reproduction size
+  const char *Name;
+
+  ThreadCache * volatile caches[POOL_MAX_THREADS];
+
+  ThreadCache *getCache(int32_t tid) {
+    ThreadCache *c = caches[tid];
+    if (likely(c))
+      return c;
+
+    c = ::new ThreadCache;
+    c->first      = 0;
+    c->remote     = 0;
+    c->wantRemote = false;
+    c->batchFirst = 0;
+    c->batchLast  = 0;
+    c->batchSize  = 0;
+    caches[tid] = c;
+    return c;
+  }
+
+  void reproduce(ThreadCache *c, int32_t tid) {
+    I(c->first==0);
+
+    for(int32_t i = 0; i < Size; i++) {
+      Holder *h = ::new Holder;
+      h->holderNext = c->first;
+      h->owner      = tid;
+      IS(h->inPool = true);
+      c->first = h;
+    }
+  }
+
+  void pushBatch(ThreadCache *c, int32_t o) {
+    I(c->batchSize[o]);
+
+    ThreadCache *oc = caches[o];
+    I(oc);
+    Holder *old;
+    do {
+      old = oc->remote;
+      c->batchLast[o]->holderNext = old;
+    }while(AtomicCompareSwap(&oc->remote, old, c->batchFirst[o]) != old);
+
+    c->batchFirst[o] = 0;
+    c->batchLast[o]  = 0;
+    c->batchSize[o]  = 0;
+  }
+
+  void remoteIn(ThreadCache *c, Holder *h) {
+    const int32_t o = h->owner;
+    I(o != poolThreadId);
+
+    if (unlikely(c->batchFirst == 0)) {
+      c->batchFirst = ::new Holder *[POOL_MAX_THREADS];
+      c->batchLast  = ::new Holder *[POOL_MAX_THREADS];
+      c->batchSize  = ::new int32_t[POOL_MAX_THREADS];
+      for(int32_t i = 0; i < POOL_MAX_THREADS; i++) {
+        c->batchFirst[i] = 0;
+        c->batchLast[i]  = 0;
+        c->batchSize[i]  = 0;
+      }
+    }
+
+    h->holderNext = c->batchFirst[o];
+    if (c->batchFirst[o] == 0)
+      c->batchLast[o] = h;
+    c->batchFirst[o] = h;
+    if (++c->batchSize[o] < POOL_REMOTE_BATCH && !caches[o]->wantRemote)
+      return;
+
+    pushBatch(c, o);
+  }
+
+public:
+  ptpool(int32_t s = 32, const char *n = "ptpool name not declared")
+    : Size(s)
+    , Name(n) {
+    I(Size > 0);
+    IS(deleted=false);
+
+    for(int32_t i = 0; i < POOL_MAX_THREADS; i++)
+      caches[i] = 0;
+
+    int32_t tid = poolGetThreadId();
+    reproduce(getCache(tid), tid);
+  }
+
+  ~ptpool() {
+    // Objects may still be in other threads lists, like pool<> nothing is freed
+    IS(deleted=true);
+  }
+
+  void flushRemote() {
+    ThreadCache *c = getCache(poolGetThreadId());
+    if (c->batchFirst == 0)
+      return;
+
+    for(int32_t o = 0; o < POOL_MAX_THREADS; o++) {
+      if (c->batchSize[o])
+        pushBatch(c, o);
+    }
+  }
+
+  void in(Ttype *data) {
+    I(!deleted);
+    const int32_t tid = poolGetThreadId();
+    ThreadCache  *c   = getCache(tid);
+    Holder       *h   = static_cast<Holder *>(data);
+
+    I(!h->inPool);
+    IS(h->inPool=true);
+
+    if (likely(h->owner == tid)) {
+      h->holderNext = c->first;
+      c->first = h;
+    }else{
+      remoteIn(c, h);
+    }
+  }
+
+  Ttype *out() {
+    I(!deleted);
+    const int32_t tid = poolGetThreadId();
+    ThreadCache  *c   = getCache(tid);
+
+    if (unlikely(c->first == 0)) {
+      c->first = AtomicSwap(&c->remote, static_cast<Holder *>(0));
+      if (c->first == 0) {
+        // Ask the other threads for their partial batches, and do not wait
+        c->wantRemote = true;
+        reproduce(c, tid);
+      }else{
+        c->wantRemote = false;
+      }
+    }
+    Holder *h = c->first;
+    c->first  = h->holderNext;
+
+    I(h->inPool);
+    IS(h->inPool=false);
+
+    return static_cast<Ttype *>(h);
+  }
+};
+
 template<class Ttype, bool noTimeCheck=false>
 class pool {
 protected:
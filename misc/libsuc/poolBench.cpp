@@ -7,6 +7,7 @@
 #include <unistd.h>
 #include <sys/time.h>
 #include <pthread.h>
+#include <sched.h>
 
 #include "nanassert.h"
 #include "Snippets.h"
@@ -242,11 +243,132 @@ void test_tspool_threaded() {
 }
 
 
+// Contended: nContended threads share one pool
+const int32_t nContended     = 4;
+const int32_t contendedIters = 10000000;
+
+template<class PoolType>
+class ContendedArgs {
+public:
+  PoolType *p;
+  long long total;
+};
+
+template<class PoolType>
+void *contended_local(void *arg) {
+  // Each thread releases its own objects (per-thread fast path for ptpool<>)
+  ContendedArgs<PoolType> *a = static_cast<ContendedArgs<PoolType> *>(arg);
+  DummyObjTest *o[8];
+
+  for(int32_t i=0;i<contendedIters;i+=8) {
+    for(int32_t j=0;j<8;j++) {
+      o[j] = a->p->out();
+      o[j]->put(j,j);
+    }
+    for(int32_t j=0;j<8;j++) {
+      a->total += o[j]->get();
+      a->p->in(o[j]);
+    }
+  }
+
+  return 0;
+}
+
+template<class PoolType>
+void contended_local_test(const char *str) {
+  PoolType p(16);
+  pthread_t th[nContended];
+  ContendedArgs<PoolType> args[nContended];
+
+  start();
+  for(int32_t i=0;i<nContended;i++) {
+    args[i].p     = &p;
+    args[i].total = 0;
+    pthread_create(&th[i],0,&contended_local<PoolType>,&args[i]);
+  }
+  long long total = 0;
+  for(int32_t i=0;i<nContended;i++) {
+    pthread_join(th[i],0);
+    total += args[i].total;
+  }
+  finish(str, nContended*contendedIters);
+
+  fprintf(stderr,"Total = %lld (%lld?)\n",total,28LL*2*nContended*(contendedIters/8));
+}
+
+class DummyObjPtr {
+public:
+  DummyObjTest *o;
+};
+
+ThreadSafeFIFO<DummyObjPtr> contendedRing[nContended];
+ptpool<DummyObjTest>       *contendedPool;
+long long                   contendedTotal[nContended];
+
+extern "C" void *contended_remote(void *arg) {
+  // Objects go to the next thread in the ring, which releases them: all the
+  // in() are from a thread that is not the owner
+  int32_t id = static_cast<int32_t>(reinterpret_cast<intptr_t>(arg));
+  ThreadSafeFIFO<DummyObjPtr> &next = contendedRing[(id+1)%nContended];
+  ThreadSafeFIFO<DummyObjPtr> &mine = contendedRing[id];
+
+  int32_t sent  = 0;
+  int32_t recv  = 0;
+  long long total = 0;
+  while(sent < contendedIters || recv < contendedIters) {
+    bool progress = false;
+    if (sent < contendedIters && !next.full()) {
+      DummyObjPtr ptr;
+      ptr.o = contendedPool->out();
+      ptr.o->put(1,1);
+      next.push(&ptr);
+      sent++;
+      progress = true;
+    }
+    if (!mine.empty()) {
+      DummyObjPtr ptr;
+      mine.pop(&ptr);
+      total += ptr.o->get();
+      contendedPool->in(ptr.o);
+      recv++;
+      progress = true;
+    }
+    if (!progress)
+      sched_yield(); // fewer host cores than threads
+  }
+  contendedPool->flushRemote();
+  contendedTotal[id] = total;
+
+  return 0;
+}
+
+void contended_remote_test() {
+  // Enough for the objects in the FIFOs without pool size warnings
+  ptpool<DummyObjTest> p(64);
+  contendedPool = &p;
+  pthread_t th[nContended];
+
+  start();
+  for(int32_t i=0;i<nContended;i++)
+    pthread_create(&th[i],0,&contended_remote,reinterpret_cast<void *>(static_cast<intptr_t>(i)));
+  long long total = 0;
+  for(int32_t i=0;i<nContended;i++) {
+    pthread_join(th[i],0);
+    total += contendedTotal[i];
+  }
+  finish("Contended remote", nContended*contendedIters);
+
+  fprintf(stderr,"Total = %lld (%lld?)\n",total,2LL*nContended*contendedIters);
+}
+
 int main() {
 
   tspool_test();
   pool_test();
   test_tspool_threaded();
+  contended_local_test< tspool<DummyObjTest> >("Contended Thread Safe");
+  contended_local_test< ptpool<DummyObjTest> >("Contended Per Thread");
+  contended_remote_test();
 
   return 0;
 }
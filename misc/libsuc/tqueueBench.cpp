@@ -0,0 +1,264 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "nanassert.h"
+#include "Snippets.h"
+
+#include "TQueue.h"
+
+/*
+ * Event queue microbenchmark. It replays an event-delay distribution through
+ * the timing wheel TQueue and through the old fast ring + tooFar heap queue
+ * (kept here as HeapTQueue for comparison).
+ *
+ * The distribution is read from a file with one "delay weight" pair per line
+ * (a histogram of schedule deltas dumped from a run). Without a file, a mix
+ * close to a multicore run is used: pipeline/cache callbacks, DRAM accesses,
+ * refresh and periodic thermal/power sampling.
+ */
+
+typedef uint64_t BTime;
+
+class BenchEvent;
+typedef TQueue<BenchEvent *, BTime> WheelQueue;
+
+class BenchEvent : public WheelQueue::User {
+public:
+  uint32_t id;
+};
+
+// Old TQueue scheme: fast ring plus a heap for the far events
+class HeapTQueue {
+private:
+  class DLess {
+  public:
+    bool operator() (const BenchEvent *x, const BenchEvent *y) const {
+      return x->getTQTime() > y->getTQTime();
+    };
+  } dLess;
+
+  BTime    minTime;
+  uint32_t minPos;
+  int32_t  nNodes;
+  const uint32_t AccessSize;
+  const uint32_t AccessMask;
+
+  std::vector<BenchEvent *> access;
+  std::vector<BenchEvent *> accessTail;
+  std::vector<BenchEvent *> tooFar;
+  BTime minTooFar;
+
+  void addNode(BenchEvent *node, BTime time) {
+    uint32_t pos = ((uint32_t)(minPos + time - minTime)) & AccessMask;
+    if (access[pos] == 0)
+      access[pos] = node;
+    else
+      accessTail[pos]->setTQNext(node);
+    accessTail[pos] = node;
+    node->setTQNext(0);
+    nNodes++;
+  };
+
+  void adjustTooFar() {
+    while (tooFar.front()->getTQTime() - minTime < AccessSize) {
+      addNode(tooFar.front(), tooFar.front()->getTQTime());
+      std::pop_heap(tooFar.begin(), tooFar.end(), dLess);
+      tooFar.pop_back();
+      if (tooFar.empty()) {
+        minTooFar = MaxTime;
+        return;
+      }
+    }
+    minTooFar = tooFar.front()->getTQTime();
+  };
+
+public:
+  HeapTQueue(uint32_t size)
+    : minTime(0)
+    , minPos(0)
+    , nNodes(0)
+    , AccessSize(roundUpPower2(size))
+    , AccessMask(roundUpPower2(size)-1)
+    , access(AccessSize)
+    , accessTail(AccessSize)
+    , minTooFar(MaxTime) {
+  };
+
+  void insert(BenchEvent *data, BTime time) {
+    data->setTQTime(time);
+    if (time - minTime < AccessSize) {
+      addNode(data, time);
+    } else {
+      tooFar.push_back(data);
+      std::push_heap(tooFar.begin(), tooFar.end(), dLess);
+      if (minTooFar > time)
+        minTooFar = time;
+    }
+  };
+
+  void reset() {
+    std::fill(access.begin(), access.end(), (BenchEvent *)0);
+    tooFar.clear();
+    minTooFar = MaxTime;
+    minTime   = 0;
+    minPos    = 0;
+    nNodes    = 0;
+  };
+
+  BenchEvent *nextJob(BTime cTime) {
+    if (minTooFar <= cTime)
+      adjustTooFar();
+    if (nNodes == 0) {
+      minTime = cTime;
+      minPos  = 0;
+      return 0;
+    }
+    BenchEvent *node = access[minPos];
+    while (node == 0 && minTime < cTime) {
+      minPos = (minPos + 1) & AccessMask;
+      minTime++;
+      node = access[minPos];
+    }
+    if (node == 0)
+      return 0;
+    nNodes--;
+    access[minPos] = node->getTQNext();
+    return node;
+  };
+};
+
+struct DelayBin {
+  BTime    delay;
+  uint64_t weight;
+};
+
+static std::vector<BTime> delayTable; // weighted samples, indexed by rand
+
+static void loadDelays(const char *file) {
+  std::vector<DelayBin> bins;
+
+  if (file) {
+    FILE *fp = fopen(file, "r");
+    if (fp == 0) {
+      fprintf(stderr, "tqueueBench: could not open [%s]\n", file);
+      exit(-1);
+    }
+    unsigned long long d, w;
+    while (fscanf(fp, "%llu %llu", &d, &w) == 2) {
+      DelayBin b = { d ? d : 1, w };
+      bins.push_back(b);
+    }
+    fclose(fp);
+  }
+
+  if (bins.empty()) {
+    static const DelayBin defBins[] = {
+      {       1, 4000 }, {      2, 2000 }, {     3, 1200 }, {      5, 800 },
+      {      12,  600 }, {     30,  300 }, {    70,  200 }, {    180, 150 },
+      {     400,  100 }, {    900,   40 }, {  4000,   10 }, {  16384,   4 },
+      {  100000,    2 }, {1000000,    1 },
+    };
+    bins.assign(defBins, defBins + sizeof(defBins)/sizeof(DelayBin));
+  }
+
+  uint64_t total = 0;
+  for(size_t i=0;i<bins.size();i++)
+    total += bins[i].weight;
+
+  const size_t TableSize = 64*1024; // power of 2
+  delayTable.clear();
+  uint64_t cum = 0;
+  for(size_t i=0;i<bins.size();i++) {
+    size_t first = (size_t)(cum * TableSize / total);
+    cum += bins[i].weight;
+    size_t last  = (size_t)(cum * TableSize / total);
+    for(size_t j=first;j<last;j++)
+      delayTable.push_back(bins[i].delay);
+  }
+  I(delayTable.size() == TableSize);
+  std::random_shuffle(delayTable.begin(), delayTable.end());
+}
+
+timeval stTime;
+
+void start() {
+  gettimeofday(&stTime, 0);
+}
+
+void finish(const char *str, uint64_t niters, uint64_t checksum) {
+
+  timeval endTime;
+  gettimeofday(&endTime, 0);
+
+  double msecs = (endTime.tv_sec - stTime.tv_sec) * 1000 
+    + (endTime.tv_usec - stTime.tv_usec) / 1000;
+  if (msecs < 1)
+    msecs = 1;
+
+  fprintf(stderr,"tqueueBench: %s %8.2f MEvents/s (checksum %llx)\n"
+      ,str
+      ,(double)niters/(1000*msecs)
+      ,(unsigned long long)checksum
+      );
+}
+
+// Hold model: each executed event schedules a new one with a sampled delay
+template<class Q>
+void run(const char *name, Q &q, uint32_t nLive, uint64_t nEvents) {
+
+  std::vector<BenchEvent> evs(nLive);
+
+  uint32_t rpos = 0;
+  for(uint32_t i=0;i<nLive;i++) {
+    evs[i].id = i;
+    q.insert(&evs[i], delayTable[rpos++ & (delayTable.size()-1)]);
+  }
+
+  start();
+
+  BTime    clock    = 0;
+  uint64_t done     = 0;
+  uint64_t checksum = 0;
+  while(done < nEvents) {
+    BenchEvent *ev = q.nextJob(clock);
+    if (ev == 0) {
+      clock++;
+      continue;
+    }
+    // Order independent within a cycle, so both queues replay the same events
+    checksum += ev->id * clock;
+    done++;
+    q.insert(ev, clock + delayTable[(ev->id * 7919 + clock) & (delayTable.size()-1)]);
+  }
+
+  finish(name, nEvents, checksum);
+
+  q.reset();
+}
+
+int main(int argc, const char **argv) {
+
+  loadDelays(argc > 1 ? argv[1] : 0);
+
+  const uint64_t nEvents = 20000000;
+  const uint32_t lives[] = { 64, 1024, 16384 };
+
+  for(size_t i=0;i<sizeof(lives)/sizeof(uint32_t);i++) {
+    char name[64];
+
+    HeapTQueue hq(1024);
+    sprintf(name, "heap  %6d live", lives[i]);
+    run(name, hq, lives[i], nEvents);
+
+    WheelQueue wq(1024);
+    sprintf(name, "wheel %6d live", lives[i]);
+    run(name, wq, lives[i], nEvents);
+  }
+
+  return 0;
+}
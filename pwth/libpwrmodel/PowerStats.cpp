@@ -37,10 +37,10 @@
 
 /* }}} */
 
-PowerStats::PowerStats(const char *str)
+PowerStats::PowerStats(const char *str, GStatsSnapshot *s)
   /* constructor {{{1 */
-  : name(strdup(str)) {
-  last_value = 0;
+  : name(strdup(str))
+  ,snap(s) {
 }
 /* }}} */
 
@@ -57,9 +57,9 @@ void PowerStats::addGStat(const char *str, const int32_t scale)
   I(str != 0);
   I(str[0] != 0);
 
-  GStats *ref = GStats::getRef(str);
-  if (ref) {
-    Container c(ref, scale);
+  int32_t index = snap->add(str);
+  if (index >= 0) {
+    Container c(index, scale);
     stats.push_back(c);
   } else if (strcmp(str, "testCounter")) {
     MSG("WARNING: GStat '%s' needed by PowerModel not found", str);
@@ -68,17 +68,15 @@ void PowerStats::addGStat(const char *str, const int32_t scale)
 }
 /* }}} */
 
-uint32_t PowerStats::getActivity()
+uint32_t PowerStats::getActivity() const
   /* getActivity {{{1 */
 {
-  uint32_t total = 0;
+  double total = 0;
 
   for(size_t i = 0; i < stats.size(); i++) 
-    total += stats[i].getValue();
+    total += snap->getDelta(stats[i].index) * stats[i].scalar;
   
-  uint32_t temp = total - last_value;
-  last_value    = total;
-  return temp;
+  return static_cast<uint32_t>(static_cast<int64_t>(total));
 }
 /* }}} */
 
@@ -47,28 +47,26 @@ class PowerStats {
   /* PowerStats class definition  */
   private:
 	  const char *name; 
-	  uint64_t    last_value;
+	  GStatsSnapshot *snap; // shared by all the PowerStats of the model
 
 	  class Container {
 	    public:
-		    Container(GStats *g, int32_t s) {
-			    gstat  = g;
+		    Container(int32_t i, int32_t s) {
+			    index  = i;
 			    scalar = s;
 		    }
-		    int32_t getValue() const {
-			    return gstat->getSamples() * scalar;
-		    }
-		    GStats *gstat;
+		    int32_t index;  // in snap
 		    int32_t scalar;
 	  };
 
 	  std::vector<Container> stats;
   
   public:
-	  PowerStats(const char* str);
+	  PowerStats(const char* str, GStatsSnapshot *s);
 	  ~PowerStats();
 	  void addGStat(const char *str, const int32_t scale);
-	  uint32_t getActivity();
+	  // Activity between the last two snap->update()
+	  uint32_t getActivity() const;
 	  const char* getName() const {
 		  return name;
 	  }
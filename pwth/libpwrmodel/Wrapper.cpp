@@ -46,6 +46,10 @@ power, and timing model and the eSESC performance simulator.
 #include "processor.h"
 #include "XML_Parse.h"
 #include "xmlParser.h"
+#include "nanassert.h"
+
+#include <math.h>
+#include <algorithm>
 
 /* }}} */
 
@@ -57,6 +61,7 @@ Wrapper::Wrapper()
   p = 0;
   proc = 0;
   nPowerCall = 0;
+  linearPower = false;
 }
 /* }}} */
 
@@ -113,17 +118,221 @@ void Wrapper::plug(const char *section,
   if (display)
     proc->displayEnergy(5, 5, true);
 
+  linearPower = false;
+  if (SescConf->checkBool(section, "linearPower"))
+    linearPower = SescConf->getBool(section, "linearPower");
+  if (linearPower && proc->procdynp.numGPU) {
+    // GPU containers are normalized by a counter (SM cycles), not by clockInterval
+    MSG("WARNING: linearPower is not supported with a GPU, using the full McPAT model");
+    linearPower = false;
+  }
+  linearPowerMaxErr = 1.0;
+  if (SescConf->checkDouble(section, "linearPowerMaxErr")) {
+    linearPowerMaxErr = SescConf->getDouble(section, "linearPowerMaxErr");
+    SescConf->isGT(section, "linearPowerMaxErr", 0);
+  }
 }
 /* }}} */
-void Wrapper::calcPower(vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, std::vector<uint64_t> *clockInterval){
-   p->updateCntrValues(statsVector, mcpat_map);
-   proc->load(clockInterval);
-   proc->Processor2(p);
+
+void Wrapper::calcPower(vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, std::vector<uint64_t> *clockInterval)
+  /* dynamic power for the last interval {{{1 */
+{
+  if (!linearPower) {
+    runMcPAT(statsVector, clockInterval);
+    return;
+  }
+
+  // Full McPAT only runs when a new frequency (DVFS state) shows up
+  float freq = energyBundle->getFreq();
+  LinearModel *lm = linearModels[freq];
+  if (lm == 0) {
+    lm = calibrate(statsVector, energyBundle, clockInterval->size());
+    linearModels[freq] = lm;
+  }
+
+  if (lm->useMcPAT) {
+    runMcPAT(statsVector, clockInterval);
+    return;
+  }
+  linearCalcPower(lm, statsVector, energyBundle, clockInterval);
+}
+/* }}} */
+
+void Wrapper::runMcPAT(std::vector<uint32_t> *statsVector, std::vector<uint64_t> *clockInterval)
+  /* full McPAT evaluation {{{1 */
+{
+  p->updateCntrValues(statsVector, mcpat_map);
+  proc->load(clockInterval);
+  proc->Processor2(p);
+}
+/* }}} */
+
+void Wrapper::findCycSources(std::vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, size_t ncores)
+  /* which clockInterval normalizes each container {{{1 */
+{
+  const uint64_t R = 1<<20;
+  size_t n = energyBundle->cntrs.size();
+  std::vector<uint64_t> ci(ncores, R);
+
+  // Containers that the dump does not touch keep the -1
+  for(size_t c = 0; c < n; c++)
+    energyBundle->cntrs[c].setDyn(-1);
+  runMcPAT(statsVector, &ci);
+
+  cycSource.assign(n, CycUnused);
+  for(size_t c = 0; c < n; c++) {
+    if (energyBundle->cntrs[c].getDyn() >= 0 && energyBundle->cntrs[c].getCyc() == R)
+      cycSource[c] = CycAvg;
+  }
+
+  // A core running twice as long changes its own containers to 2R and the
+  // shared ones (average of the cores) by less
+  for(size_t j = 0; j < ncores && ncores > 1; j++) {
+    ci[j] = 2*R;
+    runMcPAT(statsVector, &ci);
+    for(size_t c = 0; c < n; c++) {
+      if (cycSource[c] == CycAvg && energyBundle->cntrs[c].getCyc() == 2*R)
+        cycSource[c] = j;
+    }
+    ci[j] = R;
+  }
+}
+/* }}} */
+
+Wrapper::LinearModel *Wrapper::calibrate(std::vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, size_t ncores)
+  /* measure the energy of each counter with McPAT {{{1 */
+{
+  const uint64_t R = 1<<20; // cycles per core
+  const uint32_t N = 1<<16; // probe activity (even, some counters are halved)
+
+  size_t n = energyBundle->cntrs.size();
+  std::vector<uint32_t> saved(*statsVector);
+  std::vector<uint64_t> ci(ncores, R);
+
+  std::vector<float>    savedDyn(n);
+  std::vector<uint32_t> savedCyc(n);
+  for(size_t c = 0; c < n; c++) {
+    savedDyn[c] = energyBundle->cntrs[c].getDyn();
+    savedCyc[c] = energyBundle->cntrs[c].getCyc();
+  }
+
+  if (cycSource.empty())
+    findCycSources(statsVector, energyBundle, ncores);
+
+  LinearModel *lm = new LinearModel;
+  lm->base.resize(n);
+  lm->useMcPAT = false;
+
+  std::fill(statsVector->begin(), statsVector->end(), 0);
+  runMcPAT(statsVector, &ci);
+  std::vector<double> e0(n);
+  for(size_t c = 0; c < n; c++) {
+    if (cycSource[c] == CycUnused)
+      continue;
+    e0[c] = static_cast<double>(energyBundle->cntrs[c].getDyn())*energyBundle->cntrs[c].getCyc();
+    lm->base[c] = e0[c]/R;
+  }
+
+  for(size_t k = 0; k < statsVector->size(); k++) {
+    (*statsVector)[k] = N;
+    runMcPAT(statsVector, &ci);
+    (*statsVector)[k] = 0;
+
+    for(size_t c = 0; c < n; c++) {
+      if (cycSource[c] == CycUnused)
+        continue;
+      double e = static_cast<double>(energyBundle->cntrs[c].getDyn())*energyBundle->cntrs[c].getCyc();
+      // dyn is a float, ignore the rounding noise
+      if (fabs(e - e0[c]) <= 1e-6*fabs(e0[c]))
+        continue;
+      LinearTerm t;
+      t.stat = k;
+      t.cntr = c;
+      t.coef = (e - e0[c])/N;
+      lm->terms.push_back(t);
+    }
+  }
+
+  // Check the model with all the counters active at once
+  std::fill(statsVector->begin(), statsVector->end(), N/2);
+  runMcPAT(statsVector, &ci);
+  double full = 0;
+  for(size_t c = 0; c < n; c++) {
+    if (cycSource[c] != CycUnused)
+      full += energyBundle->cntrs[c].getDyn();
+  }
+  linearCalcPower(lm, statsVector, energyBundle, &ci);
+  double lin = 0;
+  for(size_t c = 0; c < n; c++) {
+    if (cycSource[c] != CycUnused)
+      lin += energyBundle->cntrs[c].getDyn();
+  }
+
+  double err = full == 0 ? 0 : 100*fabs(lin - full)/full;
+  lm->useMcPAT = err > linearPowerMaxErr;
+  MSG("linearPower: %.0fMHz model with %d terms, %.2f%% error with all counters active%s"
+      ,energyBundle->getFreq()/1e6, (int)lm->terms.size(), err
+      ,lm->useMcPAT ? " (above linearPowerMaxErr, using the full McPAT model)" : "");
+
+  *statsVector = saved;
+  for(size_t c = 0; c < n; c++) {
+    energyBundle->cntrs[c].setDyn(savedDyn[c]);
+    energyBundle->cntrs[c].setCyc(savedCyc[c]);
+  }
+  return lm;
+}
+/* }}} */
+
+void Wrapper::linearCalcPower(LinearModel *lm, std::vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, std::vector<uint64_t> *clockInterval)
+  /* dynamic power as a dot product over the activity {{{1 */
+{
+  size_t n = energyBundle->cntrs.size();
+
+  // Same cycle normalization as the McPAT dump functions
+  double avg = 0;
+  int    nActive = 0;
+  for(size_t j = 0; j < clockInterval->size(); j++) {
+    if ((*clockInterval)[j] > 1) {
+      avg += (*clockInterval)[j];
+      nActive++;
+    }
+  }
+  avg = nActive == 0 ? 0 : avg/nActive;
+
+  std::vector<double> energy(n);
+  std::vector<double> cyc(n);
+  for(size_t c = 0; c < n; c++) {
+    int src = cycSource[c];
+    if (src == CycUnused)
+      continue;
+    if (src == CycAvg) {
+      cyc[c] = avg;
+    }else{
+      uint64_t ci = (*clockInterval)[src];
+      cyc[c] = ci >= 50 ? ci : 0;
+    }
+    energy[c] = lm->base[c]*cyc[c];
+  }
+
+  for(size_t i = 0; i < lm->terms.size(); i++) {
+    const LinearTerm &t = lm->terms[i];
+    energy[t.cntr] += t.coef*(*statsVector)[t.stat];
+  }
+
+  for(size_t c = 0; c < n; c++) {
+    if (cycSource[c] == CycUnused)
+      continue;
+    energyBundle->cntrs[c].setDyn(cyc[c] == 0 ? 0 : energy[c]/cyc[c]);
+    energyBundle->cntrs[c].setCyc(cyc[c]);
+  }
 }
 /* }}} */
 
 Wrapper::~Wrapper()
   /* destructor {{{1 */
-{ }
+{
+  for(std::map<float, LinearModel *>::iterator it = linearModels.begin(); it != linearModels.end(); it++)
+    delete it->second;
+}
 /* }}} */
 
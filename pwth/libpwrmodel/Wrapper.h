@@ -68,6 +68,41 @@ private:
   FILE *logpwr;
   bool dumppwth;
 
+  // Linearized dynamic power (linearPower = true) {{{1
+  //
+  // For a given frequency the dynamic energy that McPAT reports for each
+  // container (dyn*cyc) is linear in the activity counters plus a per cycle
+  // term (clock/pipeline). The coefficients are measured with one McPAT run
+  // per counter the first time a frequency is seen, and after that
+  // calcPower is a sparse dot product. A frequency whose model is off by
+  // more than linearPowerMaxErr percent keeps using the full McPAT model.
+  class LinearTerm {
+  public:
+    uint32_t stat;
+    uint32_t cntr;
+    double   coef;
+  };
+  class LinearModel {
+  public:
+    std::vector<double>     base; // energy per cycle with no activity
+    std::vector<LinearTerm> terms;
+    bool                    useMcPAT; // calibration error above linearPowerMaxErr
+  };
+  enum {
+    CycUnused = -2, // container not updated by the dynamic power dump
+    CycAvg    = -1  // average of the active cores, else the core index
+  };
+  bool linearPower;
+  double linearPowerMaxErr; // percent
+  std::vector<int> cycSource;
+  std::map<float, LinearModel *> linearModels;
+
+  void runMcPAT(std::vector<uint32_t> *statsVector, std::vector<uint64_t> *clockInterval);
+  void findCycSources(std::vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, size_t ncores);
+  LinearModel *calibrate(std::vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, size_t ncores);
+  void linearCalcPower(LinearModel *lm, std::vector<uint32_t> *statsVector, ChipEnergyBundle *energyBundle, std::vector<uint64_t> *clockInterval);
+  // 1}}}
+
 public: 
   Wrapper();
   ~Wrapper();
@@ -472,3 +472,8 @@ void DataLibrary::set_timestep(double step)
 {
   if(_rk4Matrix) _rk4Matrix->set_timestep(step);
 }
+
+void DataLibrary::set_implicit(bool v)
+{
+  if(_rk4Matrix) _rk4Matrix->set_implicit(v);
+}
@@ -77,6 +77,7 @@ class DataLibrary
     DynamicArray <ModelUnit> &get_dyn_array(int layer);
 
     void set_timestep(double step);
+    void set_implicit(bool v); // backward Euler instead of RK4
 
     // Data
     MATRIX_DATA timestep_;			//this is the global timestep
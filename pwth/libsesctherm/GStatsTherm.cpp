@@ -81,6 +81,14 @@ void GStatsThermCntr::reportValue() const
   Report::field("%s=%Lg", name, alldata);
 }
 
+void GStatsThermCntr::getBinValues(double *v) const
+{
+  // Same value as reportValue, the second column keeps the bits a double
+  // loses
+  v[0] = static_cast<double>(alldata);
+  v[1] = static_cast<double>(alldata - static_cast<long double>(v[0]));
+}
+
 int64_t GStatsThermCntr::getSamples() const 
 { 
 	// In a counter, the # samples == value
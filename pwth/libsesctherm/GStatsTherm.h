@@ -74,6 +74,10 @@ public:
   void reportValue() const;
   void start();
   void stop(double weight=1);
+
+  char    getBinKind() const { return 'l'; }
+  int32_t getBinCols() const { return 2;   }
+  void    getBinValues(double *v) const;
 };
 
 
@@ -95,6 +99,9 @@ public:
 	}
   void start();
   void stop(double weight=1);
+
+  char    getBinKind() const { return 'x'; }
+  void    getBinValues(double *v) const { v[0] = maxValue; }
 };
 
 
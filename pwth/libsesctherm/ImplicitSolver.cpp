@@ -0,0 +1,211 @@
+/*
+    ESESC: Super ESCalar simulator
+    Copyright (C) 2010 University of California, Santa Cruz.
+
+This file is part of ESESC.
+
+ESESC is free software; you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation;
+either version 2, or (at your option) any later version.
+
+ESESC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should  have received a copy of  the GNU General  Public License along with
+ESESC; see the file COPYING.  If not, write to the  Free Software Foundation, 59
+Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+********************************************************************************
+File name:      ImplicitSolver.cpp
+Description:    Backward Euler integration of dT/dt + CT = p over the CSR copy
+                of the RK4 coefficients. Each step solves (I + hC) T' = T + hp
+                with Jacobi preconditioned BiCGSTAB (C is not symmetric, every
+                row is scaled by its own rho*Cp*V). Backward Euler is L-stable,
+                so the step is only limited by accuracy: the local error is
+                estimated from the difference with the explicit Euler step.
+********************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "RK4Matrix.h"
+
+#define IMPL_PRECISION  0.05   // max local error per step (degrees)
+#define IMPL_MIN_STEP   1e-6   // seconds
+#define IMPL_MAXUP      5.0
+#define IMPL_MAXDOWN    5.0
+#define IMPL_SAFETY     0.9
+#define IMPL_TOL        1e-10  // BiCGSTAB relative residual
+#define IMPL_MAX_ITER   200
+
+/* vout = C * vin */
+void sescthermRK4Matrix::spmv(MATRIX_DATA *vout, const MATRIX_DATA *vin) const
+{
+  for(size_t i = 0; i < _numelems; i++) {
+    MATRIX_DATA sum = 0;
+    for(int32_t k = _csr_row[i]; k < _csr_row[i+1]; k++)
+      sum += _csr_val[k] * vin[_csr_col[k]];
+    vout[i] = sum;
+  }
+}
+
+/* Solve (I + hC) x = b, x holds the initial guess. Returns the number of
+ * iterations, or -1 if it did not converge. */
+int sescthermRK4Matrix::bicgstab(MATRIX_DATA h, const MATRIX_DATA *b, MATRIX_DATA *x)
+{
+  const size_t n = _numelems;
+  MATRIX_DATA *r  = _impl_work;
+  MATRIX_DATA *r0 = r  + _numRowsInCoeffs;
+  MATRIX_DATA *p  = r0 + _numRowsInCoeffs;
+  MATRIX_DATA *v  = p  + _numRowsInCoeffs;
+  MATRIX_DATA *s  = v  + _numRowsInCoeffs;
+  MATRIX_DATA *t  = s  + _numRowsInCoeffs;
+  MATRIX_DATA *ph = t  + _numRowsInCoeffs;
+  MATRIX_DATA *sh = ph + _numRowsInCoeffs;
+
+  // r = b - (I + hC) x
+  MATRIX_DATA bnorm = 0;
+  spmv(r, x);
+  for(size_t i = 0; i < n; i++) {
+    r[i]  = b[i] - x[i] - h * r[i];
+    r0[i] = r[i];
+    p[i]  = 0;
+    v[i]  = 0;
+    bnorm += b[i] * b[i];
+  }
+  bnorm = sqrt(bnorm);
+  if (bnorm == 0)
+    bnorm = 1;
+
+  MATRIX_DATA rho = 1, alpha = 1, omega = 1;
+  for(int iter = 0; iter < IMPL_MAX_ITER; iter++) {
+    MATRIX_DATA rnorm = 0;
+    for(size_t i = 0; i < n; i++)
+      rnorm += r[i] * r[i];
+    if (sqrt(rnorm) <= IMPL_TOL * bnorm)
+      return iter;
+
+    MATRIX_DATA rho1 = 0;
+    for(size_t i = 0; i < n; i++)
+      rho1 += r0[i] * r[i];
+    if (rho1 == 0 || omega == 0)
+      return -1;
+
+    MATRIX_DATA beta = (rho1 / rho) * (alpha / omega);
+    rho = rho1;
+    for(size_t i = 0; i < n; i++) {
+      p[i]  = r[i] + beta * (p[i] - omega * v[i]);
+      ph[i] = p[i] / (1 + h * _csr_diag[i]);
+    }
+
+    spmv(v, ph);
+    MATRIX_DATA r0v = 0;
+    for(size_t i = 0; i < n; i++) {
+      v[i] = ph[i] + h * v[i];
+      r0v += r0[i] * v[i];
+    }
+    if (r0v == 0)
+      return -1;
+    alpha = rho / r0v;
+
+    MATRIX_DATA snorm = 0;
+    for(size_t i = 0; i < n; i++) {
+      s[i]  = r[i] - alpha * v[i];
+      sh[i] = s[i] / (1 + h * _csr_diag[i]);
+      snorm += s[i] * s[i];
+    }
+    if (sqrt(snorm) <= IMPL_TOL * bnorm) {
+      for(size_t i = 0; i < n; i++)
+        x[i] += alpha * ph[i];
+      return iter + 1;
+    }
+
+    spmv(t, sh);
+    MATRIX_DATA tt = 0, ts = 0;
+    for(size_t i = 0; i < n; i++) {
+      t[i] = sh[i] + h * t[i];
+      tt  += t[i] * t[i];
+      ts  += t[i] * s[i];
+    }
+    if (tt == 0)
+      return -1;
+    omega = ts / tt;
+
+    for(size_t i = 0; i < n; i++) {
+      x[i] += alpha * ph[i] + omega * sh[i];
+      r[i]  = s[i] - omega * t[i];
+    }
+  }
+
+  return -1;
+}
+
+void sescthermRK4Matrix::solve_implicit(MATRIX_DATA *temp_vector, MATRIX_DATA *power_vector, MATRIX_DATA timestep)
+{
+  const size_t n = _numelems;
+  // the first 8 work vectors belong to bicgstab
+  MATRIX_DATA *f0 = _impl_work + 8 * _numRowsInCoeffs;
+  MATRIX_DATA *b  = f0 + _numRowsInCoeffs;
+  MATRIX_DATA *x  = _temporary_temp_vector;
+
+  MATRIX_DATA h = _impl_h;
+  if (h <= 0 || h > timestep)
+    h = timestep;
+
+  MATRIX_DATA t = 0;
+  while (t < timestep) {
+    bool last = t + h >= timestep;
+    if (last)
+      h = timestep - t;
+
+    // f0 = p - C T ; b = T + h p
+    spmv(f0, temp_vector);
+    for(size_t i = 0; i < n; i++) {
+      f0[i] = power_vector[i] - f0[i];
+      b[i]  = temp_vector[i] + h * power_vector[i];
+      x[i]  = temp_vector[i];
+    }
+
+    int iters = bicgstab(h, b, x);
+    MATRIX_DATA err = 0;
+    if (iters < 0) {
+      err = 2 * IMPL_PRECISION; // no convergence, retry with a smaller step
+    }else{
+      _impl_iters += iters;
+      // local error of backward Euler ~ |T' - (T + h f0)| / 2
+      for(size_t i = 0; i < n; i++) {
+        MATRIX_DATA e = fabs(x[i] - temp_vector[i] - h * f0[i]) / 2;
+        if (e > err)
+          err = e;
+      }
+    }
+
+    if (err > IMPL_PRECISION && h > IMPL_MIN_STEP) {
+      MATRIX_DATA f = IMPL_SAFETY * sqrt(IMPL_PRECISION / err);
+      if (f < 1.0 / IMPL_MAXDOWN)
+        f = 1.0 / IMPL_MAXDOWN;
+      h *= f;
+      if (h < IMPL_MIN_STEP)
+        h = IMPL_MIN_STEP;
+      continue;
+    }
+    if (iters < 0) {
+      // should not happen with a diagonally dominant C
+      solve_rk4(temp_vector, power_vector, timestep - t);
+      return;
+    }
+
+    memmove(temp_vector, x, sizeof(MATRIX_DATA) * n);
+    t += h;
+
+    MATRIX_DATA f = IMPL_MAXUP;
+    if (err > 0 && IMPL_SAFETY * sqrt(IMPL_PRECISION / err) < f)
+      f = IMPL_SAFETY * sqrt(IMPL_PRECISION / err);
+    if (!last)
+      _impl_h = h * f;
+    h *= f;
+  }
+}
@@ -100,6 +100,17 @@ void sescthermRK4Matrix::realloc_matrices(size_t newNumelems)
   I(_temporary_temp_vector);
   memset(_temporary_temp_vector, 0, sizeof(MATRIX_DATA) * _numRowsInCoeffs);
 
+  // CSR copy of the coefficients: at most 7 entries per row
+  _csr_row = (int32_t *) calloc(_numRowsInCoeffs + 1, sizeof(int32_t));
+  _csr_col = (int32_t *) calloc(_numRowsInCoeffs * 7, sizeof(int32_t));
+  _csr_val = (MATRIX_DATA *) calloc(_numRowsInCoeffs * 7, sizeof(MATRIX_DATA));
+  _csr_diag = (MATRIX_DATA *) calloc(_numRowsInCoeffs, sizeof(MATRIX_DATA));
+  I(_csr_row && _csr_col && _csr_val && _csr_diag);
+
+  _impl_work = (MATRIX_DATA *) calloc(_numRowsInCoeffs * 10, sizeof(MATRIX_DATA));
+  I(_impl_work);
+  _impl_h = 0;
+
   _numelems = newNumelems;
   assert(newNumelems <= _numRowsInCoeffs);
 }
@@ -138,6 +149,12 @@ void sescthermRK4Matrix::free_mem()
   if(t2) { free(t2); t2 = 0x0; }
   if(ytemp) { free(ytemp); ytemp = 0x0; }
 
+  if(_csr_row)   { free(_csr_row);   _csr_row = 0x0;   }
+  if(_csr_col)   { free(_csr_col);   _csr_col = 0x0;   }
+  if(_csr_val)   { free(_csr_val);   _csr_val = 0x0;   }
+  if(_csr_diag)  { free(_csr_diag);  _csr_diag = 0x0;  }
+  if(_impl_work) { free(_impl_work); _impl_work = 0x0; }
+
   if(_temporary_temp_vector) {
     free(_temporary_temp_vector); 
     _temporary_temp_vector = 0;
@@ -194,6 +211,14 @@ void sescthermRK4Matrix::solve_matrix(ConfigData *conf, SUElement_t *temp_vector
     matrix_model_units[i]->print_rk4_equation(power_vector[i]);
     printf("\n");   ****/
 
+  if (_implicit)
+    solve_implicit(temp_vector, power_vector, timestep);
+  else
+    solve_rk4(temp_vector, power_vector, timestep);
+}
+
+void sescthermRK4Matrix::solve_rk4(MATRIX_DATA *temp_vector, MATRIX_DATA *power_vector, MATRIX_DATA timestep)
+{
   // to avoid stability issues, first try with small step size
   const MATRIX_DATA MIN_STEP = 1e-5 ; // in seconds
   MATRIX_DATA t = 0.0 , h = timestep, new_h = 0.0;
@@ -239,4 +264,40 @@ void sescthermRK4Matrix::initialize_Matrix(std::vector<ModelUnit *>& matrix_mode
     set_nbr_index(i,MAX_DIR, munit->temperature_index_);
     set_coeff(i,MAX_DIR, *(munit->t_mno));
   }
+
+  build_sparse();
+}
+
+// Compress the 7 coefficients per row into CSR. Absent neighbors have a 0
+// coefficient (and index 0), and a node may appear twice in a row when the
+// model units are lumped, so zeros are dropped and repeated columns merged.
+void sescthermRK4Matrix::build_sparse()
+{
+  int32_t nnz = 0;
+  for(size_t i = 0; i < _numelems; i++) {
+    _csr_row[i]  = nnz;
+    _csr_diag[i] = 0;
+    for(int dir = 0; dir <= MAX_DIR; dir++) {
+      MATRIX_DATA c = get_coeff(i, dir);
+      if (c == 0)
+        continue;
+      int32_t j = get_nbr_index(i, dir);
+      I(j >= 0 && (size_t)j < _numelems);
+      if ((size_t)j == i)
+        _csr_diag[i] += c;
+
+      int32_t k;
+      for(k = _csr_row[i]; k < nnz; k++) {
+        if (_csr_col[k] == j)
+          break;
+      }
+      if (k == nnz) {
+        _csr_col[nnz] = j;
+        _csr_val[nnz] = 0;
+        nnz++;
+      }
+      _csr_val[k] += c;
+    }
+  }
+  _csr_row[_numelems] = nnz;
 }
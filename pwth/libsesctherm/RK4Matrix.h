@@ -74,6 +74,22 @@ private:
   int32_t *_nbr_indices;  
   MATRIX_DATA *_coeffs;  
 
+  // Same coefficients in CSR form (zero entries dropped, repeated columns
+  // merged), rebuilt by build_sparse(). _csr_diag is the self term of each row.
+  int32_t     *_csr_row;
+  int32_t     *_csr_col;
+  MATRIX_DATA *_csr_val;
+  MATRIX_DATA *_csr_diag;
+
+  // Backward Euler solver: scratch vectors and the last accepted step size
+  bool         _implicit;
+  MATRIX_DATA *_impl_work;
+  MATRIX_DATA  _impl_h;
+  uint64_t     _impl_iters;
+
+  void spmv(MATRIX_DATA *vout, const MATRIX_DATA *vin) const;
+  int  bicgstab(MATRIX_DATA h, const MATRIX_DATA *b, MATRIX_DATA *x);
+
 public: // FIXME: make data members private
 
   // For solving dT + CT = p , where T = temp, p = energy vector in that time unit
@@ -104,6 +120,18 @@ public:
 
   void set_timestep(double step) { _new_h = step; }
 
+  // Integrate dT/dt + CT = power over timestep (power already divided by rho*Cp*V)
+  void solve_rk4(MATRIX_DATA *temp_vector, MATRIX_DATA *power_vector, MATRIX_DATA timestep);
+  void solve_implicit(MATRIX_DATA *temp_vector, MATRIX_DATA *power_vector, MATRIX_DATA timestep);
+
+  // Rebuild the CSR copy after changing coefficients with set_coeff
+  void build_sparse();
+
+  // solve_matrix uses backward Euler instead of RK4
+  void set_implicit(bool v) { _implicit = v; }
+  bool is_implicit() const { return _implicit; }
+  uint64_t get_implicit_iters() const { return _impl_iters; }
+
   // access coefficients and nbr indices. the first 4 are in one array; next 4 in 2nd array
   void set_coeff(int i, int dir, MATRIX_DATA val) {
     _coeffs[dir*_numRowsInCoeffs + i] = val;
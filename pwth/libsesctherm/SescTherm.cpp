@@ -197,6 +197,8 @@ void SescTherm::configure(ChipEnergyBundle * energyBundle){
   std::cout << "RECOMMENDED MODEL TIMESTEP: " << temp_model.get_recommended_timestep () << std::endl;
 
   temp_model.datalibrary_->set_timestep(temp_model.get_recommended_timestep());
+  if (useRK4 && SescConf->checkBool(model,"useImplicit") && SescConf->getBool(model,"useImplicit"))
+    temp_model.datalibrary_->set_implicit(true);
 
   initialTemp = SescConf->getDouble (model, "initialTemp");	// sesctherm works in K (not C)
   ambientTemp = SescConf->getDouble (model, "ambientTemp");
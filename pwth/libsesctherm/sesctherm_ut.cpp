@@ -43,13 +43,141 @@ Description:    Wrapper class structure creates the interface between SescTherm
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <math.h>
+#include <time.h>
 
 #include "SescConf.h"
 #include "SescThermWrapper.h"
+#include "RK4Matrix.h"
+#include "ModelUnit.h"
 
 void print_usage(const char * argv0);
 
+/* Thermal solver microbenchmark {{{1
+ *
+ * sesctherm_ut bench [nx] [samples] [timestep]
+ *
+ * Builds an nx*nx grid with 4 layers (active silicon, bulk silicon, spreader,
+ * sink) of 100um cells plus a locked ambient node, moves 10W of power around
+ * the die every 10 samples, and integrates the same trace with RK4 and with
+ * backward Euler. Reports the run time of each and the max temperature
+ * difference between them.
+ */
+static void benchSetup(sescthermRK4Matrix *m, int nx)
+{
+  const int    nl = 4;
+  const double a  = 100e-6;
+  const double d[nl]    = { 20e-6, 300e-6, 1e-3,   5e-3   };
+  const double k[nl]    = { 150,   150,    400,    400    };
+  const double rhoCp[nl]= { 1.63e6, 1.63e6, 3.45e6, 3.45e6 };
+  const double gAmb = 1e5 * a * a; // heat sink to ambient
+  const int    amb  = nl*nx*nx;
+
+  for(int l = 0; l < nl; l++) {
+    double gamma = rhoCp[l] * a * a * d[l];
+    double gLat  = k[l] * d[l];
+    for(int y = 0; y < nx; y++) {
+      for(int x = 0; x < nx; x++) {
+        int    i    = (l*nx + y)*nx + x;
+        int    nbr[MAX_DIR];
+        double g[MAX_DIR];
+        nbr[dir_left]   = x > 0    ? i - 1 : -1;
+        nbr[dir_right]  = x < nx-1 ? i + 1 : -1;
+        nbr[dir_bottom] = y > 0    ? i - nx : -1;
+        nbr[dir_top]    = y < nx-1 ? i + nx : -1;
+        nbr[dir_down]   = l < nl-1 ? i + nx*nx : amb;
+        nbr[dir_up]     = l > 0    ? i - nx*nx : -1;
+        g[dir_left] = g[dir_right] = g[dir_bottom] = g[dir_top] = gLat;
+        g[dir_down] = l < nl-1 ? 1/(d[l]/(2*k[l]*a*a) + d[l+1]/(2*k[l+1]*a*a)) : gAmb;
+        g[dir_up]   = l > 0    ? 1/(d[l]/(2*k[l]*a*a) + d[l-1]/(2*k[l-1]*a*a)) : 0;
+
+        double self = 0;
+        for(int dir = 0; dir < MAX_DIR; dir++) {
+          m->set_nbr_index(i, dir, nbr[dir] < 0 ? 0 : nbr[dir]);
+          m->set_coeff(i, dir, nbr[dir] < 0 ? 0 : -g[dir]/gamma);
+          if (nbr[dir] >= 0)
+            self += g[dir]/gamma;
+        }
+        m->set_nbr_index(i, MAX_DIR, i);
+        m->set_coeff(i, MAX_DIR, self);
+      }
+    }
+  }
+  // ambient is locked: all its coefficients stay 0
+  m->build_sparse();
+}
+
+static void benchPower(MATRIX_DATA *power, int nx, int n, int sample)
+{
+  const double gamma = 1.63e6 * 100e-6 * 100e-6 * 20e-6;
+  int q = (sample/10) % 4;
+  int h = nx/2;
+
+  for(int i = 0; i < n; i++)
+    power[i] = 0;
+  for(int y = 0; y < h; y++) {
+    for(int x = 0; x < h; x++) {
+      int i = (y + (q/2)*h)*nx + x + (q%2)*h;
+      power[i] = 10.0/(h*h) / gamma;
+    }
+  }
+}
+
+static int thermBench(int argc, const char **argv)
+{
+  int    nx      = argc > 2 ? atoi(argv[2]) : 32;
+  int    samples = argc > 3 ? atoi(argv[3]) : 50;
+  double dt      = argc > 4 ? atof(argv[4]) : 1e-3;
+  int    n       = 4*nx*nx + 1;
+
+  sescthermRK4Matrix *m = new sescthermRK4Matrix(n);
+  benchSetup(m, nx);
+
+  MATRIX_DATA *trk4  = new MATRIX_DATA[n];
+  MATRIX_DATA *timpl = new MATRIX_DATA[n];
+  MATRIX_DATA *power = new MATRIX_DATA[n];
+  for(int i = 0; i < n; i++)
+    trk4[i] = timpl[i] = 50 + 273.15;
+
+  double tRK4 = 0, tImpl = 0, maxDiff = 0, maxTemp = 0;
+  for(int s = 0; s < samples; s++) {
+    benchPower(power, nx, n, s);
+
+    clock_t c0 = clock();
+    m->solve_rk4(trk4, power, dt);
+    clock_t c1 = clock();
+    m->solve_implicit(timpl, power, dt);
+    clock_t c2 = clock();
+
+    tRK4  += (double)(c1 - c0) / CLOCKS_PER_SEC;
+    tImpl += (double)(c2 - c1) / CLOCKS_PER_SEC;
+    for(int i = 0; i < n; i++) {
+      if (fabs(trk4[i] - timpl[i]) > maxDiff)
+        maxDiff = fabs(trk4[i] - timpl[i]);
+      if (trk4[i] > maxTemp)
+        maxTemp = trk4[i];
+    }
+  }
+
+  printf("nodes %d samples %d timestep %g\n", n, samples, dt);
+  printf("RK4      : %8.3f s\n", tRK4);
+  printf("implicit : %8.3f s (%.2fx, %llu solver iterations)\n", tImpl, tImpl > 0 ? tRK4/tImpl : 0
+      ,(unsigned long long)m->get_implicit_iters());
+  printf("max temp %.2fK, max RK4/implicit difference %.4fK\n", maxTemp, maxDiff);
+
+  delete [] trk4;
+  delete [] timpl;
+  delete [] power;
+  delete m;
+
+  return 0;
+}
+/* }}} */
+
 int main(int argc, const char **argv){
+  if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    return thermBench(argc, argv);
+
   const char* section = 0;
 	ChipEnergyBundle *energyBundle = new ChipEnergyBundle;
   std::vector<float> *temperatures = NULL;
@@ -573,6 +573,8 @@ void SescTherm::computeTemp(int argc, const char **argv)
   std::cout << "RECOMMENDED MODEL TIMESTEP: " << temp_model.get_recommended_timestep () << std::endl;
 
   temp_model.datalibrary_->set_timestep(temp_model.get_recommended_timestep());
+  if (useRK4 && SescConf->checkBool(model,"useImplicit") && SescConf->getBool(model,"useImplicit"))
+    temp_model.datalibrary_->set_implicit(true);
 
   //this is a map of maps
   //it stores the time index of the run, and the corresponding temperature map, 
@@ -43,6 +43,7 @@
 #include "Report.h"
 #include "BPred.h"
 #include "SescConf.h"
+#include "Checkpoint.h"
 
 /*****************************************
  * BPred
@@ -69,6 +70,14 @@ BPred::BPred(int32_t i, int32_t fetchWidth, const char *sec, const char *name)
 BPred::~BPred() {
 }
 
+void BPred::checkpoint(Checkpoint *ck) {
+  // Oracle, taken, not taken have no state
+}
+
+bool BPred::beginCheckpoint(Checkpoint *ck, const char *kind, uint64_t sig) {
+  return ck->beginSection(Checkpoint::Independent, sig, "P(%d)_BPRED_%s", id, kind);
+}
+
 /*****************************************
  * RAS
  */
@@ -96,6 +105,17 @@ BPRas::~BPRas()
   delete stack;
 }
 
+void BPRas::checkpoint(Checkpoint *ck)
+{
+  if (RasSize == 0 || !beginCheckpoint(ck, "RAS", Checkpoint::signature(RasSize)))
+    return;
+
+  ck->io(stack, sizeof(AddrType)*RasSize);
+  ck->io(index);
+
+  ck->endSection();
+}
+
 PredType BPRas::predict(DInst *dinst, bool doUpdate)
 {
   // RAS is a little bit different than other predictors because it can update
@@ -154,6 +174,16 @@ BPBTB::~BPBTB()
     data->destroy();
 }
 
+void BPBTB::checkpoint(Checkpoint *ck)
+{
+  if( data == 0 )
+    return;
+
+  char cadena[100];
+  sprintf(cadena, "P(%d)_BPRED_BTB", id);
+  data->checkpoint(ck, cadena);
+}
+
 void BPBTB::updateOnly(DInst *dinst)
 {
   if( data == 0 || !dinst->isTaken() )
@@ -233,6 +263,11 @@ PredType BPOracle::predict(DInst *dinst, bool doUpdate) {
   return btb.predict(dinst, doUpdate);
 }
 
+void BPOracle::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+}
+
 /*****************************************
  * BPTaken
  */
@@ -244,6 +279,11 @@ PredType BPTaken::predict(DInst *dinst, bool doUpdate) {
   return MissPrediction;
 }
 
+void BPTaken::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+}
+
 /*****************************************
  * BPNotTaken
  */
@@ -255,6 +295,11 @@ PredType  BPNotTaken::predict(DInst *dinst, bool doUpdate) {
   return dinst->isTaken() ? MissPrediction : CorrectPrediction;
 }
 
+void BPNotTaken::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+}
+
 /*****************************************
  * BPNotTakenEnhaced
  */
@@ -274,6 +319,11 @@ PredType  BPNotTakenEnhanced::predict(DInst *dinst, bool doUpdate) {
   return CorrectPrediction;
 }
 
+void BPNotTakenEnhanced::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+}
+
 /*****************************************
  * BP2bit
  */
@@ -317,6 +367,18 @@ PredType BP2bit::predict(DInst *dinst, bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BP2bit::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  if (!beginCheckpoint(ck, "2bit", Checkpoint::signature(table.getSize())))
+    return;
+
+  table.checkpoint(ck);
+
+  ck->endSection();
+}
+
 /*****************************************
  * BP2level
  */
@@ -387,6 +449,19 @@ PredType BP2level::predict(DInst *dinst, bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BP2level::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  if (!beginCheckpoint(ck, "2level", Checkpoint::signature(l1Size, historySize, globalTable.getSize())))
+    return;
+
+  globalTable.checkpoint(ck);
+  ck->io(historyTable, sizeof(HistoryType)*l1Size);
+
+  ck->endSection();
+}
+
 /*****************************************
  * BPHybid
  */
@@ -480,6 +555,21 @@ PredType BPHybrid::predict(DInst *dinst, bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BPHybrid::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  if (!beginCheckpoint(ck, "Hybrid", Checkpoint::signature(historySize, globalTable.getSize(), localTable.getSize(), metaTable.getSize())))
+    return;
+
+  globalTable.checkpoint(ck);
+  localTable.checkpoint(ck);
+  metaTable.checkpoint(ck);
+  ck->io(ghr);
+
+  ck->endSection();
+}
+
 /*****************************************
  * 2BcgSkew 
  *
@@ -611,6 +701,23 @@ PredType BP2BcgSkew::predict(DInst *dinst, bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BP2BcgSkew::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  uint64_t hist = (G0HistorySize<<16) | (G1HistorySize<<8) | MetaHistorySize;
+  if (!beginCheckpoint(ck, "2BcgSkew", Checkpoint::signature(BIM.getSize(), G0.getSize(), G1.getSize(), metaTable.getSize(), hist)))
+    return;
+
+  BIM.checkpoint(ck);
+  G0.checkpoint(ck);
+  G1.checkpoint(ck);
+  metaTable.checkpoint(ck);
+  ck->io(history);
+
+  ck->endSection();
+}
+
 /*****************************************
  * YAGS
  * 
@@ -765,6 +872,23 @@ PredType BPyags::predict(DInst *dinst,bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BPyags::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  if (!beginCheckpoint(ck, "yags", Checkpoint::signature(table.getSize(), ctableTaken.getSize(), ctableNotTaken.getSize(), CacheTakenMask, CacheNotTakenMask)))
+    return;
+
+  table.checkpoint(ck);
+  ctableTaken.checkpoint(ck);
+  ctableNotTaken.checkpoint(ck);
+  ck->io(ghr);
+  ck->io(CacheTaken, CacheTakenMask + 1);
+  ck->io(CacheNotTaken, CacheNotTakenMask + 1);
+
+  ck->endSection();
+}
+
 /*****************************************
  * BPOgehl
  *
@@ -932,6 +1056,25 @@ PredType BPOgehl::predict(DInst *dinst, bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BPOgehl::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  if (!beginCheckpoint(ck, "ogehl", Checkpoint::signature(mtables, glength, logpred)))
+    return;
+
+  for (int32_t i = 0; i < mtables; i++)
+    ck->io(pred[i], 1 << logpred);
+  ck->io(ghist, sizeof(long long)*((glength >> 6) + 1));
+  ck->io(MINITAG, 1 << (logpred - 1));
+  ck->io(usedHistLength, sizeof(int32_t)*mtables);
+  ck->io(THETA);
+  ck->io(AC);
+  ck->io(TC);
+
+  ck->endSection();
+}
+
 
 int32_t BPOgehl::geoidx(long long Add, long long *histo, int32_t m, int32_t funct)
 {
@@ -1156,6 +1299,33 @@ PredType BPSOgehl::predict(DInst *dinst, bool doUpdate)
   return ptaken ? btb.predict(dinst, doUpdate) : CorrectPrediction;
 }
 
+void BPSOgehl::checkpoint(Checkpoint *ck)
+{
+  btb.checkpoint(ck);
+
+  if (!beginCheckpoint(ck, "sogehl", Checkpoint::signature(mtables, glength, logtsize)))
+    return;
+
+  for (int32_t i = 0; i < mtables; i++)
+    ck->io(pred[i], 1 << logtsize);
+
+  std::vector<LongHistoryType::block_type> blocks(ghr.num_blocks());
+  if (ck->isSaving())
+    boost::to_block_range(ghr, blocks.begin());
+  if (!blocks.empty())
+    ck->io(&blocks[0], sizeof(LongHistoryType::block_type)*blocks.size());
+  if (!ck->isSaving())
+    boost::from_block_range(blocks.begin(), blocks.end(), ghr);
+
+  ck->io(MINITAG, 1 << (logtsize - 1));
+  ck->io(usedHistLength, sizeof(int32_t)*mtables);
+  ck->io(THETA);
+  ck->io(AC);
+  ck->io(TC);
+
+  ck->endSection();
+}
+
 uint32_t BPSOgehl::geoidx2(long long Add, int32_t m)
 {
   uint32_t inter   = Add & ((1<< AddWidth)-1);                                           // start with the PC
@@ -1244,6 +1414,15 @@ BPredictor::~BPredictor()
   free(section);
 }
 
+void BPredictor::checkpoint(Checkpoint *ck)
+{
+  ras.checkpoint(ck);
+
+  // SMT threads share the predictor, the owner saves it
+  if (!SMTcopy)
+    pred->checkpoint(ck);
+}
+
 void BPredictor::dump(const char *str) const
 {
   // nothing?
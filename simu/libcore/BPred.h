@@ -99,11 +99,16 @@ protected:
 
     return cid;
   }
+
+  bool beginCheckpoint(Checkpoint *ck, const char *kind, uint64_t sig);
 protected:
 public:
   BPred(int32_t i, int32_t fetchWidth, const char *section, const char *name);
   virtual ~BPred();
 
+  // Save/restore the tables and histories (see Checkpoint.h)
+  virtual void checkpoint(Checkpoint *ck);
+
   // [sizhuo] this func only predicts, doesn't change stats
   virtual PredType predict(DInst *dinst, bool doUpdate) = 0;
 
@@ -133,6 +138,7 @@ public:
   BPRas(int32_t i, int32_t fetchWidth, const char *section);
   ~BPRas();
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -151,6 +157,11 @@ private:
     bool operator==(BTBState s) const {
       return inst == s.inst;
     }
+
+    void checkpoint(Checkpoint *ck) {
+      StateGeneric<AddrType>::checkpoint(ck);
+      ck->io(inst);
+    }
   };
 
   typedef CacheGeneric<BTBState, AddrType> BTBCache;
@@ -164,6 +175,7 @@ public:
 
   PredType predict(DInst *dinst, bool doUpdate);
   void updateOnly(DInst *dinst);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -180,6 +192,7 @@ public:
   }
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -196,6 +209,7 @@ public:
   }
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -212,6 +226,7 @@ public:
   }
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -228,6 +243,7 @@ public:
   }
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -241,6 +257,7 @@ public:
   BP2bit(int32_t i, int32_t fetchWidth, const char *section);
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -263,6 +280,7 @@ public:
   ~BP2level();
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -286,6 +304,7 @@ public:
   ~BPHybrid();
 
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -314,6 +333,7 @@ public:
   ~BP2BcgSkew();
   
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -344,6 +364,7 @@ public:
   ~BPyags();
   
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -380,6 +401,7 @@ public:
   ~BPOgehl();
   
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 
@@ -416,6 +438,7 @@ public:
   ~BPSOgehl();
   
   PredType predict(DInst *dinst, bool doUpdate);
+  void checkpoint(Checkpoint *ck);
 
 };
 #endif
@@ -442,6 +465,8 @@ public:
 
   static BPred *getBPred(int32_t id, int32_t fetchWidth, const char *sec);
 
+  void checkpoint(Checkpoint *ck);
+
   PredType predict(DInst *dinst, bool doUpdate) {
     I(dinst->getInst()->isControl());
 
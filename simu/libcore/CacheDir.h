@@ -0,0 +1,245 @@
+#ifndef CACHE_DIR_H
+#define CACHE_DIR_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nanassert.h"
+#include "CacheLine.h"
+
+// Directory of the upper level nodes for the lines of a cache array. The
+// entries of all the lines are packed in one array next to the tags
+// (getWords() words per line) and this object knows their format:
+//
+//  Full:       exact sharer bit-vector
+//  LimitedPtr: up to nPtr sharer pointers, all the nodes after an overflow
+//  Coarse:     up to nPtr sharer pointers, after an overflow the pointer bits
+//              are a vector where each bit covers a group of nodes
+//
+// The E/M owner is always exact (only one node can have it). An overflowed
+// entry goes back to pointers when a node becomes the owner, since the
+// protocol invalidated the other nodes first. Extra sharers in the imprecise
+// modes only cost messages: a node without the line acks the downgrade.
+//
+// Entry layout: bits 0-14 owner+1, bit 15 owner in M. Full: sharer bits from
+// bit 16. LimitedPtr/Coarse: bits 16-23 pointer count, bit 24 overflow,
+// 16-bit pointers (or the coarse vector) from bit 32.
+class CacheDir {
+public:
+	typedef CacheLine::DirWord DirWord;
+	enum Mode { Full = 0, LimitedPtr, Coarse };
+
+private:
+	enum {
+		OwnerMask   = 0x7FFF,
+		OwnerMBit   = 0x8000,
+		VecStart    = 16,
+		CountShift  = 16,
+		CountMask   = 0xFF,
+		OverflowBit = 24,
+		PtrStart    = 32
+	};
+
+	const int  nNodes;
+	const Mode mode;
+	const int  nPtr;
+	int nWords;
+	int groupSize; // nodes per bit of an overflowed Coarse entry
+
+	static bool getBit(const DirWord *e, int pos) {
+		return (e[pos >> 6] >> (pos & 63)) & 1;
+	}
+	static void setBit(DirWord *e, int pos) {
+		e[pos >> 6] |= static_cast<DirWord>(1) << (pos & 63);
+	}
+	static void clearBit(DirWord *e, int pos) {
+		e[pos >> 6] &= ~(static_cast<DirWord>(1) << (pos & 63));
+	}
+
+	int getCount(const DirWord *e) const { return (e[0] >> CountShift) & CountMask; }
+	void setCount(DirWord *e, int n) const {
+		e[0] = (e[0] & ~(static_cast<DirWord>(CountMask) << CountShift)) | (static_cast<DirWord>(n) << CountShift);
+	}
+	bool isOverflow(const DirWord *e) const { return getBit(e, OverflowBit); }
+	// pointers are 16-bit aligned, they never cross a word
+	int getPtr(const DirWord *e, int i) const {
+		const int pos = PtrStart + 16 * i;
+		return (e[pos >> 6] >> (pos & 63)) & 0xFFFF;
+	}
+	void setPtr(DirWord *e, int i, int port) const {
+		const int pos = PtrStart + 16 * i;
+		e[pos >> 6] = (e[pos >> 6] & ~(static_cast<DirWord>(0xFFFF) << (pos & 63))) | (static_cast<DirWord>(port) << (pos & 63));
+	}
+
+	void addSharer(DirWord *e, int port) const {
+		if(mode == Full) {
+			setBit(e, VecStart + port);
+			return;
+		}
+		if(isOverflow(e)) {
+			if(mode == Coarse) {
+				setBit(e, PtrStart + port / groupSize);
+			}
+			return;
+		}
+		const int n = getCount(e);
+		for(int i = 0; i < n; i++) {
+			if(getPtr(e, i) == port) {
+				return;
+			}
+		}
+		if(n < nPtr) {
+			setPtr(e, n, port);
+			setCount(e, n + 1);
+			return;
+		}
+		// overflow
+		if(mode == Coarse) {
+			int ptrs[CountMask];
+			for(int i = 0; i < n; i++) {
+				ptrs[i] = getPtr(e, i);
+			}
+			for(int i = 0; i < n; i++) {
+				setPtr(e, i, 0);
+			}
+			for(int i = 0; i < n; i++) {
+				setBit(e, PtrStart + ptrs[i] / groupSize);
+			}
+			setBit(e, PtrStart + port / groupSize);
+		}
+		setCount(e, 0);
+		setBit(e, OverflowBit);
+	}
+
+	void removeSharer(DirWord *e, int port) const {
+		if(mode == Full) {
+			clearBit(e, VecStart + port);
+			return;
+		}
+		if(isOverflow(e)) {
+			return; // not tracked per node
+		}
+		const int n = getCount(e);
+		for(int i = 0; i < n; i++) {
+			if(getPtr(e, i) == port) {
+				setPtr(e, i, getPtr(e, n - 1));
+				setPtr(e, n - 1, 0);
+				setCount(e, n - 1);
+				return;
+			}
+		}
+	}
+
+	bool isSharer(const DirWord *e, int port) const {
+		if(mode == Full) {
+			return getBit(e, VecStart + port);
+		}
+		if(isOverflow(e)) {
+			return mode == LimitedPtr || getBit(e, PtrStart + port / groupSize);
+		}
+		const int n = getCount(e);
+		for(int i = 0; i < n; i++) {
+			if(getPtr(e, i) == port) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+public:
+	CacheDir(int nNodes_, Mode mode_ = Full, int nPtr_ = 4)
+		: nNodes(nNodes_)
+		, mode(mode_)
+		, nPtr(nPtr_)
+		, groupSize(1)
+	{
+		I(nNodes > 0 && nNodes < OwnerMask);
+		I(mode == Full || (nPtr > 0 && nPtr <= CountMask));
+		if(mode == Full) {
+			nWords = (VecStart + nNodes + 63) / 64;
+		} else {
+			nWords = (PtrStart + 16 * nPtr + 63) / 64;
+			const int nBits = 16 * nPtr;
+			groupSize = (nNodes + nBits - 1) / nBits;
+		}
+	}
+
+	Mode getMode() const { return mode; }
+	int getPtrs() const { return nPtr; }
+	int getWords() const { return nWords; }
+
+	void clear(DirWord *e) const {
+		memset(e, 0, sizeof(DirWord) * nWords);
+	}
+
+	CacheLine::MESI get(const DirWord *e, int port) const {
+		I(port >= 0 && port < nNodes);
+		if(static_cast<int>(e[0] & OwnerMask) == port + 1) {
+			return (e[0] & OwnerMBit) ? CacheLine::M : CacheLine::E;
+		}
+		return isSharer(e, port) ? CacheLine::S : CacheLine::I;
+	}
+
+	void set(DirWord *e, int port, CacheLine::MESI st) const {
+		I(port >= 0 && port < nNodes);
+		if(st == CacheLine::E || st == CacheLine::M) {
+			if(mode != Full && isOverflow(e)) {
+				clear(e);
+			}
+			e[0] = (e[0] & ~static_cast<DirWord>(OwnerMask | OwnerMBit)) | (port + 1) | (st == CacheLine::M ? OwnerMBit : 0);
+			addSharer(e, port);
+			return;
+		}
+		if(static_cast<int>(e[0] & OwnerMask) == port + 1) {
+			e[0] &= ~static_cast<DirWord>(OwnerMask | OwnerMBit);
+		}
+		if(st == CacheLine::S) {
+			addSharer(e, port);
+		} else {
+			removeSharer(e, port);
+		}
+	}
+
+	// Nodes that may have the line (state != I), in increasing order. ports
+	// must have room for all the nodes. Returns the number of nodes.
+	int getSharers(const DirWord *e, int16_t *ports) const {
+		int n = 0;
+		if(mode == Full) {
+			for(int w = 0; w < nWords; w++) {
+				DirWord bits = e[w];
+				if(w == 0) {
+					bits &= ~static_cast<DirWord>(0) << VecStart;
+				}
+				while(bits) {
+					const int b = __builtin_ctzll(bits);
+					bits &= bits - 1;
+					ports[n++] = w * 64 + b - VecStart;
+				}
+			}
+			return n;
+		}
+		if(isOverflow(e)) {
+			for(int p = 0; p < nNodes; p++) {
+				if(mode == LimitedPtr || getBit(e, PtrStart + p / groupSize)) {
+					ports[n++] = p;
+				}
+			}
+			return n;
+		}
+		const int cnt = getCount(e);
+		for(int i = 0; i < cnt; i++) {
+			// insertion sort, a few pointers
+			const int16_t p = getPtr(e, i);
+			int j = n;
+			while(j > 0 && ports[j - 1] > p) {
+				ports[j] = ports[j - 1];
+				j--;
+			}
+			ports[j] = p;
+			n++;
+		}
+		return n;
+	}
+};
+
+#endif
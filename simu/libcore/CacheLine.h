@@ -10,8 +10,9 @@ class MemRequest;
 class CacheLine {
 public:
 	typedef enum {I, S, E, M} MESI;
+	typedef uint64_t DirWord;
 	MESI state; // [sizhuo] MESI state of this cache line
-	MESI *dir; // [sizhuo] directory for cache line in upper level
+	DirWord *dir; // directory entry for the upper level, format in CacheDir
 	AddrType lineAddr;
 	const MemRequest *upReq; // [sizhuo] upgrade req operating on this line
 	const MemRequest *downReq; // [sizhuo] downgrade req operating on this line
@@ -21,19 +22,6 @@ public:
 	CacheLine() : state(I), dir(0), lineAddr(0), upReq(0), downReq(0) {
 		ID(upNum = 0);
 	}
-	CacheLine(const int upNodeNum) : state(I), dir(0), lineAddr(0), upReq(0), downReq(0) {
-		dir = new MESI[upNodeNum];
-		I(dir);
-		for(int i = 0; i < upNodeNum; i++) {
-			dir[i] = I;
-		}
-		ID(upNum = upNodeNum);
-	}
-	~CacheLine() {
-		if(dir) {
-			delete[]dir;
-		}
-	}
 
 	// [sizhuo] whether the current cache line state can satisfy the upgrade req
 	static bool compatibleUpReq(MESI mesi, MsgAction act, bool isLLC) {
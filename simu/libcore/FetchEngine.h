@@ -134,6 +134,8 @@ public:
 
   void dump(const char *str) const;
 
+  void checkpoint(Checkpoint *ck) { bpred->checkpoint(ck); }
+
 
   bool isBlocked(DInst* inst) const {
     for (uint32_t i = 0; i < numSP; i++){
@@ -56,6 +56,11 @@ void MemoryObjContainer::addMemoryObj(const char *device_name, MemObj *obj) {
   mem_node.push_back(obj);
 }
 
+void MemoryObjContainer::checkpoint(Checkpoint *ck) {
+  for(size_t i = 0; i < mem_node.size(); i++)
+    mem_node[i]->checkpoint(ck);
+}
+
 MemObj *MemoryObjContainer::searchMemoryObj(const char *descr_section, 
               const char *device_name) const {
   I(descr_section);
@@ -41,6 +41,7 @@
 #include "estl.h"
 
 class MemObj;
+class Checkpoint;
 
 //Class for comparison to be used in hashes of char * where the
 //content is to be compared
@@ -63,6 +64,8 @@ class MemoryObjContainer {
   MemObj *searchMemoryObj(const char *section, const char *name) const;
   MemObj *searchMemoryObj(const char *name) const;
 
+  void checkpoint(Checkpoint *ck);
+
   void clear();
 };
 
@@ -129,6 +132,10 @@ class GMemorySystem {
   MemObj *getDL1() const { return DL1; };
   MemObj *getIL1() const { return IL1; };
   MemObj *getvpc() const { return vpc; };
+
+  // Warm state snapshot of the private/shared memory objects (see Checkpoint.h)
+  void checkpoint(Checkpoint *ck) { localMemoryObjContainer->checkpoint(ck); }
+  static void checkpointShared(Checkpoint *ck) { sharedMemoryObjContainer.checkpoint(ck); }
 };
 
 class DummyMemorySystem : public GMemorySystem {
@@ -71,6 +71,11 @@ GPUSMProcessor::~GPUSMProcessor() {
   // Nothing to do
 }
 
+void GPUSMProcessor::checkpoint(Checkpoint *ck) {
+  IFID.checkpoint(ck);
+  GProcessor::checkpoint(ck);
+}
+
 void GPUSMProcessor::fetch(FlowID fid) {
   I(eint);
 
@@ -71,6 +71,8 @@ public:
   GPUSMProcessor(GMemorySystem *gm, CPU_t i);
   virtual ~GPUSMProcessor();
 
+  void checkpoint(Checkpoint *ck);
+
   LSQ *getLSQ() { return &lsq; }
   void replay(DInst *dinst);
 
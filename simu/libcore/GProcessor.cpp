@@ -138,6 +138,10 @@ GProcessor::GProcessor(GMemorySystem *gm, CPU_t i, size_t numFlows)
 GProcessor::~GProcessor() {
 }
 
+void GProcessor::checkpoint(Checkpoint *ck) {
+  memorySystem->checkpoint(ck);
+}
+
 
 void GProcessor::buildInstStats(GStatsCntr *i[iMAX], const char *txt) {
   bzero(i, sizeof(GStatsCntr *) * iMAX);
@@ -71,6 +71,7 @@ class GMemorySystem;
 class BPredictor;
 class MTStoreSet;
 class MTLSQ;
+class Checkpoint;
 
 class GProcessor {
   private:
@@ -169,12 +170,24 @@ class GProcessor {
     // Returns the maximum number of flows this processor can support
     FlowID getMaxFlows(void) const { return MaxFlows; }
 
+    // Save/restore the warm state of the core: private memory objects, and
+    // the predictors in the cores that extend it (see Checkpoint.h)
+    virtual void checkpoint(Checkpoint *ck);
+
     void report(const char *str);
 
     // Different types of cores extend this function. See SMTProcessor and
     // Processor.
     virtual bool advance_clock(FlowID fid) = 0;
 
+    // Idle fast-forward (TaskHandler simSkipIdle): first cycle, from
+    // globalClock, where advance_clock may do more than update the stall
+    // stats if no callback happens before. The default never skips.
+    virtual Time_t nextProgress() const { return globalClock; }
+    // Add the stats of nCycles idle cycles from globalClock, as if
+    // advance_clock was called on each of them
+    virtual void skipCycles(Time_t nCycles) { I(0); }
+
     void setEmulInterface(EmulInterface *e) {
       eint = e;
     }
@@ -197,6 +210,15 @@ class GProcessor {
       lastWallClock = globalClock;
       wallClock->inc(en);
     }
+    // setWallClock for the nCycles starting at globalClock
+    void skipWallClock(Time_t nCycles, bool en) {
+      Time_t last = globalClock + nCycles - 1;
+      if (!en || lastWallClock >= last)
+        return;
+      Time_t first = lastWallClock >= globalClock ? lastWallClock + 1 : globalClock;
+      wallClock->add(last - first + 1);
+      lastWallClock = last;
+    }
 
     //StoreSet *getSS() { return &storeset; }
     StoreSet *getSS() { return 0; } // [sizhuo] never use obsolete store set
@@ -62,6 +62,11 @@ InOrderProcessor::~InOrderProcessor() {
   // Nothing to do
 }
 
+void InOrderProcessor::checkpoint(Checkpoint *ck) {
+  IFID.checkpoint(ck);
+  GProcessor::checkpoint(ck);
+}
+
 void InOrderProcessor::fetch(FlowID fid) {
   // TODO: Move this to GProcessor (same as in OoOProcessor)
   I(eint);
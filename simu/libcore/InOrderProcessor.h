@@ -74,6 +74,8 @@ public:
   InOrderProcessor(GMemorySystem *gm, CPU_t i);
   virtual ~InOrderProcessor();
 
+  void checkpoint(Checkpoint *ck);
+
   LSQ *getLSQ() { return &lsq; }
   void replay(DInst *dinst);
   bool isFlushing() {
@@ -0,0 +1,203 @@
+#ifndef LSQ_RING_H
+#define LSQ_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <iterator>
+#include <utility>
+
+#include "nanassert.h"
+#include "Snippets.h"
+
+// Queue of (DInst ID, data) kept sorted by ID in a circular array.
+//
+// It replaces std::map<Time_t, Data> in MTLSQ with the same subset of the
+// interface (find/insert/erase, bidirectional iterators, ->first/->second).
+// Entries are almost always inserted at the tail (program order) and removed
+// at the head (retire), which are O(1). Out of order insert/erase shifts the
+// shorter side of the queue, find is a binary search.
+//
+// Iterators are logical positions (0 is the oldest entry), so any insert or
+// erase invalidates them. erase returns the position of the next entry.
+// The array grows if the queue is full (reset can leave more entries than
+// the LSQ size until the poisoned loads come back).
+template<class Data>
+class LSQRing {
+public:
+  class Entry {
+  public:
+    Time_t first;
+    Data   second;
+  };
+
+  class iterator {
+  private:
+    friend class LSQRing;
+    LSQRing *q;
+    uint32_t pos;
+    iterator(LSQRing *q_, uint32_t pos_) : q(q_), pos(pos_) {}
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef Entry                           value_type;
+    typedef ptrdiff_t                       difference_type;
+    typedef Entry*                          pointer;
+    typedef Entry&                          reference;
+
+    iterator() : q(0), pos(0) {}
+
+    Entry &operator*() const  { I(pos < q->nEntries); return q->at(pos);  }
+    Entry *operator->() const { I(pos < q->nEntries); return &q->at(pos); }
+
+    iterator &operator++()   { pos++; return *this; }
+    iterator &operator--()   { I(pos > 0); pos--; return *this; }
+    iterator operator++(int) { iterator tmp(*this); pos++; return tmp; }
+    iterator operator--(int) { iterator tmp(*this); I(pos > 0); pos--; return tmp; }
+
+    bool operator==(const iterator &it) const { return pos == it.pos; }
+    bool operator!=(const iterator &it) const { return pos != it.pos; }
+  };
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+
+private:
+  Entry   *buf;
+  uint32_t mask; // capacity - 1 (power of two)
+  uint32_t head;
+  uint32_t nEntries;
+
+  Entry &at(uint32_t pos) { return buf[(head + pos) & mask]; }
+
+  void grow() {
+    uint32_t cap  = (mask + 1) * 2;
+    Entry   *nbuf = new Entry[cap];
+    for(uint32_t i = 0; i < nEntries; i++)
+      nbuf[i] = at(i);
+    delete [] buf;
+    buf  = nbuf;
+    mask = cap - 1;
+    head = 0;
+  }
+
+  // First position with ID >= id
+  uint32_t lowerBound(Time_t id) {
+    uint32_t lo = 0;
+    uint32_t hi = nEntries;
+    while(lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (at(mid).first < id)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  // Not copyable (iterators point to the queue)
+  LSQRing(const LSQRing &);
+  LSQRing &operator=(const LSQRing &);
+
+public:
+  explicit LSQRing(uint32_t size) : head(0), nEntries(0) {
+    uint32_t cap = 4;
+    while(cap < size)
+      cap <<= 1;
+    buf  = new Entry[cap];
+    mask = cap - 1;
+  }
+  ~LSQRing() {
+    delete [] buf;
+  }
+
+  iterator begin() { return iterator(this, 0);        }
+  iterator end()   { return iterator(this, nEntries); }
+  reverse_iterator rbegin() { return reverse_iterator(end());   }
+  reverse_iterator rend()   { return reverse_iterator(begin()); }
+
+  size_t size() const { return nEntries;      }
+  bool   empty() const { return nEntries == 0; }
+
+  iterator find(Time_t id) {
+    uint32_t pos = lowerBound(id);
+    if (pos < nEntries && at(pos).first == id)
+      return iterator(this, pos);
+    return end();
+  }
+
+  std::pair<iterator, bool> insert(Time_t id, Data data) {
+    if (nEntries > mask)
+      grow();
+
+    uint32_t pos;
+    if (nEntries == 0 || at(nEntries - 1).first < id) {
+      pos = nEntries; // common case: program order
+    }else{
+      pos = lowerBound(id);
+      if (at(pos).first == id)
+        return std::make_pair(iterator(this, pos), false);
+
+      if (pos < nEntries / 2) {
+        head = (head - 1) & mask;
+        for(uint32_t i = 0; i < pos; i++)
+          at(i) = at(i + 1);
+      }else{
+        for(uint32_t i = nEntries; i > pos; i--)
+          at(i) = at(i - 1);
+      }
+    }
+    Entry &e = at(pos);
+    e.first  = id;
+    e.second = data;
+    nEntries++;
+
+    return std::make_pair(iterator(this, pos), true);
+  }
+
+  iterator erase(iterator it) {
+    I(it.q == this);
+    uint32_t pos = it.pos;
+    I(pos < nEntries);
+
+    if (pos < nEntries / 2) {
+      for(uint32_t i = pos; i > 0; i--)
+        at(i) = at(i - 1);
+      head = (head + 1) & mask;
+    }else{
+      for(uint32_t i = pos; i + 1 < nEntries; i++)
+        at(i) = at(i + 1);
+    }
+    nEntries--;
+
+    return iterator(this, pos);
+  }
+};
+
+// Counting filter over addresses (aligned word or line). A zero count means
+// that no entry has the address, so a search can be skipped. Collisions only
+// make the count larger than the real one.
+class LSQAddrFilter {
+private:
+  enum { Log2Size = 10 };
+  uint16_t cnt[1 << Log2Size];
+
+  static uint32_t hash(uint64_t addr) {
+    return (uint32_t)((addr * 0x9E3779B97F4A7C15ULL) >> (64 - Log2Size));
+  }
+
+public:
+  LSQAddrFilter() { clear(); }
+
+  void clear() { memset(cnt, 0, sizeof(cnt)); }
+
+  void add(uint64_t addr) {
+    I(cnt[hash(addr)] < 0xFFFF);
+    cnt[hash(addr)]++;
+  }
+  void remove(uint64_t addr) {
+    I(cnt[hash(addr)] > 0);
+    cnt[hash(addr)]--;
+  }
+  // Upper bound of the number of entries with addr
+  uint32_t count(uint64_t addr) const { return cnt[hash(addr)]; }
+};
+
+#endif
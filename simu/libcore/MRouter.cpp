@@ -415,7 +415,7 @@ int32_t MRouter::invalidateAll(AddrType addr, MemRequest *mreq, TimeDelta_t lat)
 }
 
 // [sizhuo] newly added to send set state req using directory
-int32_t MRouter::sendSetStateOthersDir(MemRequest *mreq, MsgAction ma, CacheLine::MESI *dir, TimeDelta_t lat) {
+int32_t MRouter::sendSetStateOthersDir(MemRequest *mreq, MsgAction ma, const CacheDir *dirFmt, const CacheLine::DirWord *dir, TimeDelta_t lat) {
   if (up_node.size() <= 1)
     return 0; // if single node, for sure it does not get one
 
@@ -429,12 +429,15 @@ int32_t MRouter::sendSetStateOthersDir(MemRequest *mreq, MsgAction ma, CacheLine
 
   int32_t conta = 0;
   I(mreq->isReq() || mreq->isReqAck());
-  for(size_t i=0;i<up_node.size();i++) {
+  dirSharers.resize(up_node.size());
+  const int nSharers = dirFmt->getSharers(dir, &dirSharers[0]);
+  for(int j=0;j<nSharers;j++) {
+    const int i = dirSharers[j];
     if (up_node[i] == skip_mobj) 
       continue;
 
 		// [sizhuo] send req based on directory
-		if(!CacheLine::compatibleDownReq(dir[i], ma)) {
+		if(!CacheLine::compatibleDownReq(dirFmt->get(dir, i), ma)) {
 			MemRequest *breq = MemRequest::createSetState(self_mobj, mreq->getCreator(), ma, addr, doStats);
 #ifdef DEBUG
 			// [sizhuo] inherit debug bit
@@ -451,7 +454,7 @@ int32_t MRouter::sendSetStateOthersDir(MemRequest *mreq, MsgAction ma, CacheLine
 }
 
 // [sizhuo] newly added to send set state all using directory
-int32_t MRouter::sendSetStateAllDir(MemRequest *mreq, MsgAction ma, CacheLine::MESI* dir, TimeDelta_t lat) {
+int32_t MRouter::sendSetStateAllDir(MemRequest *mreq, MsgAction ma, const CacheDir *dirFmt, const CacheLine::DirWord *dir, TimeDelta_t lat) {
   if(up_node.empty())
     return 0; // top node?
 
@@ -460,9 +463,12 @@ int32_t MRouter::sendSetStateAllDir(MemRequest *mreq, MsgAction ma, CacheLine::M
 
   I(mreq->isSetState());
   int32_t conta = 0;
-  for(size_t i=0;i<up_node.size();i++) {
+  dirSharers.resize(up_node.size());
+  const int nSharers = dirFmt->getSharers(dir, &dirSharers[0]);
+  for(int j=0;j<nSharers;j++) {
+    const int i = dirSharers[j];
 		// [sizhuo] send req based on directory
-		if(!CacheLine::compatibleDownReq(dir[i], ma)) {
+		if(!CacheLine::compatibleDownReq(dirFmt->get(dir, i), ma)) {
 			MemRequest *breq = MemRequest::createSetState(self_mobj, mreq->getCreator(), ma, addr, doStats);
 #ifdef DEBUG
 			// [sizhuo] inherit debug bit
@@ -479,7 +485,7 @@ int32_t MRouter::sendSetStateAllDir(MemRequest *mreq, MsgAction ma, CacheLine::M
 }
 
 // [sizhuo] newly added for cache replacement using directory
-int32_t MRouter::invalidateAllDir(AddrType addr, MemRequest *mreq, CacheLine::MESI *dir, TimeDelta_t lat)
+int32_t MRouter::invalidateAllDir(AddrType addr, MemRequest *mreq, const CacheDir *dirFmt, const CacheLine::DirWord *dir, TimeDelta_t lat)
 {
   if(up_node.empty())
     return 0; // top node?
@@ -488,19 +494,20 @@ int32_t MRouter::invalidateAllDir(AddrType addr, MemRequest *mreq, CacheLine::ME
 
   I(mreq->isReq());
   int32_t conta = 0;
-  for(size_t i=0;i<up_node.size();i++) {
-		// [sizhuo] send req based on directory
-		if(dir[i] != CacheLine::I) {
-			MemRequest *breq = MemRequest::createSetState(self_mobj, mreq->getCreator(), ma_setInvalid, addr, doStats);
+  dirSharers.resize(up_node.size());
+  const int nSharers = dirFmt->getSharers(dir, &dirSharers[0]);
+  for(int j=0;j<nSharers;j++) {
+    const int i = dirSharers[j];
+		// every sharer in the directory gets an invalidation
+		MemRequest *breq = MemRequest::createSetState(self_mobj, mreq->getCreator(), ma_setInvalid, addr, doStats);
 #ifdef DEBUG
-			// [sizhuo] inherit debug bit
-			if (mreq->isDebug()) breq->setDebug();
+		// [sizhuo] inherit debug bit
+		if (mreq->isDebug()) breq->setDebug();
 #endif
-			breq->addPendingSetStateAck(mreq);
+		breq->addPendingSetStateAck(mreq);
 
-			breq->startSetState(up_node[i], lat);
-			conta++;
-		}
+		breq->startSetState(up_node[i], lat);
+		conta++;
   }
 
   return conta;
@@ -537,6 +544,51 @@ TimeDelta_t MRouter::ffwritePos(uint32_t pos ,AddrType addr)
 }
 /* }}} */
 
+int16_t MRouter::getUpNodePort(const MemObj *upm) const
+  /* index of upm in up_node {{{1 */
+{
+  if (up_node.size() == 1)
+    return 0; // Most common case
+
+  for(size_t i=0;i<up_node.size();i++) {
+    if (up_node[i] == upm)
+      return i;
+  }
+
+  return -1; // Not Found
+}
+/* }}} */
+
+bool MRouter::ffUpReq(AddrType addr, MsgAction ma)
+  /* functional upgrade to the lower level {{{1 */
+{
+  return down_node[0]->ffUpReq(addr, ma, self_mobj);
+}
+/* }}} */
+
+bool MRouter::ffSetStatePos(uint32_t pos, AddrType addr, MsgAction ma)
+  /* functional downgrade of up_node[pos] {{{1 */
+{
+  I(pos<up_node.size());
+  return up_node[pos]->ffSetState(addr, ma);
+}
+/* }}} */
+
+void MRouter::ffDisp(AddrType addr)
+  /* functional eviction to the lower level {{{1 */
+{
+  down_node[0]->ffDisp(addr, self_mobj);
+}
+/* }}} */
+
+bool MRouter::ffBusyPos(uint32_t pos, AddrType addr)
+  /* request in flight for addr in up_node[pos] {{{1 */
+{
+  I(pos<up_node.size());
+  return up_node[pos]->ffBusy(addr);
+}
+/* }}} */
+
 bool MRouter::isBusyPos(uint32_t pos, AddrType addr) const
   /* propagate the isBusy {{{1 */
 {
@@ -45,6 +45,7 @@
 #include "nanassert.h"
 #include "MsgAction.h"
 #include "CacheLine.h"
+#include "CacheDir.h"
 /* }}} */
 
 class MemObj;
@@ -67,6 +68,7 @@ protected:
   typedef HASH_MAP<const MemObj *, MemObj *, MemObjHashFunc> UPMapType;
   UPMapType up_map;
   std::vector<MemObj *> up_node;
+  std::vector<int16_t>  dirSharers; // scratch for the *Dir functions
   std::vector<MemObj *> down_node;
 
   void updateRouteTables(MemObj *upmobj, MemObj * const top_node);
@@ -122,9 +124,10 @@ public:
   int32_t invalidateAll(AddrType addr, MemRequest *mreq, TimeDelta_t lat=0);
 
 	// [sizhuo] dir versions of send downgrade req functions
-	int32_t sendSetStateOthersDir(MemRequest *mreq, MsgAction ma, CacheLine::MESI *dir, TimeDelta_t lat = 0);
-	int32_t sendSetStateAllDir(MemRequest *mreq, MsgAction ma, CacheLine::MESI *dir, TimeDelta_t lat = 0);
-  int32_t invalidateAllDir(AddrType addr, MemRequest *mreq, CacheLine::MESI *dir, TimeDelta_t lat=0);
+	// only the sharers in the directory entry are visited
+	int32_t sendSetStateOthersDir(MemRequest *mreq, MsgAction ma, const CacheDir *dirFmt, const CacheLine::DirWord *dir, TimeDelta_t lat = 0);
+	int32_t sendSetStateAllDir(MemRequest *mreq, MsgAction ma, const CacheDir *dirFmt, const CacheLine::DirWord *dir, TimeDelta_t lat = 0);
+  int32_t invalidateAllDir(AddrType addr, MemRequest *mreq, const CacheDir *dirFmt, const CacheLine::DirWord *dir, TimeDelta_t lat=0);
 
 	// [sizhuo] return upper node num
 	int32_t getUpNodeNum() { return up_node.size(); }
@@ -135,6 +138,13 @@ public:
   TimeDelta_t ffreadPos(uint32_t pos, AddrType addr);
   TimeDelta_t ffwritePos(uint32_t pos, AddrType addr);
 
+  // Functional (batched warmup) versions of req, setState and disp
+  int16_t getUpNodePort(const MemObj *upm) const;
+  bool ffUpReq(AddrType addr, MsgAction ma);
+  bool ffSetStatePos(uint32_t pos, AddrType addr, MsgAction ma);
+  void ffDisp(AddrType addr);
+  bool ffBusyPos(uint32_t pos, AddrType addr);
+
 	// [sizhuo] is down_node[pos] busy with addr now
   bool isBusyPos(uint32_t pos, AddrType addr) const;
 
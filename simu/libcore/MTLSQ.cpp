@@ -42,7 +42,10 @@ MTLSQ::MTLSQ(GProcessor *gproc_)
   , stldForwardDelay(SescConf->getInt("cpusimu", "stldForwardDelay", gproc->getId()))
   , prefetch(getStPrefetchType(SescConf->getCharPtr("cpusimu", "storePrefetch", gproc->getId())))
   , specLSQEntryPool(maxLdNum + maxStNum, "MTLSQ_specLSQEntryPool")
+  , specLSQ(maxLdNum + maxStNum)
   , comSQEntryPool(maxStNum, "MTLSQ_comSQEntryPool")
+  , comSQ(maxStNum)
+  , nSpecRecFence(0)
   , ldExPort(0)
   , stToMemPort(0)
   , nLdStallByLd("P(%d)_MTLSQ_nLdStallByLd", gproc->getId())
@@ -175,7 +178,7 @@ void MTLSQ::removePoisonedEntry(SpecLSQ::iterator rmIter) {
     rmEn->dinst->markExecuted();
   }
   // [sizhuo] erase the entry
-  specLSQ.erase(rmIter);
+  specErase(rmIter);
   // [sizhuo] call all events in pending Q
   while(!(rmEn->pendExQ).empty()) {
     CallbackBase *cb = (rmEn->pendExQ).front();
@@ -241,6 +244,10 @@ bool MTLSQ::isReset() {
 bool MTLSQ::matchStLine(AddrType byteAddr) {
   const AddrType lineAddr = getLineAddr(byteAddr);
 
+  if(comLineFilter.count(lineAddr) == 0 && specStLineFilter.count(lineAddr) == 0) {
+    return false;
+  }
+
   // [sizhuo] first search comSQ
   for(ComSQ::iterator iter = comSQ.begin(); iter != comSQ.end(); iter++) {
     I(iter->second);
@@ -250,7 +257,9 @@ bool MTLSQ::matchStLine(AddrType byteAddr) {
   }
   // [sizhuo] next search specLSQ
   for(SpecLSQ::iterator iter = specLSQ.begin(); iter != specLSQ.end(); iter++) {
-    I(iter->second);
+    if(!iter->second) { // WMM placeholder
+      continue;
+    }
     DInst *store = iter->second->dinst;
     I(store);
     if(store->getInst()->isStore() && getLineAddr(store->getAddr()) == lineAddr) {
@@ -261,6 +270,32 @@ bool MTLSQ::matchStLine(AddrType byteAddr) {
   return false;
 }
 
+void MTLSQ::specTrack(const SpecLSQEntry *en, bool add) {
+  if(!en) { // [sizhuo] WMM NULL placeholder
+    return;
+  }
+  I(en->dinst);
+  const Instruction *const ins = en->dinst->getInst();
+  if(ins->isRecFence()) {
+    nSpecRecFence += add ? 1 : -1;
+    I(nSpecRecFence >= 0);
+    return;
+  }
+  if(!ins->isLoad() && !ins->isStore()) {
+    return;
+  }
+
+  const AddrType addr = en->dinst->getAddr();
+  LSQAddrFilter &lineFilter = ins->isLoad() ? specLdLineFilter : specStLineFilter;
+  if(add) {
+    specAlignFilter.add(getMemOrdAlignAddr(addr));
+    lineFilter.add(getLineAddr(addr));
+  } else {
+    specAlignFilter.remove(getMemOrdAlignAddr(addr));
+    lineFilter.remove(getLineAddr(addr));
+  }
+}
+
 void MTLSQ::doPrefetch(AddrType byteAddr, bool doStats) {
 
   if(prefetch == All) {
@@ -7,9 +7,9 @@
 #include "GStats.h"
 #include "MemRequest.h"
 #include "SescConf.h"
-#include "DInst.h"
+#include "LSQRing.h"
 #include <queue>
-#include <map>
+#include <vector>
 
 class GProcessor;
 class MemObj;
@@ -120,7 +120,8 @@ protected:
   // [sizhuo] pool of SpecLSQ entries
   pool<SpecLSQEntry> specLSQEntryPool;
 
-  typedef std::map<Time_t, SpecLSQEntry*> SpecLSQ;
+  // [sizhuo] specLSQ & comSQ are ordered by inst ID
+  typedef LSQRing<SpecLSQEntry*> SpecLSQ;
   SpecLSQ specLSQ;
 
   // [sizhuo] commited SQ holds stores retired from ROB (non-speculative)
@@ -139,9 +140,52 @@ protected:
   // [sizhuo] pool of comSQ entries
   pool<ComSQEntry> comSQEntryPool; 
 
-  typedef std::map<Time_t, ComSQEntry*> ComSQ;
+  typedef LSQRing<ComSQEntry*> ComSQ;
   ComSQ comSQ;
 
+  // Address filters over the entries in specLSQ/comSQ. A search for an
+  // address is skipped when the filter says that no other entry can match,
+  // the result is the same as walking the whole queue.
+  LSQAddrFilter specAlignFilter;  // loads & stores, aligned addr
+  LSQAddrFilter specLdLineFilter; // loads, line addr
+  LSQAddrFilter specStLineFilter; // stores, line addr
+  LSQAddrFilter comAlignFilter;
+  LSQAddrFilter comLineFilter;
+  int32_t nSpecRecFence; // reconcile fences in specLSQ
+
+  // All insert/erase in specLSQ & comSQ go through these to keep the filters
+  void specTrack(const SpecLSQEntry *en, bool add);
+  std::pair<SpecLSQ::iterator, bool> specInsert(Time_t id, SpecLSQEntry *en) {
+    std::pair<SpecLSQ::iterator, bool> res = specLSQ.insert(id, en);
+    if(res.second) {
+      specTrack(en, true);
+    }
+    return res;
+  }
+  // fill a NULL placeholder
+  void specFill(SpecLSQ::iterator iter, SpecLSQEntry *en) {
+    I(iter->second == 0);
+    iter->second = en;
+    specTrack(en, true);
+  }
+  SpecLSQ::iterator specErase(SpecLSQ::iterator iter) {
+    specTrack(iter->second, false);
+    return specLSQ.erase(iter);
+  }
+  std::pair<ComSQ::iterator, bool> comInsert(Time_t id, ComSQEntry *en) {
+    std::pair<ComSQ::iterator, bool> res = comSQ.insert(id, en);
+    if(res.second) {
+      comAlignFilter.add(getMemOrdAlignAddr(en->addr));
+      comLineFilter.add(getLineAddr(en->addr));
+    }
+    return res;
+  }
+  ComSQ::iterator comErase(ComSQ::iterator iter) {
+    comAlignFilter.remove(getMemOrdAlignAddr(iter->second->addr));
+    comLineFilter.remove(getLineAddr(iter->second->addr));
+    return comSQ.erase(iter);
+  }
+
   // [sizhuo] fully pipelined contention port for executing Load
   PortGeneric *ldExPort;
 
@@ -284,6 +328,7 @@ protected:
   virtual void stCommited(Time_t id);
 
   SpecLSQ::iterator findStToRetire();
+  std::vector<AddrType> activeLdAddr; // findStToRetire scratch
 
 public:
   WMMLSQ(GProcessor *gproc_, bool ldldOrder, bool ldstOrder);
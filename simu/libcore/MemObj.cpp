@@ -54,6 +54,12 @@ public:
 
 uint16_t MemObj::id_counter = 0;
 
+pthread_mutex_t             MemObj::ffLock    = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t              MemObj::ffApplied = PTHREAD_COND_INITIALIZER;
+std::deque<MemObj::FFBatch> MemObj::ffQueued;
+volatile uint32_t           MemObj::ffPending = 0;
+bool                        MemObj::ffStopped = false;
+
 MemObj::MemObj(const char *sSection, const char *sName)
    /* constructor {{{1 */
   :section(sSection)
@@ -179,6 +185,112 @@ TimeDelta_t DummyMemObj::ffwrite(AddrType addr)
 }
 /* }}} */
 
+void MemObj::ffBatch(const FFAccess *acc, size_t n)
+  /* warmup a batch of accesses {{{1 */
+{
+  for(size_t i=0;i<n;i++) {
+    if (acc[i].write)
+      ffwrite(acc[i].addr);
+    else
+      ffread(acc[i].addr);
+  }
+}
+/* }}} */
+
+bool MemObj::ffUpReq(AddrType addr, MsgAction ma, const MemObj *from)
+  /* functional upgrade from upper level {{{1 */
+{
+  if (ma == ma_setDirty)
+    ffwrite(addr);
+  else
+    ffread(addr);
+
+  return true;
+}
+/* }}} */
+
+bool MemObj::ffSetState(AddrType addr, MsgAction ma)
+  /* functional downgrade from lower level {{{1 */
+{
+  return false; // No copy kept
+}
+/* }}} */
+
+void MemObj::ffDisp(AddrType addr, const MemObj *from)
+  /* functional eviction from upper level {{{1 */
+{
+}
+/* }}} */
+
+bool MemObj::ffBusy(AddrType addr)
+  /* request in flight for addr {{{1 */
+{
+  return false; // No MSHR state
+}
+/* }}} */
+
+void MemObj::ffQueue(MemObj *m, const FFAccess *acc, size_t n)
+  /* hand a warmup batch to the simulation thread {{{1 */
+{
+  I(n>0);
+
+  pthread_mutex_lock(&ffLock);
+  while(ffPending >= MaxFFQueued && !ffStopped)
+    pthread_cond_wait(&ffApplied, &ffLock);
+
+  if (!ffStopped) {
+    ffQueued.push_back(FFBatch());
+    ffQueued.back().mobj = m;
+    ffQueued.back().acc.assign(acc, acc+n);
+    ffPending++;
+  }
+  pthread_mutex_unlock(&ffLock);
+}
+/* }}} */
+
+void MemObj::ffWaitQueued()
+  /* wait until the simulation thread applied all the batches {{{1 */
+{
+  pthread_mutex_lock(&ffLock);
+  while(ffPending && !ffStopped)
+    pthread_cond_wait(&ffApplied, &ffLock);
+  pthread_mutex_unlock(&ffLock);
+}
+/* }}} */
+
+void MemObj::ffApplyQueued()
+  /* simulation thread, between cycles: apply the queued batches {{{1 */
+{
+  if (likely(ffPending == 0))
+    return;
+
+  std::deque<FFBatch> batches;
+  pthread_mutex_lock(&ffLock);
+  batches.swap(ffQueued);
+  pthread_mutex_unlock(&ffLock);
+
+  for(size_t i=0;i<batches.size();i++)
+    batches[i].mobj->ffBatch(&batches[i].acc[0], batches[i].acc.size());
+
+  pthread_mutex_lock(&ffLock);
+  ffPending -= batches.size();
+  pthread_cond_broadcast(&ffApplied);
+  pthread_mutex_unlock(&ffLock);
+}
+/* }}} */
+
+void MemObj::ffStop()
+  /* end of simulation, release the emulation threads {{{1 */
+{
+  pthread_mutex_lock(&ffLock);
+  ffStopped = true;
+  ffQueued.clear();
+  ffPending = 0;
+  pthread_cond_broadcast(&ffApplied);
+  pthread_mutex_unlock(&ffLock);
+}
+/* }}} */
+
 /* Optional virtual methods {{{1 */
 bool MemObj::checkL2TLBHit(MemRequest *req) {
   // If called, it should be redefined by the object
@@ -200,6 +312,9 @@ void MemObj::setTurboRatio(float r) {
 void MemObj::plug() {
 	I(0);
 }
+void MemObj::checkpoint(Checkpoint *ck) {
+	// Only objects with warm state use this
+}
 void MemObj::setNeedsCoherence() {
 	// Only cache uses this
 }
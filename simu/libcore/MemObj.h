@@ -44,11 +44,36 @@
 #include "Resource.h"
 #include "MRouter.h"
 
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
 class MemRequest;
 class MTLSQ;
+class Checkpoint;
+
+// One buffered warmup access (see MemObj::ffBatch)
+class FFAccess {
+public:
+  AddrType addr;
+  bool     write;
+};
 
 class MemObj {
 private:
+  // Warmup batches queued by the emulation threads (see ffQueue)
+  class FFBatch {
+  public:
+    MemObj               *mobj;
+    std::vector<FFAccess> acc;
+  };
+  enum { MaxFFQueued = 16 };
+  static pthread_mutex_t     ffLock;
+  static pthread_cond_t      ffApplied;
+  static std::deque<FFBatch> ffQueued;
+  static volatile uint32_t   ffPending; // queued or being applied
+  static bool                ffStopped;
+
 protected:
   friend class MRouter;
 
@@ -86,6 +111,32 @@ public:
   virtual TimeDelta_t ffread(AddrType addr) = 0;
   virtual TimeDelta_t ffwrite(AddrType addr) = 0;
 
+  // Batched functional warmup. Apply n accesses in order without MemRequest,
+  // ports, MSHR or stats. Only the simulation thread calls it, between
+  // cycles, and the accesses to lines with requests in flight (ffBusy) are
+  // dropped. The default falls back to ffread/ffwrite per access.
+  virtual void ffBatch(const FFAccess *acc, size_t n);
+  // Functional protocol between levels used by ffBatch: get permission ma for
+  // addr on behalf of the upper node from (false if the line is busy), downgrade
+  // a line from below (returns true if dirty data comes back), and evict a
+  // line from the upper node from
+  virtual bool ffUpReq(AddrType addr, MsgAction ma, const MemObj *from);
+  virtual bool ffSetState(AddrType addr, MsgAction ma);
+  virtual void ffDisp(AddrType addr, const MemObj *from);
+  // Is a request for addr in flight here or in an upper node with a copy?
+  virtual bool ffBusy(AddrType addr);
+
+  // The emulation threads do not call ffBatch. ffQueue copies the batch and
+  // the simulation thread applies the queued batches between cycles
+  // (ffApplyQueued), so the warmup does not race with the flows in timing
+  // mode that share the lower levels. ffQueue blocks while MaxFFQueued
+  // batches are pending, and ffWaitQueued until all of them are applied
+  // (before a mode switch). After ffStop (end of simulation) nothing waits.
+  static void ffQueue(MemObj *m, const FFAccess *acc, size_t n);
+  static void ffWaitQueued();
+  static void ffApplyQueued();
+  static void ffStop();
+
 	// [sizhuo] down: closer to memory, up: closer to core
 
   // DOWN
@@ -128,6 +179,7 @@ public:
   virtual void replayflush();
   virtual void setTurboRatio(float r);
   virtual void plug();
+  virtual void checkpoint(Checkpoint *ck); // warm state snapshot (see Checkpoint.h)
 
 	virtual void setNeedsCoherence();
 	virtual void clearNeedsCoherence();
@@ -95,6 +95,14 @@ OoOProcessor::~OoOProcessor()
 }
 /* }}} */
 
+void OoOProcessor::checkpoint(Checkpoint *ck)
+  /* warm state: branch predictor and private caches {{{1 */
+{
+  IFID.checkpoint(ck);
+  GProcessor::checkpoint(ck);
+}
+/* }}} */
+
 void OoOProcessor::fetch(FlowID fid)
   /* fetch {{{1 */
 {
@@ -233,6 +241,56 @@ bool OoOProcessor::advance_clock(FlowID fid)
 }
 /* }}} */
 
+Time_t OoOProcessor::nextProgress() const
+  /* first cycle where advance_clock does more than stall accounting {{{1 */
+{
+  // Only the usual memory bound stall: fetch can not start a bucket, the
+  // ROB head waits for a callback, and rename has a full ROB (or nothing)
+  if (!active || !busy || replayRecovering || throttlingRatio>1)
+    return globalClock;
+  if (ROB.empty() || ROB.top()->isExecuted())
+    return globalClock;
+  if (!rROB.empty() && rROB.top()->isExecuted())
+    return globalClock;
+  if (!IFID.isBlocked(0) && pipeQ.pipeLine.canFetch())
+    return globalClock;
+  if (!pipeQ.instQueue.empty() && (ROB.size()+rROB.size()) < MaxROBSize)
+    return globalClock;
+
+  // ID stage: waiting for the decode delay of the next bucket
+  if (spaceInInstQueue < FetchWidth)
+    return MaxTime;
+  return pipeQ.pipeLine.nextReadyTime();
+}
+/* }}} */
+
+void OoOProcessor::skipCycles(Time_t nCycles)
+  /* stats that advance_clock adds in nCycles idle cycles {{{1 */
+{
+  I(nextProgress() >= globalClock + nCycles);
+
+  bool getStatsFlag = ROB.top()->getStatsFlag();
+
+  clockTicks.add(nCycles, getStatsFlag);
+  skipWallClock(nCycles, getStatsFlag);
+
+  if (spaceInInstQueue >= FetchWidth)
+    noFetch2.add(nCycles, getStatsFlag);
+  else
+    noFetch.add(nCycles, getStatsFlag);
+
+  if (!pipeQ.instQueue.empty()) {
+    // issue stops at the first instruction (SmallROBStall)
+    DInst *dinst = pipeQ.instQueue.top()->top();
+    nStall[SmallROBStall]->add(RealisticWidth*nCycles, dinst->getStatsFlag());
+  }
+
+  robUsed.sampleRepeat(ROB.size(), nCycles, getStatsFlag);
+  if (!rROB.empty())
+    rrobUsed.sampleRepeat(rROB.size(), nCycles, rROB.top()->getStatsFlag());
+}
+/* }}} */
+
 StallCause OoOProcessor::addInst(DInst *dinst)
   /* rename (or addInst) a new instruction {{{1 */
 {
@@ -120,6 +120,8 @@ protected:
 
   // BEGIN VIRTUAL FUNCTIONS of GProcessor
   bool advance_clock(FlowID fid);
+  Time_t nextProgress() const;
+  void skipCycles(Time_t nCycles);
   StallCause addInst(DInst *dinst);
   void retire();
 
@@ -128,6 +130,8 @@ public:
   OoOProcessor(GMemorySystem *gm, CPU_t i);
   virtual ~OoOProcessor();
 
+  void checkpoint(Checkpoint *ck);
+
   LSQ *getLSQ() { return &lsq; }
   void replay(DInst *target);
   bool isFlushing() {return flushing;}
@@ -249,6 +249,13 @@ IBucket *Pipeline::newItem() {
   return b;
 }
 
+Time_t Pipeline::nextReadyTime() const {
+  if (buffer.empty())
+    return MaxTime;
+
+  return buffer.top()->getClock() + PipeLength;
+}
+
 bool Pipeline::hasOutstandingItems() const {
     // bucketPool.size() has lineal time O(n)
   return !buffer.empty() || !received.empty() || nIRequests < MaxIRequests;
@@ -106,6 +106,8 @@ public:
   void cleanMark();
 
   IBucket *newItem(); // [sizhuo] issue a new fetch req
+  bool canFetch() const { return nIRequests > 0 && !bucketPool.empty(); } // newItem would succeed
+  Time_t nextReadyTime() const; // first cycle nextItem can return a bucket (MaxTime if it needs a fetch resp)
   bool hasOutstandingItems() const; // [sizhuo] whole pipeline is not empty
   void readyItem(IBucket *b); // [sizhuo] a fetch resp comes
   void doneItem(IBucket *b); // [sizhuo] uOPs leave front-end pipeline
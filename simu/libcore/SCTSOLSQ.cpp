@@ -71,13 +71,14 @@ void SCTSOLSQ::issue(DInst *dinst) {
   issueEn->clear();
   issueEn->dinst = dinst;
   // [sizhuo] insert to spec LSQ
-  std::pair<SpecLSQ::iterator, bool> insertRes = specLSQ.insert(std::make_pair<Time_t, SpecLSQEntry*>(id, issueEn));
+  std::pair<SpecLSQ::iterator, bool> insertRes = specInsert(id, issueEn);
   I(insertRes.second);
   SpecLSQ::iterator issueIter = insertRes.first;
   I(issueIter != specLSQ.end());
 
   // [sizhuo] store: search LSQ to kill eager loads
-  if(ins->isStore()) {
+  // (nothing to do if the store is the only inst to its aligned addr)
+  if(ins->isStore() && specAlignFilter.count(getMemOrdAlignAddr(addr)) > 1) {
     SpecLSQ::iterator iter = issueIter;
     iter++;
     for(; iter != specLSQ.end(); iter++) {
@@ -155,6 +156,9 @@ void SCTSOLSQ::ldExecute(DInst *dinst) {
   // [sizhuo] search older inst (with lower ID) in specLSQ for bypass or stall
   // XXX: decrement iterator smaller than begin() results in undefined behavior
   SpecLSQ::iterator iter = exIter;
+  if(specAlignFilter.count(getMemOrdAlignAddr(addr)) == 1) {
+    iter = specLSQ.begin(); // [sizhuo] no other inst to same aligned addr
+  }
   while(iter != specLSQ.begin()) {
     iter--;
     I(iter != specLSQ.end());
@@ -217,7 +221,8 @@ void SCTSOLSQ::ldExecute(DInst *dinst) {
   }
 
   // [sizhuo] search commited store queue for bypass (start from youngest, i.e. largest ID)
-  for(ComSQ::reverse_iterator rIter = comSQ.rbegin(); rIter != comSQ.rend(); rIter++) {
+  ComSQ::reverse_iterator rBegin = comAlignFilter.count(getMemOrdAlignAddr(addr)) ? comSQ.rbegin() : comSQ.rend();
+  for(ComSQ::reverse_iterator rIter = rBegin; rIter != comSQ.rend(); rIter++) {
     ComSQEntry *en = rIter->second;
     I(en);
     I(rIter->first < id);
@@ -308,7 +313,7 @@ bool SCTSOLSQ::retire(DInst *dinst) {
   I(retireEn->verify == SpecLSQEntry::Good);
 
   // [sizhuo] retire from spec LSQ
-  specLSQ.erase(retireIter);
+  specErase(retireIter);
   // [sizhuo] only free load entry
   if(ins->isLoad()) {
     freeLdNum++;
@@ -323,7 +328,7 @@ bool SCTSOLSQ::retire(DInst *dinst) {
     en->clear();
     en->addr = addr;
     en->doStats = doStats;
-    std::pair<ComSQ::iterator, bool> insertRes = comSQ.insert(std::make_pair<Time_t, ComSQEntry*>(id, en));
+    std::pair<ComSQ::iterator, bool> insertRes = comInsert(id, en);
     I(insertRes.second);
     ComSQ::iterator comIter = insertRes.first;
     I(comIter != comSQ.end());
@@ -365,7 +370,7 @@ void SCTSOLSQ::stCommited(Time_t id) {
   I(comIter->first == id);
   ComSQEntry *comEn = comIter->second;
   I(comEn);
-  comSQ.erase(comIter);
+  comErase(comIter);
 
   // [sizhuo] update last commited store ID
   lastComStID = id;
@@ -385,6 +390,9 @@ void SCTSOLSQ::stCommited(Time_t id) {
 
 void SCTSOLSQ::cacheEvict(AddrType lineAddr, bool isReplace) {
   // [sizhuo] search LSQ to kill eager loads on same CACHE LINE addr
+  if(specLdLineFilter.count(lineAddr) == 0) {
+    return;
+  }
   for(SpecLSQ::iterator iter = specLSQ.begin(); iter != specLSQ.end(); iter++) {
     SpecLSQEntry *killEn = iter->second;
     I(killEn);
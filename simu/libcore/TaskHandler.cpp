@@ -39,6 +39,7 @@
 #include "Report.h"
 #include "EmuSampler.h"
 #include "EmulInterface.h"
+#include "MemObj.h"
 #include <string.h>
 /* }}} */
 
@@ -53,11 +54,21 @@ std::vector<EmulInterface *>  TaskHandler::emulas; // associated emula
 std::vector<GProcessor *>     TaskHandler::cpus;   // All the CPUs in the system
 std::vector<FlowID>           TaskHandler::FlowIDEmulMapping;  
 
+bool                          TaskHandler::skipIdle = true;
+uint64_t                      TaskHandler::nIdleSkipped = 0;
+
+CallbackBase * volatile       TaskHandler::quiescentCB   = 0;
+pthread_mutex_t               TaskHandler::quiescentLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t                TaskHandler::quiescentDone = PTHREAD_COND_INITIALIZER;
+uint64_t                      TaskHandler::quiescentRuns = 0;
+bool                          TaskHandler::quiescentStop = false;
+
 
 void TaskHandler::report(const char *str) {
   /* dump statistics to report file {{{1 */
 
   Report::field("OSSim:nCPUs=%d",cpus.size());
+  Report::field("OSSim:idleSkipped=%llu",(unsigned long long)nIdleSkipped);
   size_t cpuid     = 0;
   size_t cpuid_sub = 0;
   FlowID samplercount = 0;
@@ -411,22 +422,111 @@ void TaskHandler::freeze(FlowID fid, Time_t nCycles) {
 }
 /* }}} */
 
+bool TaskHandler::needClock() 
+  /* Is any flow in timing mode? {{{1 */
+{
+  for(AllMapsType::iterator it=allmaps.begin();it!=allmaps.end();it++) {
+    EmuSampler::EmuMode m = (*it).emul->getSampler()->getMode();
+    if (m == EmuSampler::EmuDetail || m == EmuSampler::EmuTiming)
+      return true;
+  }
+  return false;
+}
+/* }}} */
+
+bool TaskHandler::skipIdleCycles()
+  /* jump to the next callback if no core can progress before it {{{1 */
+{
+  FlowID n = running_size;
+
+  Time_t next = EventScheduler::nextEvent();
+  for(size_t i=0;i<n && next > globalClock+1;i++) {
+    Time_t t = allmaps[running[i]].simu->nextProgress();
+    if (t < next)
+      next = t;
+  }
+  // Nothing to wait for (QEMU?), or just this cycle
+  if (next == MaxTime || next <= globalClock+1)
+    return false;
+
+  // Cycles globalClock..next-1 only update stats, then the normal clock
+  // advance to next (and its callbacks)
+  Time_t nCycles = next - globalClock;
+  for(size_t i=0;i<n;i++)
+    allmaps[running[i]].simu->skipCycles(nCycles);
+
+  nIdleSkipped += nCycles;
+  globalClock   = next - 1;
+  EventScheduler::advanceClock();
+
+  return true;
+}
+/* }}} */
+
+bool TaskHandler::runQuiescent(CallbackBase *cb)
+  /* call cb in the simulation thread with nothing in flight {{{1 */
+{
+  pthread_mutex_lock(&quiescentLock);
+  while(quiescentCB && !quiescentStop)
+    pthread_cond_wait(&quiescentDone, &quiescentLock);
+
+  if (quiescentStop) {
+    pthread_mutex_unlock(&quiescentLock);
+    return false;
+  }
+
+  uint64_t ticket = quiescentRuns;
+  quiescentCB = cb;
+  while(quiescentRuns == ticket && !quiescentStop)
+    pthread_cond_wait(&quiescentDone, &quiescentLock);
+
+  bool done = quiescentRuns != ticket;
+  pthread_mutex_unlock(&quiescentLock);
+
+  return done;
+}
+/* }}} */
+
+bool TaskHandler::drainForQuiescent()
+  /* advance the clock until the requests in flight finish {{{1 */
+{
+  if (running_size || needClock())
+    return false; // wait for the flows to leave timing
+
+  if (!EventScheduler::empty()) {
+    EventScheduler::advanceClock();
+    return false;
+  }
+
+  return true;
+}
+/* }}} */
+
 void TaskHandler::boot()
   /* main simulation loop {{{1 */
 {
   while(!terminate_all) {
+    // Warmup from the emulation threads, between cycles
+    MemObj::ffApplyQueued();
+
+    if (unlikely(quiescentCB) && drainForQuiescent()) {
+      I(EventScheduler::empty());
+      quiescentCB->call();
+
+      pthread_mutex_lock(&quiescentLock);
+      quiescentCB = 0;
+      quiescentRuns++;
+      pthread_cond_broadcast(&quiescentDone);
+      pthread_mutex_unlock(&quiescentLock);
+      continue;
+    }
+
     if (unlikely(running_size == 0)) {
-      bool needIncreaseClock = false;
-      for(AllMapsType::iterator it=allmaps.begin();it!=allmaps.end();it++) {
-        EmuSampler::EmuMode m = (*it).emul->getSampler()->getMode();
-        if (m == EmuSampler::EmuDetail || m == EmuSampler::EmuTiming) {
-          needIncreaseClock = true;
-          break;
-        }
-      }
-      if (needIncreaseClock)
+      if (needClock())
         EventScheduler::advanceClock();
     }else{ // [sizhuo] here is the main simulation loop
+      if (skipIdle && skipIdleCycles())
+        continue;
       for(size_t i =0;i<running_size;i++) {
 				// [sizhuo] simulate each core
         FlowID fid = running[i];
@@ -436,6 +536,13 @@ void TaskHandler::boot()
       EventScheduler::advanceClock();
     }
   }
+
+  MemObj::ffStop();
+
+  pthread_mutex_lock(&quiescentLock);
+  quiescentStop = true;
+  pthread_cond_broadcast(&quiescentDone);
+  pthread_mutex_unlock(&quiescentLock);
 }
 /* }}} */
 
@@ -451,9 +558,21 @@ void TaskHandler::plugBegin()
   I(emulas.empty());
   I(cpus.empty());
   terminate_all = false;
+  quiescentStop = false;
 
   running = NULL;
   running_size = 0;
+
+  skipIdle = true;
+  if (SescConf->checkBool("","simSkipIdle"))
+    skipIdle = SescConf->getBool("","simSkipIdle");
+
+  // The simulator state (pools, DInst IDs, stats) is shared by all the
+  // cores, so a single host thread runs the event queue
+  if (SescConf->checkBool("","simPartition") && SescConf->getBool("","simPartition")) {
+    MSG("ERROR: simPartition is not supported, the simulation runs in a single event queue");
+    SescConf->notCorrect();
+  }
 }
 /* }}} */
 
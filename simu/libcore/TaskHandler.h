@@ -43,6 +43,7 @@
 #include <pthread.h>
 
 class GProcessor;
+class CallbackBase;
 
 class TaskHandler {
   private:
@@ -67,6 +68,21 @@ class TaskHandler {
     // static std::vector<bool>             active; // Is the flow active?
     static std::vector<EmulInterface *>  emulas; // associated emula
     static std::vector<GProcessor *>     cpus;   // All the CPUs in the system
+
+    // Idle fast-forward (simSkipIdle)
+    static bool                          skipIdle;
+    static uint64_t                      nIdleSkipped;
+
+    // Work that needs the simulated system quiescent (runQuiescent)
+    static CallbackBase * volatile       quiescentCB;
+    static pthread_mutex_t               quiescentLock;
+    static pthread_cond_t                quiescentDone;
+    static uint64_t                      quiescentRuns;
+    static bool                          quiescentStop;
+
+    static bool needClock();
+    static bool skipIdleCycles();
+    static bool drainForQuiescent();
   public:
 
     static std::vector<FlowID>           FlowIDEmulMapping;   //Which FlowIDs are associated with CPU and which with the GPUs 
@@ -82,6 +98,12 @@ class TaskHandler {
 
     static void report(const char *str);
 
+    // Calls cb in the simulation thread, between cycles, once no flow is in
+    // detail/timing mode and no callback is pending (the memory requests in
+    // flight are drained). Blocks until done, false if the simulation
+    // finished before.
+    static bool runQuiescent(CallbackBase *cb);
+
     static void addEmul(EmulInterface *eint, FlowID fid = 0);
     static void addEmulShared(EmulInterface *eint);
     static void addSimu(GProcessor *gproc);
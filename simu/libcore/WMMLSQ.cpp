@@ -4,6 +4,8 @@
 #include "SescConf.h"
 #include "DInst.h"
 
+#include <algorithm>
+
 WMMLSQ::WMMLSQ(GProcessor *gproc_, bool ldldOrder, bool ldstOrder)
   : MTLSQ(gproc_)
   , orderLdLd(ldldOrder)
@@ -50,11 +52,11 @@ StallCause WMMLSQ::addEntry(DInst *dinst) {
     en->clear();
     en->dinst = dinst;
     en->state = Done;
-    std::pair<SpecLSQ::iterator, bool> insertRes = specLSQ.insert(std::make_pair<Time_t, SpecLSQEntry*>(dinst->getID(), en));
+    std::pair<SpecLSQ::iterator, bool> insertRes = specInsert(dinst->getID(), en);
     I(insertRes.second);
   } else if(ins->isLoad() || ins->isStore()) {
     // [sizhuo] insert a NULL ptr into LSQ as placeholder to stop store from entering comSQ
-    std::pair<SpecLSQ::iterator, bool> insertRes = specLSQ.insert(std::make_pair<Time_t, SpecLSQEntry*>(dinst->getID(), 0));
+    std::pair<SpecLSQ::iterator, bool> insertRes = specInsert(dinst->getID(), 0);
     I(insertRes.second);
   } else {
     I(0);
@@ -81,7 +83,7 @@ void WMMLSQ::issue(DInst *dinst) {
     if(iter != specLSQ.end()) {
       I(0);
       I(iter->second == 0);
-      specLSQ.erase(iter);
+      specErase(iter);
     }
     return;
   }
@@ -95,13 +97,13 @@ void WMMLSQ::issue(DInst *dinst) {
   SpecLSQ::iterator issueIter = specLSQ.find(id);
   I(issueIter != specLSQ.end());
   I(issueIter->first == id);
-  I(issueIter->second == 0);
-  issueIter->second = issueEn;
+  specFill(issueIter, issueEn);
 
   // [sizhuo] search younger entry (with higer ID) to find eager load to kill
   // TODO: if we are clever enough, load can bypass from younger load instead of killing
   // store will always do the search, load will only do it only when orderLdLd == true
-  if(ins->isStore() || orderLdLd) {
+  // (nothing to do if the issuing inst is the only one to its aligned addr)
+  if((ins->isStore() || orderLdLd) && specAlignFilter.count(getMemOrdAlignAddr(addr)) > 1) {
     SpecLSQ::iterator iter = issueIter;
     iter++;
     for(; iter != specLSQ.end(); iter++) {
@@ -220,8 +222,12 @@ void WMMLSQ::ldExecute(DInst *dinst) {
   }
 
   // [sizhuo] search older inst (with lower ID) in specLSQ for bypass or stall
+  // only reconcile fences and inst to the same aligned addr matter
   // XXX: decrement iterator smaller than begin() results in undefined behavior
   SpecLSQ::iterator iter = exIter;
+  if(nSpecRecFence == 0 && specAlignFilter.count(getMemOrdAlignAddr(addr)) == 1) {
+    iter = specLSQ.begin();
+  }
   while(iter != specLSQ.begin()) {
     iter--;
     I(iter != specLSQ.end());
@@ -288,7 +294,8 @@ void WMMLSQ::ldExecute(DInst *dinst) {
   }
 
   // [sizhuo] search commited store queue for bypass (start from youngest, i.e. largest ID)
-  for(ComSQ::reverse_iterator rIter = comSQ.rbegin(); rIter != comSQ.rend(); rIter++) {
+  ComSQ::reverse_iterator rBegin = comAlignFilter.count(getMemOrdAlignAddr(addr)) ? comSQ.rbegin() : comSQ.rend();
+  for(ComSQ::reverse_iterator rIter = rBegin; rIter != comSQ.rend(); rIter++) {
     ComSQEntry *en = rIter->second;
     I(en);
     // [sizhuo] XXX: bypass from same ALIGNED address
@@ -320,7 +327,8 @@ void WMMLSQ::sendStToComSQ(MTLSQ::SpecLSQEntry *retireEn) {
   // [sizhuo] check whether comSQ already has store to same CACHE LINE
   // we do this check before insertion of current store
   bool noOlderSt = true;
-  for(ComSQ::iterator iter = comSQ.begin(); iter != comSQ.end(); iter++) {
+  ComSQ::iterator iter = comLineFilter.count(getLineAddr(addr)) ? comSQ.begin() : comSQ.end();
+  for(; iter != comSQ.end(); iter++) {
     I(iter->second);
     if(getLineAddr(iter->second->addr) == getLineAddr(addr)) {
       I(iter->first != id);
@@ -333,7 +341,7 @@ void WMMLSQ::sendStToComSQ(MTLSQ::SpecLSQEntry *retireEn) {
   en->clear();
   en->addr = addr;
   en->doStats = doStats;
-  std::pair<ComSQ::iterator, bool> insertRes = comSQ.insert(std::make_pair<Time_t, ComSQEntry*>(id, en));
+  std::pair<ComSQ::iterator, bool> insertRes = comInsert(id, en);
   I(insertRes.second);
   // [sizhuo] if comSQ doesn't have other store to same CACHE LINE, send this one to memory
   if(noOlderSt) {
@@ -358,7 +366,7 @@ bool WMMLSQ::retire(DInst *dinst) {
       I(iter->first == dinst->getID());
       I(en);
       // [sizhuo] retire from spec LSQ
-      specLSQ.erase(iter);
+      specErase(iter);
       // [sizhuo] free store entry
       I((en->pendRetireQ).empty() && (en->pendExQ).empty());
       specLSQEntryPool.in(en);
@@ -418,7 +426,7 @@ bool WMMLSQ::retire(DInst *dinst) {
 
   // [sizhuo] retire from spec LSQ
   if(retireIter != specLSQ.end()) {
-    specLSQ.erase(retireIter);
+    specErase(retireIter);
   }
 
   // [sizhuo] only free load entry (LD/RECONCILE)
@@ -474,27 +482,21 @@ void WMMLSQ::stCommited(Time_t id) {
   const AddrType lineAddr = getLineAddr(comIter->second->addr);
 
   // [sizhuo] delete all other stores to same CACHE LINE
-  while(true) {
-    ComSQ::iterator iter = comSQ.begin();
-    for(; iter != comSQ.end(); iter++) {
-      I(iter->second);
-      if(getLineAddr(iter->second->addr) == lineAddr) {
-        // [sizhuo] find the store to delete, break
-        break;
-      }
-    }
-    if(iter != comSQ.end()) {
+  // single pass, stop once the filter says no store to the line is left
+  ComSQ::iterator iter = comSQ.begin();
+  while(iter != comSQ.end() && comLineFilter.count(lineAddr) > 0) {
+    I(iter->second);
+    if(getLineAddr(iter->second->addr) == lineAddr) {
       // [sizhuo] we have store to delete & recycle & free
       ComSQEntry *en = iter->second;
-      comSQ.erase(iter);
+      iter = comErase(iter);
       comSQEntryPool.in(en);
       // [sizhuo] increment free entry
       freeStNum++;
       I(freeStNum > 0);
       I(freeStNum <= maxStNum);
     } else {
-      // [sizhuo] no more store to delete, stop
-      break;
+      iter++;
     }
   }
 }
@@ -523,7 +525,7 @@ void WMMLSQ::reset() {
       if(rmIter->second) {
         removePoisonedEntry(rmIter); // [sizhuo] non-NULL entry
       } else {
-        specLSQ.erase(rmIter); // [sizhuo] NULL entry, directly remove
+        specErase(rmIter); // [sizhuo] NULL entry, directly remove
       }
     } else {
       // [sizhuo] no more to remove stop
@@ -551,7 +553,7 @@ MTLSQ::SpecLSQ::iterator WMMLSQ::findStToRetire() {
   // Given the fact that all older loads and stores have resolved addr
   // there cannot be any violation on memory dependency among these loads/stores
 
-  std::map<AddrType, bool> activeLdAddr; // [sizhuo] set of load addr that are still executing
+  activeLdAddr.clear(); // [sizhuo] set of load addr that are still executing
   for(SpecLSQ::iterator iter = specLSQ.begin(); iter != specLSQ.end(); iter++) {
     const SpecLSQEntry *en = iter->second;
     // [sizhuo] 2. load/store with unresolved addr/data
@@ -581,11 +583,13 @@ MTLSQ::SpecLSQ::iterator WMMLSQ::findStToRetire() {
     AddrType alignAddr = getMemOrdAlignAddr(dinst->getAddr());
     if(ins->isLoad() && en->state != Done) {
       // [sizhuo] add not finished load addr to set
-      activeLdAddr.insert(std::make_pair<AddrType, bool>(alignAddr, true));
+      if(std::find(activeLdAddr.begin(), activeLdAddr.end(), alignAddr) == activeLdAddr.end()) {
+        activeLdAddr.push_back(alignAddr);
+      }
     } else if(ins->isStore()) {
       I(en->state == Done);
       // [sizhuo] 4. store addr does not match any unfinished load addr
-      if(activeLdAddr.find(alignAddr) == activeLdAddr.end()) {
+      if(std::find(activeLdAddr.begin(), activeLdAddr.end(), alignAddr) == activeLdAddr.end()) {
         // [sizhuo] 6. all older control inst have been executed
         if(gproc->allOlderCtrlDone(dinst->getID())) {
           // [sizhuo] this store can be retired, return it
@@ -627,7 +631,7 @@ bool WMMLSQ::retireStEarly() {
     // [sizhuo] send the store to comSQ
     sendStToComSQ(retireEn);
     // [sizhuo] retire from spec LSQ
-    specLSQ.erase(retireIter);
+    specErase(retireIter);
     // [sizhuo] recycle specLSQ entry
     specLSQEntryPool.in(retireEn);
     // [sizhuo] stats: new store is early retired due to unused retire BW
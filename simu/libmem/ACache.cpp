@@ -1,3 +1,5 @@
+#include <strings.h>
+
 #include "nanassert.h"
 
 #include "SescConf.h"
@@ -31,6 +33,7 @@ ACache::ACache(MemorySystem *gms, const char *section, const char *name)
 	, isL1 (SescConf->getBool(section, "isL1"))
 	, isLLC (SescConf->getBool(section, "isLLC"))
 	, upNodeNum(SescConf->getInt(section, "upNodeNum"))
+	, dirSharers(0)
 	// [sizhuo] stats counters
 	, displaced("%s:displaced", name)
 	, writeBack("%s:writeBack", name)
@@ -81,8 +84,27 @@ ACache::ACache(MemorySystem *gms, const char *section, const char *name)
 	uint32_t lineSize = SescConf->getInt(section, "Bsize");
 	uint32_t setAssoc = SescConf->getInt(section, "Assoc");
 	uint32_t bankNum = SescConf->getInt(section, "numBanks");
-	cache = new LRUCacheArray(cacheSize, lineSize, setAssoc, bankNum, upNodeNum, name);
+	// directory format, default full bit-vector
+	CacheDir::Mode dirMode = CacheDir::Full;
+	int dirPtrs = 4;
+	if(SescConf->checkCharPtr(section, "dirMode")) {
+		const char *mode = SescConf->getCharPtr(section, "dirMode");
+		if(strcasecmp(mode, "limitedPtr") == 0) {
+			dirMode = CacheDir::LimitedPtr;
+		} else if(strcasecmp(mode, "coarse") == 0) {
+			dirMode = CacheDir::Coarse;
+		} else if(strcasecmp(mode, "full") != 0) {
+			MSG("ERROR: %s dirMode = %s, it should be full, limitedPtr or coarse", section, mode);
+			SescConf->notCorrect();
+		}
+	}
+	if(SescConf->checkInt(section, "dirPtrs")) {
+		SescConf->isBetween(section, "dirPtrs", 1, 255);
+		dirPtrs = SescConf->getInt(section, "dirPtrs");
+	}
+	cache = new LRUCacheArray(cacheSize, lineSize, setAssoc, bankNum, upNodeNum, name, dirMode, dirPtrs);
 	I(cache);
+	dirSharers = new int16_t[upNodeNum];
 	MSG("ACache %s creates cache array: size %x, lineSize %x, assoc %x, bankNum %d, upNodeNum %d", name, cacheSize, lineSize, setAssoc, bankNum, upNodeNum);
 
 	// [sizhuo] create MSHR
@@ -164,6 +186,7 @@ ACache::ACache(MemorySystem *gms, const char *section, const char *name)
 }
 
 ACache::~ACache() {
+	delete[]dirSharers;
 	if(reqFromUpPort) {
 		for(int i = 0; i < upNodeNum; i++) {
 			if(reqFromUpPort[i]) delete reqFromUpPort[i];
@@ -292,6 +315,11 @@ void ACache::forwardReqDown(MemRequest *mreq, AddrType lineAddr, TimeDelta_t lat
 	// set address in cache line & clear current line
 	I(mreq);
 	I(mreq->line);
+	if(mreq->line->lineAddr != lineAddr) {
+		// the old upper level copies are gone, imprecise entries may still
+		// have sharers
+		cache->dir->clear(mreq->line->dir);
+	}
 	mreq->line->lineAddr = lineAddr;
 	mreq->line = 0;
 	mshr->upReqToWait(lineAddr, lat);
@@ -361,7 +389,7 @@ void ACache::doReq(MemRequest *mreq) {
 						I(cache->getIndex(repLineAddr) == cache->getIndex(lineAddr));
 						// [sizhuo] send invalidate msg to upper level
 						I(upNodeNum == router->getUpNodeNum()); // [sizhuo] check up node num
-						int nmsg = router->invalidateAllDir(repByteAddr, mreq, mreq->line->dir, tagReadDelay + goUpDelay);
+						int nmsg = router->invalidateAllDir(repByteAddr, mreq, cache->dir, mreq->line->dir, tagReadDelay + goUpDelay);
 						if(nmsg > 0) {
 							I(mreq->hasPendingSetStateAck());
 							// [sizhuo] wait for downgrade resp to wake me up
@@ -395,7 +423,7 @@ void ACache::doReq(MemRequest *mreq) {
 						// [sizhuo] non-L1$, downgrade upper level (other than the initiator)
 						const MsgAction downAct = reqAct == ma_setValid ? ma_setShared : ma_setInvalid;
 						I(upNodeNum == router->getUpNodeNum()); // [sizhuo] check up node num
-						int nmsg = router->sendSetStateOthersDir(mreq, downAct, mreq->line->dir, tagReadDelay + goUpDelay);
+						int nmsg = router->sendSetStateOthersDir(mreq, downAct, cache->dir, mreq->line->dir, tagReadDelay + goUpDelay);
 						if(nmsg > 0) {
 							I(mreq->hasPendingSetStateAck());
 							// [sizhuo] wait for downgrade resp to wake me up
@@ -514,7 +542,7 @@ void ACache::doReq(MemRequest *mreq) {
 					int portId = router->getCreatorPort(mreq);
 					I(portId < upNodeNum);
 					I(portId >= 0);
-					mreq->line->dir[portId] = CacheLine::upgradeState(reqAct);
+					cache->dir->set(mreq->line->dir, portId, CacheLine::upgradeState(reqAct));
 					// [sizhuo] may change line state E->M
 					if(reqAct == ma_setDirty) {
 						mreq->line->state = CacheLine::M;
@@ -599,7 +627,7 @@ void ACache::doReqAck(MemRequest *mreq) {
 		if(!mreq->isRetrying()) {
 			// [sizhuo] send downgrade req to upper level except for upgrade req home node
 			I(upNodeNum == router->getUpNodeNum()); // [sizhuo] check up node num
-			int32_t nmsg = router->sendSetStateOthersDir(mreq, ma_setInvalid, mreq->line->dir, goUpDelay);
+			int32_t nmsg = router->sendSetStateOthersDir(mreq, ma_setInvalid, cache->dir, mreq->line->dir, goUpDelay);
 			if(nmsg > 0) {
 				I(mreq->hasPendingSetStateAck());
 				// [sizhuo] need to wait for downgrade resp to try again
@@ -619,7 +647,7 @@ void ACache::doReqAck(MemRequest *mreq) {
 		int portId = router->getCreatorPort(mreq);
 		I(portId < upNodeNum);
 		I(portId >= 0);
-		mreq->line->dir[portId] = CacheLine::upgradeState(reqAckAct);
+		cache->dir->set(mreq->line->dir, portId, CacheLine::upgradeState(reqAckAct));
 		// [sizhuo] get delay in writing tag & data
 		const TimeDelta_t delay = std::max(cache->getTagAccessTime(lineAddr, doStats), cache->getDataAccessTime(lineAddr, doStats)) - globalClock;
 		// [sizhuo] release occupation on cache line & retire from MSHR after data & tag write
@@ -706,7 +734,7 @@ void ACache::doSetState(MemRequest *mreq) {
 					} else {
 						// [sizhuo] forward downgrade req to upper level
 						I(upNodeNum == router->getUpNodeNum()); // [sizhuo] check up node num
-						int32_t nmsg = router->sendSetStateAllDir(mreq, mreq->getAction(), mreq->line->dir, tagReadDelay + goUpDelay);
+						int32_t nmsg = router->sendSetStateAllDir(mreq, mreq->getAction(), cache->dir, mreq->line->dir, tagReadDelay + goUpDelay);
 						if(nmsg > 0) {
 							I(mreq->hasPendingSetStateAck());
 							// [sizhuo] need to wait for downgrade resp to try again
@@ -794,7 +822,7 @@ void ACache::doSetStateAck(MemRequest *mreq) {
 	int portId = router->getCreatorPort(mreq);
 	I(portId < upNodeNum);
 	I(portId >= 0);
-	line->dir[portId] = CacheLine::downgradeState(ackAct);
+	cache->dir->set(line->dir, portId, CacheLine::downgradeState(ackAct));
 	// [sizhuo] get tag write delay
 	TimeDelta_t delay = cache->getTagAccessTime(lineAddr, doStats) - globalClock;
 	// [sizhuo] check whether resp contains data
@@ -854,7 +882,7 @@ void ACache::doDisp(MemRequest *mreq) {
 	int portId = router->getCreatorPort(mreq);
 	I(portId < upNodeNum);
 	I(portId >= 0);
-	line->dir[portId] = CacheLine::I;
+	cache->dir->set(line->dir, portId, CacheLine::I);
 	// [sizhuo] we only get disp for dirty block, change cache line state to M
 	I(line->state == CacheLine::M || line->state == CacheLine::E);
 	line->state = CacheLine::M;
@@ -878,6 +906,168 @@ TimeDelta_t ACache::ffwrite(AddrType addr) {
 	return tagDelay + 1;
 }
 
+// Functional warmup. This follows the same MESI transitions as the
+// doReq/doReqAck/doSetState/doDisp handlers, but everything completes in place
+
+bool ACache::ffDowngradeUp(CacheLine *line, MsgAction act, int16_t skipPort) {
+	if(isL1) {
+		return false;
+	}
+	const AddrType byteAddr = line->lineAddr << cache->log2LineSize;
+	bool dirty = false;
+	const int nSharers = cache->dir->getSharers(line->dir, dirSharers);
+	for(int j = 0; j < nSharers; j++) {
+		const int i = dirSharers[j];
+		if(i == skipPort || CacheLine::compatibleDownReq(cache->dir->get(line->dir, i), act)) {
+			continue;
+		}
+		if(router->ffSetStatePos(i, byteAddr, act)) {
+			dirty = true;
+		}
+		cache->dir->set(line->dir, i, CacheLine::downgradeState(act));
+	}
+	if(dirty) {
+		I(line->state == CacheLine::M || line->state == CacheLine::E || isLLC);
+		line->state = CacheLine::M;
+	}
+	return dirty;
+}
+
+// the timing flows may have requests in flight in the upper copies (all
+// but skipPort), ffDowngradeUp can not touch them
+bool ACache::ffBusyUp(CacheLine *line, int16_t skipPort) {
+	if(isL1) {
+		return false;
+	}
+	const AddrType byteAddr = line->lineAddr << cache->log2LineSize;
+	for(int i = 0; i < upNodeNum; i++) {
+		if(i == skipPort || line->dir[i] == CacheLine::I) {
+			continue;
+		}
+		if(router->ffBusyPos(i, byteAddr)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ACache::ffReplace(CacheLine *line) {
+	I(line->state != CacheLine::I);
+	ffDowngradeUp(line, ma_setInvalid, -1);
+	if(line->state == CacheLine::M) {
+		router->ffDisp(line->lineAddr << cache->log2LineSize);
+	}
+	line->state = CacheLine::I;
+}
+
+bool ACache::ffUpgrade(AddrType lineAddr, MsgAction act, int16_t port) {
+	CacheLine *line = cache->ffOccupyLine(lineAddr);
+	if(line == 0) {
+		return false; // line busy, drop this access
+	}
+	if(line->state != CacheLine::I && ffBusyUp(line, line->lineAddr == lineAddr ? port : -1)) {
+		return false; // an upper copy (of the line or the victim) is busy
+	}
+
+	if(line->lineAddr != lineAddr || line->state == CacheLine::I) {
+		if(line->state != CacheLine::I) {
+			ffReplace(line);
+		}
+		if(line->lineAddr != lineAddr) {
+			cache->dir->clear(line->dir);
+		}
+		line->lineAddr = lineAddr;
+		line->state = CacheLine::I;
+	}
+
+	if(!CacheLine::compatibleUpReq(line->state, act, isLLC)) {
+		if(!router->ffUpReq(lineAddr << cache->log2LineSize, act)) {
+			return false;
+		}
+		line->state = CacheLine::upgradeState(act);
+	}
+
+	if(!isL1) {
+		ffDowngradeUp(line, act == ma_setValid ? ma_setShared : ma_setInvalid, port);
+		I(port >= 0);
+		cache->dir->set(line->dir, port, CacheLine::upgradeState(act));
+	}
+	if(act == ma_setDirty) {
+		line->state = CacheLine::M;
+	}
+	return true;
+}
+
+void ACache::ffBatch(const FFAccess *acc, size_t n) {
+	I(isL1);
+	// consecutive accesses to the last line skip the tag array
+	CacheLine *last = 0;
+	AddrType lastLineAddr = 0;
+	for(size_t i = 0; i < n; i++) {
+		const AddrType lineAddr = cache->getLineAddr(acc[i].addr);
+		const MsgAction act = acc[i].write ? ma_setDirty : ma_setValid;
+		if(last && lastLineAddr == lineAddr && last->lineAddr == lineAddr
+				&& CacheLine::compatibleUpReq(last->state, act, isLLC)) {
+			if(acc[i].write) {
+				last->state = CacheLine::M;
+			}
+			continue;
+		}
+		last = 0;
+		if(ffUpgrade(lineAddr, act, 0)) {
+			last = cache->ffFindLine(lineAddr);
+			lastLineAddr = lineAddr;
+		}
+	}
+}
+
+bool ACache::ffUpReq(AddrType addr, MsgAction ma, const MemObj *from) {
+	I(!isL1);
+	const int16_t port = router->getUpNodePort(from);
+	I(port >= 0 && port < upNodeNum);
+	return ffUpgrade(cache->getLineAddr(addr), ma, port);
+}
+
+bool ACache::ffSetState(AddrType addr, MsgAction ma) {
+	CacheLine *line = cache->ffFindLine(cache->getLineAddr(addr));
+	if(line == 0 || CacheLine::compatibleDownReq(line->state, ma)) {
+		return false;
+	}
+	I(line->upReq == 0 && line->downReq == 0);
+
+	ffDowngradeUp(line, ma, -1);
+	const bool dirty = line->state == CacheLine::M;
+	line->state = CacheLine::downgradeState(ma);
+	return dirty;
+}
+
+void ACache::ffDisp(AddrType addr, const MemObj *from) {
+	CacheLine *line = cache->ffFindLine(cache->getLineAddr(addr));
+	I(line);
+	if(line == 0) {
+		return;
+	}
+	const int16_t port = router->getUpNodePort(from);
+	I(port >= 0 && port < upNodeNum);
+	cache->dir->set(line->dir, port, CacheLine::I);
+	line->state = CacheLine::M;
+}
+
+bool ACache::ffBusy(AddrType addr) {
+	CacheLine *line = cache->ffFindLine(cache->getLineAddr(addr));
+	if(line == 0) {
+		return false;
+	}
+	if(line->upReq || line->downReq) {
+		return true;
+	}
+	return ffBusyUp(line, -1);
+}
+
 bool ACache::isBusy(AddrType addr) const {
 	return false;
 }
+
+void ACache::checkpoint(Checkpoint *ck) {
+	cache->checkpoint(ck);
+}
@@ -36,6 +36,7 @@ protected:
 	const bool isLLC;
 
 	const int upNodeNum; // number of upper level of nodes
+	int16_t *dirSharers; // scratch for the directory sharers
 
   // BEGIN Statistics
   GStatsCntr displaced; // [sizhuo] number of replacement
@@ -51,6 +52,13 @@ private:
 	// [sizhuo] helper function: forward req to lower level
 	void forwardReqDown(MemRequest *mreq, AddrType lineAddr, TimeDelta_t lat);
 
+	// functional warmup helpers: downgrade the upper level copies (all but
+	// skipPort) with the directory, and evict a valid line
+	bool ffDowngradeUp(CacheLine *line, MsgAction act, int16_t skipPort);
+	bool ffBusyUp(CacheLine *line, int16_t skipPort);
+	void ffReplace(CacheLine *line);
+	bool ffUpgrade(AddrType lineAddr, MsgAction act, int16_t port);
+
 public:
 	ACache(MemorySystem *gms, const char *descr_section, const char *name = NULL);
 	virtual ~ACache();
@@ -74,8 +82,16 @@ public:
   TimeDelta_t ffread(AddrType addr);
   TimeDelta_t ffwrite(AddrType addr);
 
+	void ffBatch(const FFAccess *acc, size_t n);
+	bool ffUpReq(AddrType addr, MsgAction ma, const MemObj *from);
+	bool ffSetState(AddrType addr, MsgAction ma);
+	void ffDisp(AddrType addr, const MemObj *from);
+	bool ffBusy(AddrType addr);
+
 	bool isBusy(AddrType addr) const;
 
+	void checkpoint(Checkpoint *ck);
+
 	virtual uint32_t getLog2LineSize() { return cache->log2LineSize; }
 };
 
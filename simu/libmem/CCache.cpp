@@ -716,6 +716,13 @@ bool CCache::isBusy(AddrType addr) const
 }
 // }}}
 
+void CCache::checkpoint(Checkpoint *ck)
+/* save/restore the cache lines and sharers {{{1 */
+{
+  cacheBank->checkpoint(ck, getName(), Checkpoint::Coherent);
+}
+// }}}
+
 void CCache::dump() const
 /* Dump some CCache statistics {{{1 */
 {
@@ -130,6 +130,13 @@ protected:
       clearTag();
     }
 
+    void checkpoint(Checkpoint *ck) {
+      StateGeneric<AddrType>::checkpoint(ck);
+      ck->io(state);
+      ck->io(nSharers);
+      ck->io(share, sizeof(share));
+    }
+
 		bool isBroadcastNeeded() const { return nSharers >= 8; }
 
 		int16_t getSharingCount() const {
@@ -233,6 +240,8 @@ public:
 
 	bool isBusy(AddrType addr) const;
 
+	void checkpoint(Checkpoint *ck);
+
 	void setTurboRatio(float r);
 	void dump() const;
 
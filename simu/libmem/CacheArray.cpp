@@ -1,108 +1,137 @@
 #include "CacheArray.h"
 #include <queue>
+#include <vector>
 #include "nanassert.h"
 #include "MemRequest.h"
 #include <string.h>
 
-LRUCacheArray::LRUCacheArray(const uint32_t size_, const uint32_t lineSize_, const uint32_t assoc_, const uint32_t bankNum_, const int upNodeNum, const char *name_str)
+LRUCacheArray::LRUCacheArray(const uint32_t size_, const uint32_t lineSize_, const uint32_t assoc_, const uint32_t bankNum_, const int upNodeNum_, const char *name_str, CacheDir::Mode dirMode, int dirPtrs)
 	: CacheArray(size_, lineSize_, assoc_, bankNum_, name_str)
-	, tags(0)
+	, lines(0)
+	, dirs(0)
+	, ranks(0)
+	, mruWay(0)
+	, upNodeNum(upNodeNum_)
 {
+	I(assoc <= 0x10000);
+	const uint32_t lineNum = setNum * assoc;
+
 	// [sizhuo] create tag arrays
-	tags = new CacheSet[setNum];
-	I(tags);
+	lines  = new CacheLine[lineNum];
+	dir    = new CacheDir(upNodeNum, dirMode, dirPtrs);
+	const int dirWords = dir->getWords();
+	dirs   = new CacheLine::DirWord[lineNum * dirWords];
+	ranks  = new uint16_t[lineNum];
+	mruWay = new uint16_t[setNum];
+	I(lines && dirs && ranks && mruWay);
+	memset(dirs, 0, sizeof(CacheLine::DirWord) * lineNum * dirWords);
 	for(uint32_t i = 0; i < setNum; i++) {
+		// same initial order as a list filled by push_back: way 0 is the LRU
 		for(uint32_t j = 0; j < assoc; j++) {
-			CacheLine *line = new CacheLine(upNodeNum);
-			tags[i].push_back(line);
+			CacheLine *line = getLine(i, j);
+			line->dir = &dirs[((i << log2Assoc) + j) * dirWords];
+			ID(line->upNum = upNodeNum);
+			ranks[(i << log2Assoc) + j] = assoc - 1 - j;
 		}
+		mruWay[i] = assoc - 1;
 	}
 }
 
 LRUCacheArray::~LRUCacheArray() {
-	if(tags) {
-		for(uint32_t i = 0; i < setNum; i++) {
-			while(!tags[i].empty()) {
-				CacheLine *line = tags[i].front();
-				tags[i].pop_front();
-				I(line);
-				delete line;
-			}
+	delete[]lines;
+	delete[]dirs;
+	delete dir;
+	delete[]ranks;
+	delete[]mruWay;
+}
+
+void LRUCacheArray::promote(AddrType index, uint32_t way) {
+	uint16_t *rank = &ranks[index << log2Assoc];
+	const uint16_t r = rank[way];
+	if(r == 0) {
+		return;
+	}
+	for(uint32_t i = 0; i < assoc; i++) {
+		if(rank[i] < r) {
+			rank[i]++;
+		}
+	}
+	rank[way] = 0;
+	mruWay[index] = way;
+}
+
+int LRUCacheArray::findVictimWay(AddrType index) const {
+	const uint16_t *rank = &ranks[index << log2Assoc];
+	const CacheLine *line = getLine(index, 0);
+	int victim = -1;
+	bool victimInv = false;
+
+	for(uint32_t way = 0; way < assoc; way++, line++) {
+		if(line->upReq || line->downReq) {
+			continue;
+		}
+		const bool inv = line->state == CacheLine::I;
+		if(victim < 0 || (inv && !victimInv) || (inv == victimInv && rank[way] > rank[victim])) {
+			victim = way;
+			victimInv = inv;
+		}
+	}
+	return victim;
+}
+
+void LRUCacheArray::dumpSet(AddrType index) const {
+	for(uint32_t way = 0; way < assoc; way++) {
+		const CacheLine *line = getLine(index, way);
+		MSG("tags[%lx][%d]: %p, rank %d, state %d, lineAddr %lx, upReq %p, downReq %p", index, way, line, ranks[(index << log2Assoc) + way], line->state, line->lineAddr, line->upReq, line->downReq);
+		if(line->upReq) {
+			line->upReq->dumpAlways();
+		}
+		if(line->downReq) {
+			line->downReq->dumpAlways();
 		}
-		delete[]tags;
 	}
 }
 
 CacheLine* LRUCacheArray::downReqOccupyLine(AddrType lineAddr, const MemRequest *mreq) {
 	const AddrType index = getIndex(lineAddr);
-	CacheLine *line = 0;
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++) {
-		if((*iter)->lineAddr == lineAddr && (*iter)->state != CacheLine::I) {
-			// [sizhuo] MSHR ensures that this line can only be occupied by up req in Wait state
-			line = *iter;
-			I(line->downReq == 0);
-			line->downReq = mreq;
-			return line;
-		}
+	const int way = findValidWay(index, lineAddr);
+	if(way < 0) {
+		return 0;
 	}
-	return 0;
+	// [sizhuo] MSHR ensures that this line can only be occupied by up req in Wait state
+	CacheLine *line = getLine(index, way);
+	I(line->downReq == 0);
+	line->downReq = mreq;
+	return line;
 }
 
 CacheLine* LRUCacheArray::upReqOccupyLine(AddrType lineAddr, const MemRequest *mreq) {
 	const AddrType index = getIndex(lineAddr);
-	CacheLine *line = 0;
 
 	// [sizhuo] MSHR ensures that the occupied line in this function will not be occupied by other req
 
-	// [sizhuo] find hit line
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++) {
-		if((*iter)->lineAddr == lineAddr && (*iter)->state != CacheLine::I) {
-			// [sizhuo] MSHR ensures that this line is not being replaced/downgraded by other req
-			line = (*iter);
-			// [sizhuo] promote line to MRU
-			tags[index].erase(iter);
-			tags[index].push_back(line);
-			// [sizhuo] occupy & return
-			I(line->downReq == 0);
-			I(line->upReq == 0);
-			line->upReq = mreq;
-			return line;
-		}
+	// [sizhuo] find hit line, otherwise an invalid line, otherwise the LRU line
+	int way = findValidWay(index, lineAddr);
+	if(way >= 0) {
+		// [sizhuo] MSHR ensures that this line is not being replaced/downgraded by other req
+		I(getLine(index, way)->downReq == 0);
+		I(getLine(index, way)->upReq == 0);
+	} else {
+		way = findVictimWay(index);
 	}
 
-	// [sizhuo] try to find invalid line
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++) {
-		if((*iter)->state == CacheLine::I && (*iter)->downReq == 0 && (*iter)->upReq == 0) {
-			line = (*iter);
-			// [sizhuo] promote line to MRU
-			tags[index].erase(iter);
-			tags[index].push_back(line);
-			// [sizhuo] occupy & return
-			line->upReq = mreq;
-			return line;
-		}
-	}
-
-	// [sizhuo] replace the LRU line
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++) {
-		if((*iter)->downReq == 0 && (*iter)->upReq == 0) {
-			line = (*iter);
-			// [sizhuo] promote line to MRU
-			tags[index].erase(iter);
-			tags[index].push_back(line);
-			// [sizhuo] occupy & return
-			line->upReq = mreq;
-			return line;
-		}
+	if(way < 0) {
+		// [sizhuo] fail to occupy a line, error
+		MSG("ERROR: upgrade req fail to occupy a line %lx", lineAddr);
+		dumpSet(index);
+		return 0;
 	}
 
-	// [sizhuo] fail to occupy a line, error
-	MSG("ERROR: upgrade req fail to occupy a line %lx", lineAddr);
-	int i = 0;
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++, i++) {
-		MSG("tags[%lx][%d]: state %d, lineAddr %lx, upReq %p, downReq %p", index, i, (*iter)->state, (*iter)->lineAddr, (*iter)->upReq, (*iter)->downReq);
-	}	
-	return 0;
+	// [sizhuo] promote line to MRU, occupy & return
+	CacheLine *line = getLine(index, way);
+	promote(index, way);
+	line->upReq = mreq;
+	return line;
 }
 
 CacheLine* LRUCacheArray::upReqFindLine(AddrType lineAddr, const MemRequest *mreq) {
@@ -111,45 +140,82 @@ CacheLine* LRUCacheArray::upReqFindLine(AddrType lineAddr, const MemRequest *mre
 	I(mreq->isReqAck());
 
 	// [sizhuo] when reqAck comes, cache line should not have down req
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++) {
-		if((*iter)->lineAddr == lineAddr && (*iter)->upReq == mreq && (*iter)->downReq == 0) {
-			return (*iter);
+	// the line was promoted to MRU when the req occupied it
+	CacheLine *line = getLine(index, mruWay[index]);
+	if(line->lineAddr == lineAddr && line->upReq == mreq && line->downReq == 0) {
+		return line;
+	}
+	line = getLine(index, 0);
+	for(uint32_t way = 0; way < assoc; way++, line++) {
+		if(line->lineAddr == lineAddr && line->upReq == mreq && line->downReq == 0) {
+			return line;
 		}
 	}
 	// [sizhuo] fail to find a line, error
 	MSG("ERROR: upReqFindLine fail to find the line %lx", lineAddr);
-	int i = 0;
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++, i++) {
-		MSG("tags[%lx][%d]: %p, state %d, lineAddr %lx, upReq %p, downReq %p", index, i, (*iter), (*iter)->state, (*iter)->lineAddr, (*iter)->upReq, (*iter)->downReq);
-		if((*iter)->upReq) {
-			(*iter)->upReq->dumpAlways();
-		}
-		if((*iter)->downReq) {
-			(*iter)->downReq->dumpAlways();
-		}
-	}	
+	dumpSet(index);
 	return 0;
 }
 
 CacheLine* LRUCacheArray::downRespFindLine(AddrType lineAddr) {
 	const AddrType index = getIndex(lineAddr);
-
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++) {
-		if((*iter)->lineAddr == lineAddr && (*iter)->state != CacheLine::I) {
-			return (*iter);
-		}
+	const int way = findValidWay(index, lineAddr);
+	if(way >= 0) {
+		return getLine(index, way);
 	}
 	// [sizhuo] fail to find a line, error
 	MSG("ERROR: downRespFindLine fail to find the line %lx", lineAddr);
-	int i = 0;
-	for(CacheSet::iterator iter = tags[index].begin(); iter != tags[index].end(); iter++, i++) {
-		MSG("tags[%lx][%d]: %p, state %d, lineAddr %lx, upReq %p, downReq %p", index, i, (*iter), (*iter)->state, (*iter)->lineAddr, (*iter)->upReq, (*iter)->downReq);
-		if((*iter)->upReq) {
-			(*iter)->upReq->dumpAlways();
+	dumpSet(index);
+	return 0;
+}
+
+CacheLine* LRUCacheArray::ffFindLine(AddrType lineAddr) {
+	const AddrType index = getIndex(lineAddr);
+	const int way = findValidWay(index, lineAddr);
+	return way >= 0 ? getLine(index, way) : 0;
+}
+
+CacheLine* LRUCacheArray::ffOccupyLine(AddrType lineAddr) {
+	const AddrType index = getIndex(lineAddr);
+
+	int way = findValidWay(index, lineAddr);
+	if(way >= 0) {
+		const CacheLine *line = getLine(index, way);
+		if(line->upReq || line->downReq) {
+			return 0;
 		}
-		if((*iter)->downReq) {
-			(*iter)->downReq->dumpAlways();
+	} else {
+		// first invalid line, otherwise the least recently used one
+		way = findVictimWay(index);
+		if(way < 0) {
+			return 0;
 		}
-	}	
-	return 0;
+	}
+
+	promote(index, way);
+	return getLine(index, way);
+}
+
+void LRUCacheArray::checkpoint(Checkpoint *ck) {
+	const uint64_t sig = Checkpoint::signature(size, lineSize, assoc, upNodeNum, dir->getMode(), dir->getPtrs());
+	if(!ck->beginSection(Checkpoint::Coherent, sig, "%s", getName())) {
+		return;
+	}
+
+	// lines are written in LRU order (LRU first), a restore fills the ways in
+	// the same order so the LRU order is kept
+	std::vector<uint32_t> order(assoc);
+	for(uint32_t i = 0; i < setNum; i++) {
+		for(uint32_t way = 0; way < assoc; way++) {
+			order[assoc - 1 - ranks[(i << log2Assoc) + way]] = way;
+		}
+		for(uint32_t j = 0; j < assoc; j++) {
+			CacheLine *line = getLine(i, order[j]);
+			ck->io(line->lineAddr);
+			ck->io(line->state);
+			ck->io(line->dir, sizeof(CacheLine::DirWord) * dir->getWords());
+		}
+	}
+
+	ck->endSection();
 }
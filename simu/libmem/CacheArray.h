@@ -2,8 +2,10 @@
 #define CACHE_ARRAY_H
 
 #include "CacheLine.h"
+#include "CacheDir.h"
 #include "MemRequest.h"
 #include "Port.h"
+#include "Checkpoint.h"
 
 // [sizhuo] base class for all cache arrays
 class CacheArray {
@@ -28,6 +30,8 @@ public:
   const uint32_t  log2Sets;
 	const uint32_t  maskBank;
 
+	const CacheDir *dir; // format of the directory entries (line->dir)
+
 	CacheArray(const uint32_t size_, const uint32_t lineSize_, const uint32_t assoc_, const uint32_t bankNum_, const char *name_str)
 		: name(0)
 		, tagPort(0)
@@ -43,6 +47,7 @@ public:
 		, maskSets(setNum - 1)
 		, log2Sets(log2i(setNum))
 		, maskBank(bankNum - 1)
+		, dir(0)
 	{
 		I(size > 0);
 		I(lineSize > 0);
@@ -90,6 +95,8 @@ public:
 		}
 	}
 
+	const char *getName() const { return name; }
+
 	// [sizhuo] functions to get line addr & index
 	AddrType getLineAddr (AddrType byteAddr) const {
 		return byteAddr >> log2LineSize;
@@ -115,6 +122,16 @@ public:
 	// [sizhuo] find a cache line for downgrade resp (setStateAck & disp)
 	virtual CacheLine *downRespFindLine(AddrType lineAddr) = 0;
 
+	// functional warmup: find a valid line matching address (no LRU update)
+	virtual CacheLine *ffFindLine(AddrType lineAddr) = 0;
+	// functional warmup: promote the matching line to MRU, or the line to
+	// replace on a miss (invalid first, then LRU). Lines occupied by a req are
+	// skipped, returns 0 if the matching line is occupied or no line is free
+	virtual CacheLine *ffOccupyLine(AddrType lineAddr) = 0;
+
+	// save/restore the lines (state, directory) and the LRU order
+	virtual void checkpoint(Checkpoint *ck) = 0;
+
 	// [sizhuo] port contentions
 	Time_t getTagAccessTime(AddrType lineAddr, bool statsFlag) {
 		return tagPort[getBank(lineAddr)]->nextSlot(statsFlag);
@@ -126,19 +143,51 @@ public:
 
 class LRUCacheArray : public CacheArray {
 private:
-	// [sizhuo] head of list -- LRU; tail of list -- MRU
-	typedef std::list<CacheLine*> CacheSet;
-	CacheSet *tags;
+	// lines of set i are lines[i * assoc .. i * assoc + assoc - 1]
+	CacheLine *lines;
+	CacheLine::DirWord *dirs; // directory entries of all the lines
+	// LRU rank of each line: 0 -- MRU, assoc - 1 -- LRU
+	uint16_t *ranks;
+	// way of the MRU line of each set, lookups check it first
+	uint16_t *mruWay;
+	const int upNodeNum;
+
+	CacheLine *getLine(AddrType index, uint32_t way) const {
+		return &lines[(index << log2Assoc) + way];
+	}
+	// way of the valid (MES) line matching address, -1 on miss
+	int findValidWay(AddrType index, AddrType lineAddr) const {
+		const CacheLine *line = getLine(index, mruWay[index]);
+		if(line->lineAddr == lineAddr && line->state != CacheLine::I) {
+			return mruWay[index];
+		}
+		line = getLine(index, 0);
+		for(uint32_t way = 0; way < assoc; way++, line++) {
+			if(line->lineAddr == lineAddr && line->state != CacheLine::I) {
+				return way;
+			}
+		}
+		return -1;
+	}
+	// way to replace: invalid free line first, then the LRU free line
+	int findVictimWay(AddrType index) const;
+	void promote(AddrType index, uint32_t way);
+	void dumpSet(AddrType index) const;
 
 
 public:
-	LRUCacheArray(const uint32_t size_, const uint32_t lineSize_, const uint32_t assoc_, const uint32_t bankNum_, const int upNodeNum, const char *name_str);
+	LRUCacheArray(const uint32_t size_, const uint32_t lineSize_, const uint32_t assoc_, const uint32_t bankNum_, const int upNodeNum_, const char *name_str, CacheDir::Mode dirMode = CacheDir::Full, int dirPtrs = 4);
 	virtual ~LRUCacheArray();
 
 	virtual CacheLine *downReqOccupyLine(AddrType lineAddr, const MemRequest *mreq);
 	virtual CacheLine *upReqOccupyLine(AddrType lineAddr, const MemRequest *mreq);
 	virtual CacheLine *upReqFindLine(AddrType lineAddr, const MemRequest *mreq);
 	virtual CacheLine *downRespFindLine(AddrType lineAddr);
+
+	virtual CacheLine *ffFindLine(AddrType lineAddr);
+	virtual CacheLine *ffOccupyLine(AddrType lineAddr);
+
+	virtual void checkpoint(Checkpoint *ck);
 };
 
 #endif
@@ -154,6 +154,18 @@ bool MarkovPrefetcher::isBusy(AddrType addr) const
 }
 /* }}} */
 
+void MarkovPrefetcher::checkpoint(Checkpoint *ck)
+/* save/restore the buffer and the correlation table {{{1 */
+{
+  char cadena[256];
+
+  sprintf(cadena, "%s_buff", getName());
+  buff->checkpoint(ck, cadena);
+  sprintf(cadena, "%s_table", getName());
+  table->checkpoint(ck, cadena);
+}
+/* }}} */
+
 TimeDelta_t MarkovPrefetcher::ffread(AddrType addr)
   /* fast forward reads {{{1 */
 { 
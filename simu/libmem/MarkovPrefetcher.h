@@ -56,6 +56,13 @@ class MarkovPfState : public StateGeneric<AddrType> {
   AddrType predAddr4;
   MarkovPfState(int32_t linesize){
   }
+  void checkpoint(Checkpoint *ck) {
+    StateGeneric<AddrType>::checkpoint(ck);
+    ck->io(predAddr1);
+    ck->io(predAddr2);
+    ck->io(predAddr3);
+    ck->io(predAddr4);
+  }
 };
 
 
@@ -68,6 +75,14 @@ class MarkovTState : public StateGeneric<AddrType> {
   int32_t tag;
   MarkovTState(int32_t linesize){
   }
+  void checkpoint(Checkpoint *ck) {
+    StateGeneric<AddrType>::checkpoint(ck);
+    ck->io(missAddr);
+    ck->io(predAddr1);
+    ck->io(predAddr2);
+    ck->io(predAddr3);
+    ck->io(tag);
+  }
   };
 
 
@@ -181,6 +196,7 @@ public:
   void doSetState(MemRequest *mreq);
   void doSetStateAck(MemRequest *mreq);
   bool isBusy(AddrType addr) const;
+  void checkpoint(Checkpoint *ck);
   TimeDelta_t ffread(AddrType addr);
   TimeDelta_t ffwrite(AddrType addr);
   void prefetch(AddrType prefAddr, Time_t lat);
@@ -38,6 +38,7 @@
 #include "SescConf.h"
 #include "MemorySystem.h"
 #include "MemController.h"
+#include "Checkpoint.h"
 #include <iostream>
 #include "stdlib.h"
 #include <queue>
@@ -45,16 +46,31 @@
 #include <vector>
 /* }}} */
 
+static uint32_t getOptionalInt(const char *section, const char *name, uint32_t def)
+{
+  if (!SescConf->checkInt(section, name))
+    return def;
+  return SescConf->getInt(section, name);
+}
+
 MemController::MemController(MemorySystem* current ,const char *section ,const char *name)
   /* constructor {{{1 */
   : MemObj(section, name)
+  ,fcfsPool(64, "MemController_fcfsPool")
   ,delay(SescConf->getInt(section, "delay"))
   ,PreChargeLatency(SescConf->getInt(section, "PreChargeLatency"))
   ,RowAccessLatency(SescConf->getInt(section, "RowAccessLatency"))
   ,ColumnAccessLatency(SescConf->getInt(section, "ColumnAccessLatency"))
+  ,tRRD(getOptionalInt(section, "tRRD", 0))
+  ,tRRDL(getOptionalInt(section, "tRRDL", tRRD))
+  ,tFAW(getOptionalInt(section, "tFAW", 0))
+  ,tWTR(getOptionalInt(section, "tWTR", 0))
+  ,tREFI(getOptionalInt(section, "tREFI", 0))
+  ,tRFC(getOptionalInt(section, "tRFC", 0))
   ,nPrecharge("%s:nPrecharge", name)
   ,nColumnAccess("%s:nColumnAccess", name)
   ,nRowAccess("%s:nRowAccess", name)
+  ,nRefreshClose("%s:nRefreshClose", name)
   ,avgMemLat("%s_avgMemLat", name)
   ,readHit("%s:readHit", name)
   ,memRequestBufferSize(SescConf->getInt(section, "memRequestBufferSize"))
@@ -66,40 +82,95 @@ MemController::MemController(MemorySystem* current ,const char *section ,const c
   SescConf->isGT(section, "delay",0);
 
   NumUnits_t  num = SescConf->getInt(section, "numPorts");
-  TimeDelta_t occ = SescConf->getInt(section, "portOccp");
-
-  char cadena[100];
-  sprintf(cadena,"Cmd%s", name);
-  cmdPort  = PortGeneric::create(cadena, num, occ);
+  busOccp = SescConf->getInt(section, "portOccp");
 
   SescConf->isPower2(section, "numRows",0);
   SescConf->isPower2(section, "numColumns",0);
   SescConf->isPower2(section, "numBanks",0);
   SescConf->isGT(section, "ColumnAccessLatency",4); // 1 cycle is not supported
 
-  numBanks = SescConf->getInt(section, "NumBanks");
-  unsigned int numRows = SescConf->getInt(section, "NumRows");
+  numBanks   = SescConf->getInt(section, "NumBanks");
+  numRows    = SescConf->getInt(section, "NumRows");
+  numColumns = SescConf->getInt(section, "NumColumns");
   unsigned int ColumnSize = SescConf->getInt(section, "ColumnSize");
-  unsigned int numColumns = SescConf->getInt(section, "NumColumns");
-
-  columnOffset = log2(ColumnSize);
-  columnMask   = numColumns-1;
-  columnMask   = columnMask<<columnOffset;      // FIXME: Use AddrType
-
-  rowOffset    = columnOffset+log2(numColumns);
-  rowMask      = numRows - 1;
-  rowMask      = rowMask<<rowOffset; // FIXME: use AddrType
-
-  bankOffset   = rowOffset+log2(numRows);
-  bankMask     = numBanks -1;
-  bankMask     = bankMask<<bankOffset;
-  
-  bankState = new BankStatus[numBanks];
-  for(uint32_t curBank=0; curBank<numBanks;curBank++){
-    bankState[curBank].activeRow=0;
-	bankState[curBank].state=INIT;  // Changed from ACTIVE (LNB)
-    bankState[curBank].bankTime=0;  // added (LNB)
+
+  numChannels   = getOptionalInt(section, "NumChannels", 1);
+  numRanks      = getOptionalInt(section, "NumRanks", 1);
+  numBankGroups = getOptionalInt(section, "NumBankGroups", 1);
+  if (numChannels != 1)
+    SescConf->isPower2(section, "NumChannels");
+  if (numRanks != 1)
+    SescConf->isPower2(section, "NumRanks");
+  if (numBankGroups != 1) {
+    SescConf->isPower2(section, "NumBankGroups");
+    SescConf->isBetween(section, "NumBankGroups", 1, numBanks);
+  }
+  if (tREFI && tRFC >= tREFI) {
+    MSG("ERROR: %s tRFC must be smaller than tREFI", section);
+    SescConf->notCorrect();
+  }
+
+  bankParallel = false;
+  if (SescConf->checkBool(section, "bankParallel"))
+    bankParallel = SescConf->getBool(section, "bankParallel");
+  if (!bankParallel && (tRRD || tRRDL || tFAW || tWTR || tREFI)) {
+    MSG("ERROR: %s tRRD/tFAW/tWTR/tREFI need bankParallel = true", section);
+    SescConf->notCorrect();
+  }
+
+  xorInterleave = false;
+  if (SescConf->checkCharPtr(section, "interleave")) {
+    const char *policy = SescConf->getCharPtr(section, "interleave");
+    if (strcasecmp(policy, "xor") == 0) {
+      xorInterleave = true;
+    }else if (strcasecmp(policy, "linear") != 0) {
+      MSG("ERROR: %s interleave = %s, it should be linear or xor", section, policy);
+      SescConf->notCorrect();
+    }
+  }
+
+  log2Banks     = log2i(numBanks);
+  columnOffset  = log2i(ColumnSize);
+  channelOffset = columnOffset  + log2i(numColumns);
+  rowOffset     = channelOffset + log2i(numChannels);
+  bankOffset    = rowOffset     + log2i(numRows);
+  rankOffset    = bankOffset    + log2Banks;
+
+  channels = new ChannelStatus[numChannels];
+  for(uint32_t ch=0; ch<numChannels; ch++) {
+    ChannelStatus &chan = channels[ch];
+
+    chan.bankState = new BankStatus[numRanks * numBanks];
+    for(uint32_t curBank=0; curBank<numRanks*numBanks;curBank++){
+      chan.bankState[curBank].activeRow=0;
+      chan.bankState[curBank].state=INIT;  // Changed from ACTIVE (LNB)
+      chan.bankState[curBank].bankTime=0;  // added (LNB)
+      chan.bankState[curBank].head=0;
+      chan.bankState[curBank].tail=0;
+      chan.bankState[curBank].accessing=0;
+      chan.bankState[curBank].bpend=false;
+      chan.bankState[curBank].cpend=false;
+    }
+
+    chan.rankState = new RankStatus[numRanks];
+    for(uint32_t r=0; r<numRanks; r++) {
+      RankStatus &rank = chan.rankState[r];
+      rank.lastAct      = 0;
+      rank.lastActGroup = 0;
+      for(int i=0;i<4;i++)
+        rank.actWindow[i] = 0;
+      rank.actPos       = 0;
+      rank.lastWriteEnd = 0;
+      rank.refPhase     = tREFI / numRanks * r;
+    }
+
+    chan.nBuses  = num > 0 ? num : 1;
+    chan.busFree = new Time_t[chan.nBuses];
+    for(uint32_t i=0; i<chan.nBuses; i++)
+      chan.busFree[i] = 0;
+    chan.nBuffered = 0;
   }
+
   I(current);
   lower_level = current->declareMemoryObj(section, "lowerLevel");   
   if (lower_level)
@@ -150,6 +221,38 @@ bool MemController::isBusy(AddrType addr) const
 }
 /* }}} */
 
+void MemController::checkpoint(Checkpoint *ck)
+/* save/restore the open row of each bank {{{1 */
+{
+  uint64_t sig = Checkpoint::signature(numBanks, (numRows - 1) << rowOffset, (numBanks - 1) << bankOffset, numChannels - 1, numRanks - 1, xorInterleave);
+  if (!ck->beginSection(Checkpoint::Independent, sig, "%s", getName()))
+    return;
+
+  for(uint32_t ch=0; ch<numChannels; ch++) {
+    for(uint32_t curBank=0; curBank<numRanks*numBanks;curBank++){
+      BankStatus &bank = channels[ch].bankState[curBank];
+
+      // Commands in flight are not saved, settle the bank to where they go
+      int state = bank.state;
+      if (state == PRECHARGE)
+        state = IDLE;
+      else if (state == ACTIVATING || state == ACCESSING)
+        state = ACTIVE;
+
+      ck->io(state);
+      ck->io(bank.activeRow);
+
+      if (!ck->isSaving()) {
+        bank.state    = state;
+        bank.bankTime = 0;
+      }
+    }
+  }
+
+  ck->endSection();
+}
+/* }}} */
+
 TimeDelta_t MemController::ffread(AddrType addr)
   /* fast forward reads {{{1 */
 { 
@@ -167,146 +270,370 @@ TimeDelta_t MemController::ffwrite(AddrType addr)
 
 void MemController::addMemRequest(MemRequest *mreq)
 {
-  FCFSField *newEntry   = new FCFSField;
+  FCFSField *newEntry   = fcfsPool.out();
 
+  newEntry->Channel     = getChannel(mreq);
   newEntry->Bank        = getBank(mreq);
   newEntry->Row         = getRow(mreq);
   newEntry->Column      = getColumn(mreq);
   newEntry->mreq        = mreq;
   newEntry->TimeEntered = globalClock;
 
-  OverflowMemoryRequests.push(newEntry);
+  ChannelStatus &chan = channels[newEntry->Channel];
+  if (!bankParallel) {
+    chan.OverflowMemoryRequests.push_back(newEntry);
+    manageRam(newEntry->Channel);
+    return;
+  }
 
-  manageRam();
+  if (chan.nBuffered <= memRequestBufferSize && chan.OverflowMemoryRequests.empty()) {
+    enqueue(newEntry);
+    scheduleBank(newEntry->Channel, newEntry->Bank);
+  }else{
+    chan.OverflowMemoryRequests.push_back(newEntry);
+  }
 }
 
-// This function implements the FR-FCFS memory scheduling algorithm
-void MemController::manageRam(void)
+void MemController::enqueue(FCFSField *entry)
+  /* add to the bank queues {{{1 */
 {
-  
-  // First, we need to determine if any actions (precharging, activating, or accessing) have been completed
-  for(uint32_t curBank=0; curBank <numBanks;curBank++){
-    if((bankState[curBank].state == PRECHARGE) && (globalClock - bankState[curBank].bankTime >= PreChargeLatency)){
+  ChannelStatus &chan = channels[entry->Channel];
+  BankStatus    &bank = chan.bankState[entry->Bank];
+
+  entry->bankNext = 0;
+  entry->bankPrev = bank.tail;
+  if (bank.tail)
+    bank.tail->bankNext = entry;
+  else
+    bank.head = entry;
+  bank.tail = entry;
+
+  bank.rows[entry->Row].push_back(entry);
+  chan.nBuffered++;
+}
+/* }}} */
+
+void MemController::dequeue(FCFSField *entry)
+  /* remove from the bank queues, it keeps the buffer slot until it finishes {{{1 */
+{
+  BankStatus &bank = channels[entry->Channel].bankState[entry->Bank];
+
+  if (entry->bankPrev)
+    entry->bankPrev->bankNext = entry->bankNext;
+  else
+    bank.head = entry->bankNext;
+  if (entry->bankNext)
+    entry->bankNext->bankPrev = entry->bankPrev;
+  else
+    bank.tail = entry->bankPrev;
+
+  RowMap::iterator it = bank.rows.find(entry->Row);
+  I(it != bank.rows.end());
+  I(it->second.front() == entry);
+  it->second.pop_front();
+  if (it->second.empty())
+    bank.rows.erase(it);
+}
+/* }}} */
+
+Time_t MemController::refreshFree(const RankStatus &rank, Time_t t) const
+  /* first cycle >= t outside a refresh of the rank {{{1 */
+{
+  if (tREFI == 0 || t < rank.refPhase)
+    return t;
 
-      bankState[curBank].state= IDLE;
+  Time_t phase = (t - rank.refPhase) % tREFI;
+  if (phase < tRFC)
+    return t + (tRFC - phase);
+  return t;
+}
+/* }}} */
 
-    }else if ((bankState[curBank].state == ACTIVATING) && (globalClock - bankState[curBank].bankTime >= RowAccessLatency)){
+bool MemController::refreshedSince(const RankStatus &rank, Time_t t0, Time_t t1) const
+  /* a refresh of the rank started in (t0, t1] {{{1 */
+{
+  if (tREFI == 0 || t1 < rank.refPhase)
+    return false;
 
-      bankState[curBank].state=ACTIVE;
+  Time_t next = rank.refPhase;
+  if (t0 >= rank.refPhase)
+    next += ((t0 - rank.refPhase) / tREFI + 1) * tREFI;
+  return next <= t1;
+}
+/* }}} */
 
-    }else if ((bankState[curBank].state==ACCESSING)&&(globalClock - bankState[curBank].bankTime >=ColumnAccessLatency)){
+// FR-FCFS for one bank: a column access for the oldest request to the open
+// row, otherwise open the row of the oldest request (precharge first if
+// another row is open). Each command schedules bankDone for its bank, so
+// only the banks with something to do are visited. A command may start
+// later than now to meet the rank timing (tRRD, tFAW, tWTR, refresh) or to
+// get a data bus; the bank is reserved until it finishes.
+void MemController::scheduleBank(uint32_t ch, uint32_t b)
+{
+  ChannelStatus &chan = channels[ch];
+  BankStatus    &bank = chan.bankState[b];
+  RankStatus    &rank = chan.rankState[b >> log2Banks];
+  if (bank.head == 0)
+    return;
+
+  if (bank.state == ACTIVE && refreshedSince(rank, bank.bankTime, globalClock)) {
+    // the refresh closed the row
+    bank.state = IDLE;
+    nRefreshClose.inc();
+  }
 
-      bankState[curBank].state = ACTIVE;
+  Time_t start = globalClock;
+  switch(bank.state) {
+    case ACTIVE: {
+      RowMap::iterator it = bank.rows.find(bank.activeRow);
+      if (it != bank.rows.end()) {
+        FCFSField *entry = it->second.front();
+        dequeue(entry);
+        const bool isWrite = entry->mreq->isDisp();
+
+        if (!isWrite && tWTR && rank.lastWriteEnd + tWTR > start)
+          start = rank.lastWriteEnd + tWTR;
+        // column accesses share the data buses of the channel
+        uint32_t bus = 0;
+        for(uint32_t i=1; i<chan.nBuses; i++) {
+          if (chan.busFree[i] < chan.busFree[bus])
+            bus = i;
+        }
+        Time_t prev;
+        do {
+          prev  = start;
+          start = refreshFree(rank, start);
+          if (chan.busFree[bus] > start)
+            start = chan.busFree[bus];
+        } while(start != prev);
+        chan.busFree[bus] = start + busOccp;
+        if (isWrite)
+          rank.lastWriteEnd = start + ColumnAccessLatency;
+
+        bank.accessing = entry;
+        bank.state     = ACCESSING;
+        bank.bankTime  = start;
+
+        nColumnAccess.inc();
+
+        BankDoneCB::scheduleAbs(start + ColumnAccessLatency, this, ch, b);
+        return;
+      }
+    }
+    // no row hit, fall through
+    case INIT:
+      start = refreshFree(rank, start);
+
+      bank.state    = PRECHARGE;
+      bank.bankTime = start;
+
+      nPrecharge.inc();
+
+      BankDoneCB::scheduleAbs(start + PreChargeLatency, this, ch, b);
+      return;
+    case IDLE: {
+      const uint32_t group = (b & (numBanks - 1)) / (numBanks / numBankGroups);
+      Time_t prev;
+      do {
+        prev = start;
+        if (rank.lastAct) {
+          TimeDelta_t rrd = group == rank.lastActGroup ? tRRDL : tRRD;
+          if (rank.lastAct + rrd > start)
+            start = rank.lastAct + rrd;
+        }
+        Time_t oldest = rank.actWindow[rank.actPos];
+        if (tFAW && oldest && oldest + tFAW > start)
+          start = oldest + tFAW;
+        start = refreshFree(rank, start);
+      } while(start != prev);
 
-      for (FCFSList::iterator it = curMemRequests.begin();
-           it != curMemRequests.end();
-           it++) {
+      rank.lastAct      = start;
+      rank.lastActGroup = group;
+      rank.actWindow[rank.actPos] = start;
+      rank.actPos       = (rank.actPos + 1) & 3;
 
+      bank.state     = ACTIVATING;
+      bank.bankTime  = start;
+      bank.activeRow = bank.head->Row;
+
+      nRowAccess.inc();
+
+      BankDoneCB::scheduleAbs(start + RowAccessLatency, this, ch, b);
+      return;
+    }
+    default:
+      // busy, bankDone schedules the next command
+      return;
+  }
+}
+
+void MemController::bankDone(uint32_t ch, uint32_t b)
+{
+  ChannelStatus &chan = channels[ch];
+  BankStatus    &bank = chan.bankState[b];
+
+  if (bank.state == PRECHARGE) {
+    bank.state = IDLE;
+  }else if (bank.state == ACTIVATING) {
+    bank.state = ACTIVE;
+  }else{
+    I(bank.state == ACCESSING);
+    bank.state = ACTIVE;
+
+    FCFSField *tempMem = bank.accessing;
+    bank.accessing = 0;
+    I(tempMem);
+    I(tempMem->mreq);
+    I(tempMem->Row == bank.activeRow);
+
+    finishRequest(tempMem);
+    chan.nBuffered--;
+
+    // Replace the finished request with one from the overflow queue
+    while(chan.nBuffered <= memRequestBufferSize && !chan.OverflowMemoryRequests.empty()) {
+      FCFSField *entry = chan.OverflowMemoryRequests.front();
+      chan.OverflowMemoryRequests.pop_front();
+      enqueue(entry);
+      if (entry->Bank != b)
+        scheduleBank(ch, entry->Bank);
+    }
+  }
+
+  scheduleBank(ch, b);
+}
+
+void MemController::finishRequest(FCFSField *tempMem)
+  /* send the proper ACK and recycle the entry {{{1 */
+{
+  I(tempMem->mreq);
+
+  if(tempMem->mreq->isDisp()) tempMem->mreq->ack();  // Fixed doDisp Acknowledge -- LNB 5/28/2014
+  else {
+    MemRequest *mreq = tempMem->mreq;
+    I(mreq->isReq());
+
+    if (mreq->getAction() == ma_setValid || mreq->getAction() == ma_setExclusive)
+      mreq->convert2ReqAck(ma_setExclusive);
+    else
+      mreq->convert2ReqAck(ma_setDirty);
+
+    Time_t delta = globalClock-tempMem->TimeEntered;
+
+    router->scheduleReqAck(mreq,1);  //  Fixed doReq acknowledge -- LNB 5/28/2014
+    avgMemLat.sample(delta,mreq->getStatsFlag());
+  }
+  IS(tempMem->mreq = 0);
+  fcfsPool.in(tempMem);
+}
+/* }}} */
+
+// Original scheduler (bankParallel = false), one per channel. It starts at
+// most one command each time a request arrives or a command finishes.
+void MemController::manageRam(uint32_t ch)
+{
+  ChannelStatus &chan = channels[ch];
+
+  // First, we need to determine if any actions (precharging, activating, or accessing) have been completed
+  for(uint32_t curBank=0; curBank<numRanks*numBanks; curBank++){
+    BankStatus &bank = chan.bankState[curBank];
+    if((bank.state == PRECHARGE) && (globalClock - bank.bankTime >= PreChargeLatency)){
+
+      bank.state = IDLE;
+
+    }else if ((bank.state == ACTIVATING) && (globalClock - bank.bankTime >= RowAccessLatency)){
+
+      bank.state = ACTIVE;
+
+    }else if ((bank.state == ACCESSING) && (globalClock - bank.bankTime >= ColumnAccessLatency)){
+
+      bank.state = ACTIVE;
+
+      for(std::vector<FCFSField*>::iterator it = chan.curMemRequests.begin();
+          it != chan.curMemRequests.end();
+          it++) {
         FCFSField *tempMem = *it;
-		
-		// If current memory request has completed, finish processing the request by sending the proper ACK
-        if((curBank==tempMem->Bank)&&(bankState[curBank].activeRow==tempMem->Row)) {
-
-          I(tempMem->mreq);
-		  
-		      if(tempMem->mreq->isDisp()) tempMem->mreq->ack();  // Fixed doDisp Acknowledge -- LNB 5/28/2014
-          else {
-		      	MemRequest *mreq = tempMem->mreq;
-	      		I(mreq->isReq());
-
-            if (mreq->getAction() == ma_setValid || mreq->getAction() == ma_setExclusive)
-              mreq->convert2ReqAck(ma_setExclusive);
-            else
-              mreq->convert2ReqAck(ma_setDirty);
-
-		      	Time_t delta = globalClock-tempMem->TimeEntered;
-
-            router->scheduleReqAck(mreq,1);  //  Fixed doReq acknowledge -- LNB 5/28/2014
-            avgMemLat.sample(delta,mreq->getStatsFlag());
-          }
-          IS(tempMem->mreq = 0);
-          
-          curMemRequests.erase(it);
 
+        // If current memory request has completed, finish processing the request by sending the proper ACK
+        if((curBank == tempMem->Bank) && (bank.activeRow == tempMem->Row)) {
+          chan.curMemRequests.erase(it);
+          finishRequest(tempMem);
           break;
         }
       }
     }
   }
-  
+
   // Call function to replace any deleted address with a new one from queue
-  transferOverflowMemory();
+  transferOverflowMemory(ch);
   // Call function to determine what the next action should begin
-  scheduleNextAction();
+  scheduleNextAction(ch);
 }
 
-
 // This function adds any pending references in the queue to the buffer if there is space available
-void MemController::transferOverflowMemory(void){
-  while((curMemRequests.size()<=memRequestBufferSize) && (!OverflowMemoryRequests.empty())){
-    curMemRequests.push_back(OverflowMemoryRequests.front());
-    OverflowMemoryRequests.pop();
+void MemController::transferOverflowMemory(uint32_t ch)
+{
+  ChannelStatus &chan = channels[ch];
+  while((chan.curMemRequests.size() <= memRequestBufferSize) && (!chan.OverflowMemoryRequests.empty())){
+    chan.curMemRequests.push_back(chan.OverflowMemoryRequests.front());
+    chan.OverflowMemoryRequests.pop_front();
   }
 }
 
 // This function determines what action can be performed next and schedules a callback for when that action completes
-void MemController::scheduleNextAction(void)
+void MemController::scheduleNextAction(uint32_t ch)
 {
-  uint32_t curBank,curRow;
-  uint32_t oldestReadyColsBank=numBanks+1;
-  uint32_t oldestReadyRowsBank=numBanks+1;
+  ChannelStatus &chan = channels[ch];
+  BankStatus    *bankState = chan.bankState;
+  const uint32_t nBanks    = numRanks*numBanks;
+
+  uint32_t oldestReadyColsBank=nBanks+1;
+  uint32_t oldestReadyRowsBank=nBanks+1;
   uint32_t oldestReadyRow=0;
   uint32_t oldestbank=0;
-  
+
   bool oldestColumnFound=false;
   bool oldestRowFound=false;
   bool oldestBankFound=false;
-  
+
   // Go through memory references in buffer to determine what actions are ready to begin
-  for (uint32_t curReference=0; curReference < curMemRequests.size(); curReference++){
-    curBank=curMemRequests[curReference]->Bank;
-    curRow=curMemRequests[curReference]->Row;
+  for(size_t curReference=0; curReference < chan.curMemRequests.size(); curReference++){
+    uint32_t curBank = chan.curMemRequests[curReference]->Bank;
+    uint32_t curRow  = chan.curMemRequests[curReference]->Row;
     if(!oldestColumnFound){
-      if ((bankState[curBank].state == ACTIVE) &&(bankState[curBank].activeRow==curRow)){
+      if ((bankState[curBank].state == ACTIVE) && (bankState[curBank].activeRow == curRow)){
         bankState[curBank].cpend = true;
         oldestColumnFound=true;
-     //   if(bankState[oldestReadyColsBank].bankTime > bankState[curBank].bankTime){
-          oldestReadyColsBank=curBank;
-     //   }        
+        oldestReadyColsBank=curBank;
       }
     }
-    if((bankState[curBank].state == ACTIVE) &&(bankState[curBank].activeRow!=curRow)){
+    if((bankState[curBank].state == ACTIVE) && (bankState[curBank].activeRow != curRow)){
       bankState[curBank].bpend = true;
-
     }
     if(!oldestRowFound){
       if(bankState[curBank].state == IDLE){
         oldestRowFound=true;
-    //    if(bankState[oldestReadyRowsBank].bankTime > bankState[curBank].bankTime){
-          oldestReadyRow=curMemRequests[curReference]->Row;
-          oldestReadyRowsBank=curBank;
-    //    }
+        oldestReadyRow=curRow;
+        oldestReadyRowsBank=curBank;
       }
     }
-	 if (bankState[curBank].state == INIT) {
-	   oldestBankFound = true;
-	   oldestbank = curBank;
-	 }
-
+    if (bankState[curBank].state == INIT) {
+      oldestBankFound = true;
+      oldestbank = curBank;
+    }
   }
-  
+
   //... and determine if a bank has no pending column references
-  for (uint32_t curBank=0;curBank<numBanks;curBank++){
-    if((bankState[curBank].bpend)&&(!bankState[curBank].cpend)){
+  for(uint32_t curBank=0; curBank<nBanks; curBank++){
+    if((bankState[curBank].bpend) && (!bankState[curBank].cpend)){
       oldestBankFound=true;
       if(bankState[oldestbank].bankTime > bankState[curBank].bankTime){
         oldestbank=curBank;
-      }  
+      }
     }
     bankState[curBank].bpend=false;
     bankState[curBank].cpend=false;
   }
-  
+
   // Now determine which of the ready actions should be start and when the callback should occur
   if(oldestBankFound){
     bankState[oldestbank].state = PRECHARGE;
@@ -314,14 +641,14 @@ void MemController::scheduleNextAction(void)
 
     nPrecharge.inc();
 
-    ManageRamCB::schedule(PreChargeLatency,this);  
+    ManageRamCB::schedule(PreChargeLatency, this, ch);
   } else if(oldestColumnFound){
     bankState[oldestReadyColsBank].state=ACCESSING;
     bankState[oldestReadyColsBank].bankTime=globalClock;
 
     nColumnAccess.inc();
 
-    ManageRamCB::schedule(ColumnAccessLatency,this);
+    ManageRamCB::schedule(ColumnAccessLatency, this, ch);
   } else if (oldestRowFound){
     bankState[oldestReadyRowsBank].state=ACTIVATING;
     bankState[oldestReadyRowsBank].bankTime=globalClock;
@@ -329,24 +656,37 @@ void MemController::scheduleNextAction(void)
 
     nRowAccess.inc();
 
-    ManageRamCB::schedule(RowAccessLatency,this);
+    ManageRamCB::schedule(RowAccessLatency, this, ch);
   }
 }
 
+uint32_t MemController::getChannel(MemRequest *mreq) const
+{
+  const AddrType addr = mreq->getAddr();
+  uint32_t ch = (addr >> channelOffset) & (numChannels - 1);
+  if (xorInterleave)
+    ch ^= (addr >> (rowOffset + log2Banks)) & (numChannels - 1);
+  return ch;
+}
+
 uint32_t MemController::getBank(MemRequest *mreq) const
 {
-  uint32_t bank = (mreq->getAddr()&bankMask) >> bankOffset;
-  return bank;
+  const AddrType addr = mreq->getAddr();
+  uint32_t bank = (addr >> bankOffset) & (numBanks - 1);
+  if (xorInterleave)
+    bank ^= (addr >> rowOffset) & (numBanks - 1);
+  uint32_t rank = (addr >> rankOffset) & (numRanks - 1);
+  return (rank << log2Banks) | bank;
 }
+
 uint32_t MemController::getRow(MemRequest *mreq) const
 {
-  uint32_t row = (mreq->getAddr()&rowMask) >>rowOffset;
+  uint32_t row = (mreq->getAddr() >> rowOffset) & (numRows - 1);
   return row;
 }
 
 uint32_t MemController::getColumn(MemRequest *mreq) const
 {
-  uint32_t column = (mreq->getAddr()&columnMask) >>columnOffset;
+  uint32_t column = (mreq->getAddr() >> columnOffset) & (numColumns - 1);
   return column;
 }
-
@@ -50,28 +50,52 @@
 
 class MemorySystem;
 
-#include <queue>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "pool.h"
 /* }}} */
 
 class MemController: public MemObj {
 protected:
 
-   class FCFSField {
+  class FCFSField {
   public:
-    uint32_t Bank;
+    uint32_t Channel;
+    uint32_t Bank; // bank in the channel (rank * banks per rank + bank)
     uint32_t Row;
     uint32_t Column;
     Time_t TimeEntered;
     MemRequest *mreq;
+    FCFSField *bankPrev; // requests to the same bank, arrival order
+    FCFSField *bankNext;
   };
+  pool<FCFSField> fcfsPool;
+
+  // false: the original scheduler (one command started per request arrival
+  // or command completion, no data bus occupancy). true: per bank FR-FCFS,
+  // banks in parallel, column accesses hold a data bus for portOccp and the
+  // optional DRAM timing below.
+  bool bankParallel;
+
   TimeDelta_t delay;
   TimeDelta_t PreChargeLatency;
   TimeDelta_t RowAccessLatency;
   TimeDelta_t ColumnAccessLatency;
 
+  // Optional DRAM timing (0 disables the constraint)
+  TimeDelta_t tRRD;  // activate to activate, same rank
+  TimeDelta_t tRRDL; // activate to activate, same bank group
+  TimeDelta_t tFAW;  // four activates window, same rank
+  TimeDelta_t tWTR;  // end of write data to read, same rank
+  TimeDelta_t tREFI; // refresh interval of a rank
+  TimeDelta_t tRFC;  // refresh duration, all the banks of the rank close
+
   GStatsCntr nPrecharge;
   GStatsCntr nColumnAccess;
   GStatsCntr nRowAccess;
+  GStatsCntr nRefreshClose;
   GStatsAvg avgMemLat;
   GStatsCntr readHit;
 
@@ -83,33 +107,70 @@ protected:
   ACCESSING,
   INIT  // Added LNB 5/31/2014
 };
-  PortGeneric *cmdPort;
-  
-  uint32_t rowMask;
-  uint32_t columnMask;
-  uint32_t bankMask;
-  uint32_t rowOffset;
+
+  // Address fields, from the least significant bit:
+  //   column | channel | row | bank (bank group is the upper part) | rank
+  // With interleave = "xor" the channel and the bank are XORed with row bits.
   uint32_t columnOffset;
+  uint32_t channelOffset;
+  uint32_t rowOffset;
   uint32_t bankOffset;
-  uint32_t numBanks;
-  uint32_t memRequestBufferSize;
+  uint32_t rankOffset;
+  uint32_t numColumns;
+  uint32_t numRows;
+  uint32_t numBanks;  // banks per rank
+  uint32_t numBankGroups;
+  uint32_t numRanks;  // ranks per channel
+  uint32_t numChannels;
+  uint32_t log2Banks;
+  bool     xorInterleave;
+  uint32_t memRequestBufferSize; // per channel
+
+  TimeDelta_t busOccp; // data bus occupancy of a column access
   
+  typedef std::deque<FCFSField*> RowQueue;
+  typedef std::map<uint32_t, RowQueue> RowMap;
 
   class BankStatus {
   public:
     int state;
     uint32_t activeRow;
-    bool bpend;
+    Time_t bankTime; // start of the last command
+    // Requests in the buffer for this bank: all of them in arrival order,
+    // and per row (the open row entry is the row hit index)
+    FCFSField *head;
+    FCFSField *tail;
+    RowMap rows;
+    FCFSField *accessing; // request being served by the column access
+    bool bpend;           // !bankParallel: row miss / row hit pending
     bool cpend;
-    Time_t bankTime;
   };
-  
-  BankStatus *bankState;
-  
-  typedef std::vector<FCFSField*> FCFSList;
-  FCFSList curMemRequests;
-  typedef std::queue<FCFSField*> FCFSQueue;
-  FCFSQueue OverflowMemoryRequests;
+
+  class RankStatus {
+  public:
+    Time_t   lastAct;      // 0 -- none yet
+    uint32_t lastActGroup;
+    Time_t   actWindow[4]; // last four activates (ring)
+    uint32_t actPos;
+    Time_t   lastWriteEnd;
+    Time_t   refPhase;     // ranks refresh staggered
+  };
+
+  typedef std::deque<FCFSField*> FCFSQueue;
+
+  // A channel only touches its own state, so channels advance independently
+  class ChannelStatus {
+  public:
+    BankStatus *bankState;  // numRanks * numBanks
+    RankStatus *rankState;
+    Time_t     *busFree;    // numPorts data buses
+    uint32_t    nBuses;
+    uint32_t    nBuffered;  // requests in the bank queues (up to memRequestBufferSize+1)
+    FCFSQueue   OverflowMemoryRequests;
+    std::vector<FCFSField*> curMemRequests; // !bankParallel request buffer
+  };
+
+  ChannelStatus *channels;
 
 public:
   MemController(MemorySystem* current, const char *device_descr_section, const char *device_name = NULL);
@@ -134,24 +195,36 @@ public:
 
 	bool isBusy(AddrType addr) const;
 
+  void checkpoint(Checkpoint *ck);
+
   uint16_t getLineSize() const;
 
-  void manageRam(void);
+  // A bank finished its precharge/activate/column access
+  void bankDone(uint32_t ch, uint32_t bank);
+  typedef CallbackMember2<MemController, uint32_t, uint32_t, &MemController::bankDone> BankDoneCB;
 
-  typedef CallbackMember0<MemController, &MemController::manageRam>   ManageRamCB;
- // typedef CallbackMember0<MemController, &MemController::manageRam>   ManageRamCB;  // Added by LNB 5/27/2014
+  // !bankParallel: update the banks of the channel and start the next command
+  void manageRam(uint32_t ch);
+  typedef CallbackMember1<MemController, uint32_t, &MemController::manageRam> ManageRamCB;
 
   TimeDelta_t ffread(AddrType addr, DataType data);
   TimeDelta_t ffwrite(AddrType addr, DataType data);
   void        ffinvalidate(AddrType addr, int32_t lineSize);
   private:
+  uint32_t getChannel(MemRequest *mreq) const;
   uint32_t getBank(MemRequest *mreq) const;
   uint32_t getRow(MemRequest *mreq) const;
   uint32_t getColumn(MemRequest *mreq) const;
   void addMemRequest(MemRequest *mreq);
-  
-  void transferOverflowMemory(void);
-  void scheduleNextAction(void);
+  void enqueue(FCFSField *entry);
+  void dequeue(FCFSField *entry);
+  void scheduleBank(uint32_t ch, uint32_t bank);
+  void finishRequest(FCFSField *entry);
+  void transferOverflowMemory(uint32_t ch);
+  void scheduleNextAction(uint32_t ch);
+
+  Time_t refreshFree(const RankStatus &rank, Time_t t) const;
+  bool   refreshedSince(const RankStatus &rank, Time_t t0, Time_t t1) const;
   
 };
 
@@ -180,6 +180,18 @@ bool StridePrefetcher::isBusy(AddrType addr) const
 }
 /* }}} */
 
+void StridePrefetcher::checkpoint(Checkpoint *ck)
+/* save/restore the stream buffer and the stride table {{{1 */
+{
+  char cadena[256];
+
+  sprintf(cadena, "%s_buff", getName());
+  buff->checkpoint(ck, cadena);
+  sprintf(cadena, "%s_table", getName());
+  table->checkpoint(ck, cadena);
+}
+/* }}} */
+
 TimeDelta_t StridePrefetcher::ffread(AddrType addr)
   /* fast forward reads {{{1 */
 { 
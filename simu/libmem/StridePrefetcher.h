@@ -70,6 +70,12 @@ PfState(int32_t lineSize) {
 uint32_t stride;
 bool goingUp;
 
+void checkpoint(Checkpoint *ck) {
+StateGeneric<AddrType>::checkpoint(ck);
+ck->io(stride);
+ck->io(goingUp);
+}
+
 AddrType nextAddr(CacheGeneric<PfState,AddrType> *c) {
 AddrType preaddr = c->calcAddr4Tag(getTag());
 return (goingUp ? (preaddr + stride) : (preaddr - stride));
@@ -192,6 +198,8 @@ public:
 
 	bool isBusy(AddrType addr) const;
 
+  void checkpoint(Checkpoint *ck);
+
 //typedef CallbackMember1<StridePrefetcher, AddrType, &StridePrefetcher::processAck> processAckCB;
   Time_t nextBuffSlot() {
     return buffPort->nextSlot(true);
@@ -203,6 +203,13 @@ bool TLB::isBusy(AddrType addr) const
 }
 /* }}} */
 
+void TLB::checkpoint(Checkpoint *ck)
+/* save/restore the translations {{{1 */
+{
+  tlbBank->checkpoint(ck, getName());
+}
+/* }}} */
+
 void TLB::readPage1(MemRequest *mreq) 
 {
   MemRequest::sendReqRead(
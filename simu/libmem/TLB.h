@@ -163,6 +163,8 @@ public:
 
 	bool isBusy(AddrType addr) const;
 
+  void checkpoint(Checkpoint *ck);
+
   //TLB specific
   void readPage1(MemRequest *mreq);
   void readPage2(MemRequest *mreq);
@@ -14,6 +14,7 @@ Message::Message()
     ,forwardMsgCB(this)
     ,receiveMsgCB(this)
     ,notifyMsgCB(this)
+    ,inLink(0)
 {
 #ifdef DEBUG
   msgID = gMsgCount++;
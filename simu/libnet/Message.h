@@ -11,6 +11,7 @@
 #include "NetIdentifiers.h"
 
 class Router;
+class RouterLink;
 class InterConnection;
 
 class Message {
@@ -73,6 +74,10 @@ protected:
 
   uint32_t refCount; // number of references counter 
 
+  RouterLink *inLink;  //!< link that brought the message (credits to release)
+  int32_t     inVC;
+  int32_t     inEntry;
+
   Message();
   virtual ~Message() {
     // Useless, but removes a warning in gcc
@@ -90,6 +95,7 @@ protected:
     delivery = d;
     finished = false;
     refCount = 1;
+    inLink   = 0;
 
     IS(nSize   = 0); // setSize must be called later
   }
@@ -14,7 +14,7 @@ Router::Router(const char *section, RouterID_t id,
    ,localOcc(SescConf->getInt(section, "localOcc"))
    ,localPort(SescConf->getInt(section, "localPort"))
    ,congestionFree(SescConf->getBool(section, "congestionFree"))
-   ,addFixDelay(SescConf->getBool(section, "addFixDelay"))
+   ,addFixDelay(SescConf->getInt(section, "addFixDelay"))
    ,net(n)
    ,rTable(rt)
 
@@ -31,6 +31,17 @@ Router::Router(const char *section, RouterID_t id,
 
   SescConf->isBool(section, "congestionFree");
 
+  nVCs = 1;
+  if (SescConf->checkInt(section, "nVCs")) {
+    nVCs = SescConf->getInt(section, "nVCs");
+    SescConf->isBetween(section, "nVCs", 1, 64);
+  }
+  bufferFlits = 0;
+  if (SescConf->checkInt(section, "bufferFlits")) {
+    bufferFlits = SescConf->getInt(section, "bufferFlits");
+    SescConf->isBetween(section, "bufferFlits", 0, 1024);
+  }
+
   maxLocalPort = PortID_t(static_cast<int>(LOCAL_PORT1)+localNum);
   
   I(maxLocalPort>LOCAL_PORT1);
@@ -39,7 +50,7 @@ Router::Router(const char *section, RouterID_t id,
   // Initialize ports
   l2rPort.resize(MAX_PORTS);
   r2lPort.resize(MAX_PORTS);
-  r2rPort.resize(MAX_PORTS);
+  r2rLink.resize(MAX_PORTS);
 
   for(PortID_t i=LOCAL_PORT1;i<maxLocalPort;i++) {
     char name[256];
@@ -52,11 +63,7 @@ Router::Router(const char *section, RouterID_t id,
     r2lPort[i] = PortGeneric::create(name,localPort,localOcc);
   }
   for(PortID_t i=DISABLED_PORT;i<rTable->getnPorts();i++) {
-    char name[256];
-    int32_t ret = snprintf(name,127,"r2rPort(%d-%d)",myID,i+1);
-    I(ret > 0);
-
-    r2rPort[i+1] = PortGeneric::create(name,1,1);
+    r2rLink[i+1] = new RouterLink(nVCs, bufferFlits);
   }
   
 
@@ -72,7 +79,8 @@ Router::Router(const char *section, RouterID_t id,
 
 Router::~Router()
 {
-  // nothing to do
+  for(size_t i=0;i<r2rLink.size();i++)
+    delete r2rLink[i];
 }
 
 void Router::launchMsg(Message *msg)
@@ -115,18 +123,10 @@ void Router::launchMsg(Message *msg)
     dstRouter->receiveMsg(msg);
 
   } else {
-   
-    //JUDITH commented this out because
-     // occupySlots not defined anywhere in esesc
-//    Time_t when = l2rPort[portid]->occupySlots(calcNumFlits(msg)); //original code
-      Time_t when = l2rPort[portid]->nextSlot(true);
-         for(int i = 0; i < calcNumFlits(msg); i++){
-            l2rPort[portid]->nextSlot(true);
-         }
-   //   printf("%d\n", when);
-     
-      when+=addFixDelay;
-  
+    Time_t when = l2rPort[portid]->occupySlots(calcNumFlits(msg), true);
+
+    when+=addFixDelay;
+
     if (congestionFree)
       msg->receiveMsgAbs(when,dstRouter);
     else
@@ -175,13 +175,16 @@ void Router::forwardMsg(Message *msg)
     wire = 0;
   }
 
-//  JUDITH commented this out because
-//  occupySlots not defined anywhere in esesc
-//  Time_t when = r2rPort[wire->port]->occupySlots(calcNumFlits(msg));
- Time_t when = r2rPort[wire->port]->nextSlot(true);
-      for(int i = 0; i < calcNumFlits(msg); i++){
-         r2rPort[wire->port]->nextSlot(true);
-      }
+  ushort  nFlits = calcNumFlits(msg);
+  int32_t vc;
+  int32_t entry;
+  RouterLink *link = r2rLink[wire->port];
+  Time_t when = link->reserve(nFlits, wire->dist, crossLat, vc, entry);
+
+  releaseInput(msg, nFlits, when);
+  msg->inLink  = link;
+  msg->inVC    = vc;
+  msg->inEntry = entry;
 
   // MSG("%lld router::forwardMsg %d->%d",globalClock,myID, wire->rID);
 
@@ -197,19 +200,12 @@ void Router::receiveMsg(Message *msg)
   PortID_t portid = msg->getDstPortID();
   I(r2lPort[portid]);
 
-//  JUDITH commented this out because
-//  occupySlots not defined anywhere in esesc
-//
-//  Time_t when = r2lPort[portid]->occupySlots(calcNumFlits(msg));
-    Time_t when = r2lPort[portid]->nextSlot(true);
-       for(int i = 0; i < calcNumFlits(msg); i++){
-          r2lPort[portid]->nextSlot(true);
-      }
-
-
+  ushort nFlits = calcNumFlits(msg);
+  Time_t when   = r2lPort[portid]->occupySlots(nFlits, true);
+  releaseInput(msg, nFlits, when);
 
   // MSG("dstport:%d srcport:%d router:%d",portid,msg->getSrcPortID(),myID);
-  msg->notifyMsgAbs(when + calcNumFlits(msg), this);
+  msg->notifyMsgAbs(when + nFlits, this);
 }
 
 void Router::notifyMsg(Message *msg)
@@ -231,15 +227,16 @@ void Router::notifyMsg(Message *msg)
   // notify the network that it does not want a message. (Too many
   // freaking details, sorry)
 
-  ProtHandlersType::iterator it = localPortProtocol.find(msg->getUniqueProtID());
-  GLOG(it==localPortProtocol.end(),
+  size_t pos = protIndex(msg->getUniqueProtID());
+  ProtocolCBBase *pcb = pos < localPortProtocol.size() ? localPortProtocol[pos] : 0;
+  GLOG(pcb==0,
        "Router[%d]::receiveMsg no one accepts packet in router[%d:%d] (uniqueID=%d)\n", 
        myID, 
        msg->getDstRouterID(),
        msg->getDstPortID(),
        msg->getUniqueProtID());
 
-  it->second->call(msg);
+  pcb->call(msg);
 
   // TODO: decrease destroy. (GC destroy)
 }
@@ -249,13 +246,36 @@ void Router::dump()
   fprintf(stderr, "Router #%d\n", myID);
 }
 
+size_t Router::protIndex(int32_t id)
+{
+  // id is PMessage::getUniqueProtID: device in the upper 16 bits, message type in the lower
+  uint32_t uid = static_cast<uint32_t>(id);
+  I((uid & 0xFFFF) < MaxMessageType);
+  return (uid >> 16) * MaxMessageType + (uid & 0xFFFF);
+}
+
 void Router::registerProtocol(ProtocolCBBase *pcb, PortID_t pID, int32_t id)
 {
-  I(localPortProtocol.find(id) == localPortProtocol.end());
-  localPortProtocol[id] = pcb;
+  size_t pos = protIndex(id);
+  if (pos >= localPortProtocol.size())
+    localPortProtocol.resize(pos+1, 0);
+
+  I(localPortProtocol[pos] == 0);
+  localPortProtocol[pos] = pcb;
+}
+
+// The flits leave the input buffer one per cycle from firstLeave on. A
+// RCV_AND_PASS message is ejected and forwarded, the later one frees the entry.
+void Router::releaseInput(Message *msg, ushort nFlits, Time_t firstLeave)
+{
+  if (msg->inLink)
+    msg->inLink->release(msg->inVC, msg->inEntry, nFlits, firstLeave);
 }
 
+// ceil(size/linkBytes) in bits: linkBits may not be a multiple of 8
 ushort Router::calcNumFlits(Message *msg) const {
-  return (ushort) ceil(msg->getSize() / net->getLinkBytes());
+  uint32_t bits = net->getLinkBits();
+  ushort n = (ushort) ((msg->getSize()*8 + bits - 1) / bits);
+  return n ? n : 1; // the head flit is always sent
 }
 
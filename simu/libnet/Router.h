@@ -10,6 +10,7 @@
 #include "Port.h"
 #include "ProtocolCB.h"
 #include "RoutingTable.h"
+#include "RouterLink.h"
 
 class Message;
 class InterConnection;
@@ -23,6 +24,9 @@ class InterConnection;
  * involved. Once the message arrives to the destination, receiveMsg is invoked.
  *
  * Routers have virtual channels with turn based port selection. (The best according to Martinez)
+ * The router to router links have nVCs virtual channels with bufferFlits entries each and credit
+ * based flow control (see RouterLink). All the flits of a message cross a link in one event. The
+ * credits of the input buffer return when the message is forwarded or ejected (releaseInput).
  *
  * This implementation of Router assume in many places that the links are unidirectional. This means
  * that for each port there are two dedicated links (input and output).
@@ -43,6 +47,8 @@ private:
 
   const bool congestionFree;     //!< Skip the router modeling (just local ports)
   const TimeDelta_t addFixDelay; //!< fix delay to add to the network forwarding
+  int32_t nVCs;                  //!< Virtual channels per router to router link [1..64]
+  int32_t bufferFlits;           //!< Input buffer entries per VC, 0 is unlimited [0..1024]
   // End Configuration parameters
 
   PortID_t maxLocalPort;
@@ -51,17 +57,19 @@ private:
 
   RoutingTable *rTable;
 
-  typedef HASH_MAP<int32_t,ProtocolCBBase*> ProtHandlersType;
+  //! Protocol handlers by protIndex(uniqueID), looked up on every delivery
+  std::vector<ProtocolCBBase *> localPortProtocol;
 
-  ProtHandlersType localPortProtocol;
+  static size_t protIndex(int32_t id);
 
   std::vector<PortGeneric *> l2rPort; //!< ports from local device to router
   std::vector<PortGeneric *> r2lPort; //!< ports from router to local device
-  std::vector<PortGeneric *> r2rPort; //!< ports from router to router (output)
+  std::vector<RouterLink *>  r2rLink; //!< links from router to router (output)
 
 protected:
 
   ushort calcNumFlits(Message *msg) const;
+  void releaseInput(Message *msg, ushort nFlits, Time_t firstLeave);
 
 public:	
   Router(const char *section, RouterID_t id, InterConnection *n, RoutingTable *rt);
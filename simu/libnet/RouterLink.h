@@ -0,0 +1,118 @@
+#ifndef ROUTERLINK_H
+#define ROUTERLINK_H
+
+#include <vector>
+
+#include "nanassert.h"
+#include "callback.h"
+
+/*! \class RouterLink
+ * \brief Output link between two routers with virtual channels and credits
+ *
+ * The link moves one flit per cycle. Each virtual channel has bufferFlits
+ * entries in the input buffer of the next router, and a flit needs a credit
+ * (a free entry) to cross. The credit comes back when the flit leaves the
+ * next router and the credit wire brings it back.
+ *
+ * When a flit crosses, its entry is held at least until the flit could leave
+ * the next router (wire + crossing + credit wire). The next router calls
+ * release() when it forwards (or ejects) the message, and a flit stalled
+ * there keeps the entry busy until it actually leaves. A congested router
+ * then delays the senders behind it (backpressure). A flit reserved before
+ * the release only sees the earliest time (one hop of lag).
+ *
+ * Nothing is scheduled per flit or per cycle: reserve() computes when each
+ * flit of the message crosses from the state of the link, so the router
+ * schedules one event per hop and an idle link costs nothing.
+ *
+ * bufferFlits == 0 means unlimited buffers (no credit stalls).
+ */
+class RouterLink {
+private:
+  const int32_t nVCs;
+  const int32_t bufferFlits;
+
+  TimeDelta_t creditDist;    //!< wire latency of the credit (same wire)
+
+  Time_t linkFree;           //!< first cycle the wire is not used
+  std::vector<Time_t> credit; //!< per VC (bufferFlits each), when each entry is free
+  std::vector<int32_t> head;  //!< per VC, next entry (they are used in FIFO order)
+
+public:
+  RouterLink(int32_t nvc, int32_t buf)
+    : nVCs(nvc)
+    ,bufferFlits(buf)
+    ,creditDist(0)
+    ,linkFree(0) {
+    I(nVCs>0);
+    I(bufferFlits>=0);
+    credit.resize(nVCs*bufferFlits, 0);
+    head.resize(nVCs, 0);
+  }
+
+  //! Sends nFlits back to back through the VC with the first free entry.
+  //! dist is the wire latency and crossLat the crossing latency of the
+  //! next router. Returns when the head flit crosses the link, and the
+  //! entries used (vc, entry) for the release() by the next router.
+  Time_t reserve(int32_t nFlits, TimeDelta_t dist, TimeDelta_t crossLat, int32_t &vcUsed, int32_t &entry) {
+    I(nFlits>0);
+
+    Time_t t = linkFree < globalClock ? globalClock : linkFree;
+
+    if (bufferFlits == 0) {
+      vcUsed   = 0;
+      entry    = 0;
+      linkFree = t + nFlits;
+      return t;
+    }
+
+    int32_t vc = 0;
+    for(int32_t i=1;i<nVCs;i++) {
+      if (credit[i*bufferFlits+head[i]] < credit[vc*bufferFlits+head[vc]])
+        vc = i;
+    }
+
+    Time_t *buf  = &credit[vc*bufferFlits];
+    int32_t h    = head[vc];
+    Time_t start = 0;
+    vcUsed       = vc;
+    entry        = h;
+    creditDist   = dist;
+    for(int32_t i=0;i<nFlits;i++) {
+      if (t < buf[h])
+        t = buf[h]; // wait for the credit
+      if (i==0)
+        start = t;
+      buf[h] = t + dist + crossLat + dist;
+      h++;
+      if (h == bufferFlits)
+        h = 0;
+      t++;
+    }
+    head[vc] = h;
+    linkFree = t;
+
+    return start;
+  }
+
+  //! The next router sends the nFlits of a message (reserved at vc, entry)
+  //! one per cycle from firstLeave on. Their credits can not come back
+  //! before the credit wire brings them.
+  void release(int32_t vc, int32_t entry, int32_t nFlits, Time_t firstLeave) {
+    if (bufferFlits == 0)
+      return;
+
+    Time_t *buf = &credit[vc*bufferFlits];
+    int32_t h   = entry;
+    for(int32_t i=0;i<nFlits;i++) {
+      Time_t c = firstLeave + i + creditDist;
+      if (buf[h] < c)
+        buf[h] = c;
+      h++;
+      if (h == bufferFlits)
+        h = 0;
+    }
+  }
+};
+
+#endif // ROUTERLINK_H
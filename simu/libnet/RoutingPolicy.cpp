@@ -43,6 +43,7 @@ void RoutingPolicy::make(const char* section)
 	table[i]->addNeighborWire(j,adjacent[i][j][k]);
       }
     }
+    table[i]->freeze();
     if (next[i])
       table[i]->setNextWire(next[i]);
   }
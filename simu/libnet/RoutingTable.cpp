@@ -18,6 +18,7 @@ RoutingTable::RoutingTable(const char *section, RouterID_t id,  size_t size, Por
   : myID(id)
     ,fixMessagePath(SescConf->getBool(section,"fixMessagePath"))
     ,nPorts(np)
+    ,next(0)
 {
   SescConf->isBool(section,"fixMessagePath");
   
@@ -30,6 +31,8 @@ RoutingTable::~RoutingTable()
 
 void RoutingTable::addNeighborWire(RouterID_t id, const Wire &wire)
 {
+  I(wires.empty()); // no wires after freeze
+
   while( nextHop.size() < id ) {
     nextHop.push_back(Wires4Router());
   }
@@ -62,26 +65,30 @@ void RoutingTable::addNeighborWire(RouterID_t id, const Wire &wire)
   nextHop[id].succs.push_back(wire);
 }
 
-const RoutingTable::Wire *RoutingTable::getWire(RouterID_t destid) 
+void RoutingTable::freeze()
 {
-  size_t pos = nextHop[destid].prevTurn+1;
-  I(!nextHop[destid].succs.empty());
-  
-  if( fixMessagePath || pos >= nextHop[destid].succs.size()  )
-    pos=0;
+  size_t size = nextHop.size();
 
-  nextHop[destid].prevTurn = pos;
-  
-  return &nextHop[destid].succs[pos];
+  firstWire.resize(size);
+  nWires.resize(size);
+  prevTurn.resize(size);
+
+  for(size_t i=0;i<size;i++) {
+    firstWire[i] = wires.size();
+    nWires[i]    = nextHop[i].succs.size();
+    prevTurn[i]  = 0;
+    I(nWires[i] == nextHop[i].succs.size()); // fits in 16 bits
+    wires.insert(wires.end(), nextHop[i].succs.begin(), nextHop[i].succs.end());
+  }
+
+  nextHop.clear();
 }
 
 const RoutingTable::Wire *RoutingTable::getPortWire(RouterID_t id, PortID_t port) const 
 {
-  size_t nSuccs = nextHop[id].succs.size();
-  
-  for(size_t i=0 ; i<nSuccs ; i++ ) {
-    if( nextHop[id].succs[i].port == port )
-      return &nextHop[id].succs[i];
+  for(size_t i=firstWire[id] ; i<firstWire[id]+nWires[id] ; i++ ) {
+    if( wires[i].port == port )
+      return &wires[i];
   }
 
   I(0);
@@ -90,11 +97,10 @@ const RoutingTable::Wire *RoutingTable::getPortWire(RouterID_t id, PortID_t port
 
 void RoutingTable::dump()
 {
-  for(size_t i = 0; i < nextHop.size(); i++) {
+  for(size_t i = 0; i < firstWire.size(); i++) {
     printf("From %d to %zu : ", myID, i);
-    for (std::vector<Wire>::iterator iter = nextHop[i].succs.begin();
-	 iter != nextHop[i].succs.end(); iter++) {
-      printf(",%d port %d in %d clks ", iter->rID, iter->port, iter->dist);
+    for (size_t j = firstWire[i]; j < firstWire[i]+nWires[i]; j++) {
+      printf(",%d port %d in %d clks ", wires[j].rID, wires[j].port, wires[j].dist);
     }
     printf("\n");
   }
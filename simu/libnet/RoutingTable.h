@@ -45,9 +45,16 @@ protected:
     int32_t prevTurn;
   };
   
-  std::vector<Wires4Router> nextHop;
+  std::vector<Wires4Router> nextHop; // only while the table is built (see freeze)
   Wire* next; /* next in broadcast (see Message::Type or ask Karin) */
 
+  // Flat table used by getWire: the wires to reach router i are
+  // wires[firstWire[i]..firstWire[i]+nWires[i])
+  std::vector<Wire>     wires;
+  std::vector<uint32_t> firstWire;
+  std::vector<uint16_t> nWires;
+  std::vector<uint16_t> prevTurn;
+
   const Wire *getPortWire(RouterID_t id, PortID_t port) const;
 
 public:
@@ -55,7 +62,18 @@ public:
   RoutingTable(const char *section, RouterID_t id, size_t size, PortID_t np);
   virtual ~RoutingTable();
 
-  const Wire *getWire(RouterID_t destid);
+  const Wire *getWire(RouterID_t destid) {
+    I(destid < nWires.size());
+    I(nWires[destid] > 0);
+    uint16_t pos = 0;
+    if (!fixMessagePath && nWires[destid] > 1) {
+      pos = prevTurn[destid] + 1;
+      if (pos >= nWires[destid])
+        pos = 0;
+      prevTurn[destid] = pos;
+    }
+    return &wires[firstWire[destid] + pos];
+  }
 
   void setNextWire(Wire* w) { next = w; }
   const Wire *getNextWire() const { return next; }
@@ -65,6 +83,7 @@ public:
   }
 
   void addNeighborWire(RouterID_t id, const Wire &succs);
+  void freeze(); //!< Called once all the wires are added
 
   const Wire *getUpWire(RouterID_t id) const { 
     return getPortWire(id,UP_PORT);
@@ -45,6 +45,7 @@
 
 #include "SamplerSMARTS.h"
 #include "SamplerPeriodic.h"
+#include "SamplerSimPoint.h"
 
 #ifdef ENABLE_CUDA
 #include "SamplerGPUSim.h"
@@ -61,6 +62,7 @@
 #include "../libmem/MemorySystem.h"
 
 #include "Report.h"
+#include "GStatsBin.h"
 #include "SescConf.h"
 #include "DrawArch.h"
 
@@ -121,6 +123,12 @@ void BootLoader::check()
 void BootLoader::reportOnTheFly(const char *file) {
   char *tmp;
 
+  if (GStatsBin::isOpen()) {
+    // Only a new row, the configuration is already in the first report
+    GStatsBin::append("partial");
+    return;
+  }
+
   if( !file )
     file = reportFile;
 
@@ -255,6 +263,8 @@ EmuSampler *BootLoader::getSampler(const char *section, const char *keyword, Emu
     sampler = new SamplerSMARTS("TASS",sampler_sec,eint, fid);
   }else if(strcasecmp(sampler_type,"time") == 0 ) {
     sampler = new SamplerPeriodic("TBS",sampler_sec,eint, fid);
+  }else if(strcasecmp(sampler_type,"SPoint") == 0 ) {
+    sampler = new SamplerSimPoint("SPoint",sampler_sec,eint, fid);
 #ifdef ENABLE_CUDA
   }else if(strcasecmp(sampler_type,"GPUSpacial") == 0 ) {
     I(strcasecmp(sampler_type,"GPUSpacial")==0);
@@ -368,6 +378,14 @@ void BootLoader::plug(int argc, const char **argv) {
   }
 
   Report::openFile(reportFile);
+
+  if (SescConf->checkBool("","reportBinary") && SescConf->getBool("","reportBinary")) {
+    // GStats go to esesc_xxx.stb (see main/statsbin.cpp to get the text back)
+    char *bin = (char *)malloc(strlen(Report::getNameID())+5);
+    sprintf(bin,"%s.stb",Report::getNameID());
+    GStatsBin::open(bin);
+    free(bin);
+  }
   
   SescConf->getDouble("technology","frequency"); // Just read it to get it in the dump
 
@@ -425,6 +443,7 @@ void BootLoader::unplug() {
 #endif
 
   TaskHandler::unplug();
+  GStatsBin::close();
 #ifdef ESESC_POWERMODEL
   if (doPower)
     pwrmodel->unplug();
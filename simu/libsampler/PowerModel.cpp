@@ -164,6 +164,7 @@ void PowerModel::updateActivity(uint64_t timeinterval, FlowID fid)
 {
   // Update stats that are passed to McPat
   timeInterval = timeinterval;
+  activitySnap.update();
   PowerStats *pwrstat = 0;
   uint32_t zcnt = 0;
   for(size_t i        = 0; i < stats->size(); i++) {
@@ -183,22 +184,14 @@ void PowerModel::updateActivity(uint64_t timeinterval, FlowID fid)
 #endif
 
   // Update internal performance counters
-  GStats *gref = 0;
-  char str[128];
-
   for (size_t i=0; i<ncores; i++) {
-
-    sprintf(str,"S(%lu):globalClock_Timing", i);
-    gref = GStats::getRef(str); 
-    I(gref);
-    uint64_t cticks = gref->getSamples(); // clockTicks
-    if (cticks - clockPrev[i] == 0) {
+    Time_t cticks = static_cast<Time_t>(activitySnap.getDelta(clockIdx[i])); // clockTicks
+    if (cticks == 0) {
       I(0);
       clockInterval[i]  = 0;
     }else{
-      clockInterval[i]    =  cticks - clockPrev[i]; // + 1000;
+      clockInterval[i]    =  cticks; // + 1000;
     }
-    clockPrev[i]        =  cticks;
   }
 
   // Just use the total stats, not average
@@ -808,7 +801,7 @@ void PowerModel::readStatsFromConfFile(const char *section) {
     std::strncpy(new_str, start, len);
     new_str[len] = '\0';
 
-    PowerStats *pwrstat = new PowerStats(new_str);
+    PowerStats *pwrstat = new PowerStats(new_str, &activitySnap);
 
     while (*end) {
       len = 0;
@@ -860,8 +853,14 @@ void PowerModel::initPowerModel(const char *section) {
   //mcpatWrapper->plug(section, activity, energyCntrNames, leakageCntrValues, deviceTypes, energyCntrAreas, energyCntrTDPs, sysConn, coreConn, &coreEIdx, &ncores, &nL2, &nL3, coreIndex, gpuIndex, true);
   mcpatWrapper->plug(section, activity, energyBundle, &coreEIdx, &ncores, &nL2, &nL3, coreIndex, gpuIndex, false);
   I(ncores == (uint32_t)SescConf->getRecordSize("","cpusimu"));
-  clockPrev.resize(ncores);
   clockInterval.resize(ncores);
+  clockIdx.resize(ncores);
+  for (size_t i=0; i<ncores; i++) {
+    char str[128];
+    sprintf(str,"S(%lu):globalClock_Timing", i);
+    clockIdx[i] = activitySnap.add(str);
+    I(clockIdx[i] >= 0);
+  }
   temperatures->resize(energyBundle->cntrs.size(), INITIAL_TEMP);
 
   powerGlue.dumpFlpDescr(coreEIdx);
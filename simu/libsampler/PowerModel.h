@@ -63,6 +63,8 @@ private:
     Others
   }samplerType;
   std::vector<PowerStats *> *stats;
+  GStatsSnapshot            activitySnap; // all the stats read by stats and clockIdx
+  std::vector<int32_t>      clockIdx;     // S(i):globalClock_Timing
 
   PowerGlue powerGlue;
 
@@ -104,7 +106,6 @@ private:
   uint32_t updateInterval;
   uint64_t instCountCurrent;
   uint64_t instCountPrev;
-  std::vector<Time_t>  clockPrev ;
   std::vector<Time_t>  clockInterval ;
   uint64_t timeInterval;
   double  freq;
@@ -41,6 +41,7 @@
 #include "GProcessor.h"
 #include "GMemorySystem.h"
 #include "Report.h"
+#include "GStatsBin.h"
 
 #include <iostream>
 
@@ -56,6 +57,7 @@ GStatsMax *SamplerBase::progressedTime = 0;
 
 SamplerBase::SamplerBase(const char *iname, const char *section, EmulInterface *emu, FlowID fid)
   : EmuSampler(iname, emu, fid)
+  ,checkpointCB(this)
   /* SamplerBase constructor {{{1 */
 {
   if (progressedTime==0)
@@ -76,6 +78,37 @@ SamplerBase::SamplerBase(const char *iname, const char *section, EmulInterface *
   maxnsTime   = static_cast<uint64_t>(SescConf->getDouble(section,"maxnsTime"));
   SescConf->isBetween(section,"maxnsTime",1,1e12);
 
+  checkpointSave  = 0;
+  checkpointLoad  = 0;
+  checkpointCk    = 0;
+  nInstCheckpoint = 0;
+  if (fid == 0) {
+    if (SescConf->checkCharPtr(section,"checkpointSave"))
+      checkpointSave = SescConf->getCharPtr(section,"checkpointSave");
+    if (SescConf->checkDouble(section,"checkpointInst"))
+      nInstCheckpoint = static_cast<uint64_t>(SescConf->getDouble(section,"checkpointInst"));
+
+    if (SescConf->checkCharPtr(section,"checkpointLoad")) {
+      const char *fname = SescConf->getCharPtr(section,"checkpointLoad");
+      if (checkpointSave) {
+        MSG("ERROR: sampler section [%s] can not have both checkpointSave and checkpointLoad", section);
+        SescConf->notCorrect();
+      }
+      checkpointLoad = Checkpoint::open(fname);
+      if (checkpointLoad == 0) {
+        MSG("ERROR: could not open checkpoint [%s] from section [%s]", fname, section);
+        exit(-2);
+      }
+      // Skip to the snapshot, the restore happens at the first mode switch
+      nInstSkip = checkpointLoad->getKey();
+    }
+  }
+
+  nInstReport = 0;
+  if (fid == 0 && SescConf->checkDouble("","reportBinaryInterval"))
+    nInstReport = static_cast<uint64_t>(SescConf->getDouble("","reportBinaryInterval"));
+  nextReport = nInstReport;
+
   if (nInstWarmup>0) {
     sequence_mode.push_back(EmuWarmup);
     sequence_size.push_back(nInstWarmup);
@@ -133,6 +166,7 @@ SamplerBase::SamplerBase(const char *iname, const char *section, EmulInterface *
   GProcessor *gproc = TaskHandler::getSimu(fid);
   MemObj *mobj      =  gproc->getMemorySystem()->getDL1();
   DL1 = mobj;
+  nWarmupBatch = 0;
 
   double ninst_d = SescConf->getDouble(section,"nInstDetail");
   double ninst_t = SescConf->getDouble(section,"nInstTiming");
@@ -152,10 +186,35 @@ void SamplerBase::doWarmupOpAddr(char op, uint64_t addr) {
   I(mode == EmuWarmup);
 	I(emul->cputype != GPU);
 
+  bool write;
 	if ( (op&0x3F) == 1)
-		DL1->ffread(addr);
+    write = false;
 	else if ( (op&0x3F) == 2)
-		DL1->ffwrite(addr);
+    write = true;
+  else
+    return;
+
+  FFAccess &acc = warmupBatch[nWarmupBatch++];
+  acc.addr  = addr;
+  acc.write = write;
+
+  if (nWarmupBatch == WarmupBatchSize) {
+    MemObj::ffQueue(DL1, warmupBatch, nWarmupBatch);
+    nWarmupBatch = 0;
+  }
+}
+// 1}}}
+
+void SamplerBase::flushWarmup()
+  // {{{1 apply the buffered warmup accesses before a mode switch
+{
+  if (nWarmupBatch) {
+    MemObj::ffQueue(DL1, warmupBatch, nWarmupBatch);
+    nWarmupBatch = 0;
+  }
+
+  // The simulation thread applies the batches between cycles
+  MemObj::ffWaitQueued();
 }
 // 1}}}
 
@@ -293,7 +352,112 @@ FILE *SamplerBase::genReportFileNameAndOpen(const char *str) {
 }
 
 
+void SamplerBase::checkpointState(Checkpoint *ck)
+  // {{{1 walk all the objects with warm state
+{
+  if (ck->beginSection(Checkpoint::Independent, Checkpoint::signature(sequence_mode.size()), "S(%d)_sequence", sFid)) {
+    uint64_t pos = sequence_pos;
+    ck->io(pos);
+    sequence_pos = pos;
+    ck->endSection();
+  }
+
+  for(FlowID i=0;i<TaskHandler::getNumCPUS();i++)
+    TaskHandler::getSimu(i)->checkpoint(ck);
+
+  GMemorySystem::checkpointShared(ck);
+}
+// 1}}}
+
+void SamplerBase::checkpointQuiescent()
+  // {{{1 simulation thread, nothing in flight: save or restore checkpointCk
+{
+  I(checkpointCk);
+  I(EventScheduler::empty()); // No MSHR, upReq or downReq in the caches
+
+  if (checkpointCk == checkpointLoad) {
+    // Probe first, the cache hierarchy is restored all or nothing
+    checkpointCk->setProbe(true);
+    checkpointState(checkpointCk);
+    checkpointCk->setProbe(false);
+  }
+  checkpointState(checkpointCk);
+}
+// 1}}}
+
+void SamplerBase::doCheckpoint()
+  // {{{1 save or restore the warm state at a mode switch
+{
+  if (likely(checkpointSave == 0 && checkpointLoad == 0))
+    return;
+
+  // The memory system only drains out of timing (see runQuiescent)
+  if (mode == EmuDetail || mode == EmuTiming)
+    return;
+
+  if (checkpointLoad) {
+    if (totalnInst < checkpointLoad->getKey())
+      return;
+
+    flushWarmup();
+    checkpointCk = checkpointLoad;
+    if (TaskHandler::runQuiescent(&checkpointCB))
+      checkpointLoad->report();
+    else
+      MSG("WARNING: the simulation finished before restoring the checkpoint");
+    checkpointCk = 0;
+
+    delete checkpointLoad;
+    checkpointLoad = 0;
+    return;
+  }
+
+  if (totalnInst < nInstCheckpoint)
+    return;
+  if (nInstWarmup && mode != EmuWarmup)
+    return; // save at the end of a warmup interval
+
+  flushWarmup();
+  Checkpoint *ck = Checkpoint::create(checkpointSave, totalnInst);
+  if (ck == 0) {
+    MSG("WARNING: could not create checkpoint [%s]", checkpointSave);
+    checkpointSave = 0;
+    return;
+  }
+
+  checkpointCk = ck;
+  if (TaskHandler::runQuiescent(&checkpointCB))
+    ck->report();
+  else
+    MSG("WARNING: the simulation finished before saving checkpoint [%s]", checkpointSave);
+  checkpointCk = 0;
+
+  delete ck;
+  checkpointSave = 0;
+}
+// 1}}}
+
+void SamplerBase::doIntervalReport()
+  // {{{1 append a stats row to the binary report every nInstReport
+{
+  if (likely(nInstReport == 0 || totalnInst < nextReport))
+    return;
+  if (!GStatsBin::isOpen())
+    return;
+
+  char tag[64];
+  sprintf(tag, "interval_%llu", (unsigned long long)totalnInst);
+  GStatsBin::append(tag);
+
+  while(nextReport <= totalnInst)
+    nextReport += nInstReport;
+}
+// 1}}}
+
 void SamplerBase::fetchNextMode() {
+  doCheckpoint();
+  doIntervalReport();
+
   sequence_pos++;
   if (sequence_pos >= sequence_mode.size())
     sequence_pos = 0;
@@ -45,8 +45,8 @@
 #include "nanassert.h"
 #include "EmuSampler.h"
 #include "TaskHandler.h"
-
-class MemObj;
+#include "MemObj.h"
+#include "Checkpoint.h"
 
 class SamplerBase : public EmuSampler {
 
@@ -57,6 +57,12 @@ protected:
 
 	MemObj  *DL1; // For warmup
 
+  // Warmup accesses are buffered per flow and handed in bulk to the
+  // simulation thread, that applies them to DL1 (MemObj::ffQueue)
+  enum { WarmupBatchSize = 1024 };
+  FFAccess warmupBatch[WarmupBatchSize];
+  size_t   nWarmupBatch;
+
   uint64_t nInstRabbit;
   uint64_t nInstWarmup;
   uint64_t nInstDetail;
@@ -67,6 +73,20 @@ protected:
   uint64_t nInstSkip;
   uint64_t nInstMax;
 
+  // Warm state snapshot (first flow only, see Checkpoint.h)
+  const char *checkpointSave;
+  Checkpoint *checkpointLoad;
+  uint64_t    nInstCheckpoint;
+  // Saved or restored by the simulation thread with nothing in flight
+  // (TaskHandler::runQuiescent)
+  Checkpoint *checkpointCk;
+  void checkpointQuiescent();
+  StaticCallbackMember0<SamplerBase, &SamplerBase::checkpointQuiescent> checkpointCB;
+
+  // Interval rows in the binary report (first flow only, see GStatsBin.h)
+  uint64_t nInstReport;
+  uint64_t nextReport;
+
 
   EmuMode  next2EmuTiming;
   EmuMode lastMode;
@@ -109,6 +129,10 @@ protected:
   FILE *genReportFileNameAndOpen(const char *str);
   void fetchNextMode();
 	void doWarmupOpAddr(char op, uint64_t addr);
+  void flushWarmup();
+  void doCheckpoint();
+  void checkpointState(Checkpoint *ck);
+  void doIntervalReport();
 
   void setNextSwitch(uint64_t instNum);
   uint64_t getNextSwitch() const { return nextSwitch; }
@@ -197,6 +197,7 @@ void SamplerPeriodic::loadPredCPI()
 
 
 void SamplerPeriodic::nextMode(bool rotate, FlowID fid, EmuMode mod) {
+  flushWarmup();
   winnerFid = 999999;
   if (rotate){
     totalnInstForcedDetail = 0;
@@ -161,6 +161,7 @@ void SamplerSMARTS::updateCPI(FlowID fid){
 
 
 void SamplerSMARTS::nextMode(bool rotate, FlowID fid, EmuMode mod){
+  flushWarmup();
 
   if (rotate){
 
@@ -0,0 +1,257 @@
+// Contributed by Jose Renau
+//
+// The ESESC/BSD License
+//
+// Copyright (c) 2005-2013, Regents of the University of California and 
+// the ESESC Project.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+//   - Neither the name of the University of California, Santa Cruz nor the
+//   names of its contributors may be used to endorse or promote products
+//   derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "SamplerSimPoint.h"
+#include "EmulInterface.h"
+#include "SescConf.h"
+#include "TaskHandler.h"
+#include "GStats.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+SamplerSimPoint::SamplerSimPoint(const char *iname, const char *section, EmulInterface *emu, FlowID fid)
+  : SamplerBase(iname, section, emu, fid)
+  /* SamplerSimPoint constructor {{{1 */
+{
+  finished[fid] = true; // will be set to false in resumeThread
+  finished[0] = false;
+
+  if (fid != 0)
+    MSG("WARNING: SamplerSimPoint only flow 0 weights the statistics, flow %d stats are added unweighted",(int)fid);
+
+  spointSize = static_cast<uint64_t>(SescConf->getDouble(section,"spointSize"));
+  SescConf->isGT(section,"spointSize",0);
+
+  nInstForcedDetail = nInstDetail==0? spointSize/2:nInstDetail;
+
+  std::vector<Point> points;
+  readPoints(section, points);
+  std::sort(points.begin(), points.end());
+
+  int32_t spointRun = -1; // all the points
+  if (SescConf->checkInt(section,"spointRun"))
+    spointRun = SescConf->getInt(section,"spointRun");
+  if (spointRun >= static_cast<int32_t>(points.size())) {
+    MSG("ERROR: SamplerSimPoint section [%s] spointRun %d, but there are only %d points",section,spointRun,(int)points.size());
+    SescConf->notCorrect();
+  }
+
+  // A checkpoint (checkpointLoad) sets nInstSkip to the instruction where it was taken
+  addPhase(EmuRabbit, checkpointLoad ? nInstSkip : 1);
+
+  nInstSimulated = 0;
+  for(size_t i=0;i<points.size();i++) {
+    if (spointRun >= 0 && i != static_cast<size_t>(spointRun))
+      continue;
+
+    uint64_t start = points[i].first;
+    uint64_t end   = start + spointSize;
+    uint64_t warm  = nInstWarmup + nInstDetail;
+
+    addPhase(EmuRabbit, start > warm        ? start - warm        : 0);
+    addPhase(EmuWarmup, start > nInstDetail ? start - nInstDetail : 0);
+    addPhase(EmuDetail, start);
+
+    if (end <= plan.back().end) {
+      MSG("WARNING: SamplerSimPoint point %d starts before the checkpoint or inside the previous point (skipped)",(int)i);
+      continue;
+    }
+    nInstSimulated += end - std::max(start, plan.back().end);
+    addPhase(EmuTiming, end, points[i].second);
+  }
+
+  if (nInstSimulated == 0) {
+    MSG("ERROR: SamplerSimPoint section [%s] has no points to simulate",section);
+    SescConf->notCorrect();
+  }
+
+  planPos = 0;
+  setNextSwitch(plan[0].end);
+  startRabbit(fid);
+
+  std::cout << "Sampler: SimPoint, points:" << points.size()
+            << ", spointSize:"              << spointSize
+            << ", W:"                       << nInstWarmup
+            << ", D:"                       << nInstDetail
+            << ", spointRun:"               << spointRun
+            << std::endl;
+}
+/* }}} */
+
+SamplerSimPoint::~SamplerSimPoint()
+  /* Destructor {{{1 */
+{
+}
+/* }}} */
+
+void SamplerSimPoint::readPoints(const char *section, std::vector<Point> &points)
+  /* spoint/spweight records, or the SimPoint output files {{{1 */
+{
+  if (!SescConf->checkCharPtr(section,"simpointFile")) {
+    int32_t min = SescConf->getRecordMin(section,"spoint");
+    int32_t max = SescConf->getRecordMax(section,"spoint");
+    for(int32_t i=min;i<=max;i++) {
+      uint64_t start = static_cast<uint64_t>(SescConf->getDouble(section,"spoint",i));
+      points.push_back(Point(start, SescConf->getDouble(section,"spweight",i)));
+    }
+    return;
+  }
+
+  // SimPoint 3 output: "<interval> <cluster>" and "<weight> <cluster>" lines
+  const char *sfile = SescConf->getCharPtr(section,"simpointFile");
+  const char *wfile = SescConf->getCharPtr(section,"spweightFile");
+
+  std::map<int32_t, double> clusterWeight;
+  FILE *fp = fopen(wfile,"r");
+  if (fp == 0) {
+    MSG("ERROR: SamplerSimPoint could not open spweightFile [%s]",wfile);
+    SescConf->notCorrect();
+    return;
+  }
+  double  w;
+  int32_t c;
+  while(fscanf(fp,"%lf %d",&w,&c) == 2)
+    clusterWeight[c] = w;
+  fclose(fp);
+
+  fp = fopen(sfile,"r");
+  if (fp == 0) {
+    MSG("ERROR: SamplerSimPoint could not open simpointFile [%s]",sfile);
+    SescConf->notCorrect();
+    return;
+  }
+  unsigned long long interval;
+  while(fscanf(fp,"%llu %d",&interval,&c) == 2) {
+    if (clusterWeight.find(c) == clusterWeight.end()) {
+      MSG("ERROR: SamplerSimPoint cluster %d in [%s] has no weight in [%s]",c,sfile,wfile);
+      SescConf->notCorrect();
+      continue;
+    }
+    points.push_back(Point(interval*spointSize, clusterWeight[c]));
+  }
+  fclose(fp);
+}
+/* }}} */
+
+void SamplerSimPoint::addPhase(EmuMode m, uint64_t end, double weight)
+  /* append to the plan, phases that end before the previous one are dropped {{{1 */
+{
+  if (!plan.empty()) {
+    Phase &last = plan.back();
+    if (end <= last.end)
+      return;
+    if (last.mode == m && m != EmuTiming) {
+      last.end = end;
+      return;
+    }
+  }
+
+  Phase p;
+  p.mode   = m;
+  p.end    = end;
+  p.weight = weight;
+  plan.push_back(p);
+}
+/* }}} */
+
+void SamplerSimPoint::queue(uint32_t insn, uint64_t pc, uint64_t addr, FlowID fid, char op, uint64_t icount, void *env)
+  /* main qemu/gpu/tracer/... entry point {{{1 */
+{
+  I(fid < emul->getNumEmuls());
+  if(likely(!execute(fid, icount)))
+    return; // QEMU can still send a few additional instructions (emul should stop soon)
+  I(mode!=EmuInit);
+
+  I(insn);
+
+  if (getNextSwitch()>totalnInst) {
+
+    if (mode == EmuRabbit || mode == EmuInit)
+      return;
+
+    if (mode == EmuDetail || mode == EmuTiming) {
+      emul->queueInstruction(insn,pc,addr, (op&0xc0) /* thumb */ ,fid, env, getStatsFlag());
+      return;
+    }
+
+    I(mode == EmuWarmup);
+    doWarmupOpAddr(op, addr);
+    return;
+  }
+
+  pthread_mutex_lock (&mode_lock);
+
+  if (getNextSwitch() > totalnInst){//another thread just changed the mode
+    pthread_mutex_unlock (&mode_lock);
+    return;
+  }
+
+  lastMode = mode;
+  nextMode(ROTATE, fid);
+
+  pthread_mutex_unlock (&mode_lock);
+}
+/* }}} */
+
+void SamplerSimPoint::nextMode(bool rotate, FlowID fid, EmuMode mod)
+  /* move to the next phase of the plan {{{1 */
+{
+  I(rotate);
+  flushWarmup();
+  doCheckpoint();
+  doIntervalReport();
+
+  const Phase &cur = plan[planPos];
+  // GStats::weight scales all the stats, not just this flow: only flow 0 does it
+  if (cur.mode == EmuTiming && getsFid() == 0) {
+    MSG("SimPoint: point done at %llu with weight %f",(unsigned long long)totalnInst,cur.weight);
+    GStats::weight(cur.weight);
+  }
+
+  planPos++;
+  if (planPos >= plan.size() || getTime()>=maxnsTime || totalnInst>=nInstMax) {
+    if (planPos < plan.size())
+      MSG("Time/Inst exceeds limits: time %lu ns, inst %lu", getTime(), totalnInst);
+    markDone();
+    return;
+  }
+
+  setMode(plan[planPos].mode, fid);
+  if (plan[planPos].mode == EmuRabbit)
+    setModeNativeRabbit();
+  setNextSwitch(plan[planPos].end);
+}
+/* }}} */
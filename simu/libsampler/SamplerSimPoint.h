@@ -0,0 +1,91 @@
+// Contributed by Jose Renau
+//
+// The ESESC/BSD License
+//
+// Copyright (c) 2005-2013, Regents of the University of California and 
+// the ESESC Project.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+//   - Neither the name of the University of California, Santa Cruz nor the
+//   names of its contributors may be used to endorse or promote products
+//   derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef EMU_SAMPLER_SIMPOINT_H
+#define EMU_SAMPLER_SIMPOINT_H
+
+#include <vector>
+
+#include "nanassert.h"
+#include "SamplerBase.h"
+
+/*
+ * Simulates only the representative intervals of a SimPoint analysis
+ * (conf/scripts/bbv-editor.rb). Before each interval start the flow runs
+ * native until nInstWarmup+nInstDetail instructions before it, then warmup,
+ * detail, and spointSize instructions in timing. At the end of each interval
+ * the statistics collected are scaled by the interval weight
+ * (GStats::weight), so the report has the weighted per-interval estimate.
+ * The weight scales all the statistics (they are not per flow), so only the
+ * flow 0 sampler applies it: weighted SimPoint runs support a single flow.
+ *
+ * spointRun selects one interval: each interval can run as an independent
+ * process (optionally from a checkpoint) and conf/scripts/spoint-run.rb
+ * adds up the weighted reports.
+ */
+
+class SamplerSimPoint : public SamplerBase {
+private:
+  class Phase {
+  public:
+    EmuMode  mode;
+    uint64_t end;    // totalnInst at the end of the phase
+    double   weight; // timing phases only
+  };
+
+  typedef std::pair<uint64_t, double> Point; // start, weight
+
+  std::vector<Phase> plan;
+  size_t   planPos;
+  uint64_t spointSize;
+  uint64_t nInstSimulated;
+
+  void readPoints(const char *section, std::vector<Point> &points);
+  void addPhase(EmuMode m, uint64_t end, double weight = 0);
+
+protected:
+public:
+  SamplerSimPoint(const char *name, const char *section, EmulInterface *emul, FlowID fid);
+  virtual ~SamplerSimPoint();
+
+  void queue(uint32_t insn, uint64_t pc, uint64_t addr, uint32_t fid, char op, uint64_t icount, void *env);
+
+  void syncStats(){
+  };
+  void nextMode(bool rotate, FlowID fid, EmuMode mod = EmuRabbit);
+  float getSamplingRatio() {
+    return static_cast<float>(nInstSimulated)/static_cast<float>(plan.back().end);
+  };
+};
+#endif
@@ -27,6 +27,8 @@
 
 #include <stdio.h>
 #include <exception>
+#include <list>
+#include <vector>
 #include "gtest/gtest.h"
 #include "CCache.h"
 #include "GProcessor.h"
@@ -44,6 +46,7 @@
 #include "ARMCrack.h"
 #include "ThumbCrack.h"
 #include "MemStruct.h"
+#include "CacheArray.h"
 
 using ::testing::EmptyTestEventListener;
 using ::testing::InitGoogleTest;
@@ -454,3 +457,311 @@ TEST_F(CacheTest,Invalid_ninth_test){
 }
 
 
+
+// LRUCacheArray keeps each set in a flat array with LRU ranks. RefLRUSet is
+// the std::list version it replaced (head of list -- LRU, tail -- MRU). Both
+// get the same random mix of warmup fills, up reqs, releases and
+// invalidations, and must pick the same lines.
+class RefLRULine {
+public:
+  AddrType lineAddr;
+  bool     valid;
+  bool     busy;
+  RefLRULine() : lineAddr(0), valid(false), busy(false) {}
+};
+
+class RefLRUSet {
+  typedef std::list<RefLRULine*> LineList;
+  LineList lines;
+
+  RefLRULine *promote(LineList::iterator it) {
+    RefLRULine *l = *it;
+    lines.erase(it);
+    lines.push_back(l);
+    return l;
+  }
+public:
+  RefLRUSet(int assoc) {
+    for(int i=0;i<assoc;i++)
+      lines.push_back(new RefLRULine);
+  }
+  ~RefLRUSet() {
+    for(LineList::iterator it=lines.begin();it!=lines.end();it++)
+      delete *it;
+  }
+  RefLRULine *find(AddrType lineAddr) {
+    for(LineList::iterator it=lines.begin();it!=lines.end();it++)
+      if ((*it)->valid && (*it)->lineAddr == lineAddr)
+        return *it;
+    return 0;
+  }
+  // old LRUCacheArray::ffOccupyLine
+  RefLRULine *ffOccupy(AddrType lineAddr) {
+    LineList::iterator victim = lines.end();
+    for(LineList::iterator it=lines.begin();it!=lines.end();it++) {
+      RefLRULine *l = *it;
+      if (l->valid && l->lineAddr == lineAddr) {
+        if (l->busy)
+          return 0;
+        victim = it;
+        break;
+      }
+      if (l->busy)
+        continue;
+      if (victim == lines.end() || (!l->valid && (*victim)->valid))
+        victim = it;
+    }
+    if (victim == lines.end())
+      return 0;
+    return promote(victim);
+  }
+  // old LRUCacheArray::upReqOccupyLine
+  RefLRULine *upOccupy(AddrType lineAddr) {
+    for(LineList::iterator it=lines.begin();it!=lines.end();it++)
+      if ((*it)->valid && (*it)->lineAddr == lineAddr)
+        return promote(it);
+    for(LineList::iterator it=lines.begin();it!=lines.end();it++)
+      if (!(*it)->valid && !(*it)->busy)
+        return promote(it);
+    for(LineList::iterator it=lines.begin();it!=lines.end();it++)
+      if (!(*it)->busy)
+        return promote(it);
+    return 0;
+  }
+};
+
+static void expectSameLine(CacheLine *line, RefLRULine *ref) {
+  ASSERT_EQ(ref == 0, line == 0);
+  if (line) {
+    EXPECT_EQ(ref->valid, line->state != CacheLine::I);
+    EXPECT_EQ(ref->lineAddr, line->lineAddr);
+  }
+}
+
+TEST(LRUCacheArrayTest, Same_replacement_as_list_LRU){
+  const uint32_t assoc  = 8;
+  const uint32_t setNum = 16;
+  LRUCacheArray cache(64*assoc*setNum, 64, assoc, 1, 2, "LRUCacheArrayTest");
+  std::vector<RefLRUSet*> ref;
+  for(uint32_t i=0;i<setNum;i++)
+    ref.push_back(new RefLRUSet(assoc));
+
+  static const char fakeReqStorage = 0;
+  const MemRequest *fakeReq = reinterpret_cast<const MemRequest*>(&fakeReqStorage);
+
+  // lines occupied by an up req
+  std::vector<std::pair<CacheLine*, RefLRULine*> > busy;
+
+  srand(7);
+  for(int i=0;i<200000;i++) {
+    AddrType lineAddr = rand() % (setNum * assoc * 3);
+    RefLRUSet *set    = ref[cache.getIndex(lineAddr)];
+    int op = rand() % 20;
+
+    // the MSHR never lets another req touch a line held by an up req
+    bool held = false;
+    for(size_t j=0;j<busy.size();j++)
+      held = held || busy[j].second->lineAddr == lineAddr;
+    if (held)
+      continue;
+
+    if (op < 12) {
+      // functional warmup fill
+      CacheLine  *line = cache.ffOccupyLine(lineAddr);
+      RefLRULine *r    = set->ffOccupy(lineAddr);
+      expectSameLine(line, r);
+      if (line == 0 || r == 0)
+        continue;
+      line->lineAddr = lineAddr;
+      line->state    = CacheLine::E;
+      r->lineAddr    = lineAddr;
+      r->valid       = true;
+    }else if (op < 15) {
+      // up req miss/hit, released later
+      if (busy.size() >= assoc/2)
+        continue;
+      CacheLine  *line = cache.upReqOccupyLine(lineAddr, fakeReq);
+      RefLRULine *r    = set->upOccupy(lineAddr);
+      expectSameLine(line, r);
+      if (line == 0 || r == 0)
+        continue;
+      EXPECT_EQ(fakeReq, line->upReq);
+      line->lineAddr = lineAddr;
+      r->lineAddr    = lineAddr;
+      r->busy        = true;
+      busy.push_back(std::make_pair(line, r));
+    }else if (op < 18) {
+      if (busy.empty())
+        continue;
+      int j = rand() % busy.size();
+      busy[j].first->upReq  = 0;
+      busy[j].first->state  = CacheLine::S;
+      busy[j].second->busy  = false;
+      busy[j].second->valid = true;
+      busy.erase(busy.begin() + j);
+    }else{
+      // invalidation from below
+      CacheLine  *line = cache.ffFindLine(lineAddr);
+      RefLRULine *r    = set->find(lineAddr);
+      expectSameLine(line, r);
+      if (line && r) {
+        line->state = CacheLine::I;
+        r->valid    = false;
+      }
+    }
+  }
+
+  for(uint32_t i=0;i<setNum;i++)
+    delete ref[i];
+}
+
+// CacheDir keeps the sharers of a line packed. The same random MESI
+// transitions are applied to the directory and to a plain per node state
+// array: the full bit-vector must match it, the limited pointer and coarse
+// modes must report every node that has the line and the exact owner.
+static void checkDirMode(CacheDir::Mode mode, int nNodes, int nPtr) {
+  CacheDir dir(nNodes, mode, nPtr);
+  std::vector<CacheLine::DirWord> entry(dir.getWords());
+  std::vector<CacheLine::MESI>    ref(nNodes, CacheLine::I);
+  std::vector<int16_t>            sharers(nNodes);
+  dir.clear(&entry[0]);
+
+  srand(11);
+  for(int i=0;i<50000;i++) {
+    int port = rand() % nNodes;
+    int op   = rand() % 8;
+
+    // the protocol downgrades the other nodes first, using the directory
+    int n = dir.getSharers(&entry[0], &sharers[0]);
+    if (op < 3) {
+      for(int j=0;j<n;j++) {
+        if (sharers[j] != port && dir.get(&entry[0], sharers[j]) != CacheLine::S) {
+          dir.set(&entry[0], sharers[j], CacheLine::S);
+          ref[sharers[j]] = CacheLine::S;
+        }
+      }
+      dir.set(&entry[0], port, CacheLine::S);
+      ref[port] = CacheLine::S;
+    }else if (op < 5) {
+      for(int j=0;j<n;j++) {
+        if (sharers[j] != port) {
+          dir.set(&entry[0], sharers[j], CacheLine::I);
+          ref[sharers[j]] = CacheLine::I;
+        }
+      }
+      for(int j=0;j<nNodes;j++)
+        EXPECT_TRUE(j == port || ref[j] == CacheLine::I);
+      CacheLine::MESI st = op == 3 ? CacheLine::E : CacheLine::M;
+      dir.set(&entry[0], port, st);
+      ref[port] = st;
+    }else{
+      dir.set(&entry[0], port, CacheLine::I);
+      ref[port] = CacheLine::I;
+    }
+
+    n = dir.getSharers(&entry[0], &sharers[0]);
+    for(int j=1;j<n;j++)
+      ASSERT_LT(sharers[j-1], sharers[j]);
+    int k = 0;
+    for(int p=0;p<nNodes;p++) {
+      bool listed = k < n && sharers[k] == p;
+      if (listed)
+        k++;
+      CacheLine::MESI st = dir.get(&entry[0], p);
+      if (mode == CacheDir::Full || ref[p] != CacheLine::I) {
+        ASSERT_EQ(ref[p], st);
+      }else{
+        ASSERT_TRUE(st == CacheLine::I || st == CacheLine::S);
+      }
+      ASSERT_EQ(st != CacheLine::I, listed);
+    }
+    ASSERT_EQ(n, k);
+  }
+}
+
+TEST(CacheDirTest, Full_matches_MESI_vector){
+  checkDirMode(CacheDir::Full, 6, 0);
+  checkDirMode(CacheDir::Full, 130, 0);
+}
+
+TEST(CacheDirTest, Limited_pointer_and_coarse_cover_the_sharers){
+  checkDirMode(CacheDir::LimitedPtr, 40, 2);
+  checkDirMode(CacheDir::Coarse, 40, 2);
+  checkDirMode(CacheDir::Coarse, 200, 1);
+}
+
+// CacheAssocSoA is the default tag store of the caches with 2048 or more
+// lines. The same random stream of lookups, fills and invalidations goes to
+// it and to CacheAssoc: the hits, the victims and the MRU order of every set
+// (getPLine) must match.
+class SoATestState : public StateGeneric<AddrType> {
+public:
+  SoATestState(int32_t lineSize) { }
+};
+typedef CacheGeneric<SoATestState, AddrType> SoATestCache;
+
+static void checkSoAMatchesAssoc(const char *pStr, int32_t size, int32_t assoc) {
+  const int32_t bsize = 64;
+  SoATestCache *ref = SoATestCache::create(size, assoc, bsize, 1, pStr, false, false, 0, false);
+  SoATestCache *soa = SoATestCache::create(size, assoc, bsize, 1, pStr, false, false, 0, true);
+  uint32_t nLines = ref->getNumLines();
+  ASSERT_EQ(nLines, soa->getNumLines());
+
+  srand(17);
+  for(int i=0;i<200000;i++) {
+    // 3x the cache footprint, so there are hits and evictions in every set
+    AddrType addr = (AddrType)(rand() % (3*nLines) + 1) * bsize;
+
+    SoATestCache::CacheLine *l1;
+    SoATestCache::CacheLine *l2;
+    if (rand() % 16) {
+      l1 = ref->readLine(addr);
+      l2 = soa->readLine(addr);
+      ASSERT_EQ(l1 == 0, l2 == 0);
+      if (l1 == 0) {
+        AddrType rplc1, rplc2;
+        l1 = ref->fillLine(addr, rplc1);
+        l2 = soa->fillLine(addr, rplc2);
+        ASSERT_EQ(rplc1, rplc2);
+      }
+      ASSERT_EQ(l1->getTag(), l2->getTag());
+    }else{
+      l1 = ref->findLineNoEffect(addr);
+      l2 = soa->findLineNoEffect(addr);
+      ASSERT_EQ(l1 == 0, l2 == 0);
+      if (l1) {
+        l1->invalidate();
+        l2->invalidate();
+      }
+    }
+
+    if ((i & 1023) == 0 || i < 64) {
+      for(uint32_t j=0;j<nLines;j++) {
+        ASSERT_EQ(ref->getPLine(j)->isValid(), soa->getPLine(j)->isValid());
+        if (ref->getPLine(j)->isValid()) {
+          ASSERT_EQ(ref->getPLine(j)->getTag(), soa->getPLine(j)->getTag());
+        }
+      }
+    }
+  }
+
+  ref->destroy();
+  soa->destroy();
+}
+
+TEST(CacheSoATest, LRU_matches_CacheAssoc){
+  checkSoAMatchesAssoc("LRU", 32*1024, 4);
+  checkSoAMatchesAssoc("LRU", 128*1024, 8);
+  checkSoAMatchesAssoc("LRU", 256*1024, 16);
+  checkSoAMatchesAssoc("LRU", 64*1024, 128);
+}
+
+TEST(CacheSoATest, LRUp_matches_CacheAssoc){
+  checkSoAMatchesAssoc("LRUp", 128*1024, 8);
+  checkSoAMatchesAssoc("LRUp", 256*1024, 16);
+}
+
+TEST(CacheSoATest, RANDOM_matches_CacheAssoc){
+  checkSoAMatchesAssoc("RANDOM", 128*1024, 8);
+  checkSoAMatchesAssoc("RANDOM", 256*1024, 32);
+}